@@ -0,0 +1,118 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <limits.h>
+
+#include "CaptureArena.h"
+
+CAPTUREARENA::CAPTUREARENA()
+{
+    RtlZeroMemory(m_Slots, sizeof(m_Slots));
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+CAPTUREARENA::~CAPTUREARENA()
+{
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        if (m_Slots[i])
+        {
+            delete [] m_Slots[i];
+            m_Slots[i] = nullptr;
+        }
+    }
+}
+
+//
+// Allocates every slot up front, call when a capture thread starts rather than on the first frame
+//
+DUPL_RETURN CAPTUREARENA::Prepare()
+{
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        if (m_Stats.Capacity[i] < ARENA_INITIAL_SIZE)
+        {
+            DUPL_RETURN Ret = Grow(static_cast<ARENA_SLOT>(i), ARENA_INITIAL_SIZE);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Returns the slot buffer, reallocating it if it is smaller than Size
+//
+DUPL_RETURN CAPTUREARENA::Reserve(ARENA_SLOT Slot, UINT Size, _Outptr_result_bytebuffer_(Size) BYTE** Buffer)
+{
+    m_Stats.HighWater[Slot] = max(m_Stats.HighWater[Slot], Size);
+
+    if (Size > m_Stats.Capacity[Slot])
+    {
+        DUPL_RETURN Ret = Grow(Slot, Size);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            *Buffer = nullptr;
+            return Ret;
+        }
+    }
+
+    *Buffer = m_Slots[Slot];
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Replaces the slot buffer with one that holds at least Size bytes
+//
+DUPL_RETURN CAPTUREARENA::Grow(ARENA_SLOT Slot, UINT Size)
+{
+    UINT NewSize = GrowSize(m_Stats.Capacity[Slot], Size);
+
+    if (m_Slots[Slot])
+    {
+        delete [] m_Slots[Slot];
+    }
+
+    m_Slots[Slot] = new (std::nothrow) BYTE[NewSize];
+    if (!m_Slots[Slot])
+    {
+        m_Stats.Capacity[Slot] = 0;
+        return ProcessFailure(nullptr, L"Failed to allocate memory for capture arena", L"Error", E_OUTOFMEMORY);
+    }
+
+    m_Stats.Capacity[Slot] = NewSize;
+    ++m_Stats.Grows[Slot];
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies out the high-water marks
+//
+void CAPTUREARENA::GetStats(_Out_ ARENA_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
+
+//
+// Capacity to grow to when Needed bytes do not fit, at least double the old one
+//
+UINT CAPTUREARENA::GrowSize(UINT Capacity, UINT Needed)
+{
+    UINT Doubled = (Capacity > UINT_MAX / 2) ? UINT_MAX : Capacity * 2;
+    UINT NewSize = max(Needed, Doubled);
+    if (NewSize <= UINT_MAX - (ARENA_GRANULARITY - 1))
+    {
+        NewSize = (NewSize + (ARENA_GRANULARITY - 1)) & ~static_cast<UINT>(ARENA_GRANULARITY - 1);
+    }
+
+    return NewSize;
+}
@@ -0,0 +1,67 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CAPTUREARENA_H_
+#define _CAPTUREARENA_H_
+
+#include "CommonTypes.h"
+
+// Size every slot starts with, enough for a few thousand rects
+#define ARENA_INITIAL_SIZE (64 * 1024)
+
+// Slot capacities are rounded up to this
+#define ARENA_GRANULARITY 4096
+
+//
+// Scratch buffers a capture thread needs every frame
+//
+typedef enum _ARENA_SLOT
+{
+    ARENA_SLOT_METADATA         = 0,
+    ARENA_SLOT_DIRTY_VERTICES   = 1,
+    ARENA_SLOT_MOVE_RECTS       = 2,
+    ARENA_SLOT_COALESCED_RECTS  = 3,
+    ARENA_SLOT_DAMAGE_RECTS     = 4,
+    ARENA_SLOT_COUNT            = 5
+} ARENA_SLOT;
+
+//
+// Largest request, current capacity and number of reallocations per slot
+//
+typedef struct _ARENA_STATS
+{
+    UINT HighWater[ARENA_SLOT_COUNT];
+    UINT Capacity[ARENA_SLOT_COUNT];
+    UINT64 Grows[ARENA_SLOT_COUNT];
+} ARENA_STATS;
+
+//
+// Holds the per frame scratch buffers of one capture thread.
+// Each slot only ever grows, at least doubling so a slowly rising rect count settles after a few
+// frames. THREADMANAGER owns the arenas and keeps them across reinit, so a restarted thread starts
+// out with the capacity its predecessor needed and does not allocate while capturing. Slot
+// contents are not kept when a slot grows.
+//
+class CAPTUREARENA
+{
+    public:
+        CAPTUREARENA();
+        ~CAPTUREARENA();
+        DUPL_RETURN Prepare();
+        DUPL_RETURN Reserve(ARENA_SLOT Slot, UINT Size, _Outptr_result_bytebuffer_(Size) BYTE** Buffer);
+        void GetStats(_Out_ ARENA_STATS* Stats);
+        static UINT GrowSize(UINT Capacity, UINT Needed);
+
+    private:
+        DUPL_RETURN Grow(ARENA_SLOT Slot, UINT Size);
+
+    // vars
+        BYTE* m_Slots[ARENA_SLOT_COUNT];
+        ARENA_STATS m_Stats;
+};
+
+#endif
@@ -0,0 +1,242 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <stdio.h>
+
+#include "CaptureStats.h"
+
+CAPTURESTATS::CAPTURESTATS()
+{
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+CAPTURESTATS::~CAPTURESTATS()
+{
+}
+
+//
+// Adds Amount to Value
+//
+void CAPTURESTATS::Add(_Inout_ LONG64* Value, LONG64 Amount)
+{
+    InterlockedExchangeAdd64(Value, Amount);
+}
+
+//
+// Raises Value to Candidate if Candidate is larger
+//
+void CAPTURESTATS::Max(_Inout_ LONG64* Value, LONG64 Candidate)
+{
+    LONG64 Old = Read(Value);
+    while (Candidate > Old)
+    {
+        LONG64 Seen = InterlockedCompareExchange64(Value, Candidate, Old);
+        if (Seen == Old)
+        {
+            break;
+        }
+        Old = Seen;
+    }
+}
+
+//
+// Reads Value in one piece
+//
+LONG64 CAPTURESTATS::Read(_In_ LONG64* Value)
+{
+    return InterlockedCompareExchange64(Value, 0, 0);
+}
+
+//
+// Histogram bucket for a frame that changed Pixels pixels
+//
+UINT CAPTURESTATS::AreaBucket(LONG64 Pixels)
+{
+    if (Pixels <= 0)
+    {
+        return 0;
+    }
+
+    UINT Bucket = 1;
+    LONG64 Limit = STATS_AREA_BASE;
+    while (Bucket < STATS_AREA_BUCKETS - 1 && Pixels >= Limit)
+    {
+        ++Bucket;
+        Limit *= 4;
+    }
+
+    return Bucket;
+}
+
+//
+// Counts an acquired frame and its metadata
+//
+void CAPTURESTATS::OnFrame(_In_ FRAME_DATA* Data)
+{
+    LONG64 Pixels = 0;
+    if (Data->FrameInfo.TotalMetadataBufferSize)
+    {
+        DXGI_OUTDUPL_MOVE_RECT* MoveRects = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(Data->MetaData);
+        for (UINT i = 0; i < Data->MoveCount; ++i)
+        {
+            RECT* Dest = &MoveRects[i].DestinationRect;
+            Pixels += static_cast<LONG64>(Dest->right - Dest->left) * (Dest->bottom - Dest->top);
+        }
+
+        RECT* DirtyRects = reinterpret_cast<RECT*>(Data->MetaData + (Data->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
+        for (UINT i = 0; i < Data->DirtyCount; ++i)
+        {
+            Pixels += static_cast<LONG64>(DirtyRects[i].right - DirtyRects[i].left) * (DirtyRects[i].bottom - DirtyRects[i].top);
+        }
+
+        Add(&m_Stats.MoveRects, Data->MoveCount);
+        Add(&m_Stats.DirtyRects, Data->DirtyCount);
+        Add(&m_Stats.DirtyPixels, Pixels);
+    }
+
+    Add(&m_Stats.FramesAcquired, 1);
+    Add(&m_Stats.AreaHistogram[AreaBucket(Pixels)], 1);
+}
+
+//
+// Counts an acquire that timed out
+//
+void CAPTURESTATS::OnTimeout()
+{
+    Add(&m_Stats.Timeouts, 1);
+}
+
+//
+// Counts one wait on the shared surface's keyed mutex
+//
+void CAPTURESTATS::OnMutexWait(LONGLONG Ticks, bool Acquired)
+{
+    Add(&m_Stats.MutexWaits, 1);
+    Add(&m_Stats.MutexWaitTicks, Ticks);
+    Max(&m_Stats.MutexWaitMaxTicks, Ticks);
+    if (!Acquired)
+    {
+        Add(&m_Stats.MutexTimeouts, 1);
+    }
+}
+
+//
+// Counts how long a frame was held between acquire and release
+//
+void CAPTURESTATS::OnRelease(LONGLONG Ticks)
+{
+    Add(&m_Stats.AcquireToReleaseTicks, Ticks);
+    Max(&m_Stats.AcquireToReleaseMaxTicks, Ticks);
+}
+
+//
+// Copies out the totals, each field is consistent on its own though fields may be from slightly different moments
+//
+void CAPTURESTATS::Snapshot(_Out_ CAPTURE_STATS* Stats)
+{
+    LONG64* Source = reinterpret_cast<LONG64*>(&m_Stats);
+    LONG64* Dest = reinterpret_cast<LONG64*>(Stats);
+    for (UINT i = 0; i < sizeof(CAPTURE_STATS) / sizeof(LONG64); ++i)
+    {
+        Dest[i] = Read(&Source[i]);
+    }
+}
+
+STATSEXPORTER::STATSEXPORTER() : m_File(INVALID_HANDLE_VALUE)
+{
+    QueryPerformanceFrequency(&m_Frequency);
+    m_Start.QuadPart = 0;
+}
+
+STATSEXPORTER::~STATSEXPORTER()
+{
+    if (m_File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+}
+
+//
+// Creates the file and writes the column names
+//
+DUPL_RETURN STATSEXPORTER::Open(_In_z_ const CHAR* Path)
+{
+    m_File = CreateFileA(Path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        return ProcessFailure(nullptr, L"Failed to create capture statistics file in STATSEXPORTER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+    QueryPerformanceCounter(&m_Start);
+
+    CHAR Line[512];
+    INT Length = sprintf_s(Line, 512, "ms,output,frames,timeouts,hold_avg_us,hold_max_us,mutex_waits,mutex_wait_avg_us,mutex_wait_max_us,mutex_timeouts,move_rects,dirty_rects,dirty_pixels,area_0");
+    LONG64 Limit = STATS_AREA_BASE;
+    for (UINT i = 1; i < STATS_AREA_BUCKETS - 1; ++i, Limit *= 4)
+    {
+        Length += sprintf_s(Line + Length, 512 - Length, ",area_lt_%lld", Limit);
+    }
+    sprintf_s(Line + Length, 512 - Length, ",area_ge_%lld\r\n", Limit / 4);
+
+    return WriteLine(Line);
+}
+
+//
+// Whether Open succeeded
+//
+bool STATSEXPORTER::IsOpen()
+{
+    return m_File != INVALID_HANDLE_VALUE;
+}
+
+//
+// Converts QPC ticks to microseconds
+//
+double STATSEXPORTER::TicksToMicroseconds(LONG64 Ticks)
+{
+    return (Ticks * 1000000.0) / m_Frequency.QuadPart;
+}
+
+//
+// Appends one snapshot of an output
+//
+DUPL_RETURN STATSEXPORTER::Write(UINT Output, _In_ CAPTURE_STATS* Stats)
+{
+    LARGE_INTEGER Now;
+    QueryPerformanceCounter(&Now);
+
+    double HoldAvg = Stats->FramesAcquired ? TicksToMicroseconds(Stats->AcquireToReleaseTicks) / Stats->FramesAcquired : 0.0;
+    double WaitAvg = Stats->MutexWaits ? TicksToMicroseconds(Stats->MutexWaitTicks) / Stats->MutexWaits : 0.0;
+
+    CHAR Line[512];
+    INT Length = sprintf_s(Line, 512, "%.0f,%u,%lld,%lld,%.1f,%.1f,%lld,%.1f,%.1f,%lld,%lld,%lld,%lld",
+                           (Now.QuadPart - m_Start.QuadPart) * 1000.0 / m_Frequency.QuadPart, Output, Stats->FramesAcquired, Stats->Timeouts,
+                           HoldAvg, TicksToMicroseconds(Stats->AcquireToReleaseMaxTicks), Stats->MutexWaits, WaitAvg,
+                           TicksToMicroseconds(Stats->MutexWaitMaxTicks), Stats->MutexTimeouts, Stats->MoveRects, Stats->DirtyRects, Stats->DirtyPixels);
+    for (UINT i = 0; i < STATS_AREA_BUCKETS; ++i)
+    {
+        Length += sprintf_s(Line + Length, 512 - Length, ",%lld", Stats->AreaHistogram[i]);
+    }
+    sprintf_s(Line + Length, 512 - Length, "\r\n");
+
+    return WriteLine(Line);
+}
+
+//
+// Writes a line of text to the file
+//
+DUPL_RETURN STATSEXPORTER::WriteLine(_In_z_ const CHAR* Line)
+{
+    DWORD Size = static_cast<DWORD>(strlen(Line));
+    DWORD Written = 0;
+    if (!WriteFile(m_File, Line, Size, &Written, nullptr) || Written != Size)
+    {
+        return ProcessFailure(nullptr, L"Failed to write capture statistics in STATSEXPORTER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
@@ -0,0 +1,90 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CAPTURESTATS_H_
+#define _CAPTURESTATS_H_
+
+#include "CommonTypes.h"
+
+// Dirty area histogram buckets: no change, then below 1K, 4K, 16K, 64K, 256K, 1M pixels, then the rest
+#define STATS_AREA_BUCKETS 8
+
+// Smallest area counted in bucket 2, each later bucket starts 4 times higher
+#define STATS_AREA_BASE 1024
+
+// How often the render thread appends a snapshot to the stats file
+#define STATS_EXPORT_INTERVAL_MS 1000
+
+//
+// Totals for one output since the application started, times are in QPC ticks.
+// Dirty pixels count the area of every move destination and dirty rect, overlap included.
+//
+typedef struct _CAPTURE_STATS
+{
+    LONG64 FramesAcquired;
+    LONG64 Timeouts;
+    LONG64 AcquireToReleaseTicks;
+    LONG64 AcquireToReleaseMaxTicks;
+    LONG64 MutexWaits;
+    LONG64 MutexWaitTicks;
+    LONG64 MutexWaitMaxTicks;
+    LONG64 MutexTimeouts;
+    LONG64 MoveRects;
+    LONG64 DirtyRects;
+    LONG64 DirtyPixels;
+    LONG64 AreaHistogram[STATS_AREA_BUCKETS];
+} CAPTURE_STATS;
+
+//
+// Capture statistics of one output.
+// Only the output's capture thread updates them but any thread can take a snapshot at any time,
+// every field is read and written with interlocked operations so 64-bit values never tear on x86.
+//
+class CAPTURESTATS
+{
+    public:
+        CAPTURESTATS();
+        ~CAPTURESTATS();
+        void OnFrame(_In_ FRAME_DATA* Data);
+        void OnTimeout();
+        void OnMutexWait(LONGLONG Ticks, bool Acquired);
+        void OnRelease(LONGLONG Ticks);
+        void Snapshot(_Out_ CAPTURE_STATS* Stats);
+        static UINT AreaBucket(LONG64 Pixels);
+
+    private:
+        static void Add(_Inout_ LONG64* Value, LONG64 Amount);
+        static void Max(_Inout_ LONG64* Value, LONG64 Candidate);
+        static LONG64 Read(_In_ LONG64* Value);
+
+    // vars
+        CAPTURE_STATS m_Stats;
+};
+
+//
+// Appends capture statistics snapshots to a CSV file, one line per output per snapshot
+//
+class STATSEXPORTER
+{
+    public:
+        STATSEXPORTER();
+        ~STATSEXPORTER();
+        DUPL_RETURN Open(_In_z_ const CHAR* Path);
+        bool IsOpen();
+        DUPL_RETURN Write(UINT Output, _In_ CAPTURE_STATS* Stats);
+
+    private:
+        DUPL_RETURN WriteLine(_In_z_ const CHAR* Line);
+        double TicksToMicroseconds(LONG64 Ticks);
+
+    // vars
+        HANDLE m_File;
+        LARGE_INTEGER m_Frequency;
+        LARGE_INTEGER m_Start;
+};
+
+#endif
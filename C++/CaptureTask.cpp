@@ -0,0 +1,792 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CaptureArena.h"
+#include "CaptureStats.h"
+#include "CaptureTask.h"
+#include "PointerState.h"
+
+CAPTURETASK::CAPTURETASK(_In_ THREAD_DATA* TData) : m_TData(TData),
+                                                    m_FrameRate(&m_Clock),
+                                                    m_Source(&m_DuplMgr),
+                                                    m_SharedSurf(nullptr),
+                                                    m_KeyMutex(nullptr),
+                                                    m_Mailbox(TData->Mailbox),
+                                                    m_Recording(false),
+                                                    m_Accumulate(false),
+                                                    m_Started(false),
+                                                    m_WaitToProcessCurrentFrame(false),
+                                                    m_HaveFrame(false),
+                                                    m_ShadowStaging(nullptr),
+                                                    m_ShadowGeneration(0),
+                                                    m_ShadowPending(0),
+                                                    m_ShadowFill(false),
+                                                    m_ShadowMaps(0),
+                                                    m_ShadowMapTicks(0)
+{
+    RtlZeroMemory(m_Slots, sizeof(m_Slots));
+    RtlZeroMemory(m_SlotMutexes, sizeof(m_SlotMutexes));
+    RtlZeroMemory(m_SlotFilled, sizeof(m_SlotFilled));
+    RtlZeroMemory(m_SlotSince, sizeof(m_SlotSince));
+    RtlZeroMemory(&m_PtrInfo, sizeof(m_PtrInfo));
+    RtlZeroMemory(&m_DesktopDesc, sizeof(m_DesktopDesc));
+    RtlZeroMemory(&m_CurrentData, sizeof(m_CurrentData));
+    m_AcquireTime.QuadPart = 0;
+    SetRectEmpty(&m_ShadowRegion);
+    SetRectEmpty(&m_ShadowRect);
+
+    // Frames come from desktop duplication unless a trace is being played back
+    if (m_TData->Capture.ReplayPath[0])
+    {
+        m_ReplayMgr.SetOptions(&m_TData->Capture);
+        m_Source = &m_ReplayMgr;
+    }
+}
+
+CAPTURETASK::~CAPTURETASK()
+{
+    CleanRefs();
+}
+
+//
+// Releases the shared surface, the mailbox slots, the pointer shadow staging texture and the pointer shape buffer
+//
+void CAPTURETASK::CleanRefs()
+{
+    if (m_ShadowStaging)
+    {
+        m_ShadowStaging->Release();
+        m_ShadowStaging = nullptr;
+    }
+    m_ShadowPending = 0;
+
+    if (m_SharedSurf)
+    {
+        m_SharedSurf->Release();
+        m_SharedSurf = nullptr;
+    }
+
+    if (m_KeyMutex)
+    {
+        m_KeyMutex->Release();
+        m_KeyMutex = nullptr;
+    }
+
+    for (UINT i = 0; i < MAILBOX_SLOTS; ++i)
+    {
+        if (m_SlotMutexes[i])
+        {
+            m_SlotMutexes[i]->Release();
+            m_SlotMutexes[i] = nullptr;
+        }
+
+        if (m_Slots[i])
+        {
+            m_Slots[i]->Release();
+            m_Slots[i] = nullptr;
+        }
+        m_SlotFilled[i] = false;
+    }
+
+    if (m_PtrInfo.PtrShapeBuffer)
+    {
+        delete [] m_PtrInfo.PtrShapeBuffer;
+        m_PtrInfo.PtrShapeBuffer = nullptr;
+    }
+}
+
+//
+// Attaches the input desktop to the calling thread, every thread that runs a capture task needs it
+//
+DUPL_RETURN CAPTURETASK::AttachInputDesktop()
+{
+    HDESK CurrentDesktop = OpenInputDesktop(0, FALSE, GENERIC_ALL);
+    if (!CurrentDesktop)
+    {
+        // We do not have access to the desktop so request a retry
+        return DUPL_RETURN_ERROR_EXPECTED;
+    }
+
+    bool DesktopAttached = SetThreadDesktop(CurrentDesktop) != 0;
+    CloseDesktop(CurrentDesktop);
+    CurrentDesktop = nullptr;
+    if (!DesktopAttached)
+    {
+        // We do not have access to the desktop so request a retry
+        return DUPL_RETURN_ERROR_EXPECTED;
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Opens the shared surface and the frame source
+//
+DUPL_RETURN CAPTURETASK::Start()
+{
+    m_Started = true;
+
+    // New display manager
+    m_DispMgr.InitD3D(&m_TData->DxRes);
+
+    // Per frame scratch buffers come from this output's arena
+    m_DuplMgr.SetArena(m_TData->Arena);
+    m_DispMgr.SetArena(m_TData->Arena);
+    m_DispMgr.SetTileMap(m_TData->TileMap, m_TData->SurfaceX - m_TData->OffsetX, m_TData->SurfaceY - m_TData->OffsetY);
+    m_DispMgr.SetCpuCompose(m_TData->Capture.CpuCompose, m_TData->BandPool);
+    DUPL_RETURN Ret = m_TData->Arena->Prepare();
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    if (m_Mailbox)
+    {
+        Ret = OpenMailbox();
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+    else
+    {
+        // Obtain handle to sync shared Surface
+        HRESULT hr = m_TData->DxRes.Device->OpenSharedResource(m_TData->TexSharedHandle, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_SharedSurf));
+        if (FAILED (hr))
+        {
+            return ProcessFailure(m_TData->DxRes.Device, L"Opening shared texture failed", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        hr = m_SharedSurf->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&m_KeyMutex));
+        if (FAILED(hr))
+        {
+            return ProcessFailure(nullptr, L"Failed to get keyed mutex interface in spawned thread", L"Error", hr);
+        }
+    }
+
+    // Make frame source
+    Ret = m_Source->InitSource(m_TData->DxRes.Device, m_TData->Output);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    // Get output description
+    m_Source->GetOutputDesc(&m_DesktopDesc);
+
+    // Start trace recording
+    m_Recording = m_TData->Capture.RecordPath[0] != '\0';
+    if (m_Recording)
+    {
+        Ret = m_Recorder.InitRecorder(m_TData->DxRes.Device, &m_TData->Capture, m_TData->Output, &m_DesktopDesc);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+
+    // Frames are only deferred when not recording since each recorded frame needs its own pointer data
+    m_Accumulate = m_TData->Capture.Accumulate && !m_Recording;
+    if (m_Accumulate)
+    {
+        m_Accumulator.InitAccumulator(m_TData->DxRes.Device);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Acquires and draws at most one frame. With Wait set it blocks about as long as the next frame
+// should take and for the shared surface like a dedicated thread would, otherwise it does not
+// wait at all and sets Idle when there was nothing it could do.
+//
+DUPL_RETURN CAPTURETASK::Step(bool Wait, _Out_ bool* Idle)
+{
+    *Idle = false;
+
+    DUPL_RETURN Ret;
+    if (!m_WaitToProcessCurrentFrame)
+    {
+        // Get new frame from desktop duplication
+        // Wait about as long as the next frame should take so the terminate event is checked often
+        bool TimeOut;
+        Ret = m_Source->GetFrame(Wait ? m_FrameRate.GetAcquireTimeout() : 0, &m_CurrentData, &TimeOut);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            // An error occurred getting the next frame, the caller
+            // will check if it was expected or not
+            return Ret;
+        }
+
+        // Check for timeout
+        if (TimeOut)
+        {
+            // No new frame at the moment, without waiting that only means the output was polled early
+            if (Wait)
+            {
+                m_FrameRate.OnTimeout();
+                m_TData->Stats->OnTimeout();
+            }
+            m_TData->CaptureFps = m_FrameRate.GetFramesPerSecond();
+
+            // A quiet moment is a good time to draw deferred frames
+            if (!m_Accumulator.HasPending())
+            {
+                *Idle = true;
+                return DUPL_RETURN_SUCCESS;
+            }
+            m_HaveFrame = false;
+        }
+        else
+        {
+            QueryPerformanceCounter(&m_AcquireTime);
+            m_FrameRate.OnFrame();
+            m_TData->Stats->OnFrame(&m_CurrentData);
+            m_TData->CaptureFps = m_FrameRate.GetFramesPerSecond();
+            m_HaveFrame = true;
+        }
+    }
+
+    // We have a new frame so try and process it
+    // Try to acquire keyed mutex in order to access shared surface, only briefly if the frame can be deferred
+    bool CanDefer = m_Accumulate && (!m_HaveFrame || m_Accumulator.CanDefer(&m_CurrentData));
+    UINT SyncTimeout = CanDefer ? ACCUMULATE_SYNC_TIMEOUT_MS : 1000;
+    LARGE_INTEGER WaitStart;
+    LARGE_INTEGER WaitEnd;
+    QueryPerformanceCounter(&WaitStart);
+    HRESULT hr = AcquireSurface(Wait ? SyncTimeout : 0);
+    QueryPerformanceCounter(&WaitEnd);
+    m_TData->Stats->OnMutexWait(WaitEnd.QuadPart - WaitStart.QuadPart, hr == S_OK);
+    if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+    {
+        if (m_HaveFrame && CanDefer)
+        {
+            // Give the frame back to DXGI now and draw its changes once the shared surface is free
+            Ret = m_Accumulator.Defer(&m_CurrentData);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                m_Source->DoneWithFrame();
+                return Ret;
+            }
+
+            m_HaveFrame = false;
+            LARGE_INTEGER ReleaseTime;
+            QueryPerformanceCounter(&ReleaseTime);
+            m_TData->Stats->OnRelease(ReleaseTime.QuadPart - m_AcquireTime.QuadPart);
+            return m_Source->DoneWithFrame();
+        }
+
+        // Can't use shared surface right now, try again later
+        m_WaitToProcessCurrentFrame = m_HaveFrame;
+        *Idle = true;
+        return DUPL_RETURN_SUCCESS;
+    }
+    else if (FAILED(hr))
+    {
+        // Generic unknown failure
+        Ret = ProcessFailure(m_TData->DxRes.Device, L"Unexpected error acquiring KeyMutex", L"Error", hr, SystemTransitionsExpectedErrors);
+        if (m_HaveFrame)
+        {
+            m_Source->DoneWithFrame();
+        }
+        return Ret;
+    }
+
+    // We can now process the current frame
+    m_WaitToProcessCurrentFrame = false;
+
+    // Tiles stamped from here on are the ones the pointer shadow may need again
+    LONG ShadowSince = m_TData->TileMap ? m_TData->TileMap->GetGeneration() : 0;
+
+    // Deferred frames are older than the current one so they are drawn first
+    if (m_Accumulator.HasPending())
+    {
+        FRAME_DATA PendingData;
+        m_Accumulator.GetPendingFrame(&PendingData);
+        Ret = m_Source->GetMouse(&m_PtrInfo, m_TData->Pointer, &(PendingData.FrameInfo), m_TData->OffsetX, m_TData->OffsetY);
+        if (Ret == DUPL_RETURN_SUCCESS)
+        {
+            Ret = m_DispMgr.ProcessFrame(&PendingData, m_SharedSurf, m_TData->SurfaceX, m_TData->SurfaceY, &m_DesktopDesc);
+        }
+        m_Accumulator.Clear();
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            if (m_HaveFrame)
+            {
+                m_Source->DoneWithFrame();
+            }
+            ReleaseSurface(false);
+            return Ret;
+        }
+    }
+
+    if (!m_HaveFrame)
+    {
+        Ret = CopyShadow(ShadowSince);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            ReleaseSurface(false);
+            return Ret;
+        }
+
+        hr = ReleaseSurface(true);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_TData->DxRes.Device, L"Unexpected error releasing the keyed mutex", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+        return FlushShadow();
+    }
+    m_HaveFrame = false;
+
+    // Get mouse info
+    Ret = m_Source->GetMouse(&m_PtrInfo, m_TData->Pointer, &(m_CurrentData.FrameInfo), m_TData->OffsetX, m_TData->OffsetY);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        m_Source->DoneWithFrame();
+        ReleaseSurface(false);
+        return Ret;
+    }
+
+    // Record metadata and the pointer shape this frame carried
+    if (m_Recording)
+    {
+        Ret = m_Recorder.RecordFrame(&m_CurrentData, &m_PtrInfo, m_AcquireTime);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            m_Source->DoneWithFrame();
+            ReleaseSurface(false);
+            return Ret;
+        }
+    }
+
+    // Process new frame
+    Ret = m_DispMgr.ProcessFrame(&m_CurrentData, m_SharedSurf, m_TData->SurfaceX, m_TData->SurfaceY, &m_DesktopDesc);
+    if (Ret == DUPL_RETURN_SUCCESS)
+    {
+        Ret = CopyShadow(ShadowSince);
+    }
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        m_Source->DoneWithFrame();
+        ReleaseSurface(false);
+        return Ret;
+    }
+
+    // Release acquired keyed mutex
+    hr = ReleaseSurface(true);
+    if (FAILED(hr))
+    {
+        Ret = ProcessFailure(m_TData->DxRes.Device, L"Unexpected error releasing the keyed mutex", L"Error", hr, SystemTransitionsExpectedErrors);
+        m_Source->DoneWithFrame();
+        return Ret;
+    }
+
+    // The pointer shadow waits for its copy here so the renderer never does
+    Ret = FlushShadow();
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        m_Source->DoneWithFrame();
+        return Ret;
+    }
+
+    // Pixel readback and file write happen outside the keyed mutex
+    if (m_Recording)
+    {
+        Ret = m_Recorder.Flush(&m_CurrentData);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            m_Source->DoneWithFrame();
+            return Ret;
+        }
+    }
+
+    // Release frame back to desktop duplication
+    LARGE_INTEGER ReleaseTime;
+    QueryPerformanceCounter(&ReleaseTime);
+    m_TData->Stats->OnRelease(ReleaseTime.QuadPart - m_AcquireTime.QuadPart);
+    return m_Source->DoneWithFrame();
+}
+
+//
+// Opens the mailbox slots and makes the private surface frames are drawn into
+//
+DUPL_RETURN CAPTURETASK::OpenMailbox()
+{
+    for (UINT i = 0; i < MAILBOX_SLOTS; ++i)
+    {
+        HRESULT hr = m_TData->DxRes.Device->OpenSharedResource(m_TData->SlotHandles[i], __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_Slots[i]));
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_TData->DxRes.Device, L"Opening mailbox slot failed", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        hr = m_Slots[i]->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&m_SlotMutexes[i]));
+        if (FAILED(hr))
+        {
+            return ProcessFailure(nullptr, L"Failed to get keyed mutex interface of mailbox slot", L"Error", hr);
+        }
+    }
+
+    // Moves read the surface they draw into, so frames can't go straight into a slot that missed the frames before
+    D3D11_TEXTURE2D_DESC Desc;
+    m_Slots[0]->GetDesc(&Desc);
+    Desc.MiscFlags = 0;
+    HRESULT hr = m_TData->DxRes.Device->CreateTexture2D(&Desc, nullptr, &m_SharedSurf);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_TData->DxRes.Device, L"Failed to create private surface for mailbox", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Takes the surface frames are drawn into, with a mailbox that is private and never has to be waited for
+//
+HRESULT CAPTURETASK::AcquireSurface(UINT Timeout)
+{
+    if (m_Mailbox)
+    {
+        return S_OK;
+    }
+
+    return m_KeyMutex->AcquireSync(0, Timeout);
+}
+
+//
+// Gives the surface back to the renderer, with a mailbox what was drawn is published unless capture is failing
+//
+HRESULT CAPTURETASK::ReleaseSurface(bool Publish)
+{
+    if (!m_Mailbox)
+    {
+        return m_KeyMutex->ReleaseSync(1);
+    }
+
+    return Publish ? PublishSlot() : S_OK;
+}
+
+//
+// Brings the mailbox's back slot up to date with the private surface and hands it to the renderer.
+// A slot misses the frames published into the other two, so it gets every tile this output drew
+// since it was last published rather than just the last frame's.
+//
+HRESULT CAPTURETASK::PublishSlot()
+{
+    // The renderer only ever holds the front slot so this doesn't wait, the keyed mutex
+    // is there to order the renderer's reads after these writes across devices
+    UINT Slot = m_Mailbox->GetWriteSlot();
+    HRESULT hr = m_SlotMutexes[Slot]->AcquireSync(0, 0);
+    if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+    {
+        // The private surface keeps the frame, the next publish carries it along
+        return S_OK;
+    }
+    else if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // Tiles stamped from here on are newer than what this slot gets now, this thread is the only one
+    // stamping this output's tiles and has taken the generation of every frame already drawn
+    LONG Generation = m_TData->TileMap ? m_TData->TileMap->GetGeneration() : 0;
+    if (m_TData->TileMap && m_SlotFilled[Slot])
+    {
+        CopyChangedTiles(Slot, m_SlotSince[Slot]);
+    }
+    else
+    {
+        m_TData->DxRes.Context->CopyResource(m_Slots[Slot], m_SharedSurf);
+    }
+    m_SlotFilled[Slot] = true;
+    m_SlotSince[Slot] = Generation + 1;
+
+    hr = m_SlotMutexes[Slot]->ReleaseSync(0);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_Mailbox->Publish();
+    return S_OK;
+}
+
+//
+// Copies the tiles of this output stamped with Since or later from the private surface into a slot,
+// one copy per run of changed tiles along a row as TILEMAP::NextChangedRun walks them
+//
+void CAPTURETASK::CopyChangedTiles(UINT Slot, LONG Since)
+{
+    // This output in desktop image coordinates, which the tiles are in
+    RECT OutputRect;
+    OutputRect.left = m_DesktopDesc.DesktopCoordinates.left - m_TData->OffsetX;
+    OutputRect.top = m_DesktopDesc.DesktopCoordinates.top - m_TData->OffsetY;
+    OutputRect.right = m_DesktopDesc.DesktopCoordinates.right - m_TData->OffsetX;
+    OutputRect.bottom = m_DesktopDesc.DesktopCoordinates.bottom - m_TData->OffsetY;
+
+    UINT Cursor = 0;
+    RECT Copy;
+    while (m_TData->TileMap->NextChangedRun(&OutputRect, Since, &Cursor, &Copy))
+    {
+        // Same place in the slot as in the private surface
+        D3D11_BOX Box;
+        Box.left = Copy.left - (m_TData->SurfaceX - m_TData->OffsetX);
+        Box.top = Copy.top - (m_TData->SurfaceY - m_TData->OffsetY);
+        Box.front = 0;
+        Box.right = Copy.right - (m_TData->SurfaceX - m_TData->OffsetX);
+        Box.bottom = Copy.bottom - (m_TData->SurfaceY - m_TData->OffsetY);
+        Box.back = 1;
+        m_TData->DxRes.Context->CopySubresourceRegion(m_Slots[Slot], 0, Box.left, Box.top, 0, m_SharedSurf, 0, &Box);
+    }
+}
+
+//
+// Queues a copy of this output's part of the pointer shadow's region from the surface, all of it the
+// first time this output sees the region and after that only the tiles drawn over since Since.
+// Only call while the surface is held.
+//
+DUPL_RETURN CAPTURETASK::CopyShadow(LONG Since)
+{
+    if (!m_TData->TileMap)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    RECT Region;
+    LONG Generation = m_TData->Pointer->GetShadow()->GetRegion(&Region);
+
+    // This output in desktop image coordinates
+    RECT OutputRect;
+    OutputRect.left = m_DesktopDesc.DesktopCoordinates.left - m_TData->OffsetX;
+    OutputRect.top = m_DesktopDesc.DesktopCoordinates.top - m_TData->OffsetY;
+    OutputRect.right = m_DesktopDesc.DesktopCoordinates.right - m_TData->OffsetX;
+    OutputRect.bottom = m_DesktopDesc.DesktopCoordinates.bottom - m_TData->OffsetY;
+
+    RECT Part;
+    if (!IntersectRect(&Part, &Region, &OutputRect))
+    {
+        // Nothing of the region is on this output
+        m_ShadowGeneration = Generation;
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    bool Fill = (Generation != m_ShadowGeneration);
+    RECT Copy = Part;
+    if (!Fill && !m_TData->TileMap->GetChangedBounds(&Part, Since, &Copy))
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    if (!m_ShadowStaging)
+    {
+        D3D11_TEXTURE2D_DESC Desc;
+        m_SharedSurf->GetDesc(&Desc);
+        Desc.Width = POINTER_SHADOW_SIZE;
+        Desc.Height = POINTER_SHADOW_SIZE;
+        Desc.MipLevels = 1;
+        Desc.ArraySize = 1;
+        Desc.SampleDesc.Count = 1;
+        Desc.SampleDesc.Quality = 0;
+        Desc.Usage = D3D11_USAGE_STAGING;
+        Desc.BindFlags = 0;
+        Desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        Desc.MiscFlags = 0;
+        HRESULT hr = m_TData->DxRes.Device->CreateTexture2D(&Desc, nullptr, &m_ShadowStaging);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_TData->DxRes.Device, L"Failed to create staging texture for pointer shadow", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+    }
+
+    // Same place in the staging texture as in the region
+    D3D11_BOX Box;
+    Box.left = Copy.left - (m_TData->SurfaceX - m_TData->OffsetX);
+    Box.top = Copy.top - (m_TData->SurfaceY - m_TData->OffsetY);
+    Box.front = 0;
+    Box.right = Copy.right - (m_TData->SurfaceX - m_TData->OffsetX);
+    Box.bottom = Copy.bottom - (m_TData->SurfaceY - m_TData->OffsetY);
+    Box.back = 1;
+    m_TData->DxRes.Context->CopySubresourceRegion(m_ShadowStaging, 0, Copy.left - Region.left, Copy.top - Region.top, 0, m_SharedSurf, 0, &Box);
+
+    m_ShadowPending = Generation;
+    m_ShadowRegion = Region;
+    m_ShadowRect = Copy;
+    m_ShadowFill = Fill;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Reads back the copy CopyShadow queued and hands it to the pointer shadow, call after the surface is released
+//
+DUPL_RETURN CAPTURETASK::FlushShadow()
+{
+    if (!m_ShadowPending)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+    LONG Generation = m_ShadowPending;
+    m_ShadowPending = 0;
+
+    LARGE_INTEGER MapStart;
+    LARGE_INTEGER MapEnd;
+    QueryPerformanceCounter(&MapStart);
+    D3D11_MAPPED_SUBRESOURCE Mapped;
+    HRESULT hr = m_TData->DxRes.Context->Map(m_ShadowStaging, 0, D3D11_MAP_READ, 0, &Mapped);
+    QueryPerformanceCounter(&MapEnd);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_TData->DxRes.Device, L"Failed to map pointer shadow staging texture", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+    ++m_ShadowMaps;
+    m_ShadowMapTicks += MapEnd.QuadPart - MapStart.QuadPart;
+
+    const BYTE* Src = reinterpret_cast<const BYTE*>(Mapped.pData) + ((m_ShadowRect.top - m_ShadowRegion.top) * Mapped.RowPitch) + ((m_ShadowRect.left - m_ShadowRegion.left) * BPP);
+    m_TData->Pointer->GetShadow()->Write(Generation, &m_ShadowRect, Src, Mapped.RowPitch, m_ShadowFill);
+    m_TData->DxRes.Context->Unmap(m_ShadowStaging, 0);
+
+    if (m_ShadowFill)
+    {
+        m_ShadowGeneration = Generation;
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Reports this output's statistics, signals how capture ended and releases the shared surface
+//
+void CAPTURETASK::Finish(DUPL_RETURN Ret)
+{
+    ReportStats();
+
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        if (Ret == DUPL_RETURN_ERROR_EXPECTED)
+        {
+            // The system is in a transition state so request the duplication be restarted
+            SetEvent(m_TData->ExpectedErrorEvent);
+        }
+        else
+        {
+            // Unexpected error so exit the application
+            SetEvent(m_TData->UnexpectedErrorEvent);
+        }
+    }
+
+    CleanRefs();
+}
+
+//
+// One scheduler run: starts the output the first time, then steps it without waiting until the
+// terminate event is set or an error occurs. An idle output asks to be run again when its next
+// frame is due, or soon when it holds a frame the shared surface was too busy for.
+//
+TASK_RESULT CAPTURETASK::Run(_Inout_ unsigned* IdlePollMs)
+{
+    DUPL_RETURN Ret = DUPL_RETURN_SUCCESS;
+    if (!m_Started)
+    {
+        Ret = Start();
+    }
+
+    if (Ret == DUPL_RETURN_SUCCESS && (WaitForSingleObjectEx(m_TData->TerminateThreadsEvent, 0, FALSE) == WAIT_TIMEOUT))
+    {
+        bool Idle;
+        Ret = Step(false, &Idle);
+        if (Ret == DUPL_RETURN_SUCCESS)
+        {
+            if (!Idle)
+            {
+                return TASK_RUN_AGAIN;
+            }
+
+            *IdlePollMs = m_WaitToProcessCurrentFrame ? POLL_INTERVAL_MIN_MS : m_FrameRate.GetPollInterval();
+            return TASK_IDLE;
+        }
+    }
+
+    Finish(Ret);
+    return TASK_DONE;
+}
+
+//
+// Reports the capture rate and what dirty rect coalescing, move planning and CPU composition did for this output
+//
+void CAPTURETASK::ReportStats()
+{
+    if (m_FrameRate.GetFramesPerSecond() > 0.0f)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u capture rate: %.1f fps, last acquire timeout %u ms\n",
+                   m_TData->Output, m_FrameRate.GetFramesPerSecond(), m_FrameRate.GetAcquireTimeout());
+        OutputDebugStringW(StatsMsg);
+    }
+
+    COALESCE_STATS CoalesceStats;
+    m_DispMgr.GetCoalesceStats(&CoalesceStats);
+    if (CoalesceStats.Frames)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u dirty rects: %llu frames, %llu rects in, %llu rects out, %llu full copies, %llu pixels over-copied\n",
+                   m_TData->Output, CoalesceStats.Frames, CoalesceStats.RectsIn, CoalesceStats.RectsOut, CoalesceStats.FullCopies, CoalesceStats.PixelsOverCopied);
+        OutputDebugStringW(StatsMsg);
+    }
+
+    MOVE_PLAN_STATS MoveStats;
+    m_DispMgr.GetMovePlanStats(&MoveStats);
+    if (MoveStats.Steps)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u move rects: %llu direct, %llu banded, %llu staged, %llu copies\n",
+                   m_TData->Output, MoveStats.DirectMoves, MoveStats.BandedMoves, MoveStats.StagedMoves, MoveStats.Steps);
+        OutputDebugStringW(StatsMsg);
+    }
+
+    // Bandwidth the CPU compositor reached, a reference for what the GPU path should beat
+    COMPOSE_STATS ComposeStats;
+    m_DispMgr.GetComposeStats(&ComposeStats);
+    if (ComposeStats.Frames && ComposeStats.Nanoseconds)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u CPU composition: %llu frames, %llu banded, %llu bytes moved, %llu bytes copied, %.2f GB/s\n",
+                   m_TData->Output, ComposeStats.Frames, ComposeStats.BandedFrames, ComposeStats.MovedBytes, ComposeStats.CopiedBytes,
+                   static_cast<double>(ComposeStats.MovedBytes + ComposeStats.CopiedBytes) / ComposeStats.Nanoseconds);
+        OutputDebugStringW(StatsMsg);
+    }
+
+    ACCUMULATE_STATS AccumulateStats;
+    m_Accumulator.GetStats(&AccumulateStats);
+    if (AccumulateStats.DeferredFrames)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u accumulation: %llu frames deferred, %llu flushes, %llu rects in, %llu rects drawn\n",
+                   m_TData->Output, AccumulateStats.DeferredFrames, AccumulateStats.Flushes, AccumulateStats.RectsDeferred, AccumulateStats.RectsFlushed);
+        OutputDebugStringW(StatsMsg);
+    }
+
+    // Time this output waited on the GPU for the pointer shadow, the renderer would have waited instead
+    if (m_ShadowMaps)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u pointer shadow: %llu copies, %.1f us average map wait\n",
+                   m_TData->Output, m_ShadowMaps, (m_ShadowMapTicks * 1000000.0) / (m_ShadowMaps * m_Clock.Frequency()));
+        OutputDebugStringW(StatsMsg);
+    }
+
+    // High-water marks of the scratch buffers, the arena keeps this capacity for the next run
+    ARENA_STATS ArenaStats;
+    m_TData->Arena->GetStats(&ArenaStats);
+    if (ArenaStats.HighWater[ARENA_SLOT_METADATA])
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Output %u arena high-water: %u metadata, %u vertex, %u move, %u coalesce, %u damage bytes\n",
+                   m_TData->Output, ArenaStats.HighWater[ARENA_SLOT_METADATA], ArenaStats.HighWater[ARENA_SLOT_DIRTY_VERTICES],
+                   ArenaStats.HighWater[ARENA_SLOT_MOVE_RECTS], ArenaStats.HighWater[ARENA_SLOT_COALESCED_RECTS], ArenaStats.HighWater[ARENA_SLOT_DAMAGE_RECTS]);
+        OutputDebugStringW(StatsMsg);
+    }
+}
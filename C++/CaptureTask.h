@@ -0,0 +1,95 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CAPTURETASK_H_
+#define _CAPTURETASK_H_
+
+#include "DirtyAccumulator.h"
+#include "DisplayManager.h"
+#include "DuplicationManager.h"
+#include "FrameTiming.h"
+#include "ReplayManager.h"
+#include "TaskScheduler.h"
+#include "TraceRecorder.h"
+
+//
+// Duplicates one output into its shared surface, one frame per Step.
+// DDProc drives it from a dedicated thread with blocking waits, TASKSCHEDULER drives it through
+// Run where nothing blocks: a missing frame or a busy shared surface ends the step and the
+// output is looked at again when the frame rate estimate says the next frame is due.
+//
+class CAPTURETASK
+{
+    public:
+        CAPTURETASK(_In_ THREAD_DATA* TData);
+        ~CAPTURETASK();
+        static DUPL_RETURN AttachInputDesktop();
+        DUPL_RETURN Start();
+        DUPL_RETURN Step(bool Wait, _Out_ bool* Idle);
+        void Finish(DUPL_RETURN Ret);
+        TASK_RESULT Run(_Inout_ unsigned* IdlePollMs);
+
+    private:
+        DUPL_RETURN OpenMailbox();
+        HRESULT AcquireSurface(UINT Timeout);
+        HRESULT ReleaseSurface(bool Publish);
+        HRESULT PublishSlot();
+        void CopyChangedTiles(UINT Slot, LONG Since);
+        DUPL_RETURN CopyShadow(LONG Since);
+        DUPL_RETURN FlushShadow();
+        void ReportStats();
+        void CleanRefs();
+
+    // vars
+        THREAD_DATA* m_TData;
+        DISPLAYMANAGER m_DispMgr;
+        DUPLICATIONMANAGER m_DuplMgr;
+        REPLAYMANAGER m_ReplayMgr;
+        TRACERECORDER m_Recorder;
+        DIRTYACCUMULATOR m_Accumulator;
+        QPCCLOCK m_Clock;
+        FRAMERATEESTIMATOR m_FrameRate;
+        FRAMESOURCE* m_Source;
+        ID3D11Texture2D* m_SharedSurf;
+        IDXGIKeyedMutex* m_KeyMutex;
+
+        // With a mailbox m_SharedSurf is this output's private copy of its surface and has no keyed mutex,
+        // each frame drawn into it is copied into the mailbox's back slot and published
+        MAILBOX* m_Mailbox;
+        ID3D11Texture2D* m_Slots[MAILBOX_SLOTS];
+        IDXGIKeyedMutex* m_SlotMutexes[MAILBOX_SLOTS];
+
+        // Whether each slot was ever published into, and the generation of the oldest tiles it hasn't got
+        bool m_SlotFilled[MAILBOX_SLOTS];
+        LONG m_SlotSince[MAILBOX_SLOTS];
+
+        // Shapes this output fetched, published to the render thread through m_TData->Pointer
+        PTR_INFO m_PtrInfo;
+        DXGI_OUTPUT_DESC m_DesktopDesc;
+        bool m_Recording;
+        bool m_Accumulate;
+        bool m_Started;
+
+        // Frame held between steps when the shared surface was busy
+        bool m_WaitToProcessCurrentFrame;
+        bool m_HaveFrame;
+        FRAME_DATA m_CurrentData;
+        LARGE_INTEGER m_AcquireTime;
+
+        // This output's pixels for the pointer shadow are copied into m_ShadowStaging while the surface is held
+        // and read back after it is released. m_ShadowGeneration is the region this output last filled its part of.
+        ID3D11Texture2D* m_ShadowStaging;
+        LONG m_ShadowGeneration;
+        LONG m_ShadowPending;
+        RECT m_ShadowRegion;
+        RECT m_ShadowRect;
+        bool m_ShadowFill;
+        ULONGLONG m_ShadowMaps;
+        LONGLONG m_ShadowMapTicks;
+};
+
+#endif
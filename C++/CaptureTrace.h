@@ -0,0 +1,65 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CAPTURETRACE_H_
+#define _CAPTURETRACE_H_
+
+#include "CommonTypes.h"
+
+//
+// On-disk layout of a capture trace.
+//
+// A trace is a CAPTURE_TRACE_HEADER followed by back to back records. Every record starts with a
+// CAPTURE_TRACE_RECORD and is followed by its payloads in this order:
+//   MoveCount DXGI_OUTDUPL_MOVE_RECTs, DirtyCount RECTs, ShapeSize bytes of pointer shape and
+//   PixelBytes of dirty pixels (each dirty rect in turn, tightly packed BGRA rows).
+// RecordSize covers the record header and payloads and is padded to CAPTURE_TRACE_ALIGN so the
+// whole file can be walked in place through a file mapping.
+//
+#define CAPTURE_TRACE_MAGIC             0x52544444      // 'DDTR'
+#define CAPTURE_TRACE_VERSION           1
+#define CAPTURE_TRACE_ALIGN             8
+
+// CAPTURE_TRACE_HEADER::Flags
+#define CAPTURE_TRACE_FLAG_PIXELS       0x1
+
+typedef struct _CAPTURE_TRACE_HEADER
+{
+    UINT Magic;
+    UINT Version;
+    UINT HeaderSize;
+    UINT Flags;
+    UINT Output;
+    RECT DesktopCoordinates;
+    UINT Rotation;
+    UINT FrameWidth;
+    UINT FrameHeight;
+    LARGE_INTEGER QPCFrequency;
+} CAPTURE_TRACE_HEADER;
+
+typedef struct _CAPTURE_TRACE_RECORD
+{
+    UINT RecordSize;
+    UINT MoveCount;
+    UINT DirtyCount;
+    UINT ShapeSize;
+    UINT PixelBytes;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    LARGE_INTEGER AcquireTime;
+    DXGI_OUTDUPL_FRAME_INFO FrameInfo;
+} CAPTURE_TRACE_RECORD;
+
+//
+// Rects that are empty or fall outside the frame carry no pixels, recording and playback skip the same ones
+//
+inline bool IsTraceRectInFrame(_In_ const RECT* Rect, UINT FrameWidth, UINT FrameHeight)
+{
+    return Rect->right > Rect->left && Rect->bottom > Rect->top && Rect->left >= 0 && Rect->top >= 0 &&
+           static_cast<UINT>(Rect->right) <= FrameWidth && static_cast<UINT>(Rect->bottom) <= FrameHeight;
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include <warning.h>
 #include <DirectXMath.h>
 
+#include "Mailbox.h"
 #include "PixelShader.h"
 #include "VertexShader.h"
 
@@ -67,6 +68,7 @@ typedef struct _PTR_INFO
 {
     _Field_size_bytes_(BufferSize) BYTE* PtrShapeBuffer;
     DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    UINT64 ShapeHash;
     POINT Position;
     bool Visible;
     UINT BufferSize;
@@ -85,11 +87,76 @@ typedef struct _DX_RESOURCES
     ID3D11PixelShader* PixelShader;
     ID3D11InputLayout* InputLayout;
     ID3D11SamplerState* SamplerLinear;
+
+    // Hardware unless the device fell back to WARP or the reference rasterizer
+    D3D_DRIVER_TYPE DriverType;
 } DX_RESOURCES;
 
+//
+// Capture settings taken from the command line
+//
+typedef struct _CAPTURE_OPTIONS
+{
+    // Trace to play back instead of duplicating the output, empty for live capture
+    CHAR ReplayPath[MAX_PATH];
+
+    // Playback rate relative to the recording, 0 plays back as fast as possible
+    FLOAT ReplaySpeed;
+
+    // Trace to record acquired frames into, empty when not recording
+    CHAR RecordPath[MAX_PATH];
+
+    // Also record the pixels of every dirty rect
+    bool RecordPixels;
+
+    // Set after the first session so reinitializing after a transition continues the trace
+    bool RecordAppend;
+
+    // Release frames right away while the shared surface is busy and draw their changes later
+    bool Accumulate;
+
+    // CSV file per output capture statistics are written to every STATS_EXPORT_INTERVAL_MS, empty when not exporting
+    CHAR StatsPath[MAX_PATH];
+
+    // Give every output its own shared surface and keyed mutex instead of one for the whole desktop
+    bool PerSurface;
+
+    // Hand each output to the renderer through MAILBOX_SLOTS surfaces of its own so neither side waits on the other
+    bool Mailbox;
+
+    // Capture every output as a task on this many shared worker threads, 0 gives each output its own thread
+    UINT Workers;
+
+    // Compose frames in a CPU framebuffer and upload only what changed, always done on a WARP or reference device
+    bool CpuCompose;
+
+    // Share of the pointer's predicted motion it is drawn ahead by, 0 draws it where it was last reported
+    FLOAT PredictPointer;
+} CAPTURE_OPTIONS;
+
+//
+// Surface a duplication thread draws into, SurfaceX and SurfaceY are where its top left corner is in desktop coordinates
+//
+typedef struct _SURFACE_TARGET
+{
+    HANDLE SharedHandle;
+    INT SurfaceX;
+    INT SurfaceY;
+
+    // With a mailbox SharedHandle is null and the thread publishes into these slots instead
+    MAILBOX* Mailbox;
+    HANDLE SlotHandles[MAILBOX_SLOTS];
+} SURFACE_TARGET;
+
 //
 // Structure to pass to a new thread
 //
+class CAPTUREARENA;
+class TILEMAP;
+class CAPTURESTATS;
+class POINTERSTATE;
+class BANDPOOL;
+
 typedef struct _THREAD_DATA
 {
     // Used to indicate abnormal error condition
@@ -105,8 +172,30 @@ typedef struct _THREAD_DATA
     UINT Output;
     INT OffsetX;
     INT OffsetY;
-    PTR_INFO* PtrInfo;
+
+    // Where the shared surface starts in desktop coordinates, the same as OffsetX and OffsetY unless each output has its own surface
+    INT SurfaceX;
+    INT SurfaceY;
+
+    // Slots the frames are published into when the surface is handed over through a mailbox
+    MAILBOX* Mailbox;
+    HANDLE SlotHandles[MAILBOX_SLOTS];
+    POINTERSTATE* Pointer;
+    CAPTUREARENA* Arena;
+
+    // Dirty tiles of the shared surface, stamped by every thread
+    TILEMAP* TileMap;
+
+    // Counters for this output, read by the render thread
+    CAPTURESTATS* Stats;
+
+    // Threads CPU composition splits large dirty sets across, shared by every output
+    BANDPOOL* BandPool;
     DX_RESOURCES DxRes;
+    CAPTURE_OPTIONS Capture;
+
+    // Measured capture rate of this output, written by its thread
+    volatile FLOAT CaptureFps;
 } THREAD_DATA;
 
 //
@@ -137,6 +226,17 @@ typedef struct _CBUFFER
 	DirectX::XMMATRIX Final;
 }CBUFFER;
 
+//
+// Pointer overlay of the distortion pass. Rects are left, top, right, bottom of the pointer in the texture
+// coordinates of the eye texture bound to t0 and t1, Tex is how much of the pointer texture is used and
+// whether there is a pointer at all
+//
+typedef struct _OVERLAY_CBUFFER
+{
+	DirectX::XMFLOAT4 Rect[2];
+	DirectX::XMFLOAT4 Tex;
+}OVERLAY_CBUFFER;
+
 enum Eye_Type
 {
 	LEFT_EYE = 0,
@@ -0,0 +1,469 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "CpuCompositor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define COMPOSE_SSE2
+#endif
+
+// Bands handed out per thread so a thread that drew a light band can take another
+#define COMPOSE_BANDS_PER_THREAD 2
+
+typedef std::chrono::steady_clock COMPOSE_CLOCK;
+
+BANDPOOL::BANDPOOL() : m_Stopping(false)
+{
+}
+
+BANDPOOL::~BANDPOOL()
+{
+    Stop();
+}
+
+//
+// Starts ThreadCount helper threads, capped at COMPOSE_MAX_THREADS. 0 is allowed and runs every band on the caller.
+//
+bool BANDPOOL::Start(unsigned ThreadCount)
+{
+    if (!m_Threads.empty())
+    {
+        return false;
+    }
+
+    m_Stopping = false;
+    ThreadCount = std::min(ThreadCount, static_cast<unsigned>(COMPOSE_MAX_THREADS));
+    try
+    {
+        for (unsigned i = 0; i < ThreadCount; ++i)
+        {
+            m_Threads.push_back(std::thread(&BANDPOOL::WorkerLoop, this));
+        }
+    }
+    catch (...)
+    {
+        Stop();
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Joins the helper threads, callers still in Run finish their bands themselves
+//
+void BANDPOOL::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Lock);
+        m_Stopping = true;
+        m_WorkSignal.notify_all();
+    }
+
+    for (size_t i = 0; i < m_Threads.size(); ++i)
+    {
+        if (m_Threads[i].joinable())
+        {
+            m_Threads[i].join();
+        }
+    }
+    m_Threads.clear();
+}
+
+unsigned BANDPOOL::GetThreadCount()
+{
+    return static_cast<unsigned>(m_Threads.size());
+}
+
+//
+// Calls Proc once for every band from 0 to BandCount and returns when all of them are done
+//
+void BANDPOOL::Run(BAND_PROC Proc, void* Context, unsigned BandCount)
+{
+    // The caller counts as active until it has stopped taking bands
+    JOB Job;
+    Job.Proc = Proc;
+    Job.Context = Context;
+    Job.BandCount = BandCount;
+    Job.NextBand = 0;
+    Job.Active = 1;
+
+    std::unique_lock<std::mutex> Lock(m_Lock);
+    if (BandCount > 1 && !m_Threads.empty() && !m_Stopping)
+    {
+        try
+        {
+            m_Jobs.push_back(&Job);
+            m_WorkSignal.notify_all();
+        }
+        catch (const std::bad_alloc&)
+        {
+            // Nobody else sees the job, the caller runs every band
+        }
+    }
+
+    while (RunBand(Lock, &Job))
+    {
+    }
+
+    --Job.Active;
+    m_DoneSignal.wait(Lock, [&Job] { return Job.Active == 0; });
+}
+
+//
+// Body of every helper thread
+//
+void BANDPOOL::WorkerLoop()
+{
+    std::unique_lock<std::mutex> Lock(m_Lock);
+    while (true)
+    {
+        m_WorkSignal.wait(Lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+        if (m_Stopping)
+        {
+            return;
+        }
+
+        JOB* Job = m_Jobs.front();
+        ++Job->Active;
+        RunBand(Lock, Job);
+        if (--Job->Active == 0)
+        {
+            m_DoneSignal.notify_all();
+        }
+    }
+}
+
+//
+// Takes the next band of Job and runs it with the lock released, false when every band was already taken
+//
+bool BANDPOOL::RunBand(std::unique_lock<std::mutex>& Lock, JOB* Job)
+{
+    if (Job->NextBand >= Job->BandCount)
+    {
+        return false;
+    }
+
+    unsigned Band = Job->NextBand++;
+    if (Job->NextBand == Job->BandCount)
+    {
+        // Last band handed out, no other thread needs to find the job any more
+        std::deque<JOB*>::iterator It = std::find(m_Jobs.begin(), m_Jobs.end(), Job);
+        if (It != m_Jobs.end())
+        {
+            m_Jobs.erase(It);
+        }
+    }
+
+    Lock.unlock();
+    Job->Proc(Job->Context, Band);
+    Lock.lock();
+
+    return true;
+}
+
+CPUCOMPOSITOR::CPUCOMPOSITOR() : m_Buffer(nullptr),
+                                 m_Pixels(nullptr),
+                                 m_Capacity(0),
+                                 m_Width(0),
+                                 m_Height(0),
+                                 m_Pitch(0),
+                                 m_Pool(nullptr),
+                                 m_Frames(0),
+                                 m_BandedFrames(0),
+                                 m_MovedBytes(0),
+                                 m_CopiedBytes(0),
+                                 m_Nanoseconds(0)
+{
+}
+
+CPUCOMPOSITOR::~CPUCOMPOSITOR()
+{
+    delete [] m_Buffer;
+    m_Buffer = nullptr;
+    m_Pixels = nullptr;
+}
+
+//
+// Large dirty sets are split across Pool, nullptr copies everything on the calling thread
+//
+void CPUCOMPOSITOR::SetPool(BANDPOOL* Pool)
+{
+    m_Pool = Pool;
+}
+
+//
+// Sizes the framebuffer, it is cleared to black whenever the size changes. The allocation only grows.
+//
+bool CPUCOMPOSITOR::Resize(unsigned Width, unsigned Height)
+{
+    if (m_Pixels && Width == m_Width && Height == m_Height)
+    {
+        return true;
+    }
+
+    unsigned Pitch = (Width * COMPOSE_BPP + (COMPOSE_ROW_ALIGN - 1)) & ~static_cast<unsigned>(COMPOSE_ROW_ALIGN - 1);
+    size_t Needed = static_cast<size_t>(Pitch) * Height + COMPOSE_ROW_ALIGN;
+    if (Needed > m_Capacity)
+    {
+        unsigned char* Buffer = new (std::nothrow) unsigned char[Needed];
+        if (!Buffer)
+        {
+            return false;
+        }
+        delete [] m_Buffer;
+        m_Buffer = Buffer;
+        m_Capacity = Needed;
+    }
+
+    size_t Misalign = reinterpret_cast<size_t>(m_Buffer) & (COMPOSE_ROW_ALIGN - 1);
+    m_Pixels = m_Buffer + (Misalign ? COMPOSE_ROW_ALIGN - Misalign : 0);
+    m_Width = Width;
+    m_Height = Height;
+    m_Pitch = Pitch;
+    memset(m_Pixels, 0, static_cast<size_t>(Pitch) * Height);
+
+    return true;
+}
+
+unsigned char* CPUCOMPOSITOR::GetPixels()
+{
+    return m_Pixels;
+}
+
+unsigned CPUCOMPOSITOR::GetPitch()
+{
+    return m_Pitch;
+}
+
+//
+// Clips Rect to the framebuffer, false when nothing of it is left
+//
+bool CPUCOMPOSITOR::ClipRect(const COMPOSE_RECT* Rect, COMPOSE_RECT* Clipped)
+{
+    Clipped->left = std::max(Rect->left, 0);
+    Clipped->top = std::max(Rect->top, 0);
+    Clipped->right = std::min(Rect->right, static_cast<int>(m_Width));
+    Clipped->bottom = std::min(Rect->bottom, static_cast<int>(m_Height));
+
+    return Clipped->left < Clipped->right && Clipped->top < Clipped->bottom;
+}
+
+//
+// Applies move rects in order. Each row is a memmove so a move within the same rows is safe, and rows are
+// walked bottom up when the destination is below the source so no row is overwritten before it is read.
+//
+void CPUCOMPOSITOR::ApplyMoves(const COMPOSE_MOVE* Moves, unsigned MoveCount)
+{
+    if (!m_Pixels || MoveCount == 0)
+    {
+        return;
+    }
+
+    COMPOSE_CLOCK::time_point Start = COMPOSE_CLOCK::now();
+    int Width = static_cast<int>(m_Width);
+    int Height = static_cast<int>(m_Height);
+
+    for (unsigned i = 0; i < MoveCount; ++i)
+    {
+        // Clip the destination so the source stays inside the framebuffer as well
+        int DeltaX = Moves[i].SrcX - Moves[i].Dest.left;
+        int DeltaY = Moves[i].SrcY - Moves[i].Dest.top;
+        COMPOSE_RECT Dest;
+        if (!ClipRect(&Moves[i].Dest, &Dest))
+        {
+            continue;
+        }
+        Dest.left = std::max(Dest.left, -DeltaX);
+        Dest.top = std::max(Dest.top, -DeltaY);
+        Dest.right = std::min(Dest.right, Width - DeltaX);
+        Dest.bottom = std::min(Dest.bottom, Height - DeltaY);
+        if (Dest.left >= Dest.right || Dest.top >= Dest.bottom)
+        {
+            continue;
+        }
+
+        size_t RowBytes = static_cast<size_t>(Dest.right - Dest.left) * COMPOSE_BPP;
+        int Rows = Dest.bottom - Dest.top;
+        unsigned char* DestRow = m_Pixels + static_cast<size_t>(Dest.top) * m_Pitch + static_cast<size_t>(Dest.left) * COMPOSE_BPP;
+        unsigned char* SrcRow = m_Pixels + static_cast<size_t>(Dest.top + DeltaY) * m_Pitch + static_cast<size_t>(Dest.left + DeltaX) * COMPOSE_BPP;
+
+        if (DeltaY < 0)
+        {
+            DestRow += static_cast<size_t>(Rows - 1) * m_Pitch;
+            SrcRow += static_cast<size_t>(Rows - 1) * m_Pitch;
+            for (int Row = 0; Row < Rows; ++Row)
+            {
+                memmove(DestRow, SrcRow, RowBytes);
+                DestRow -= m_Pitch;
+                SrcRow -= m_Pitch;
+            }
+        }
+        else
+        {
+            for (int Row = 0; Row < Rows; ++Row)
+            {
+                memmove(DestRow, SrcRow, RowBytes);
+                DestRow += m_Pitch;
+                SrcRow += m_Pitch;
+            }
+        }
+
+        m_MovedBytes += static_cast<unsigned long long>(Rows) * RowBytes;
+    }
+
+    m_Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(COMPOSE_CLOCK::now() - Start).count();
+}
+
+//
+// Copies dirty rects from Src, an image the size of the framebuffer, into the same place in the framebuffer.
+// Rects may overlap each other, the bytes they share are simply written twice with the same pixels.
+//
+void CPUCOMPOSITOR::ApplyDirty(const COMPOSE_RECT* Rects, unsigned RectCount, const unsigned char* Src, unsigned SrcPitch)
+{
+    if (!m_Pixels || RectCount == 0)
+    {
+        return;
+    }
+
+    COMPOSE_CLOCK::time_point Start = COMPOSE_CLOCK::now();
+
+    unsigned long long Pixels = 0;
+    int Top = static_cast<int>(m_Height);
+    int Bottom = 0;
+    for (unsigned i = 0; i < RectCount; ++i)
+    {
+        COMPOSE_RECT Clipped;
+        if (ClipRect(&Rects[i], &Clipped))
+        {
+            Pixels += static_cast<unsigned long long>(Clipped.right - Clipped.left) * (Clipped.bottom - Clipped.top);
+            Top = std::min(Top, Clipped.top);
+            Bottom = std::max(Bottom, Clipped.bottom);
+        }
+    }
+    if (Pixels == 0)
+    {
+        return;
+    }
+
+    unsigned Threads = m_Pool ? m_Pool->GetThreadCount() : 0;
+    int Rows = Bottom - Top;
+    if (Threads && Pixels >= COMPOSE_BAND_MIN_PIXELS && Rows >= 2 * COMPOSE_BAND_MIN_ROWS)
+    {
+        int Bands = static_cast<int>((Threads + 1) * COMPOSE_BANDS_PER_THREAD);
+        DIRTY_JOB Job;
+        Job.Compositor = this;
+        Job.Rects = Rects;
+        Job.RectCount = RectCount;
+        Job.Src = Src;
+        Job.SrcPitch = SrcPitch;
+        Job.Top = Top;
+        Job.RowsPerBand = std::max(static_cast<int>(COMPOSE_BAND_MIN_ROWS), (Rows + Bands - 1) / Bands);
+        m_Pool->Run(DirtyBand, &Job, static_cast<unsigned>((Rows + Job.RowsPerBand - 1) / Job.RowsPerBand));
+        ++m_BandedFrames;
+    }
+    else
+    {
+        CopyRects(Rects, RectCount, Src, SrcPitch, Top, Bottom);
+    }
+
+    ++m_Frames;
+    m_CopiedBytes += Pixels * COMPOSE_BPP;
+    m_Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(COMPOSE_CLOCK::now() - Start).count();
+}
+
+//
+// Snapshot of the running totals
+//
+void CPUCOMPOSITOR::GetStats(COMPOSE_STATS* Stats)
+{
+    Stats->Frames = m_Frames;
+    Stats->BandedFrames = m_BandedFrames;
+    Stats->MovedBytes = m_MovedBytes;
+    Stats->CopiedBytes = m_CopiedBytes;
+    Stats->Nanoseconds = m_Nanoseconds;
+}
+
+//
+// Copies one row. Long rows go through non-temporal stores so a large dirty set does not evict
+// everything else from the cache, the caller fences before the rows are read by anyone else.
+//
+void CPUCOMPOSITOR::CopyRow(unsigned char* Dest, const unsigned char* Src, size_t Bytes)
+{
+#ifdef COMPOSE_SSE2
+    if (Bytes >= COMPOSE_STREAM_MIN_BYTES)
+    {
+        size_t Head = (16 - (reinterpret_cast<size_t>(Dest) & 15)) & 15;
+        memcpy(Dest, Src, Head);
+        Dest += Head;
+        Src += Head;
+        Bytes -= Head;
+
+        size_t Lines = Bytes / 64;
+        for (size_t i = 0; i < Lines; ++i)
+        {
+            __m128i A = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src));
+            __m128i B = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 16));
+            __m128i C = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 32));
+            __m128i D = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(Dest), A);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(Dest + 16), B);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(Dest + 32), C);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(Dest + 48), D);
+            Dest += 64;
+            Src += 64;
+        }
+        Bytes -= Lines * 64;
+    }
+#endif
+
+    memcpy(Dest, Src, Bytes);
+}
+
+//
+// Band of a banded dirty copy, runs on the pool
+//
+void CPUCOMPOSITOR::DirtyBand(void* Context, unsigned Band)
+{
+    DIRTY_JOB* Job = reinterpret_cast<DIRTY_JOB*>(Context);
+    int Top = Job->Top + static_cast<int>(Band) * Job->RowsPerBand;
+    Job->Compositor->CopyRects(Job->Rects, Job->RectCount, Job->Src, Job->SrcPitch, Top, Top + Job->RowsPerBand);
+}
+
+//
+// Copies the rows of every rect that fall between Top and Bottom
+//
+void CPUCOMPOSITOR::CopyRects(const COMPOSE_RECT* Rects, unsigned RectCount, const unsigned char* Src, unsigned SrcPitch, int Top, int Bottom)
+{
+    for (unsigned i = 0; i < RectCount; ++i)
+    {
+        COMPOSE_RECT Clipped;
+        if (!ClipRect(&Rects[i], &Clipped))
+        {
+            continue;
+        }
+        Clipped.top = std::max(Clipped.top, Top);
+        Clipped.bottom = std::min(Clipped.bottom, Bottom);
+
+        size_t RowBytes = static_cast<size_t>(Clipped.right - Clipped.left) * COMPOSE_BPP;
+        size_t Column = static_cast<size_t>(Clipped.left) * COMPOSE_BPP;
+        for (int Row = Clipped.top; Row < Clipped.bottom; ++Row)
+        {
+            CopyRow(m_Pixels + static_cast<size_t>(Row) * m_Pitch + Column, Src + static_cast<size_t>(Row) * SrcPitch + Column, RowBytes);
+        }
+    }
+
+#ifdef COMPOSE_SSE2
+    _mm_sfence();
+#endif
+}
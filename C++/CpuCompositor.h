@@ -0,0 +1,160 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CPUCOMPOSITOR_H_
+#define _CPUCOMPOSITOR_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bytes per framebuffer pixel, BGRA
+#define COMPOSE_BPP 4
+
+// Framebuffer rows start on this boundary so streaming stores line up with cache lines
+#define COMPOSE_ROW_ALIGN 64
+
+// Rows shorter than this are copied with memcpy, streaming stores only pay off for long runs
+#define COMPOSE_STREAM_MIN_BYTES 256
+
+// Dirty sets covering fewer pixels than this are copied on the calling thread
+#define COMPOSE_BAND_MIN_PIXELS (512 * 1024)
+
+// Smallest band handed to a pool thread
+#define COMPOSE_BAND_MIN_ROWS 32
+
+// Most helper threads a BANDPOOL starts, the calling thread always works on a band too
+#define COMPOSE_MAX_THREADS 7
+
+//
+// Same layout as RECT and DXGI_OUTDUPL_MOVE_RECT so metadata can be handed over as is
+//
+typedef struct _COMPOSE_RECT
+{
+    int left;
+    int top;
+    int right;
+    int bottom;
+} COMPOSE_RECT;
+
+typedef struct _COMPOSE_MOVE
+{
+    int SrcX;
+    int SrcY;
+    COMPOSE_RECT Dest;
+} COMPOSE_MOVE;
+
+//
+// Running totals kept by CPUCOMPOSITOR, bytes over nanoseconds is the copy bandwidth it reached
+//
+typedef struct _COMPOSE_STATS
+{
+    unsigned long long Frames;
+    unsigned long long BandedFrames;
+    unsigned long long MovedBytes;
+    unsigned long long CopiedBytes;
+    unsigned long long Nanoseconds;
+} COMPOSE_STATS;
+
+typedef void (*BAND_PROC)(void* Context, unsigned Band);
+
+//
+// Fork-join pool for splitting one copy into bands. Run queues a job and the calling thread takes
+// bands out of it alongside the pool threads, so a pool without threads still finishes every job.
+// Any number of threads may call Run at once, their jobs are shared out in the order they came.
+//
+class BANDPOOL
+{
+    public:
+        BANDPOOL();
+        ~BANDPOOL();
+        bool Start(unsigned ThreadCount);
+        void Stop();
+        unsigned GetThreadCount();
+        void Run(BAND_PROC Proc, void* Context, unsigned BandCount);
+
+    private:
+        // Lives on the stack of the thread in Run, which waits for Active to reach 0 before returning
+        struct JOB
+        {
+            BAND_PROC Proc;
+            void* Context;
+            unsigned BandCount;
+            unsigned NextBand;
+            unsigned Active;
+        };
+
+        void WorkerLoop();
+        bool RunBand(std::unique_lock<std::mutex>& Lock, JOB* Job);
+
+    // vars
+        std::mutex m_Lock;
+        std::condition_variable m_WorkSignal;
+        std::condition_variable m_DoneSignal;
+        std::deque<JOB*> m_Jobs;
+        std::vector<std::thread> m_Threads;
+        bool m_Stopping;
+};
+
+//
+// CPU resident BGRA framebuffer of one output that frames are composed into.
+// Moves are row ordered memmoves so overlapping source and destination are safe, dirty rects are
+// copied in from a mapped frame with streaming stores and split into bands of rows across the pool
+// when there are enough pixels. Bands never share a row so they never write the same bytes.
+// Only uses the C++ standard library so it can be exercised away from Windows.
+//
+class CPUCOMPOSITOR
+{
+    public:
+        CPUCOMPOSITOR();
+        ~CPUCOMPOSITOR();
+        void SetPool(BANDPOOL* Pool);
+        bool Resize(unsigned Width, unsigned Height);
+        unsigned char* GetPixels();
+        unsigned GetPitch();
+        bool ClipRect(const COMPOSE_RECT* Rect, COMPOSE_RECT* Clipped);
+        void ApplyMoves(const COMPOSE_MOVE* Moves, unsigned MoveCount);
+        void ApplyDirty(const COMPOSE_RECT* Rects, unsigned RectCount, const unsigned char* Src, unsigned SrcPitch);
+        void GetStats(COMPOSE_STATS* Stats);
+        static void CopyRow(unsigned char* Dest, const unsigned char* Src, size_t Bytes);
+
+    private:
+        struct DIRTY_JOB
+        {
+            CPUCOMPOSITOR* Compositor;
+            const COMPOSE_RECT* Rects;
+            unsigned RectCount;
+            const unsigned char* Src;
+            unsigned SrcPitch;
+            int Top;
+            int RowsPerBand;
+        };
+
+        static void DirtyBand(void* Context, unsigned Band);
+        void CopyRects(const COMPOSE_RECT* Rects, unsigned RectCount, const unsigned char* Src, unsigned SrcPitch, int Top, int Bottom);
+
+    // vars
+        unsigned char* m_Buffer;
+        unsigned char* m_Pixels;
+        size_t m_Capacity;
+        unsigned m_Width;
+        unsigned m_Height;
+        unsigned m_Pitch;
+        BANDPOOL* m_Pool;
+
+        // Only touched by the thread composing this output
+        unsigned long long m_Frames;
+        unsigned long long m_BandedFrames;
+        unsigned long long m_MovedBytes;
+        unsigned long long m_CopiedBytes;
+        unsigned long long m_Nanoseconds;
+};
+
+#endif
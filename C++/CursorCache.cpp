@@ -0,0 +1,373 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CursorCache.h"
+
+// 64-bit FNV-1a parameters
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME        1099511628211ULL
+
+CURSORCACHE::CURSORCACHE() : m_Device(nullptr),
+                             m_DeviceContext(nullptr),
+                             m_UseCount(0),
+                             m_Staging(nullptr),
+                             m_MaskedTex(nullptr),
+                             m_MaskedShaderRes(nullptr),
+                             m_ScratchWidth(0),
+                             m_ScratchHeight(0),
+                             m_Buffer(nullptr),
+                             m_BufferSize(0),
+                             m_VertexBuffer(nullptr)
+{
+    RtlZeroMemory(m_Entries, sizeof(m_Entries));
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+CURSORCACHE::~CURSORCACHE()
+{
+    CleanRefs();
+
+    if (m_Buffer)
+    {
+        delete [] m_Buffer;
+        m_Buffer = nullptr;
+    }
+    m_BufferSize = 0;
+}
+
+//
+// Keeps references to the render device, resources are made as cursors show up
+//
+void CURSORCACHE::InitCache(_In_ ID3D11Device* Device, _In_ ID3D11DeviceContext* DeviceContext)
+{
+    m_Device = Device;
+    m_Device->AddRef();
+    m_DeviceContext = DeviceContext;
+    m_DeviceContext->AddRef();
+}
+
+//
+// Releases every D3D resource, the pixel buffer is kept since it doesn't depend on the device
+//
+void CURSORCACHE::CleanRefs()
+{
+    for (UINT i = 0; i < CURSOR_CACHE_ENTRIES; ++i)
+    {
+        ReleaseEntry(&m_Entries[i]);
+    }
+
+    ReleaseScratch();
+
+    if (m_VertexBuffer)
+    {
+        m_VertexBuffer->Release();
+        m_VertexBuffer = nullptr;
+    }
+
+    if (m_DeviceContext)
+    {
+        m_DeviceContext->Release();
+        m_DeviceContext = nullptr;
+    }
+
+    if (m_Device)
+    {
+        m_Device->Release();
+        m_Device = nullptr;
+    }
+}
+
+//
+// FNV-1a over the shape description and the shape bytes
+//
+UINT64 CURSORCACHE::HashShape(_In_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_(Size) BYTE* Buffer, UINT Size)
+{
+    UINT64 Hash = FNV_OFFSET_BASIS;
+
+    BYTE* Info = reinterpret_cast<BYTE*>(ShapeInfo);
+    for (UINT i = 0; i < sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO); ++i)
+    {
+        Hash = (Hash ^ Info[i]) * FNV_PRIME;
+    }
+
+    for (UINT i = 0; i < Size; ++i)
+    {
+        Hash = (Hash ^ Buffer[i]) * FNV_PRIME;
+    }
+
+    return Hash;
+}
+
+//
+// Releases the resources of one entry and marks it free
+//
+void CURSORCACHE::ReleaseEntry(_Inout_ CURSOR_ENTRY* Entry)
+{
+    if (Entry->ShaderResource)
+    {
+        Entry->ShaderResource->Release();
+        Entry->ShaderResource = nullptr;
+    }
+
+    if (Entry->Texture)
+    {
+        Entry->Texture->Release();
+        Entry->Texture = nullptr;
+    }
+
+    Entry->Hash = 0;
+    Entry->LastUsed = 0;
+}
+
+//
+// Makes the texture and view for the color cursor in PtrInfo
+//
+DUPL_RETURN CURSORCACHE::CreateEntry(_Inout_ CURSOR_ENTRY* Entry, _In_ PTR_INFO* PtrInfo)
+{
+    D3D11_TEXTURE2D_DESC Desc;
+    Desc.Width = PtrInfo->ShapeInfo.Width;
+    Desc.Height = PtrInfo->ShapeInfo.Height;
+    Desc.MipLevels = 1;
+    Desc.ArraySize = 1;
+    Desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    Desc.SampleDesc.Count = 1;
+    Desc.SampleDesc.Quality = 0;
+    Desc.Usage = D3D11_USAGE_IMMUTABLE;
+    Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    Desc.CPUAccessFlags = 0;
+    Desc.MiscFlags = 0;
+
+    D3D11_SUBRESOURCE_DATA InitData;
+    InitData.pSysMem = PtrInfo->PtrShapeBuffer;
+    InitData.SysMemPitch = PtrInfo->ShapeInfo.Pitch;
+    InitData.SysMemSlicePitch = 0;
+
+    HRESULT hr = m_Device->CreateTexture2D(&Desc, &InitData, &Entry->Texture);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to create mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC SDesc;
+    SDesc.Format = Desc.Format;
+    SDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    SDesc.Texture2D.MostDetailedMip = Desc.MipLevels - 1;
+    SDesc.Texture2D.MipLevels = Desc.MipLevels;
+    hr = m_Device->CreateShaderResourceView(Entry->Texture, &SDesc, &Entry->ShaderResource);
+    if (FAILED(hr))
+    {
+        ReleaseEntry(Entry);
+        return ProcessFailure(m_Device, L"Failed to create shader resource from mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    Entry->Hash = PtrInfo->ShapeHash;
+    Entry->ShapeInfo = PtrInfo->ShapeInfo;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Returns a view of the color cursor in PtrInfo, making it if it isn't cached. The view stays owned by the cache.
+//
+DUPL_RETURN CURSORCACHE::GetColorCursor(_In_ PTR_INFO* PtrInfo, _Outptr_ ID3D11ShaderResourceView** ShaderResource)
+{
+    *ShaderResource = nullptr;
+
+    // Free entries have LastUsed of zero so they are picked before any in use
+    CURSOR_ENTRY* Victim = &m_Entries[0];
+    for (UINT i = 0; i < CURSOR_CACHE_ENTRIES; ++i)
+    {
+        CURSOR_ENTRY* Entry = &m_Entries[i];
+        if (Entry->ShaderResource && Entry->Hash == PtrInfo->ShapeHash &&
+            memcmp(&Entry->ShapeInfo, &PtrInfo->ShapeInfo, sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO)) == 0)
+        {
+            Entry->LastUsed = ++m_UseCount;
+            *ShaderResource = Entry->ShaderResource;
+            ++m_Stats.Hits;
+            return DUPL_RETURN_SUCCESS;
+        }
+
+        if (Entry->LastUsed < Victim->LastUsed)
+        {
+            Victim = Entry;
+        }
+    }
+
+    ++m_Stats.Misses;
+    if (Victim->ShaderResource)
+    {
+        ReleaseEntry(Victim);
+        ++m_Stats.Evictions;
+    }
+
+    DUPL_RETURN Ret = CreateEntry(Victim, PtrInfo);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    Victim->LastUsed = ++m_UseCount;
+    *ShaderResource = Victim->ShaderResource;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Releases the monochrome and masked cursor textures
+//
+void CURSORCACHE::ReleaseScratch()
+{
+    if (m_MaskedShaderRes)
+    {
+        m_MaskedShaderRes->Release();
+        m_MaskedShaderRes = nullptr;
+    }
+
+    if (m_MaskedTex)
+    {
+        m_MaskedTex->Release();
+        m_MaskedTex = nullptr;
+    }
+
+    if (m_Staging)
+    {
+        m_Staging->Release();
+        m_Staging = nullptr;
+    }
+
+    m_ScratchWidth = 0;
+    m_ScratchHeight = 0;
+}
+
+//
+// Returns textures and a pixel buffer of at least Width by Height for building a monochrome or masked cursor.
+// Everything stays owned by the cache and is only made again when a larger cursor shows up.
+//
+DUPL_RETURN CURSORCACHE::GetMaskedScratch(UINT Width, UINT Height, _Outptr_ ID3D11Texture2D** Staging, _Outptr_ ID3D11Texture2D** Texture, _Outptr_ ID3D11ShaderResourceView** ShaderResource, _Outptr_result_bytebuffer_(Width * Height * BPP) BYTE** Buffer)
+{
+    ++m_Stats.MaskedDraws;
+
+    if (!m_Staging || Width > m_ScratchWidth || Height > m_ScratchHeight)
+    {
+        UINT NewWidth = max(Width, m_ScratchWidth);
+        UINT NewHeight = max(Height, m_ScratchHeight);
+        ReleaseScratch();
+        ++m_Stats.ScratchGrows;
+
+        D3D11_TEXTURE2D_DESC Desc;
+        Desc.Width = NewWidth;
+        Desc.Height = NewHeight;
+        Desc.MipLevels = 1;
+        Desc.ArraySize = 1;
+        Desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        Desc.SampleDesc.Count = 1;
+        Desc.SampleDesc.Quality = 0;
+        Desc.Usage = D3D11_USAGE_STAGING;
+        Desc.BindFlags = 0;
+        Desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        Desc.MiscFlags = 0;
+        HRESULT hr = m_Device->CreateTexture2D(&Desc, nullptr, &m_Staging);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed creating staging texture for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        Desc.Usage = D3D11_USAGE_DEFAULT;
+        Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        Desc.CPUAccessFlags = 0;
+        hr = m_Device->CreateTexture2D(&Desc, nullptr, &m_MaskedTex);
+        if (FAILED(hr))
+        {
+            ReleaseScratch();
+            return ProcessFailure(m_Device, L"Failed to create mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC SDesc;
+        SDesc.Format = Desc.Format;
+        SDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        SDesc.Texture2D.MostDetailedMip = Desc.MipLevels - 1;
+        SDesc.Texture2D.MipLevels = Desc.MipLevels;
+        hr = m_Device->CreateShaderResourceView(m_MaskedTex, &SDesc, &m_MaskedShaderRes);
+        if (FAILED(hr))
+        {
+            ReleaseScratch();
+            return ProcessFailure(m_Device, L"Failed to create shader resource from mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        m_ScratchWidth = NewWidth;
+        m_ScratchHeight = NewHeight;
+    }
+
+    UINT BufferSize = m_ScratchWidth * m_ScratchHeight * BPP;
+    if (BufferSize > m_BufferSize)
+    {
+        if (m_Buffer)
+        {
+            delete [] m_Buffer;
+            m_Buffer = nullptr;
+        }
+        m_BufferSize = 0;
+
+        m_Buffer = new (std::nothrow) BYTE[BufferSize];
+        if (!m_Buffer)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate memory for new mouse shape buffer.", L"Error", E_OUTOFMEMORY);
+        }
+        m_BufferSize = BufferSize;
+    }
+
+    *Staging = m_Staging;
+    *Texture = m_MaskedTex;
+    *ShaderResource = m_MaskedShaderRes;
+    *Buffer = m_Buffer;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Writes the cursor quad into the dynamic vertex buffer, which stays owned by the cache
+//
+DUPL_RETURN CURSORCACHE::SetQuad(_In_reads_(NUMVERTICES) VERTEX* Vertices, _Outptr_ ID3D11Buffer** VertexBuffer)
+{
+    *VertexBuffer = nullptr;
+
+    if (!m_VertexBuffer)
+    {
+        D3D11_BUFFER_DESC BDesc;
+        RtlZeroMemory(&BDesc, sizeof(D3D11_BUFFER_DESC));
+        BDesc.Usage = D3D11_USAGE_DYNAMIC;
+        BDesc.ByteWidth = sizeof(VERTEX) * NUMVERTICES;
+        BDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        BDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        HRESULT hr = m_Device->CreateBuffer(&BDesc, nullptr, &m_VertexBuffer);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to create mouse pointer vertex buffer in CURSORCACHE", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+    }
+
+    D3D11_MAPPED_SUBRESOURCE Mapped;
+    HRESULT hr = m_DeviceContext->Map(m_VertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &Mapped);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to map mouse pointer vertex buffer in CURSORCACHE", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+    memcpy_s(Mapped.pData, sizeof(VERTEX) * NUMVERTICES, Vertices, sizeof(VERTEX) * NUMVERTICES);
+    m_DeviceContext->Unmap(m_VertexBuffer, 0);
+
+    *VertexBuffer = m_VertexBuffer;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies out the running totals
+//
+void CURSORCACHE::GetStats(_Out_ CURSOR_CACHE_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
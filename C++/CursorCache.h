@@ -0,0 +1,84 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CURSORCACHE_H_
+#define _CURSORCACHE_H_
+
+#include "CommonTypes.h"
+
+// Color cursors kept ready to draw, the least recently drawn one is replaced first
+#define CURSOR_CACHE_ENTRIES 8
+
+//
+// Running totals kept by CURSORCACHE
+//
+typedef struct _CURSOR_CACHE_STATS
+{
+    UINT64 Hits;
+    UINT64 Misses;
+    UINT64 Evictions;
+    UINT64 MaskedDraws;
+    UINT64 ScratchGrows;
+} CURSOR_CACHE_STATS;
+
+//
+// One cached color cursor
+//
+typedef struct _CURSOR_ENTRY
+{
+    UINT64 Hash;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    ID3D11Texture2D* Texture;
+    ID3D11ShaderResourceView* ShaderResource;
+    UINT64 LastUsed;
+} CURSOR_ENTRY;
+
+//
+// Holds the D3D resources DrawMouse needs so steady state cursor drawing creates nothing.
+// Color cursors become immutable textures keyed by PTR_INFO::ShapeHash, which the capture thread
+// computes once per new shape. Monochrome and masked cursors depend on the desktop underneath so
+// they are rebuilt every frame, but in a staging texture, pixel buffer and texture that are only
+// ever grown. The cursor quad lives in one dynamic vertex buffer.
+//
+class CURSORCACHE
+{
+    public:
+        CURSORCACHE();
+        ~CURSORCACHE();
+        void InitCache(_In_ ID3D11Device* Device, _In_ ID3D11DeviceContext* DeviceContext);
+        void CleanRefs();
+        DUPL_RETURN GetColorCursor(_In_ PTR_INFO* PtrInfo, _Outptr_ ID3D11ShaderResourceView** ShaderResource);
+        DUPL_RETURN GetMaskedScratch(UINT Width, UINT Height, _Outptr_ ID3D11Texture2D** Staging, _Outptr_ ID3D11Texture2D** Texture, _Outptr_ ID3D11ShaderResourceView** ShaderResource, _Outptr_result_bytebuffer_(Width * Height * BPP) BYTE** Buffer);
+        DUPL_RETURN SetQuad(_In_reads_(NUMVERTICES) VERTEX* Vertices, _Outptr_ ID3D11Buffer** VertexBuffer);
+        void GetStats(_Out_ CURSOR_CACHE_STATS* Stats);
+        static UINT64 HashShape(_In_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_(Size) BYTE* Buffer, UINT Size);
+
+    private:
+        DUPL_RETURN CreateEntry(_Inout_ CURSOR_ENTRY* Entry, _In_ PTR_INFO* PtrInfo);
+        void ReleaseEntry(_Inout_ CURSOR_ENTRY* Entry);
+        void ReleaseScratch();
+
+    // vars
+        ID3D11Device* m_Device;
+        ID3D11DeviceContext* m_DeviceContext;
+        CURSOR_ENTRY m_Entries[CURSOR_CACHE_ENTRIES];
+        UINT64 m_UseCount;
+
+        // Monochrome and masked cursor scratch
+        ID3D11Texture2D* m_Staging;
+        ID3D11Texture2D* m_MaskedTex;
+        ID3D11ShaderResourceView* m_MaskedShaderRes;
+        UINT m_ScratchWidth;
+        UINT m_ScratchHeight;
+        _Field_size_bytes_(m_BufferSize) BYTE* m_Buffer;
+        UINT m_BufferSize;
+
+        ID3D11Buffer* m_VertexBuffer;
+        CURSOR_CACHE_STATS m_Stats;
+};
+
+#endif
@@ -0,0 +1,316 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CursorKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CURSOR_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC builds AVX2 intrinsics without any switch, GCC and Clang want the function marked
+#if defined(CURSOR_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CURSOR_AVX2_FUNC __attribute__((target("avx2")))
+#else
+#define CURSOR_AVX2_FUNC
+#endif
+
+// Alpha byte of a BGRA pixel
+#define CURSOR_ALPHA 0xFF000000u
+
+// Color bytes of a BGRA pixel
+#define CURSOR_COLOR 0x00FFFFFFu
+
+//
+// One pixel of a monochrome pointer, Bit is the index into the AND and XOR rows
+//
+static inline unsigned MonoPixel(unsigned Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned Bit)
+{
+    unsigned char Mask = static_cast<unsigned char>(0x80 >> (Bit & 7));
+    unsigned AndMask32 = (AndRow[Bit >> 3] & Mask) ? 0xFFFFFFFFu : CURSOR_ALPHA;
+    unsigned XorMask32 = (XorRow[Bit >> 3] & Mask) ? CURSOR_COLOR : 0;
+    return (Desktop & AndMask32) ^ XorMask32;
+}
+
+//
+// One pixel of a masked color pointer
+//
+static inline unsigned ColorPixel(unsigned Desktop, unsigned Shape)
+{
+    unsigned Keep = (Shape & CURSOR_ALPHA) ? 0xFFFFFFFFu : 0;
+    return ((Desktop & Keep) ^ Shape) | CURSOR_ALPHA;
+}
+
+#ifdef CURSOR_X86
+static void CpuId(int Leaf, int SubLeaf, unsigned Regs[4])
+{
+#if defined(_MSC_VER)
+    int Info[4];
+    __cpuidex(Info, Leaf, SubLeaf);
+    for (int i = 0; i < 4; ++i)
+    {
+        Regs[i] = static_cast<unsigned>(Info[i]);
+    }
+#else
+    __cpuid_count(Leaf, SubLeaf, Regs[0], Regs[1], Regs[2], Regs[3]);
+#endif
+}
+
+static unsigned long long GetXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned Low;
+    unsigned High;
+    __asm__ __volatile__("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+    return (static_cast<unsigned long long>(High) << 32) | Low;
+#endif
+}
+#endif
+
+CURSORKERNELS::CURSORKERNELS() : m_Kernel(CURSOR_KERNEL_SCALAR),
+                                 m_MonoRow(MonoRowScalar),
+                                 m_ColorRow(ColorRowScalar)
+{
+    Select(GetSupported());
+}
+
+CURSORKERNELS::~CURSORKERNELS()
+{
+}
+
+//
+// Uses the given level, or the best one below it this CPU runs
+//
+void CURSORKERNELS::Select(CURSOR_KERNEL Kernel)
+{
+    CURSOR_KERNEL Supported = GetSupported();
+    m_Kernel = (Kernel > Supported) ? Supported : Kernel;
+    m_MonoRow = GetMonoRow(m_Kernel);
+    m_ColorRow = GetColorRow(m_Kernel);
+}
+
+CURSOR_KERNEL CURSORKERNELS::GetKernel()
+{
+    return m_Kernel;
+}
+
+MONO_ROW_PROC CURSORKERNELS::GetMonoRow()
+{
+    return m_MonoRow;
+}
+
+COLOR_ROW_PROC CURSORKERNELS::GetColorRow()
+{
+    return m_ColorRow;
+}
+
+//
+// Best level the CPU has and the OS saves the registers of
+//
+CURSOR_KERNEL CURSORKERNELS::GetSupported()
+{
+#ifdef CURSOR_X86
+    unsigned Regs[4];
+    CpuId(0, 0, Regs);
+    unsigned MaxLeaf = Regs[0];
+
+    CpuId(1, 0, Regs);
+    if (!(Regs[3] & (1u << 26)))
+    {
+        return CURSOR_KERNEL_SCALAR;
+    }
+
+    // AVX2 needs AVX, OSXSAVE and the OS saving XMM and YMM state on top of the AVX2 bit itself
+    bool Avx = (Regs[2] & (1u << 28)) && (Regs[2] & (1u << 27));
+    if (!Avx || MaxLeaf < 7 || (GetXcr0() & 0x6) != 0x6)
+    {
+        return CURSOR_KERNEL_SSE2;
+    }
+
+    CpuId(7, 0, Regs);
+    return (Regs[1] & (1u << 5)) ? CURSOR_KERNEL_AVX2 : CURSOR_KERNEL_SSE2;
+#else
+    return CURSOR_KERNEL_SCALAR;
+#endif
+}
+
+MONO_ROW_PROC CURSORKERNELS::GetMonoRow(CURSOR_KERNEL Kernel)
+{
+    switch (Kernel)
+    {
+        case CURSOR_KERNEL_AVX2:
+            return MonoRowAvx2;
+        case CURSOR_KERNEL_SSE2:
+            return MonoRowSse2;
+        default:
+            return MonoRowScalar;
+    }
+}
+
+COLOR_ROW_PROC CURSORKERNELS::GetColorRow(CURSOR_KERNEL Kernel)
+{
+    switch (Kernel)
+    {
+        case CURSOR_KERNEL_AVX2:
+            return ColorRowAvx2;
+        case CURSOR_KERNEL_SSE2:
+            return ColorRowSse2;
+        default:
+            return ColorRowScalar;
+    }
+}
+
+void CURSORKERNELS::MonoRowScalar(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width)
+{
+    for (unsigned Col = 0; Col < Width; ++Col)
+    {
+        Dest[Col] = MonoPixel(Desktop[Col], AndRow, XorRow, SkipX + Col);
+    }
+}
+
+void CURSORKERNELS::ColorRowScalar(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width)
+{
+    for (unsigned Col = 0; Col < Width; ++Col)
+    {
+        Dest[Col] = ColorPixel(Desktop[Col], Shape[Col]);
+    }
+}
+
+//
+// Pixels are done one at a time until the mask bits are byte aligned, then eight at a time from one
+// AND byte and one XOR byte that are broadcast to every lane and tested against that lane's bit.
+//
+void CURSORKERNELS::MonoRowSse2(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width)
+{
+#ifdef CURSOR_X86
+    unsigned Col = 0;
+    for (; Col < Width && ((SkipX + Col) & 7); ++Col)
+    {
+        Dest[Col] = MonoPixel(Desktop[Col], AndRow, XorRow, SkipX + Col);
+    }
+
+    const __m128i HighBits = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i LowBits = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i Alpha = _mm_set1_epi32(static_cast<int>(CURSOR_ALPHA));
+    const __m128i Color = _mm_set1_epi32(static_cast<int>(CURSOR_COLOR));
+    for (; Col + 8 <= Width; Col += 8)
+    {
+        unsigned Byte = (SkipX + Col) >> 3;
+        __m128i And = _mm_set1_epi32(AndRow[Byte]);
+        __m128i Xor = _mm_set1_epi32(XorRow[Byte]);
+
+        __m128i AndMask = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(And, HighBits), HighBits), Alpha);
+        __m128i XorMask = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(Xor, HighBits), HighBits), Color);
+        __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Desktop + Col));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + Col), _mm_xor_si128(_mm_and_si128(Pixels, AndMask), XorMask));
+
+        AndMask = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(And, LowBits), LowBits), Alpha);
+        XorMask = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(Xor, LowBits), LowBits), Color);
+        Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Desktop + Col + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + Col + 4), _mm_xor_si128(_mm_and_si128(Pixels, AndMask), XorMask));
+    }
+
+    for (; Col < Width; ++Col)
+    {
+        Dest[Col] = MonoPixel(Desktop[Col], AndRow, XorRow, SkipX + Col);
+    }
+#else
+    MonoRowScalar(Dest, Desktop, AndRow, XorRow, SkipX, Width);
+#endif
+}
+
+//
+// Shape pixels with a zero alpha byte clear the desktop pixel before the XOR, which leaves the shape itself
+//
+void CURSORKERNELS::ColorRowSse2(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width)
+{
+#ifdef CURSOR_X86
+    const __m128i Alpha = _mm_set1_epi32(static_cast<int>(CURSOR_ALPHA));
+    const __m128i Zero = _mm_setzero_si128();
+    unsigned Col = 0;
+    for (; Col + 4 <= Width; Col += 4)
+    {
+        __m128i Pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Desktop + Col));
+        __m128i Src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Shape + Col));
+        __m128i Replace = _mm_cmpeq_epi32(_mm_and_si128(Src, Alpha), Zero);
+        __m128i Out = _mm_or_si128(_mm_xor_si128(_mm_andnot_si128(Replace, Pixels), Src), Alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + Col), Out);
+    }
+
+    for (; Col < Width; ++Col)
+    {
+        Dest[Col] = ColorPixel(Desktop[Col], Shape[Col]);
+    }
+#else
+    ColorRowScalar(Dest, Desktop, Shape, Width);
+#endif
+}
+
+//
+// Same as the SSE2 kernel with all eight pixels of a mask byte in one register
+//
+CURSOR_AVX2_FUNC void CURSORKERNELS::MonoRowAvx2(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width)
+{
+#ifdef CURSOR_X86
+    unsigned Col = 0;
+    for (; Col < Width && ((SkipX + Col) & 7); ++Col)
+    {
+        Dest[Col] = MonoPixel(Desktop[Col], AndRow, XorRow, SkipX + Col);
+    }
+
+    const __m256i Bits = _mm256_set_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    const __m256i Alpha = _mm256_set1_epi32(static_cast<int>(CURSOR_ALPHA));
+    const __m256i Color = _mm256_set1_epi32(static_cast<int>(CURSOR_COLOR));
+    for (; Col + 8 <= Width; Col += 8)
+    {
+        unsigned Byte = (SkipX + Col) >> 3;
+        __m256i And = _mm256_set1_epi32(AndRow[Byte]);
+        __m256i Xor = _mm256_set1_epi32(XorRow[Byte]);
+
+        __m256i AndMask = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(And, Bits), Bits), Alpha);
+        __m256i XorMask = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(Xor, Bits), Bits), Color);
+        __m256i Pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Desktop + Col));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(Dest + Col), _mm256_xor_si256(_mm256_and_si256(Pixels, AndMask), XorMask));
+    }
+
+    for (; Col < Width; ++Col)
+    {
+        Dest[Col] = MonoPixel(Desktop[Col], AndRow, XorRow, SkipX + Col);
+    }
+#else
+    MonoRowScalar(Dest, Desktop, AndRow, XorRow, SkipX, Width);
+#endif
+}
+
+CURSOR_AVX2_FUNC void CURSORKERNELS::ColorRowAvx2(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width)
+{
+#ifdef CURSOR_X86
+    const __m256i Alpha = _mm256_set1_epi32(static_cast<int>(CURSOR_ALPHA));
+    const __m256i Zero = _mm256_setzero_si256();
+    unsigned Col = 0;
+    for (; Col + 8 <= Width; Col += 8)
+    {
+        __m256i Pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Desktop + Col));
+        __m256i Src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Shape + Col));
+        __m256i Replace = _mm256_cmpeq_epi32(_mm256_and_si256(Src, Alpha), Zero);
+        __m256i Out = _mm256_or_si256(_mm256_xor_si256(_mm256_andnot_si256(Replace, Pixels), Src), Alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(Dest + Col), Out);
+    }
+
+    // Up to seven pixels are left
+    ColorRowSse2(Dest + Col, Desktop + Col, Shape + Col, Width - Col);
+#else
+    ColorRowScalar(Dest, Desktop, Shape, Width);
+#endif
+}
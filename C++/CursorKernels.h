@@ -0,0 +1,67 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _CURSORKERNELS_H_
+#define _CURSORKERNELS_H_
+
+//
+// Instruction sets the cursor kernels come in, each level needs the ones below it
+//
+typedef enum _CURSOR_KERNEL
+{
+    CURSOR_KERNEL_SCALAR = 0,
+    CURSOR_KERNEL_SSE2   = 1,
+    CURSOR_KERNEL_AVX2   = 2
+} CURSOR_KERNEL;
+
+//
+// Builds one row of a monochrome pointer over the desktop. Bit SkipX of AndRow and XorRow belongs to the
+// first pixel, a set AND bit keeps the desktop pixel and a set XOR bit inverts its color.
+//
+typedef void (*MONO_ROW_PROC)(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width);
+
+//
+// Builds one row of a masked color pointer over the desktop. Shape pixels with a non-zero alpha byte are
+// XOR'd with the desktop, the others replace it. Every result is opaque.
+//
+typedef void (*COLOR_ROW_PROC)(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width);
+
+//
+// Row kernels that combine monochrome and masked color pointers with the desktop under them.
+// Dest may be the same row as Desktop.
+// The best level the CPU and OS support is picked once, all levels give the same pixels so the
+// scalar one is the reference for the others.
+// Only uses the C++ standard library and compiler intrinsics so it can be exercised away from Windows.
+//
+class CURSORKERNELS
+{
+    public:
+        CURSORKERNELS();
+        ~CURSORKERNELS();
+        void Select(CURSOR_KERNEL Kernel);
+        CURSOR_KERNEL GetKernel();
+        MONO_ROW_PROC GetMonoRow();
+        COLOR_ROW_PROC GetColorRow();
+        static CURSOR_KERNEL GetSupported();
+        static MONO_ROW_PROC GetMonoRow(CURSOR_KERNEL Kernel);
+        static COLOR_ROW_PROC GetColorRow(CURSOR_KERNEL Kernel);
+
+    private:
+        static void MonoRowScalar(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width);
+        static void MonoRowSse2(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width);
+        static void MonoRowAvx2(unsigned* Dest, const unsigned* Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned SkipX, unsigned Width);
+        static void ColorRowScalar(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width);
+        static void ColorRowSse2(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width);
+        static void ColorRowAvx2(unsigned* Dest, const unsigned* Desktop, const unsigned* Shape, unsigned Width);
+
+    // vars
+        CURSOR_KERNEL m_Kernel;
+        MONO_ROW_PROC m_MonoRow;
+        COLOR_ROW_PROC m_ColorRow;
+};
+
+#endif
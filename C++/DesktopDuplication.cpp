@@ -7,8 +7,7 @@
 
 #include <limits.h>
 
-#include "DisplayManager.h"
-#include "DuplicationManager.h"
+#include "CaptureTask.h"
 #include "OutputManager.h"
 #include "ThreadManager.h"
 
@@ -34,6 +33,7 @@ RadiusDown = 0;
 void OnKey(unsigned vk, bool down);
 void UpdateCameraPosition(XMVECTOR & camPos);
 void UpdateRadiusAndAngle(float &radius, float &halfAngle);
+bool IsViewMoving();
 
 // Below are lists of errors expect from Dxgi API calls when a transition event like mode change, PnpStop, PnpStart
 // desktop switch, TDR or session disconnect/reconnect. In all these cases we want the application to clean up the threads that process
@@ -76,7 +76,7 @@ HRESULT EnumOutputsExpectedErrors[] = {
 //
 DWORD WINAPI DDProc(_In_ void* Param);
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
-bool ProcessCmdline(_Out_ INT* Output);
+bool ProcessCmdline(_Out_ INT* Output, _Out_ CAPTURE_OPTIONS* Capture);
 void ShowHelp();
 
 //
@@ -168,6 +168,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     UNREFERENCED_PARAMETER(lpCmdLine);
 
     INT SingleOutput;
+    CAPTURE_OPTIONS Capture;
 
     // Synchronization
     HANDLE UnexpectedErrorEvent = nullptr;
@@ -177,7 +178,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     // Window
     HWND WindowHandle = nullptr;
 
-    bool CmdResult = ProcessCmdline(&SingleOutput);
+    bool CmdResult = ProcessCmdline(&SingleOutput, &Capture);
     if (!CmdResult)
     {
         ShowHelp();
@@ -286,6 +287,17 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     bool Occluded = true;
     DYNAMIC_WAIT DynamicWait;
 
+    // Set once the loop below gives up on an unexpected error, the process then exits with a failure code
+    bool Failed = false;
+
+    // Capture statistics are written out periodically when a file was given, without the file there is nothing to run for
+    STATSEXPORTER StatsExporter;
+    if (Capture.StatsPath[0] && StatsExporter.Open(Capture.StatsPath) != DUPL_RETURN_SUCCESS)
+    {
+        SetEvent(UnexpectedErrorEvent);
+    }
+    ULONGLONG LastStatsExport = GetTickCount64();
+
     while (WM_QUIT != msg.message)
     {
         DUPL_RETURN Ret = DUPL_RETURN_SUCCESS;
@@ -306,6 +318,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         else if (WaitForSingleObjectEx(UnexpectedErrorEvent, 0, FALSE) == WAIT_OBJECT_0)
         {
             // Unexpected error occurred so exit the application
+            Failed = true;
             break;
         }
         else if (FirstTime || WaitForSingleObjectEx(ExpectedErrorEvent, 0, FALSE) == WAIT_OBJECT_0)
@@ -333,19 +346,13 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
             }
 
             // Re-initialize
-            Ret = OutMgr.InitOutput(WindowHandle, SingleOutput, &OutputCount, &DeskBounds);
+            Ret = OutMgr.InitOutput(WindowHandle, SingleOutput, &Capture, &OutputCount, &DeskBounds);
             if (Ret == DUPL_RETURN_SUCCESS)
             {
-                HANDLE SharedHandle = OutMgr.GetSharedHandle();
-                if (SharedHandle)
-                {
-                    Ret = ThreadMgr.Initialize(SingleOutput, OutputCount, UnexpectedErrorEvent, ExpectedErrorEvent, TerminateThreadsEvent, SharedHandle, &DeskBounds);
-                }
-                else
-                {
-                    DisplayMsg(L"Failed to get handle of shared surface", L"Error", S_OK);
-                    Ret = DUPL_RETURN_ERROR_UNEXPECTED;
-                }
+                Ret = ThreadMgr.Initialize(SingleOutput, OutputCount, UnexpectedErrorEvent, ExpectedErrorEvent, TerminateThreadsEvent, OutMgr.GetSurfaceTargets(), OutMgr.GetTileMap(), &DeskBounds, &Capture);
+
+                // Later sessions keep adding to the same trace
+                Capture.RecordAppend = true;
             }
 
             // We start off in occluded state and we should immediate get a occlusion status window message
@@ -359,10 +366,17 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 #ifdef VR_DESKTOP
 				
 #endif // VR_DESKTOP
-                Ret = OutMgr.UpdateApplicationWindow(ThreadMgr.GetPointerInfo(), &Occluded);
+                Ret = OutMgr.UpdateApplicationWindow(ThreadMgr.GetPointerState(), &Occluded);
             }
         }
 
+        // Snapshot the capture statistics of every output
+        if (Ret == DUPL_RETURN_SUCCESS && StatsExporter.IsOpen() && GetTickCount64() - LastStatsExport >= STATS_EXPORT_INTERVAL_MS)
+        {
+            LastStatsExport = GetTickCount64();
+            Ret = ThreadMgr.ExportStats(&StatsExporter);
+        }
+
         // Check if for errors
         if (Ret != DUPL_RETURN_SUCCESS)
         {
@@ -374,6 +388,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
             else
             {
                 // Unexpected error so exit
+                Failed = true;
                 break;
             }
         }
@@ -385,6 +400,12 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         ThreadMgr.WaitForThreadTermination();
     }
 
+    // Final totals
+    if (StatsExporter.IsOpen())
+    {
+        ThreadMgr.ExportStats(&StatsExporter);
+    }
+
     // Clean up
     CloseHandle(UnexpectedErrorEvent);
     CloseHandle(ExpectedErrorEvent);
@@ -396,7 +417,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         return static_cast<INT>(msg.wParam);
     }
 
-    return 0;
+    return Failed ? 1 : 0;
 }
 
 //
@@ -404,16 +425,30 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 //
 void ShowHelp()
 {
-    DisplayMsg(L"The following optional parameters can be used -\n  /output [all | n]\t\tto duplicate all outputs or the nth output\n  /?\t\t\tto display this help section",
+    DisplayMsg(L"The following optional parameters can be used -\n  /output [all | n]\t\tto duplicate all outputs or the nth output\n"
+               L"  /replay file\t\tto play back a capture trace instead of duplicating, file.n per output when there are several\n"
+               L"  /replayspeed [max | x]\tto play back as fast as possible or at x times the recorded rate\n"
+               L"  /record file\t\tto record a capture trace, file.n per output when there are several\n"
+               L"  /recordpixels\t\tto also record the pixels of every dirty rect\n"
+               L"  /accumulate\t\tto release frames right away and draw their changes later when the renderer is busy\n"
+               L"  /stats file\t\tto write per output capture statistics to a CSV file every second\n"
+               L"  /persurface\t\tto give every output its own shared surface so outputs don't wait on each other\n"
+               L"  /mailbox\t\tto hand every output to the renderer through three surfaces so capture and rendering never wait on each other\n"
+               L"  /workers n\t\tto capture every output on n shared worker threads instead of one thread per output\n"
+               L"  /cpucompose\t\tto compose frames on the CPU and upload only what changed, the default without a hardware device\n"
+               L"  /predict x\t\tto draw the pointer x times its predicted motion ahead of where it was last reported, 1 for full prediction\n"
+               L"  /?\t\t\tto display this help section",
                L"Proper usage", S_OK);
 }
 
 //
 // Process command line parameters
 //
-bool ProcessCmdline(_Out_ INT* Output)
+bool ProcessCmdline(_Out_ INT* Output, _Out_ CAPTURE_OPTIONS* Capture)
 {
     *Output = -1;
+    RtlZeroMemory(Capture, sizeof(CAPTURE_OPTIONS));
+    Capture->ReplaySpeed = 1.0f;
 
     // __argv and __argc are global vars set by system
     for (UINT i = 1; i < static_cast<UINT>(__argc); ++i)
@@ -436,6 +471,109 @@ bool ProcessCmdline(_Out_ INT* Output)
             }
             continue;
         }
+        else if ((strcmp(__argv[i], "-replay") == 0) ||
+                 (strcmp(__argv[i], "/replay") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc) || strcpy_s(Capture->ReplayPath, MAX_PATH, __argv[i]) != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-record") == 0) ||
+                 (strcmp(__argv[i], "/record") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc) || strcpy_s(Capture->RecordPath, MAX_PATH, __argv[i]) != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-recordpixels") == 0) ||
+                 (strcmp(__argv[i], "/recordpixels") == 0))
+        {
+            Capture->RecordPixels = true;
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-stats") == 0) ||
+                 (strcmp(__argv[i], "/stats") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc) || strcpy_s(Capture->StatsPath, MAX_PATH, __argv[i]) != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-accumulate") == 0) ||
+                 (strcmp(__argv[i], "/accumulate") == 0))
+        {
+            Capture->Accumulate = true;
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-persurface") == 0) ||
+                 (strcmp(__argv[i], "/persurface") == 0))
+        {
+            Capture->PerSurface = true;
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-mailbox") == 0) ||
+                 (strcmp(__argv[i], "/mailbox") == 0))
+        {
+            Capture->Mailbox = true;
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-cpucompose") == 0) ||
+                 (strcmp(__argv[i], "/cpucompose") == 0))
+        {
+            Capture->CpuCompose = true;
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-predict") == 0) ||
+                 (strcmp(__argv[i], "/predict") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc))
+            {
+                return false;
+            }
+            Capture->PredictPointer = static_cast<FLOAT>(atof(__argv[i]));
+            if (Capture->PredictPointer < 0.0f)
+            {
+                return false;
+            }
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-workers") == 0) ||
+                 (strcmp(__argv[i], "/workers") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc) || atoi(__argv[i]) <= 0)
+            {
+                return false;
+            }
+            Capture->Workers = static_cast<UINT>(atoi(__argv[i]));
+            continue;
+        }
+        else if ((strcmp(__argv[i], "-replayspeed") == 0) ||
+                 (strcmp(__argv[i], "/replayspeed") == 0))
+        {
+            if (++i >= static_cast<UINT>(__argc))
+            {
+                return false;
+            }
+
+            if (strcmp(__argv[i], "max") == 0)
+            {
+                Capture->ReplaySpeed = 0.0f;
+            }
+            else
+            {
+                Capture->ReplaySpeed = static_cast<FLOAT>(atof(__argv[i]));
+                if (Capture->ReplaySpeed <= 0.0f)
+                {
+                    return false;
+                }
+            }
+            continue;
+        }
         else
         {
             return false;
@@ -480,177 +618,25 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 //
 DWORD WINAPI DDProc(_In_ void* Param)
 {
-    // Classes
-    DISPLAYMANAGER DispMgr;
-    DUPLICATIONMANAGER DuplMgr;
-
-    // D3D objects
-    ID3D11Texture2D* SharedSurf = nullptr;
-    IDXGIKeyedMutex* KeyMutex = nullptr;
-
     // Data passed in from thread creation
     THREAD_DATA* TData = reinterpret_cast<THREAD_DATA*>(Param);
+    CAPTURETASK Task(TData);
 
     // Get desktop
-    DUPL_RETURN Ret;
-    HDESK CurrentDesktop = nullptr;
-    CurrentDesktop = OpenInputDesktop(0, FALSE, GENERIC_ALL);
-    if (!CurrentDesktop)
-    {
-        // We do not have access to the desktop so request a retry
-        SetEvent(TData->ExpectedErrorEvent);
-        Ret = DUPL_RETURN_ERROR_EXPECTED;
-        goto Exit;
-    }
-
-    // Attach desktop to this thread
-    bool DesktopAttached = SetThreadDesktop(CurrentDesktop) != 0;
-    CloseDesktop(CurrentDesktop);
-    CurrentDesktop = nullptr;
-    if (!DesktopAttached)
-    {
-        // We do not have access to the desktop so request a retry
-        Ret = DUPL_RETURN_ERROR_EXPECTED;
-        goto Exit;
-    }
-
-    // New display manager
-    DispMgr.InitD3D(&TData->DxRes);
-
-    // Obtain handle to sync shared Surface
-    HRESULT hr = TData->DxRes.Device->OpenSharedResource(TData->TexSharedHandle, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&SharedSurf));
-    if (FAILED (hr))
-    {
-        Ret = ProcessFailure(TData->DxRes.Device, L"Opening shared texture failed", L"Error", hr, SystemTransitionsExpectedErrors);
-        goto Exit;
-    }
-
-    hr = SharedSurf->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&KeyMutex));
-    if (FAILED(hr))
-    {
-        Ret = ProcessFailure(nullptr, L"Failed to get keyed mutex interface in spawned thread", L"Error", hr);
-        goto Exit;
-    }
-
-    // Make duplication manager
-    Ret = DuplMgr.InitDupl(TData->DxRes.Device, TData->Output);
-    if (Ret != DUPL_RETURN_SUCCESS)
+    DUPL_RETURN Ret = CAPTURETASK::AttachInputDesktop();
+    if (Ret == DUPL_RETURN_SUCCESS)
     {
-        goto Exit;
+        Ret = Task.Start();
     }
 
-    // Get output description
-    DXGI_OUTPUT_DESC DesktopDesc;
-    RtlZeroMemory(&DesktopDesc, sizeof(DXGI_OUTPUT_DESC));
-    DuplMgr.GetOutputDesc(&DesktopDesc);
-
     // Main duplication loop
-    bool WaitToProcessCurrentFrame = false;
-    FRAME_DATA CurrentData;
-
-    while ((WaitForSingleObjectEx(TData->TerminateThreadsEvent, 0, FALSE) == WAIT_TIMEOUT))
+    while (Ret == DUPL_RETURN_SUCCESS && (WaitForSingleObjectEx(TData->TerminateThreadsEvent, 0, FALSE) == WAIT_TIMEOUT))
     {
-        if (!WaitToProcessCurrentFrame)
-        {
-            // Get new frame from desktop duplication
-            bool TimeOut;
-            Ret = DuplMgr.GetFrame(&CurrentData, &TimeOut);
-            if (Ret != DUPL_RETURN_SUCCESS)
-            {
-                // An error occurred getting the next frame drop out of loop which
-                // will check if it was expected or not
-                break;
-            }
-
-            // Check for timeout
-            if (TimeOut)
-            {
-                // No new frame at the moment
-                continue;
-            }
-        }
-
-        // We have a new frame so try and process it
-        // Try to acquire keyed mutex in order to access shared surface
-        hr = KeyMutex->AcquireSync(0, 1000);
-        if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
-        {
-            // Can't use shared surface right now, try again later
-            WaitToProcessCurrentFrame = true;
-            continue;
-        }
-        else if (FAILED(hr))
-        {
-            // Generic unknown failure
-            Ret = ProcessFailure(TData->DxRes.Device, L"Unexpected error acquiring KeyMutex", L"Error", hr, SystemTransitionsExpectedErrors);
-            DuplMgr.DoneWithFrame();
-            break;
-        }
-
-        // We can now process the current frame
-        WaitToProcessCurrentFrame = false;
-
-        // Get mouse info
-        Ret = DuplMgr.GetMouse(TData->PtrInfo, &(CurrentData.FrameInfo), TData->OffsetX, TData->OffsetY);
-        if (Ret != DUPL_RETURN_SUCCESS)
-        {
-            DuplMgr.DoneWithFrame();
-            KeyMutex->ReleaseSync(1);
-            break;
-        }
-
-        // Process new frame
-        Ret = DispMgr.ProcessFrame(&CurrentData, SharedSurf, TData->OffsetX, TData->OffsetY, &DesktopDesc);
-        if (Ret != DUPL_RETURN_SUCCESS)
-        {
-            DuplMgr.DoneWithFrame();
-            KeyMutex->ReleaseSync(1);
-            break;
-        }
-
-        // Release acquired keyed mutex
-        hr = KeyMutex->ReleaseSync(1);
-        if (FAILED(hr))
-        {
-            Ret = ProcessFailure(TData->DxRes.Device, L"Unexpected error releasing the keyed mutex", L"Error", hr, SystemTransitionsExpectedErrors);
-            DuplMgr.DoneWithFrame();
-            break;
-        }
-
-        // Release frame back to desktop duplication
-        Ret = DuplMgr.DoneWithFrame();
-        if (Ret != DUPL_RETURN_SUCCESS)
-        {
-            break;
-        }
+        bool Idle;
+        Ret = Task.Step(true, &Idle);
     }
 
-Exit:
-    if (Ret != DUPL_RETURN_SUCCESS)
-    {
-        if (Ret == DUPL_RETURN_ERROR_EXPECTED)
-        {
-            // The system is in a transition state so request the duplication be restarted
-            SetEvent(TData->ExpectedErrorEvent);
-        }
-        else
-        {
-            // Unexpected error so exit the application
-            SetEvent(TData->UnexpectedErrorEvent);
-        }
-    }
-
-    if (SharedSurf)
-    {
-        SharedSurf->Release();
-        SharedSurf = nullptr;
-    }
-
-    if (KeyMutex)
-    {
-        KeyMutex->Release();
-        KeyMutex = nullptr;
-    }
+    Task.Finish(Ret);
 
     return 0;
 }
@@ -801,4 +787,13 @@ void UpdateRadiusAndAngle(float &radius, float &halfAngle)
 	if (DegreeDown) halfAngle -= 0.2f;
 	if (DegreeUp) halfAngle += 0.2f;
 	if (halfAngle >= 180) halfAngle = 180;
+}
+
+//
+// True while a key that moves the camera or reshapes the screen is held down
+//
+bool IsViewMoving()
+{
+	return MoveForward || MoveBack || MoveLeft || MoveRight || MoveUp || MoveDown ||
+		   DegreeUp || DegreeDown || RadiusUp || RadiusDown;
 }
\ No newline at end of file
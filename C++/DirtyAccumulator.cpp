@@ -0,0 +1,228 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "DirtyAccumulator.h"
+
+DIRTYACCUMULATOR::DIRTYACCUMULATOR() : m_Device(nullptr),
+                                       m_DeviceContext(nullptr),
+                                       m_Surf(nullptr),
+                                       m_Width(0),
+                                       m_Height(0),
+                                       m_PendingFrames(0),
+                                       m_HasPointerUpdate(false)
+{
+    RtlZeroMemory(&m_PointerFrameInfo, sizeof(m_PointerFrameInfo));
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+DIRTYACCUMULATOR::~DIRTYACCUMULATOR()
+{
+    if (m_Surf)
+    {
+        m_Surf->Release();
+        m_Surf = nullptr;
+    }
+
+    if (m_DeviceContext)
+    {
+        m_DeviceContext->Release();
+        m_DeviceContext = nullptr;
+    }
+
+    if (m_Device)
+    {
+        m_Device->Release();
+        m_Device = nullptr;
+    }
+}
+
+//
+// Keeps a reference to the capture thread's device, the private texture is made on the first deferred frame
+//
+void DIRTYACCUMULATOR::InitAccumulator(_In_ ID3D11Device* Device)
+{
+    m_Device = Device;
+    m_Device->AddRef();
+    m_Device->GetImmediateContext(&m_DeviceContext);
+}
+
+//
+// A frame carrying a new pointer shape has to be processed while it is still acquired
+//
+bool DIRTYACCUMULATOR::CanDefer(_In_ FRAME_DATA* Data)
+{
+    return Data->FrameInfo.PointerShapeBufferSize == 0;
+}
+
+//
+// Makes sure the private texture matches Frame, Recreated is set if it had to be made again
+//
+DUPL_RETURN DIRTYACCUMULATOR::PrepareSurface(_In_ ID3D11Texture2D* Frame, _Out_ bool* Recreated)
+{
+    *Recreated = false;
+
+    D3D11_TEXTURE2D_DESC FrameDesc;
+    Frame->GetDesc(&FrameDesc);
+    if (m_Surf && FrameDesc.Width == m_Width && FrameDesc.Height == m_Height)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    if (m_Surf)
+    {
+        m_Surf->Release();
+        m_Surf = nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC Desc;
+    RtlZeroMemory(&Desc, sizeof(Desc));
+    Desc.Width = FrameDesc.Width;
+    Desc.Height = FrameDesc.Height;
+    Desc.MipLevels = 1;
+    Desc.ArraySize = 1;
+    Desc.Format = FrameDesc.Format;
+    Desc.SampleDesc.Count = 1;
+    Desc.Usage = D3D11_USAGE_DEFAULT;
+    Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    HRESULT hr = m_Device->CreateTexture2D(&Desc, nullptr, &m_Surf);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to create texture for accumulated dirty rects", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    m_Width = FrameDesc.Width;
+    m_Height = FrameDesc.Height;
+    *Recreated = true;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies one rect of Frame into the private texture at the same place
+//
+void DIRTYACCUMULATOR::CopyRect(_In_ ID3D11Texture2D* Frame, _In_ const RECT* Rect)
+{
+    D3D11_BOX Box;
+    Box.left = Rect->left;
+    Box.top = Rect->top;
+    Box.front = 0;
+    Box.right = Rect->right;
+    Box.bottom = Rect->bottom;
+    Box.back = 1;
+
+    m_DeviceContext->CopySubresourceRegion(m_Surf, 0, Rect->left, Rect->top, 0, Frame, 0, &Box);
+}
+
+//
+// Takes over the contents of Data so the frame can be released right away
+//
+DUPL_RETURN DIRTYACCUMULATOR::Defer(_In_ FRAME_DATA* Data)
+{
+    bool Recreated;
+    DUPL_RETURN Ret = PrepareSurface(Data->Frame, &Recreated);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    RECT Frame = {0, 0, static_cast<LONG>(m_Width), static_cast<LONG>(m_Height)};
+    if (Recreated && !m_Pending.IsEmpty())
+    {
+        // Pending content was lost with the old texture so take the whole frame
+        CopyRect(Data->Frame, &Frame);
+        Ret = m_Pending.SetRect(&Frame);
+    }
+    else if (Data->FrameInfo.TotalMetadataBufferSize)
+    {
+        // The frame already holds the result of a move so moved areas are handled like dirty ones,
+        // the region drops the overlap between rects so each pixel is copied once
+        Ret = m_FrameRegion.SetFromMetadata(Data);
+        if (Ret == DUPL_RETURN_SUCCESS)
+        {
+            Ret = m_FrameRegion.IntersectRect(&Frame);
+        }
+        if (Ret == DUPL_RETURN_SUCCESS)
+        {
+            UINT BoxCount;
+            const RECT* Boxes = m_FrameRegion.GetRects(&BoxCount);
+            for (UINT i = 0; i < BoxCount; ++i)
+            {
+                CopyRect(Data->Frame, &Boxes[i]);
+            }
+            Ret = m_Pending.Combine(&m_FrameRegion, REGION_OP_UNION);
+        }
+        m_Stats.RectsDeferred += Data->MoveCount + Data->DirtyCount;
+    }
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    // Only the newest pointer position matters
+    if (Data->FrameInfo.LastMouseUpdateTime.QuadPart)
+    {
+        m_PointerFrameInfo = Data->FrameInfo;
+        m_HasPointerUpdate = true;
+    }
+
+    ++m_PendingFrames;
+    ++m_Stats.DeferredFrames;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Whether anything is waiting to be drawn
+//
+bool DIRTYACCUMULATOR::HasPending()
+{
+    return !m_Pending.IsEmpty() || m_HasPointerUpdate;
+}
+
+//
+// Fills Data with a dirty-only frame covering everything deferred so far, valid until Clear or Defer
+//
+void DIRTYACCUMULATOR::GetPendingFrame(_Out_ FRAME_DATA* Data)
+{
+    RtlZeroMemory(Data, sizeof(FRAME_DATA));
+    if (m_HasPointerUpdate)
+    {
+        Data->FrameInfo = m_PointerFrameInfo;
+    }
+
+    UINT BoxCount;
+    const RECT* Boxes = m_Pending.GetRects(&BoxCount);
+    Data->FrameInfo.AccumulatedFrames = m_PendingFrames;
+    Data->FrameInfo.PointerShapeBufferSize = 0;
+    Data->FrameInfo.TotalMetadataBufferSize = BoxCount * sizeof(RECT);
+
+    Data->Frame = m_Surf;
+    Data->MetaData = reinterpret_cast<BYTE*>(const_cast<RECT*>(Boxes));
+    Data->DirtyCount = BoxCount;
+    Data->MoveCount = 0;
+
+    ++m_Stats.Flushes;
+    m_Stats.RectsFlushed += BoxCount;
+}
+
+//
+// Forgets what was pending, call once the pending frame has been drawn
+//
+void DIRTYACCUMULATOR::Clear()
+{
+    m_Pending.Clear();
+    m_PendingFrames = 0;
+    m_HasPointerUpdate = false;
+}
+
+//
+// Copies out the running totals
+//
+void DIRTYACCUMULATOR::GetStats(_Out_ ACCUMULATE_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
@@ -0,0 +1,67 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _DIRTYACCUMULATOR_H_
+#define _DIRTYACCUMULATOR_H_
+
+#include "CommonTypes.h"
+#include "Region.h"
+
+// How long DDProc waits for the shared surface before deferring a frame
+#define ACCUMULATE_SYNC_TIMEOUT_MS 2
+
+//
+// Running totals kept by DIRTYACCUMULATOR
+//
+typedef struct _ACCUMULATE_STATS
+{
+    UINT64 DeferredFrames;
+    UINT64 Flushes;
+    UINT64 RectsDeferred;
+    UINT64 RectsFlushed;
+} ACCUMULATE_STATS;
+
+//
+// Lets the capture thread give a frame back to DXGI while the shared surface is busy.
+// The dirty and moved areas of a deferred frame are copied into a private texture and added to a
+// pending region, later frames add to both, and once the shared surface is free the private
+// texture is drawn with the region's boxes as one dirty-only frame. Pointer positions are carried
+// along; a frame with a new pointer shape cannot be deferred since the shape is only readable
+// while the frame is held.
+//
+class DIRTYACCUMULATOR
+{
+    public:
+        DIRTYACCUMULATOR();
+        ~DIRTYACCUMULATOR();
+        void InitAccumulator(_In_ ID3D11Device* Device);
+        bool CanDefer(_In_ FRAME_DATA* Data);
+        DUPL_RETURN Defer(_In_ FRAME_DATA* Data);
+        bool HasPending();
+        void GetPendingFrame(_Out_ FRAME_DATA* Data);
+        void Clear();
+        void GetStats(_Out_ ACCUMULATE_STATS* Stats);
+
+    private:
+        DUPL_RETURN PrepareSurface(_In_ ID3D11Texture2D* Frame, _Out_ bool* Recreated);
+        void CopyRect(_In_ ID3D11Texture2D* Frame, _In_ const RECT* Rect);
+
+    // vars
+        ID3D11Device* m_Device;
+        ID3D11DeviceContext* m_DeviceContext;
+        ID3D11Texture2D* m_Surf;
+        UINT m_Width;
+        UINT m_Height;
+        REGION m_Pending;
+        REGION m_FrameRegion;
+        UINT m_PendingFrames;
+        bool m_HasPointerUpdate;
+        DXGI_OUTDUPL_FRAME_INFO m_PointerFrameInfo;
+        ACCUMULATE_STATS m_Stats;
+};
+
+#endif
@@ -19,8 +19,13 @@ DISPLAYMANAGER::DISPLAYMANAGER() : m_Device(nullptr),
                                    m_InputLayout(nullptr),
                                    m_RTV(nullptr),
                                    m_SamplerLinear(nullptr),
-                                   m_DirtyVertexBufferAlloc(nullptr),
-                                   m_DirtyVertexBufferAllocSize(0)
+                                   m_Arena(nullptr),
+                                   m_TileMap(nullptr),
+                                   m_TileOffsetX(0),
+                                   m_TileOffsetY(0),
+                                   m_Generation(0),
+                                   m_CpuCompose(false),
+                                   m_CpuStaging(nullptr)
 {
 }
 
@@ -30,12 +35,6 @@ DISPLAYMANAGER::DISPLAYMANAGER() : m_Device(nullptr),
 DISPLAYMANAGER::~DISPLAYMANAGER()
 {
     CleanRefs();
-
-    if (m_DirtyVertexBufferAlloc)
-    {
-        delete [] m_DirtyVertexBufferAlloc;
-        m_DirtyVertexBufferAlloc = nullptr;
-    }
 }
 
 //
@@ -71,6 +70,18 @@ DUPL_RETURN DISPLAYMANAGER::ProcessFrame(_In_ FRAME_DATA* Data, _Inout_ ID3D11Te
         D3D11_TEXTURE2D_DESC Desc;
         Data->Frame->GetDesc(&Desc);
 
+        // Everything this frame draws is stamped with one generation
+        if (m_TileMap)
+        {
+            m_Generation = m_TileMap->NextGeneration();
+        }
+
+        // Rotated outputs need their pixels turned which only the shader path does
+        if (m_CpuCompose && (DeskDesc->Rotation == DXGI_MODE_ROTATION_IDENTITY || DeskDesc->Rotation == DXGI_MODE_ROTATION_UNSPECIFIED))
+        {
+            return ComposeOnCpu(Data, SharedSurf, OffsetX, OffsetY, DeskDesc, &Desc);
+        }
+
         if (Data->MoveCount)
         {
             Ret = CopyMove(SharedSurf, reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(Data->MetaData), Data->MoveCount, OffsetX, OffsetY, DeskDesc, Desc.Width, Desc.Height);
@@ -82,13 +93,78 @@ DUPL_RETURN DISPLAYMANAGER::ProcessFrame(_In_ FRAME_DATA* Data, _Inout_ ID3D11Te
 
         if (Data->DirtyCount)
         {
-            Ret = CopyDirty(Data->Frame, SharedSurf, reinterpret_cast<RECT*>(Data->MetaData + (Data->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT))), Data->DirtyCount, OffsetX, OffsetY, DeskDesc);
+            // Merge fragmented dirty rects before building vertices for them
+            RECT* DirtyRects;
+            UINT DirtyCount;
+            Ret = m_Coalescer.Coalesce(reinterpret_cast<RECT*>(Data->MetaData + (Data->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT))), Data->DirtyCount, Desc.Width, Desc.Height, &DirtyRects, &DirtyCount);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+
+            if (DirtyCount)
+            {
+                Ret = CopyDirty(Data->Frame, SharedSurf, DirtyRects, DirtyCount, OffsetX, OffsetY, DeskDesc);
+            }
         }
     }
 
     return Ret;
 }
 
+//
+// Returns dirty rect coalescing totals for this output
+//
+void DISPLAYMANAGER::GetCoalesceStats(_Out_ COALESCE_STATS* Stats)
+{
+    m_Coalescer.GetStats(Stats);
+}
+
+//
+// Per frame scratch buffers come from Arena, must be set before the first ProcessFrame
+//
+void DISPLAYMANAGER::SetArena(_In_ CAPTUREARENA* Arena)
+{
+    m_Arena = Arena;
+    m_Coalescer.SetArena(Arena);
+}
+
+//
+// Shared surface tiles that frames draw over are stamped in TileMap, nullptr to not track them.
+// OffsetX and OffsetY move surface coordinates into the tile map's, they are non-zero when each output has its own surface.
+//
+void DISPLAYMANAGER::SetTileMap(_In_opt_ TILEMAP* TileMap, INT OffsetX, INT OffsetY)
+{
+    m_TileMap = TileMap;
+    m_TileOffsetX = OffsetX;
+    m_TileOffsetY = OffsetY;
+}
+
+//
+// Returns move planning totals for this output
+//
+void DISPLAYMANAGER::GetMovePlanStats(_Out_ MOVE_PLAN_STATS* Stats)
+{
+    m_MovePlanner.GetStats(Stats);
+}
+
+//
+// Frames of unrotated outputs are composed on the CPU when CpuCompose is set, large dirty sets are split across Pool
+//
+void DISPLAYMANAGER::SetCpuCompose(bool CpuCompose, _In_opt_ BANDPOOL* Pool)
+{
+    m_CpuCompose = CpuCompose;
+    m_Compositor.SetPool(Pool);
+}
+
+//
+// Returns CPU composition totals for this output
+//
+void DISPLAYMANAGER::GetComposeStats(_Out_ COMPOSE_STATS* Stats)
+{
+    m_Compositor.GetStats(Stats);
+}
+
 //
 // Returns D3D device being used
 //
@@ -168,50 +244,91 @@ void DISPLAYMANAGER::SetMoveRect(_Out_ RECT* SrcRect, _Out_ RECT* DestRect, _In_
 //
 DUPL_RETURN DISPLAYMANAGER::CopyMove(_Inout_ ID3D11Texture2D* SharedSurf, _In_reads_(MoveCount) DXGI_OUTDUPL_MOVE_RECT* MoveBuffer, UINT MoveCount, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc, INT TexWidth, INT TexHeight)
 {
-    D3D11_TEXTURE2D_DESC FullDesc;
-    SharedSurf->GetDesc(&FullDesc);
+    MOVE_STEP Steps[MOVE_PLAN_MAX_STEPS];
 
-    // Make new intermediate surface to copy into for moving
-    if (!m_MoveSurf)
+    // Output origin within the shared surface
+    INT OriginX = DeskDesc->DesktopCoordinates.left - OffsetX;
+    INT OriginY = DeskDesc->DesktopCoordinates.top - OffsetY;
+
+    // Space for the rotated source and destination rects
+    BYTE* MoveRectBuffer;
+    DUPL_RETURN Ret = m_Arena->Reserve(ARENA_SLOT_MOVE_RECTS, MoveCount * 2 * sizeof(RECT), &MoveRectBuffer);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        D3D11_TEXTURE2D_DESC MoveDesc;
-        MoveDesc = FullDesc;
-        MoveDesc.Width = DeskDesc->DesktopCoordinates.right - DeskDesc->DesktopCoordinates.left;
-        MoveDesc.Height = DeskDesc->DesktopCoordinates.bottom - DeskDesc->DesktopCoordinates.top;
-        MoveDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
-        MoveDesc.MiscFlags = 0;
-        HRESULT hr = m_Device->CreateTexture2D(&MoveDesc, nullptr, &m_MoveSurf);
-        if (FAILED(hr))
+        return Ret;
+    }
+
+    RECT* SrcRects = reinterpret_cast<RECT*>(MoveRectBuffer);
+    RECT* DestRects = SrcRects + MoveCount;
+    m_Transform.PrepareMoves(DeskDesc->Rotation, TexWidth, TexHeight);
+    m_Transform.TransformMoves(MoveBuffer, MoveCount, SrcRects, DestRects);
+
+    for (UINT i = 0; i < MoveCount; ++i)
+    {
+        RECT SrcRect = SrcRects[i];
+        RECT DestRect = DestRects[i];
+
+#ifdef _DEBUG
+        // Batched transform must agree with the per rect version
+        RECT CheckSrc;
+        RECT CheckDest;
+        SetMoveRect(&CheckSrc, &CheckDest, DeskDesc, &(MoveBuffer[i]), TexWidth, TexHeight);
+        assert(EqualRect(&CheckSrc, &SrcRect) && EqualRect(&CheckDest, &DestRect));
+#endif
+
+        // Plan in shared surface coordinates
+        OffsetRect(&SrcRect, OriginX, OriginY);
+        OffsetRect(&DestRect, OriginX, OriginY);
+        UINT StepCount = m_MovePlanner.PlanMove(&SrcRect, &DestRect, Steps);
+
+        for (UINT j = 0; j < StepCount; ++j)
         {
-            return ProcessFailure(m_Device, L"Failed to create staging texture for move rects", L"Error", hr, SystemTransitionsExpectedErrors);
+            D3D11_BOX Box;
+            Box.left = Steps[j].Src.left;
+            Box.top = Steps[j].Src.top;
+            Box.front = 0;
+            Box.right = Steps[j].Src.right;
+            Box.bottom = Steps[j].Src.bottom;
+            Box.back = 1;
+
+            if (!Steps[j].Staged)
+            {
+                // Source and destination don't overlap so copy within the shared surface
+                m_DeviceContext->CopySubresourceRegion(SharedSurf, 0, Steps[j].Dest.x, Steps[j].Dest.y, 0, SharedSurf, 0, &Box);
+                continue;
+            }
+
+            // Make new intermediate surface to copy into for moving
+            if (!m_MoveSurf)
+            {
+                D3D11_TEXTURE2D_DESC MoveDesc;
+                SharedSurf->GetDesc(&MoveDesc);
+                MoveDesc.Width = DeskDesc->DesktopCoordinates.right - DeskDesc->DesktopCoordinates.left;
+                MoveDesc.Height = DeskDesc->DesktopCoordinates.bottom - DeskDesc->DesktopCoordinates.top;
+                MoveDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+                MoveDesc.MiscFlags = 0;
+                HRESULT hr = m_Device->CreateTexture2D(&MoveDesc, nullptr, &m_MoveSurf);
+                if (FAILED(hr))
+                {
+                    return ProcessFailure(m_Device, L"Failed to create staging texture for move rects", L"Error", hr, SystemTransitionsExpectedErrors);
+                }
+            }
+
+            // Copy rect out of shared surface
+            m_DeviceContext->CopySubresourceRegion(m_MoveSurf, 0, Steps[j].Src.left - OriginX, Steps[j].Src.top - OriginY, 0, SharedSurf, 0, &Box);
+
+            // Copy back to shared surface
+            Box.left = Steps[j].Src.left - OriginX;
+            Box.top = Steps[j].Src.top - OriginY;
+            Box.right = Steps[j].Src.right - OriginX;
+            Box.bottom = Steps[j].Src.bottom - OriginY;
+            m_DeviceContext->CopySubresourceRegion(SharedSurf, 0, Steps[j].Dest.x, Steps[j].Dest.y, 0, m_MoveSurf, 0, &Box);
         }
     }
 
-    for (UINT i = 0; i < MoveCount; ++i)
+    if (m_TileMap)
     {
-        RECT SrcRect;
-        RECT DestRect;
-
-        SetMoveRect(&SrcRect, &DestRect, DeskDesc, &(MoveBuffer[i]), TexWidth, TexHeight);
-
-        // Copy rect out of shared surface
-        D3D11_BOX Box;
-        Box.left = SrcRect.left + DeskDesc->DesktopCoordinates.left - OffsetX;
-        Box.top = SrcRect.top + DeskDesc->DesktopCoordinates.top - OffsetY;
-        Box.front = 0;
-        Box.right = SrcRect.right + DeskDesc->DesktopCoordinates.left - OffsetX;
-        Box.bottom = SrcRect.bottom + DeskDesc->DesktopCoordinates.top - OffsetY;
-        Box.back = 1;
-        m_DeviceContext->CopySubresourceRegion(m_MoveSurf, 0, SrcRect.left, SrcRect.top, 0, SharedSurf, 0, &Box);
-
-        // Copy back to shared surface
-        Box.left = SrcRect.left;
-        Box.top = SrcRect.top;
-        Box.front = 0;
-        Box.right = SrcRect.right;
-        Box.bottom = SrcRect.bottom;
-        Box.back = 1;
-        m_DeviceContext->CopySubresourceRegion(SharedSurf, 0, DestRect.left + DeskDesc->DesktopCoordinates.left - OffsetX, DestRect.top + DeskDesc->DesktopCoordinates.top - OffsetY, 0, m_MoveSurf, 0, &Box);
+        m_TileMap->MarkRects(DestRects, MoveCount, OriginX + m_TileOffsetX, OriginY + m_TileOffsetY, m_Generation);
     }
 
     return DUPL_RETURN_SUCCESS;
@@ -356,31 +473,48 @@ DUPL_RETURN DISPLAYMANAGER::CopyDirty(_In_ ID3D11Texture2D* SrcSurface, _Inout_
     m_DeviceContext->PSSetSamplers(0, 1, &m_SamplerLinear);
     m_DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    // Create space for vertices for the dirty rects if the current space isn't large enough
+    // Space for vertices for the dirty rects
     UINT BytesNeeded = sizeof(VERTEX) * NUMVERTICES * DirtyCount;
-    if (BytesNeeded > m_DirtyVertexBufferAllocSize)
+    BYTE* DirtyVertexBuffer;
+    DUPL_RETURN Ret = m_Arena->Reserve(ARENA_SLOT_DIRTY_VERTICES, BytesNeeded, &DirtyVertexBuffer);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        if (m_DirtyVertexBufferAlloc)
-        {
-            delete [] m_DirtyVertexBufferAlloc;
-        }
+        ShaderResource->Release();
+        ShaderResource = nullptr;
+        return Ret;
+    }
+
+    // Fill them in
+    VERTEX* DirtyVertex = reinterpret_cast<VERTEX*>(DirtyVertexBuffer);
+    m_Transform.PrepareDirty(DeskDesc, OffsetX, OffsetY, &FullDesc, &ThisDesc);
+    m_Transform.TransformDirty(DirtyBuffer, DirtyCount, DirtyVertex);
 
-        m_DirtyVertexBufferAlloc = new (std::nothrow) BYTE[BytesNeeded];
-        if (!m_DirtyVertexBufferAlloc)
+    // Stamp the tiles the rects are drawn over
+    if (m_TileMap)
+    {
+        BYTE* DamageBuffer;
+        Ret = m_Arena->Reserve(ARENA_SLOT_DAMAGE_RECTS, DirtyCount * sizeof(RECT), &DamageBuffer);
+        if (Ret != DUPL_RETURN_SUCCESS)
         {
-            m_DirtyVertexBufferAllocSize = 0;
-            return ProcessFailure(nullptr, L"Failed to allocate memory for dirty vertex buffer.", L"Error", E_OUTOFMEMORY);
+            ShaderResource->Release();
+            ShaderResource = nullptr;
+            return Ret;
         }
 
-        m_DirtyVertexBufferAllocSize = BytesNeeded;
+        RECT* DamageRects = reinterpret_cast<RECT*>(DamageBuffer);
+        m_Transform.TransformDirtyRects(DirtyBuffer, DirtyCount, DamageRects);
+        m_TileMap->MarkRects(DamageRects, DirtyCount, DeskDesc->DesktopCoordinates.left - OffsetX + m_TileOffsetX, DeskDesc->DesktopCoordinates.top - OffsetY + m_TileOffsetY, m_Generation);
     }
 
-    // Fill them in
-    VERTEX* DirtyVertex = reinterpret_cast<VERTEX*>(m_DirtyVertexBufferAlloc);
+#ifdef _DEBUG
+    // Batched transform must agree with the per rect version
     for (UINT i = 0; i < DirtyCount; ++i, DirtyVertex += NUMVERTICES)
     {
-        SetDirtyVert(DirtyVertex, &(DirtyBuffer[i]), OffsetX, OffsetY, DeskDesc, &FullDesc, &ThisDesc);
+        VERTEX Check[NUMVERTICES];
+        SetDirtyVert(Check, &(DirtyBuffer[i]), OffsetX, OffsetY, DeskDesc, &FullDesc, &ThisDesc);
+        assert(memcmp(Check, DirtyVertex, sizeof(Check)) == 0);
     }
+#endif
 
     // Create vertex buffer
     D3D11_BUFFER_DESC BufferDesc;
@@ -391,7 +525,7 @@ DUPL_RETURN DISPLAYMANAGER::CopyDirty(_In_ ID3D11Texture2D* SrcSurface, _Inout_
     BufferDesc.CPUAccessFlags = 0;
     D3D11_SUBRESOURCE_DATA InitData;
     RtlZeroMemory(&InitData, sizeof(InitData));
-    InitData.pSysMem = m_DirtyVertexBufferAlloc;
+    InitData.pSysMem = DirtyVertexBuffer;
 
     ID3D11Buffer* VertBuf = nullptr;
     hr = m_Device->CreateBuffer(&BufferDesc, &InitData, &VertBuf);
@@ -423,6 +557,136 @@ DUPL_RETURN DISPLAYMANAGER::CopyDirty(_In_ ID3D11Texture2D* SrcSurface, _Inout_
     return DUPL_RETURN_SUCCESS;
 }
 
+//
+// Composes a frame in the CPU framebuffer: dirty rects are read back through a staging texture,
+// moves and dirty rects are applied on the CPU and the rects they touched are uploaded to the shared surface
+//
+DUPL_RETURN DISPLAYMANAGER::ComposeOnCpu(_In_ FRAME_DATA* Data, _Inout_ ID3D11Texture2D* SharedSurf, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc, _In_ D3D11_TEXTURE2D_DESC* FrameDesc)
+{
+    static_assert(sizeof(COMPOSE_RECT) == sizeof(RECT), "COMPOSE_RECT must match RECT");
+    static_assert(sizeof(COMPOSE_MOVE) == sizeof(DXGI_OUTDUPL_MOVE_RECT), "COMPOSE_MOVE must match DXGI_OUTDUPL_MOVE_RECT");
+
+    if (!m_Compositor.Resize(FrameDesc->Width, FrameDesc->Height))
+    {
+        return ProcessFailure(nullptr, L"Failed to allocate CPU framebuffer", L"Error", E_OUTOFMEMORY);
+    }
+
+    // Staging copy of the frame, made again if the output changed size
+    if (m_CpuStaging)
+    {
+        D3D11_TEXTURE2D_DESC StagingDesc;
+        m_CpuStaging->GetDesc(&StagingDesc);
+        if (StagingDesc.Width != FrameDesc->Width || StagingDesc.Height != FrameDesc->Height)
+        {
+            m_CpuStaging->Release();
+            m_CpuStaging = nullptr;
+        }
+    }
+    if (!m_CpuStaging)
+    {
+        D3D11_TEXTURE2D_DESC StagingDesc = *FrameDesc;
+        StagingDesc.MipLevels = 1;
+        StagingDesc.ArraySize = 1;
+        StagingDesc.Usage = D3D11_USAGE_STAGING;
+        StagingDesc.BindFlags = 0;
+        StagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        StagingDesc.MiscFlags = 0;
+        HRESULT hr = m_Device->CreateTexture2D(&StagingDesc, nullptr, &m_CpuStaging);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to create staging texture for CPU composition", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+    }
+
+    // Output origin within the shared surface
+    INT OriginX = DeskDesc->DesktopCoordinates.left - OffsetX;
+    INT OriginY = DeskDesc->DesktopCoordinates.top - OffsetY;
+
+    // Moves first, they read what the previous frames left in the framebuffer
+    DXGI_OUTDUPL_MOVE_RECT* MoveBuffer = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(Data->MetaData);
+    m_Compositor.ApplyMoves(reinterpret_cast<COMPOSE_MOVE*>(MoveBuffer), Data->MoveCount);
+
+    RECT* DirtyRects = nullptr;
+    UINT DirtyCount = 0;
+    if (Data->DirtyCount)
+    {
+        DUPL_RETURN Ret = m_Coalescer.Coalesce(reinterpret_cast<RECT*>(Data->MetaData + (Data->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT))), Data->DirtyCount, FrameDesc->Width, FrameDesc->Height, &DirtyRects, &DirtyCount);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+
+    if (DirtyCount)
+    {
+        // Only the dirty parts of the frame are read back
+        for (UINT i = 0; i < DirtyCount; ++i)
+        {
+            D3D11_BOX Box;
+            Box.left = DirtyRects[i].left;
+            Box.top = DirtyRects[i].top;
+            Box.front = 0;
+            Box.right = DirtyRects[i].right;
+            Box.bottom = DirtyRects[i].bottom;
+            Box.back = 1;
+            m_DeviceContext->CopySubresourceRegion(m_CpuStaging, 0, DirtyRects[i].left, DirtyRects[i].top, 0, Data->Frame, 0, &Box);
+        }
+
+        D3D11_MAPPED_SUBRESOURCE Mapped;
+        HRESULT hr = m_DeviceContext->Map(m_CpuStaging, 0, D3D11_MAP_READ, 0, &Mapped);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to map staging texture for CPU composition", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+        m_Compositor.ApplyDirty(reinterpret_cast<COMPOSE_RECT*>(DirtyRects), DirtyCount, reinterpret_cast<unsigned char*>(Mapped.pData), Mapped.RowPitch);
+        m_DeviceContext->Unmap(m_CpuStaging, 0);
+    }
+
+    // Upload what changed, moved rects first since dirty rects may cover part of them
+    for (UINT i = 0; i < Data->MoveCount; ++i)
+    {
+        UploadRect(SharedSurf, &MoveBuffer[i].DestinationRect, OriginX, OriginY);
+        if (m_TileMap)
+        {
+            m_TileMap->MarkRects(&MoveBuffer[i].DestinationRect, 1, OriginX + m_TileOffsetX, OriginY + m_TileOffsetY, m_Generation);
+        }
+    }
+
+    for (UINT i = 0; i < DirtyCount; ++i)
+    {
+        UploadRect(SharedSurf, &DirtyRects[i], OriginX, OriginY);
+    }
+    if (m_TileMap && DirtyCount)
+    {
+        m_TileMap->MarkRects(DirtyRects, DirtyCount, OriginX + m_TileOffsetX, OriginY + m_TileOffsetY, m_Generation);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies a rect of the CPU framebuffer to the same place of the output in the shared surface
+//
+void DISPLAYMANAGER::UploadRect(_Inout_ ID3D11Texture2D* SharedSurf, _In_ RECT* Rect, INT OriginX, INT OriginY)
+{
+    COMPOSE_RECT Clipped;
+    if (!m_Compositor.ClipRect(reinterpret_cast<COMPOSE_RECT*>(Rect), &Clipped))
+    {
+        return;
+    }
+
+    D3D11_BOX Box;
+    Box.left = Clipped.left + OriginX;
+    Box.top = Clipped.top + OriginY;
+    Box.front = 0;
+    Box.right = Clipped.right + OriginX;
+    Box.bottom = Clipped.bottom + OriginY;
+    Box.back = 1;
+
+    BYTE* Pixels = m_Compositor.GetPixels() + (Clipped.top * m_Compositor.GetPitch()) + (Clipped.left * COMPOSE_BPP);
+    m_DeviceContext->UpdateSubresource(SharedSurf, 0, &Box, Pixels, m_Compositor.GetPitch(), 0);
+}
+
 //
 // Clean all references
 //
@@ -446,6 +710,12 @@ void DISPLAYMANAGER::CleanRefs()
         m_MoveSurf = nullptr;
     }
 
+    if (m_CpuStaging)
+    {
+        m_CpuStaging->Release();
+        m_CpuStaging = nullptr;
+    }
+
     if (m_VertexShader)
     {
         m_VertexShader->Release();
@@ -8,7 +8,12 @@
 #ifndef _DISPLAYMANAGER_H_
 #define _DISPLAYMANAGER_H_
 
-#include "CommonTypes.h"
+#include "CaptureArena.h"
+#include "CpuCompositor.h"
+#include "MovePlanner.h"
+#include "RectCoalescer.h"
+#include "RectTransform.h"
+#include "TileMap.h"
 
 //
 // Handles the task of processing frames
@@ -19,8 +24,14 @@ class DISPLAYMANAGER
         DISPLAYMANAGER();
         ~DISPLAYMANAGER();
         void InitD3D(DX_RESOURCES* Data);
+        void SetArena(_In_ CAPTUREARENA* Arena);
+        void SetTileMap(_In_opt_ TILEMAP* TileMap, INT OffsetX, INT OffsetY);
+        void SetCpuCompose(bool CpuCompose, _In_opt_ BANDPOOL* Pool);
         ID3D11Device* GetDevice();
         DUPL_RETURN ProcessFrame(_In_ FRAME_DATA* Data, _Inout_ ID3D11Texture2D* SharedSurf, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc);
+        void GetCoalesceStats(_Out_ COALESCE_STATS* Stats);
+        void GetMovePlanStats(_Out_ MOVE_PLAN_STATS* Stats);
+        void GetComposeStats(_Out_ COMPOSE_STATS* Stats);
         void CleanRefs();
 
     private:
@@ -28,6 +39,8 @@ class DISPLAYMANAGER
         DUPL_RETURN CopyDirty(_In_ ID3D11Texture2D* SrcSurface, _Inout_ ID3D11Texture2D* SharedSurf, _In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc);
         DUPL_RETURN CopyMove(_Inout_ ID3D11Texture2D* SharedSurf, _In_reads_(MoveCount) DXGI_OUTDUPL_MOVE_RECT* MoveBuffer, UINT MoveCount, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc, INT TexWidth, INT TexHeight);
         void SetDirtyVert(_Out_writes_(NUMVERTICES) VERTEX* Vertices, _In_ RECT* Dirty, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc, _In_ D3D11_TEXTURE2D_DESC* FullDesc, _In_ D3D11_TEXTURE2D_DESC* ThisDesc);
+        DUPL_RETURN ComposeOnCpu(_In_ FRAME_DATA* Data, _Inout_ ID3D11Texture2D* SharedSurf, INT OffsetX, INT OffsetY, _In_ DXGI_OUTPUT_DESC* DeskDesc, _In_ D3D11_TEXTURE2D_DESC* FrameDesc);
+        void UploadRect(_Inout_ ID3D11Texture2D* SharedSurf, _In_ RECT* Rect, INT OriginX, INT OriginY);
         void SetMoveRect(_Out_ RECT* SrcRect, _Out_ RECT* DestRect, _In_ DXGI_OUTPUT_DESC* DeskDesc, _In_ DXGI_OUTDUPL_MOVE_RECT* MoveRect, INT TexWidth, INT TexHeight);
 
     // variables
@@ -39,8 +52,20 @@ class DISPLAYMANAGER
         ID3D11InputLayout* m_InputLayout;
         ID3D11RenderTargetView* m_RTV;
         ID3D11SamplerState* m_SamplerLinear;
-        BYTE* m_DirtyVertexBufferAlloc;
-        UINT m_DirtyVertexBufferAllocSize;
+        CAPTUREARENA* m_Arena;
+        TILEMAP* m_TileMap;
+        INT m_TileOffsetX;
+        INT m_TileOffsetY;
+        LONG m_Generation;
+        RECTCOALESCER m_Coalescer;
+        MOVEPLANNER m_MovePlanner;
+        RECTTRANSFORM m_Transform;
+
+        // With CPU composition frames are read back into m_Compositor through m_CpuStaging and
+        // only the rects that changed are uploaded to the shared surface
+        bool m_CpuCompose;
+        CPUCOMPOSITOR m_Compositor;
+        ID3D11Texture2D* m_CpuStaging;
 };
 
 #endif
@@ -12,12 +12,9 @@
 //
 DUPLICATIONMANAGER::DUPLICATIONMANAGER() : m_DeskDupl(nullptr),
                                            m_AcquiredDesktopImage(nullptr),
-                                           m_MetaDataBuffer(nullptr),
-                                           m_MetaDataSize(0),
-                                           m_OutputNumber(0),
-                                           m_Device(nullptr)
+                                           m_Device(nullptr),
+                                           m_Arena(nullptr)
 {
-    RtlZeroMemory(&m_OutputDesc, sizeof(m_OutputDesc));
 }
 
 //
@@ -37,12 +34,6 @@ DUPLICATIONMANAGER::~DUPLICATIONMANAGER()
         m_AcquiredDesktopImage = nullptr;
     }
 
-    if (m_MetaDataBuffer)
-    {
-        delete [] m_MetaDataBuffer;
-        m_MetaDataBuffer = nullptr;
-    }
-
     if (m_Device)
     {
         m_Device->Release();
@@ -53,7 +44,7 @@ DUPLICATIONMANAGER::~DUPLICATIONMANAGER()
 //
 // Initialize duplication interfaces
 //
-DUPL_RETURN DUPLICATIONMANAGER::InitDupl(_In_ ID3D11Device* Device, UINT Output)
+DUPL_RETURN DUPLICATIONMANAGER::InitSource(_In_ ID3D11Device* Device, UINT Output)
 {
     m_OutputNumber = Output;
 
@@ -119,75 +110,22 @@ DUPL_RETURN DUPLICATIONMANAGER::InitDupl(_In_ ID3D11Device* Device, UINT Output)
 }
 
 //
-// Retrieves mouse info and write it into PtrInfo
+// Metadata buffers come from Arena, must be set before the first GetFrame
 //
-DUPL_RETURN DUPLICATIONMANAGER::GetMouse(_Inout_ PTR_INFO* PtrInfo, _In_ DXGI_OUTDUPL_FRAME_INFO* FrameInfo, INT OffsetX, INT OffsetY)
+void DUPLICATIONMANAGER::SetArena(_In_ CAPTUREARENA* Arena)
 {
-    // A non-zero mouse update timestamp indicates that there is a mouse position update and optionally a shape change
-    if (FrameInfo->LastMouseUpdateTime.QuadPart == 0)
-    {
-        return DUPL_RETURN_SUCCESS;
-    }
-
-    bool UpdatePosition = true;
-
-    // Make sure we don't update pointer position wrongly
-    // If pointer is invisible, make sure we did not get an update from another output that the last time that said pointer
-    // was visible, if so, don't set it to invisible or update.
-    if (!FrameInfo->PointerPosition.Visible && (PtrInfo->WhoUpdatedPositionLast != m_OutputNumber))
-    {
-        UpdatePosition = false;
-    }
-
-    // If two outputs both say they have a visible, only update if new update has newer timestamp
-    if (FrameInfo->PointerPosition.Visible && PtrInfo->Visible && (PtrInfo->WhoUpdatedPositionLast != m_OutputNumber) && (PtrInfo->LastTimeStamp.QuadPart > FrameInfo->LastMouseUpdateTime.QuadPart))
-    {
-        UpdatePosition = false;
-    }
-
-    // Update position
-    if (UpdatePosition)
-    {
-        PtrInfo->Position.x = FrameInfo->PointerPosition.Position.x + m_OutputDesc.DesktopCoordinates.left - OffsetX;
-        PtrInfo->Position.y = FrameInfo->PointerPosition.Position.y + m_OutputDesc.DesktopCoordinates.top - OffsetY;
-        PtrInfo->WhoUpdatedPositionLast = m_OutputNumber;
-        PtrInfo->LastTimeStamp = FrameInfo->LastMouseUpdateTime;
-        PtrInfo->Visible = FrameInfo->PointerPosition.Visible != 0;
-    }
-
-    // No new shape
-    if (FrameInfo->PointerShapeBufferSize == 0)
-    {
-        return DUPL_RETURN_SUCCESS;
-    }
-
-    // Old buffer too small
-    if (FrameInfo->PointerShapeBufferSize > PtrInfo->BufferSize)
-    {
-        if (PtrInfo->PtrShapeBuffer)
-        {
-            delete [] PtrInfo->PtrShapeBuffer;
-            PtrInfo->PtrShapeBuffer = nullptr;
-        }
-        PtrInfo->PtrShapeBuffer = new (std::nothrow) BYTE[FrameInfo->PointerShapeBufferSize];
-        if (!PtrInfo->PtrShapeBuffer)
-        {
-            PtrInfo->BufferSize = 0;
-            return ProcessFailure(nullptr, L"Failed to allocate memory for pointer shape in DUPLICATIONMANAGER", L"Error", E_OUTOFMEMORY);
-        }
-
-        // Update buffer size
-        PtrInfo->BufferSize = FrameInfo->PointerShapeBufferSize;
-    }
+    m_Arena = Arena;
+}
 
-    // Get shape
+//
+// Retrieves the shape of the pointer that changed in the current frame
+//
+DUPL_RETURN DUPLICATIONMANAGER::GetPointerShape(UINT BufferSize, _Out_writes_bytes_(BufferSize) BYTE* Buffer, _Out_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo)
+{
     UINT BufferSizeRequired;
-    HRESULT hr = m_DeskDupl->GetFramePointerShape(FrameInfo->PointerShapeBufferSize, reinterpret_cast<VOID*>(PtrInfo->PtrShapeBuffer), &BufferSizeRequired, &(PtrInfo->ShapeInfo));
+    HRESULT hr = m_DeskDupl->GetFramePointerShape(BufferSize, reinterpret_cast<VOID*>(Buffer), &BufferSizeRequired, ShapeInfo);
     if (FAILED(hr))
     {
-        delete [] PtrInfo->PtrShapeBuffer;
-        PtrInfo->PtrShapeBuffer = nullptr;
-        PtrInfo->BufferSize = 0;
         return ProcessFailure(m_Device, L"Failed to get frame pointer shape in DUPLICATIONMANAGER", L"Error", hr, FrameInfoExpectedErrors);
     }
 
@@ -199,13 +137,13 @@ DUPL_RETURN DUPLICATIONMANAGER::GetMouse(_Inout_ PTR_INFO* PtrInfo, _In_ DXGI_OU
 // Get next frame and write it into Data
 //
 _Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS)
-DUPL_RETURN DUPLICATIONMANAGER::GetFrame(_Out_ FRAME_DATA* Data, _Out_ bool* Timeout)
+DUPL_RETURN DUPLICATIONMANAGER::GetFrame(UINT TimeoutInMilliseconds, _Out_ FRAME_DATA* Data, _Out_ bool* Timeout)
 {
     IDXGIResource* DesktopResource = nullptr;
     DXGI_OUTDUPL_FRAME_INFO FrameInfo;
 
     // Get new frame
-    HRESULT hr = m_DeskDupl->AcquireNextFrame(500, &FrameInfo, &DesktopResource);
+    HRESULT hr = m_DeskDupl->AcquireNextFrame(TimeoutInMilliseconds, &FrameInfo, &DesktopResource);
     if (hr == DXGI_ERROR_WAIT_TIMEOUT)
     {
         *Timeout = true;
@@ -237,29 +175,20 @@ DUPL_RETURN DUPLICATIONMANAGER::GetFrame(_Out_ FRAME_DATA* Data, _Out_ bool* Tim
     // Get metadata
     if (FrameInfo.TotalMetadataBufferSize)
     {
-        // Old buffer too small
-        if (FrameInfo.TotalMetadataBufferSize > m_MetaDataSize)
+        // Metadata lives in the thread's arena
+        BYTE* MetaDataBuffer;
+        DUPL_RETURN Ret = m_Arena->Reserve(ARENA_SLOT_METADATA, FrameInfo.TotalMetadataBufferSize, &MetaDataBuffer);
+        if (Ret != DUPL_RETURN_SUCCESS)
         {
-            if (m_MetaDataBuffer)
-            {
-                delete [] m_MetaDataBuffer;
-                m_MetaDataBuffer = nullptr;
-            }
-            m_MetaDataBuffer = new (std::nothrow) BYTE[FrameInfo.TotalMetadataBufferSize];
-            if (!m_MetaDataBuffer)
-            {
-                m_MetaDataSize = 0;
-                Data->MoveCount = 0;
-                Data->DirtyCount = 0;
-                return ProcessFailure(nullptr, L"Failed to allocate memory for metadata in DUPLICATIONMANAGER", L"Error", E_OUTOFMEMORY);
-            }
-            m_MetaDataSize = FrameInfo.TotalMetadataBufferSize;
+            Data->MoveCount = 0;
+            Data->DirtyCount = 0;
+            return Ret;
         }
 
         UINT BufSize = FrameInfo.TotalMetadataBufferSize;
 
         // Get move rectangles
-        hr = m_DeskDupl->GetFrameMoveRects(BufSize, reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(m_MetaDataBuffer), &BufSize);
+        hr = m_DeskDupl->GetFrameMoveRects(BufSize, reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(MetaDataBuffer), &BufSize);
         if (FAILED(hr))
         {
             Data->MoveCount = 0;
@@ -268,7 +197,7 @@ DUPL_RETURN DUPLICATIONMANAGER::GetFrame(_Out_ FRAME_DATA* Data, _Out_ bool* Tim
         }
         Data->MoveCount = BufSize / sizeof(DXGI_OUTDUPL_MOVE_RECT);
 
-        BYTE* DirtyRects = m_MetaDataBuffer + BufSize;
+        BYTE* DirtyRects = MetaDataBuffer + BufSize;
         BufSize = FrameInfo.TotalMetadataBufferSize - BufSize;
 
         // Get dirty rectangles
@@ -281,7 +210,7 @@ DUPL_RETURN DUPLICATIONMANAGER::GetFrame(_Out_ FRAME_DATA* Data, _Out_ bool* Tim
         }
         Data->DirtyCount = BufSize / sizeof(RECT);
 
-        Data->MetaData = m_MetaDataBuffer;
+        Data->MetaData = MetaDataBuffer;
     }
 
     Data->Frame = m_AcquiredDesktopImage;
@@ -309,11 +238,3 @@ DUPL_RETURN DUPLICATIONMANAGER::DoneWithFrame()
 
     return DUPL_RETURN_SUCCESS;
 }
-
-//
-// Gets output desc into DescPtr
-//
-void DUPLICATIONMANAGER::GetOutputDesc(_Out_ DXGI_OUTPUT_DESC* DescPtr)
-{
-    *DescPtr = m_OutputDesc;
-}
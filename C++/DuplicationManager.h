@@ -8,32 +8,32 @@
 #ifndef _DUPLICATIONMANAGER_H_
 #define _DUPLICATIONMANAGER_H_
 
-#include "CommonTypes.h"
+#include "CaptureArena.h"
+#include "FrameSource.h"
 
 //
 // Handles the task of duplicating an output.
 //
-class DUPLICATIONMANAGER
+class DUPLICATIONMANAGER : public FRAMESOURCE
 {
     public:
         DUPLICATIONMANAGER();
         ~DUPLICATIONMANAGER();
-        _Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS) DUPL_RETURN GetFrame(_Out_ FRAME_DATA* Data, _Out_ bool* Timeout);
+        _Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS) DUPL_RETURN GetFrame(UINT TimeoutInMilliseconds, _Out_ FRAME_DATA* Data, _Out_ bool* Timeout);
         DUPL_RETURN DoneWithFrame();
-        DUPL_RETURN InitDupl(_In_ ID3D11Device* Device, UINT Output);
-        DUPL_RETURN GetMouse(_Inout_ PTR_INFO* PtrInfo, _In_ DXGI_OUTDUPL_FRAME_INFO* FrameInfo, INT OffsetX, INT OffsetY);
-        void GetOutputDesc(_Out_ DXGI_OUTPUT_DESC* DescPtr);
+        DUPL_RETURN InitSource(_In_ ID3D11Device* Device, UINT Output);
+        void SetArena(_In_ CAPTUREARENA* Arena);
+
+    protected:
+        DUPL_RETURN GetPointerShape(UINT BufferSize, _Out_writes_bytes_(BufferSize) BYTE* Buffer, _Out_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo);
 
     private:
 
     // vars
         IDXGIOutputDuplication* m_DeskDupl;
         ID3D11Texture2D* m_AcquiredDesktopImage;
-        _Field_size_bytes_(m_MetaDataSize) BYTE* m_MetaDataBuffer;
-        UINT m_MetaDataSize;
-        UINT m_OutputNumber;
-        DXGI_OUTPUT_DESC m_OutputDesc;
         ID3D11Device* m_Device;
+        CAPTUREARENA* m_Arena;
 };
 
 #endif
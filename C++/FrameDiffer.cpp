@@ -0,0 +1,269 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "FrameDiffer.h"
+
+// Bands handed out per thread so a thread that compared a quick band can take another
+#define DIFF_BANDS_PER_THREAD 2
+
+typedef std::chrono::steady_clock DIFF_CLOCK;
+
+FRAMEDIFFER::FRAMEDIFFER() : m_Width(0),
+                             m_Height(0),
+                             m_TilesX(0),
+                             m_TilesY(0),
+                             m_Pool(nullptr),
+                             m_Frames(0),
+                             m_UnchangedFrames(0),
+                             m_TilesCompared(0),
+                             m_TilesChanged(0),
+                             m_RectsOut(0),
+                             m_Nanoseconds(0)
+{
+}
+
+FRAMEDIFFER::~FRAMEDIFFER()
+{
+}
+
+//
+// Large frames are compared across Pool, nullptr compares everything on the calling thread
+//
+void FRAMEDIFFER::SetPool(BANDPOOL* Pool)
+{
+    m_Pool = Pool;
+}
+
+//
+// Forgets the previous frame so the next one is dirty as a whole
+//
+void FRAMEDIFFER::Reset()
+{
+    m_Width = 0;
+    m_Height = 0;
+}
+
+//
+// Compares a BGRA frame with the previous one. Rects point into storage owned by the differ that stays
+// valid until the next call, RectCount is 0 when nothing changed. False when out of memory.
+//
+bool FRAMEDIFFER::Diff(const unsigned char* Pixels, unsigned Width, unsigned Height, unsigned Pitch, COMPOSE_RECT** Rects, unsigned* RectCount)
+{
+    *Rects = nullptr;
+    *RectCount = 0;
+    if (!Pixels || Width == 0 || Height == 0)
+    {
+        return true;
+    }
+
+    DIFF_CLOCK::time_point Start = DIFF_CLOCK::now();
+
+    bool Whole = (Width != m_Width || Height != m_Height);
+    if (Whole)
+    {
+        unsigned TilesX = (Width + DIFF_TILE_SIZE - 1) >> DIFF_TILE_SHIFT;
+        unsigned TilesY = (Height + DIFF_TILE_SIZE - 1) >> DIFF_TILE_SHIFT;
+        try
+        {
+            // At most one rect per tile so building them never allocates
+            m_Previous.resize(static_cast<size_t>(Width) * Height * COMPOSE_BPP);
+            m_Changed.resize(static_cast<size_t>(TilesX) * TilesY);
+            m_Rects.reserve(static_cast<size_t>(TilesX) * TilesY);
+            m_OpenRects.resize(TilesX);
+        }
+        catch (const std::bad_alloc&)
+        {
+            Reset();
+            return false;
+        }
+        m_Width = Width;
+        m_Height = Height;
+        m_TilesX = TilesX;
+        m_TilesY = TilesY;
+    }
+
+    m_Rects.clear();
+    if (Whole)
+    {
+        // Nothing to compare with, the frame is only kept for the next one
+        size_t RowBytes = static_cast<size_t>(Width) * COMPOSE_BPP;
+        for (unsigned Row = 0; Row < Height; ++Row)
+        {
+            memcpy(&m_Previous[Row * RowBytes], Pixels + static_cast<size_t>(Row) * Pitch, RowBytes);
+        }
+
+        COMPOSE_RECT Rect = {0, 0, static_cast<int>(Width), static_cast<int>(Height)};
+        m_Rects.push_back(Rect);
+        m_TilesChanged += static_cast<unsigned long long>(m_TilesX) * m_TilesY;
+    }
+    else
+    {
+        unsigned Threads = m_Pool ? m_Pool->GetThreadCount() : 0;
+        if (Threads && static_cast<unsigned long long>(Width) * Height >= DIFF_BAND_MIN_PIXELS)
+        {
+            unsigned Bands = (Threads + 1) * DIFF_BANDS_PER_THREAD;
+            DIFF_JOB Job;
+            Job.Differ = this;
+            Job.Pixels = Pixels;
+            Job.Pitch = Pitch;
+            Job.RowsPerBand = (m_TilesY + Bands - 1) / Bands;
+            m_Pool->Run(CompareBand, &Job, (m_TilesY + Job.RowsPerBand - 1) / Job.RowsPerBand);
+        }
+        else
+        {
+            CompareRows(Pixels, Pitch, 0, m_TilesY);
+        }
+        BuildRects();
+    }
+    m_TilesCompared += static_cast<unsigned long long>(m_TilesX) * m_TilesY;
+
+    ++m_Frames;
+    if (m_Rects.empty())
+    {
+        ++m_UnchangedFrames;
+    }
+    else
+    {
+        *Rects = &m_Rects[0];
+        *RectCount = static_cast<unsigned>(m_Rects.size());
+    }
+    m_RectsOut += m_Rects.size();
+    m_Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(DIFF_CLOCK::now() - Start).count();
+
+    return true;
+}
+
+//
+// Snapshot of the running totals
+//
+void FRAMEDIFFER::GetStats(DIFF_STATS* Stats)
+{
+    Stats->Frames = m_Frames;
+    Stats->UnchangedFrames = m_UnchangedFrames;
+    Stats->TilesCompared = m_TilesCompared;
+    Stats->TilesChanged = m_TilesChanged;
+    Stats->RectsOut = m_RectsOut;
+    Stats->Nanoseconds = m_Nanoseconds;
+}
+
+//
+// Band of a banded compare, runs on the pool
+//
+void FRAMEDIFFER::CompareBand(void* Context, unsigned Band)
+{
+    DIFF_JOB* Job = reinterpret_cast<DIFF_JOB*>(Context);
+    unsigned FirstRow = Band * Job->RowsPerBand;
+    unsigned EndRow = std::min(FirstRow + Job->RowsPerBand, Job->Differ->m_TilesY);
+    Job->Differ->CompareRows(Job->Pixels, Job->Pitch, FirstRow, EndRow);
+}
+
+//
+// Flags the tiles in tile rows FirstRow to EndRow that differ from the previous frame and copies them over it.
+// A pixel row that matches as a whole clears every tile it crosses in one memcmp, only one that doesn't is
+// compared again per tile, skipping tiles already known to have changed.
+//
+void FRAMEDIFFER::CompareRows(const unsigned char* Pixels, unsigned Pitch, unsigned FirstRow, unsigned EndRow)
+{
+    size_t RowBytes = static_cast<size_t>(m_Width) * COMPOSE_BPP;
+    size_t TileBytes = static_cast<size_t>(DIFF_TILE_SIZE) * COMPOSE_BPP;
+    for (unsigned TileY = FirstRow; TileY < EndRow; ++TileY)
+    {
+        unsigned Top = TileY << DIFF_TILE_SHIFT;
+        unsigned Bottom = std::min(Top + DIFF_TILE_SIZE, m_Height);
+        unsigned char* Changed = &m_Changed[static_cast<size_t>(TileY) * m_TilesX];
+        memset(Changed, 0, m_TilesX);
+
+        // Once every tile of the row changed the rest of its pixel rows needn't be looked at
+        unsigned ChangedCount = 0;
+        for (unsigned Row = Top; Row < Bottom && ChangedCount < m_TilesX; ++Row)
+        {
+            const unsigned char* Src = Pixels + static_cast<size_t>(Row) * Pitch;
+            const unsigned char* Prev = &m_Previous[Row * RowBytes];
+            if (memcmp(Src, Prev, RowBytes) == 0)
+            {
+                continue;
+            }
+
+            for (unsigned TileX = 0; TileX < m_TilesX; ++TileX)
+            {
+                size_t Offset = TileX * TileBytes;
+                if (!Changed[TileX] && memcmp(Src + Offset, Prev + Offset, std::min(TileBytes, RowBytes - Offset)) != 0)
+                {
+                    Changed[TileX] = 1;
+                    ++ChangedCount;
+                }
+            }
+        }
+
+        // Rows of a changed tile above the first difference already match, copying the whole tile is simpler
+        for (unsigned TileX = 0; TileX < m_TilesX; ++TileX)
+        {
+            if (!Changed[TileX])
+            {
+                continue;
+            }
+
+            size_t Offset = TileX * TileBytes;
+            size_t Bytes = std::min(TileBytes, RowBytes - Offset);
+            for (unsigned Row = Top; Row < Bottom; ++Row)
+            {
+                memcpy(&m_Previous[Row * RowBytes + Offset], Pixels + static_cast<size_t>(Row) * Pitch + Offset, Bytes);
+            }
+        }
+    }
+}
+
+//
+// Turns the changed tiles into rects, runs along each tile row grow downwards while the next row has a run
+// over exactly the same columns
+//
+void FRAMEDIFFER::BuildRects()
+{
+    std::fill(m_OpenRects.begin(), m_OpenRects.end(), -1);
+
+    for (unsigned TileY = 0; TileY < m_TilesY; ++TileY)
+    {
+        int Top = static_cast<int>(TileY << DIFF_TILE_SHIFT);
+        int Bottom = std::min(Top + DIFF_TILE_SIZE, static_cast<int>(m_Height));
+        const unsigned char* Changed = &m_Changed[static_cast<size_t>(TileY) * m_TilesX];
+
+        unsigned TileX = 0;
+        while (TileX < m_TilesX)
+        {
+            if (!Changed[TileX])
+            {
+                ++TileX;
+                continue;
+            }
+
+            unsigned First = TileX;
+            while (TileX < m_TilesX && Changed[TileX])
+            {
+                ++TileX;
+            }
+            m_TilesChanged += TileX - First;
+
+            int Left = static_cast<int>(First << DIFF_TILE_SHIFT);
+            int Right = std::min(static_cast<int>(TileX << DIFF_TILE_SHIFT), static_cast<int>(m_Width));
+            int Open = m_OpenRects[First];
+            if (Open >= 0 && m_Rects[Open].bottom == Top && m_Rects[Open].right == Right)
+            {
+                m_Rects[Open].bottom = Bottom;
+                continue;
+            }
+
+            COMPOSE_RECT Rect = {Left, Top, Right, Bottom};
+            m_OpenRects[First] = static_cast<int>(m_Rects.size());
+            m_Rects.push_back(Rect);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _FRAMEDIFFER_H_
+#define _FRAMEDIFFER_H_
+
+#include <vector>
+
+#include "CpuCompositor.h"
+
+// Frames are compared in square tiles of 1 << DIFF_TILE_SHIFT pixels
+#define DIFF_TILE_SHIFT 5
+#define DIFF_TILE_SIZE  (1 << DIFF_TILE_SHIFT)
+
+// Frames with fewer pixels than this are compared on the calling thread
+#define DIFF_BAND_MIN_PIXELS (2560 * 1440)
+
+//
+// Running totals kept by FRAMEDIFFER
+//
+typedef struct _DIFF_STATS
+{
+    unsigned long long Frames;
+    unsigned long long UnchangedFrames;
+    unsigned long long TilesCompared;
+    unsigned long long TilesChanged;
+    unsigned long long RectsOut;
+    unsigned long long Nanoseconds;
+} DIFF_STATS;
+
+//
+// Derives dirty rects for frame sources that only hand over whole frames.
+// A copy of the previous frame is kept and each pixel row of a BGRA frame is compared with it in one
+// memcmp, only rows that differ are compared again tile by tile to find the tiles that changed. Changed
+// tiles are copied into the kept frame, merged into runs along each tile row and runs spanning the same
+// columns in consecutive tile rows into one rect. Comparing with the pixels themselves costs about what
+// hashing every tile did and can't miss a change.
+// The first frame and any frame of a new size are dirty as a whole.
+// Large frames are compared in bands of tile rows across the pool.
+// Only uses the C++ standard library so it can be exercised away from Windows.
+//
+class FRAMEDIFFER
+{
+    public:
+        FRAMEDIFFER();
+        ~FRAMEDIFFER();
+        void SetPool(BANDPOOL* Pool);
+        bool Diff(const unsigned char* Pixels, unsigned Width, unsigned Height, unsigned Pitch, COMPOSE_RECT** Rects, unsigned* RectCount);
+        void Reset();
+        void GetStats(DIFF_STATS* Stats);
+
+    private:
+        struct DIFF_JOB
+        {
+            FRAMEDIFFER* Differ;
+            const unsigned char* Pixels;
+            unsigned Pitch;
+            unsigned RowsPerBand;
+        };
+
+        static void CompareBand(void* Context, unsigned Band);
+        void CompareRows(const unsigned char* Pixels, unsigned Pitch, unsigned FirstRow, unsigned EndRow);
+        void BuildRects();
+
+    // vars
+        unsigned m_Width;
+        unsigned m_Height;
+        unsigned m_TilesX;
+        unsigned m_TilesY;
+        BANDPOOL* m_Pool;
+
+        // The previous frame packed at m_Width pixels per row, and one entry per tile rebuilt every frame
+        std::vector<unsigned char> m_Previous;
+        std::vector<unsigned char> m_Changed;
+        std::vector<COMPOSE_RECT> m_Rects;
+
+        // Rect of every run in the tile row above that can still grow downwards, by starting column
+        std::vector<int> m_OpenRects;
+
+        unsigned long long m_Frames;
+        unsigned long long m_UnchangedFrames;
+        unsigned long long m_TilesCompared;
+        unsigned long long m_TilesChanged;
+        unsigned long long m_RectsOut;
+        unsigned long long m_Nanoseconds;
+};
+
+#endif
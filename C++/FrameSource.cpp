@@ -0,0 +1,88 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CaptureArena.h"
+#include "CursorCache.h"
+#include "PointerState.h"
+#include "FrameSource.h"
+
+FRAMESOURCE::FRAMESOURCE() : m_OutputNumber(0)
+{
+    RtlZeroMemory(&m_OutputDesc, sizeof(m_OutputDesc));
+}
+
+FRAMESOURCE::~FRAMESOURCE()
+{
+}
+
+//
+// Retrieves mouse info and publishes it to Pointer. A new shape is fetched into PtrInfo, which belongs to the calling thread.
+//
+DUPL_RETURN FRAMESOURCE::GetMouse(_Inout_ PTR_INFO* PtrInfo, _Inout_ POINTERSTATE* Pointer, _In_ DXGI_OUTDUPL_FRAME_INFO* FrameInfo, INT OffsetX, INT OffsetY)
+{
+    // A non-zero mouse update timestamp indicates that there is a mouse position update and optionally a shape change
+    if (FrameInfo->LastMouseUpdateTime.QuadPart == 0)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    // Whether this update wins over the other outputs' is decided where it is published
+    POINT Position;
+    Position.x = FrameInfo->PointerPosition.Position.x + m_OutputDesc.DesktopCoordinates.left - OffsetX;
+    Position.y = FrameInfo->PointerPosition.Position.y + m_OutputDesc.DesktopCoordinates.top - OffsetY;
+    Pointer->PublishPosition(m_OutputNumber, Position, FrameInfo->PointerPosition.Visible != 0, FrameInfo->LastMouseUpdateTime);
+
+    // No new shape
+    if (FrameInfo->PointerShapeBufferSize == 0)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    // Old buffer too small, grow it the same way capture arena slots grow
+    if (FrameInfo->PointerShapeBufferSize > PtrInfo->BufferSize)
+    {
+        UINT NewSize = CAPTUREARENA::GrowSize(PtrInfo->BufferSize, FrameInfo->PointerShapeBufferSize);
+        if (PtrInfo->PtrShapeBuffer)
+        {
+            delete [] PtrInfo->PtrShapeBuffer;
+            PtrInfo->PtrShapeBuffer = nullptr;
+        }
+        PtrInfo->PtrShapeBuffer = new (std::nothrow) BYTE[NewSize];
+        if (!PtrInfo->PtrShapeBuffer)
+        {
+            PtrInfo->BufferSize = 0;
+            return ProcessFailure(nullptr, L"Failed to allocate memory for pointer shape in FRAMESOURCE", L"Error", E_OUTOFMEMORY);
+        }
+
+        // Update buffer size
+        PtrInfo->BufferSize = NewSize;
+    }
+
+    // Get shape
+    DUPL_RETURN Ret = GetPointerShape(FrameInfo->PointerShapeBufferSize, PtrInfo->PtrShapeBuffer, &(PtrInfo->ShapeInfo));
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        delete [] PtrInfo->PtrShapeBuffer;
+        PtrInfo->PtrShapeBuffer = nullptr;
+        PtrInfo->BufferSize = 0;
+        return Ret;
+    }
+
+    // Hashed once here so the render thread can find the shape's texture without looking at the bytes
+    PtrInfo->ShapeHash = CURSORCACHE::HashShape(&PtrInfo->ShapeInfo, PtrInfo->PtrShapeBuffer, FrameInfo->PointerShapeBufferSize);
+    Pointer->PublishShape(&PtrInfo->ShapeInfo, PtrInfo->PtrShapeBuffer, FrameInfo->PointerShapeBufferSize, PtrInfo->ShapeHash);
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Gets output desc into DescPtr
+//
+void FRAMESOURCE::GetOutputDesc(_Out_ DXGI_OUTPUT_DESC* DescPtr)
+{
+    *DescPtr = m_OutputDesc;
+}
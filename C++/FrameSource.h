@@ -0,0 +1,36 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _FRAMESOURCE_H_
+#define _FRAMESOURCE_H_
+
+#include "CommonTypes.h"
+
+//
+// Produces desktop frames and pointer updates for one output.
+// DUPLICATIONMANAGER is the live DXGI backend, REPLAYMANAGER plays back a recorded capture trace.
+//
+class FRAMESOURCE
+{
+    public:
+        FRAMESOURCE();
+        virtual ~FRAMESOURCE();
+        virtual DUPL_RETURN InitSource(_In_ ID3D11Device* Device, UINT Output) = 0;
+        virtual _Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS) DUPL_RETURN GetFrame(UINT TimeoutInMilliseconds, _Out_ FRAME_DATA* Data, _Out_ bool* Timeout) = 0;
+        virtual DUPL_RETURN DoneWithFrame() = 0;
+        DUPL_RETURN GetMouse(_Inout_ PTR_INFO* PtrInfo, _Inout_ POINTERSTATE* Pointer, _In_ DXGI_OUTDUPL_FRAME_INFO* FrameInfo, INT OffsetX, INT OffsetY);
+        void GetOutputDesc(_Out_ DXGI_OUTPUT_DESC* DescPtr);
+
+    protected:
+        virtual DUPL_RETURN GetPointerShape(UINT BufferSize, _Out_writes_bytes_(BufferSize) BYTE* Buffer, _Out_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo) = 0;
+
+    // vars
+        UINT m_OutputNumber;
+        DXGI_OUTPUT_DESC m_OutputDesc;
+};
+
+#endif
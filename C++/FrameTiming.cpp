@@ -0,0 +1,128 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <math.h>
+
+#include "FrameTiming.h"
+
+// Weight of the newest interval in the moving average
+#define FRAME_INTERVAL_WEIGHT 0.125
+
+// Longer gaps are counted as this long so the average recovers quickly once the desktop is busy again
+#define FRAME_INTERVAL_MAX_MS 1000
+
+QPCCLOCK::QPCCLOCK()
+{
+    QueryPerformanceFrequency(&m_Frequency);
+}
+
+LONGLONG QPCCLOCK::Now()
+{
+    LARGE_INTEGER Counter;
+    QueryPerformanceCounter(&Counter);
+    return Counter.QuadPart;
+}
+
+LONGLONG QPCCLOCK::Frequency()
+{
+    return m_Frequency.QuadPart;
+}
+
+FRAMERATEESTIMATOR::FRAMERATEESTIMATOR(_In_ CAPTURECLOCK* Clock) : m_Clock(Clock)
+{
+    Reset();
+}
+
+FRAMERATEESTIMATOR::~FRAMERATEESTIMATOR()
+{
+}
+
+//
+// Forget the measured rate, the next acquire waits the longest allowed
+//
+void FRAMERATEESTIMATOR::Reset()
+{
+    m_LastFrame = 0;
+    m_Interval = 0.0;
+    m_Timeout = ACQUIRE_TIMEOUT_MAX_MS;
+}
+
+//
+// A frame was acquired
+//
+void FRAMERATEESTIMATOR::OnFrame()
+{
+    LONGLONG Now = m_Clock->Now();
+    if (m_LastFrame)
+    {
+        double Frequency = static_cast<double>(m_Clock->Frequency());
+        double Sample = min(static_cast<double>(Now - m_LastFrame), (Frequency * FRAME_INTERVAL_MAX_MS) / 1000.0);
+        m_Interval = (m_Interval > 0.0) ? m_Interval + ((Sample - m_Interval) * FRAME_INTERVAL_WEIGHT) : Sample;
+
+        double Timeout = (2.0 * m_Interval * 1000.0) / Frequency;
+        m_Timeout = static_cast<UINT>(max(static_cast<double>(ACQUIRE_TIMEOUT_MIN_MS), min(Timeout, static_cast<double>(ACQUIRE_TIMEOUT_MAX_MS))));
+    }
+    m_LastFrame = Now;
+}
+
+//
+// No frame arrived within the last timeout, back off so an idle desktop is not polled at the frame rate
+//
+void FRAMERATEESTIMATOR::OnTimeout()
+{
+    m_Timeout = min(m_Timeout * 2, static_cast<UINT>(ACQUIRE_TIMEOUT_MAX_MS));
+}
+
+//
+// Timeout in milliseconds for the next acquire
+//
+UINT FRAMERATEESTIMATOR::GetAcquireTimeout()
+{
+    return m_Timeout;
+}
+
+//
+// Milliseconds until an output polled without blocking should be polled again. It sleeps until a quarter
+// interval before the next frame is due and polls at the floor from there, so oversleeping never pushes
+// the poll past the frame. Once a frame is an interval late the desktop has gone quiet and it is polled
+// every quarter of however late that is.
+//
+UINT FRAMERATEESTIMATOR::GetPollInterval()
+{
+    if (m_Interval <= 0.0)
+    {
+        return ACQUIRE_TIMEOUT_MIN_MS;
+    }
+
+    double Remaining = m_Interval - static_cast<double>(m_Clock->Now() - m_LastFrame);
+    double Wait = 0.0;
+    if (Remaining > m_Interval / 4.0)
+    {
+        Wait = Remaining - (m_Interval / 4.0);
+    }
+    else if (Remaining < -m_Interval)
+    {
+        Wait = -Remaining / 4.0;
+    }
+    double Milliseconds = floor((Wait * 1000.0) / static_cast<double>(m_Clock->Frequency()));
+
+    return static_cast<UINT>(max(static_cast<double>(POLL_INTERVAL_MIN_MS), min(Milliseconds, static_cast<double>(ACQUIRE_TIMEOUT_MAX_MS))));
+}
+
+//
+// Measured capture rate, falls off while no frames arrive
+//
+FLOAT FRAMERATEESTIMATOR::GetFramesPerSecond()
+{
+    if (m_Interval <= 0.0)
+    {
+        return 0.0f;
+    }
+
+    double Interval = max(m_Interval, static_cast<double>(m_Clock->Now() - m_LastFrame));
+    return static_cast<FLOAT>(static_cast<double>(m_Clock->Frequency()) / Interval);
+}
@@ -0,0 +1,71 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _FRAMETIMING_H_
+#define _FRAMETIMING_H_
+
+#include "CommonTypes.h"
+
+// Bounds on the AcquireNextFrame timeout, the upper one is also the worst case wait for shutdown or reinit
+#define ACQUIRE_TIMEOUT_MIN_MS 4
+#define ACQUIRE_TIMEOUT_MAX_MS 100
+
+// Shortest wait before an output that is polled without blocking is looked at again
+#define POLL_INTERVAL_MIN_MS 1
+
+//
+// Source of time for FRAMERATEESTIMATOR, so the policy can be driven by a fake clock
+//
+class CAPTURECLOCK
+{
+    public:
+        virtual ~CAPTURECLOCK() {}
+        virtual LONGLONG Now() = 0;
+        virtual LONGLONG Frequency() = 0;
+};
+
+//
+// CAPTURECLOCK backed by QueryPerformanceCounter
+//
+class QPCCLOCK : public CAPTURECLOCK
+{
+    public:
+        QPCCLOCK();
+        LONGLONG Now();
+        LONGLONG Frequency();
+
+    private:
+        LARGE_INTEGER m_Frequency;
+};
+
+//
+// Tracks the interval between frames of one output as an exponentially weighted moving average.
+// The acquire timeout is twice the average interval, so a frame that is a little late is still
+// waited for, clamped so an idle desktop is polled often enough to notice the terminate event.
+// Outputs polled without blocking are looked at again when the next frame is due.
+//
+class FRAMERATEESTIMATOR
+{
+    public:
+        FRAMERATEESTIMATOR(_In_ CAPTURECLOCK* Clock);
+        ~FRAMERATEESTIMATOR();
+        void Reset();
+        void OnFrame();
+        void OnTimeout();
+        UINT GetAcquireTimeout();
+        UINT GetPollInterval();
+        FLOAT GetFramesPerSecond();
+
+    private:
+    // vars
+        CAPTURECLOCK* m_Clock;
+        LONGLONG m_LastFrame;
+        double m_Interval;
+        UINT m_Timeout;
+};
+
+#endif
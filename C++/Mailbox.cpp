@@ -0,0 +1,80 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "Mailbox.h"
+
+// Set in m_Middle while the middle slot holds a frame the reader has not taken
+#define MAILBOX_FRESH 4
+#define MAILBOX_INDEX 3
+
+MAILBOX::MAILBOX() : m_Middle(1),
+                     m_Back(0),
+                     m_Front(2),
+                     m_Published(0),
+                     m_Dropped(0),
+                     m_Consumed(0),
+                     m_Reused(0)
+{
+}
+
+MAILBOX::~MAILBOX()
+{
+}
+
+//
+// Slot the writer draws the next frame into, it stays the writer's until Publish
+//
+unsigned MAILBOX::GetWriteSlot()
+{
+    return m_Back;
+}
+
+//
+// Hands the back slot to the reader as the latest frame and takes the middle slot back for writing
+//
+void MAILBOX::Publish()
+{
+    unsigned Old = m_Middle.exchange(m_Back | MAILBOX_FRESH, std::memory_order_acq_rel);
+    m_Back = Old & MAILBOX_INDEX;
+    m_Published.fetch_add(1, std::memory_order_relaxed);
+    if (Old & MAILBOX_FRESH)
+    {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//
+// Gives the reader the latest published frame in Slot. Returns false when nothing was published
+// since the last call, Slot is then the frame the reader already has.
+//
+bool MAILBOX::Acquire(unsigned* Slot)
+{
+    if (!(m_Middle.load(std::memory_order_relaxed) & MAILBOX_FRESH))
+    {
+        m_Reused.fetch_add(1, std::memory_order_relaxed);
+        *Slot = m_Front;
+        return false;
+    }
+
+    // Only the writer can change the middle slot in between, and it only ever makes it fresh again
+    unsigned Old = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+    m_Front = Old & MAILBOX_INDEX;
+    m_Consumed.fetch_add(1, std::memory_order_relaxed);
+    *Slot = m_Front;
+    return true;
+}
+
+//
+// Snapshot of the running totals
+//
+void MAILBOX::GetStats(MAILBOX_STATS* Stats)
+{
+    Stats->Published = m_Published.load(std::memory_order_relaxed);
+    Stats->Dropped = m_Dropped.load(std::memory_order_relaxed);
+    Stats->Consumed = m_Consumed.load(std::memory_order_relaxed);
+    Stats->Reused = m_Reused.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _MAILBOX_H_
+#define _MAILBOX_H_
+
+#include <atomic>
+
+// One slot being written, one holding the latest finished frame and one being read
+#define MAILBOX_SLOTS 3
+
+//
+// Running totals kept by MAILBOX
+//
+typedef struct _MAILBOX_STATS
+{
+    unsigned long long Published;
+    unsigned long long Dropped;
+    unsigned long long Consumed;
+    unsigned long long Reused;
+} MAILBOX_STATS;
+
+//
+// Slot states of a triple buffered handoff between one writer and one reader.
+// The writer owns its back slot and the reader its front slot, the third slot holds the latest
+// finished frame. Publish trades the back slot for it and marks it fresh, Acquire trades the front
+// slot for it only when it is fresh. Both are a single atomic exchange so neither side ever waits
+// on the other: a frame published before the reader took the previous one is dropped, and a reader
+// that finds nothing fresh keeps reading the frame it has.
+// Only uses the C++ standard library so it can be exercised away from Windows.
+//
+class MAILBOX
+{
+    public:
+        MAILBOX();
+        ~MAILBOX();
+        unsigned GetWriteSlot();
+        void Publish();
+        bool Acquire(unsigned* Slot);
+        void GetStats(MAILBOX_STATS* Stats);
+
+    private:
+    // vars
+        // Index of the middle slot in the low bits, MAILBOX_FRESH when it has not been read yet
+        std::atomic<unsigned> m_Middle;
+        unsigned m_Back;
+        unsigned m_Front;
+
+        std::atomic<unsigned long long> m_Published;
+        std::atomic<unsigned long long> m_Dropped;
+        std::atomic<unsigned long long> m_Consumed;
+        std::atomic<unsigned long long> m_Reused;
+};
+
+#endif
@@ -0,0 +1,163 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <limits.h>
+
+#include "MovePlanner.h"
+
+MOVEPLANNER::MOVEPLANNER() : m_MaxBands(MOVE_PLAN_MAX_STEPS)
+{
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+MOVEPLANNER::~MOVEPLANNER()
+{
+}
+
+//
+// Moves needing more than MaxBands copies go through the staging surface, 1 always stages overlapping moves
+//
+void MOVEPLANNER::SetMaxBands(UINT MaxBands)
+{
+    m_MaxBands = max(1U, min(MaxBands, static_cast<UINT>(MOVE_PLAN_MAX_STEPS)));
+}
+
+//
+// Fills Steps with the copies for one move, both rects are in shared surface coordinates
+//
+UINT MOVEPLANNER::PlanMove(_In_ RECT* SrcRect, _In_ RECT* DestRect, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps)
+{
+    LONG Width = SrcRect->right - SrcRect->left;
+    LONG Height = SrcRect->bottom - SrcRect->top;
+    LONG Dx = DestRect->left - SrcRect->left;
+    LONG Dy = DestRect->top - SrcRect->top;
+
+    // Nothing to do
+    if (Width <= 0 || Height <= 0 || (Dx == 0 && Dy == 0))
+    {
+        return 0;
+    }
+
+    UINT StepCount;
+    if (abs(Dx) >= Width || abs(Dy) >= Height)
+    {
+        // Source and destination are disjoint so copy straight across
+        Steps[0].Src = *SrcRect;
+        Steps[0].Dest.x = DestRect->left;
+        Steps[0].Dest.y = DestRect->top;
+        Steps[0].Staged = false;
+        StepCount = 1;
+        ++m_Stats.DirectMoves;
+    }
+    else
+    {
+        // Band across whichever axis needs fewer copies
+        UINT RowBands = Dy ? static_cast<UINT>((Height + abs(Dy) - 1) / abs(Dy)) : UINT_MAX;
+        UINT ColumnBands = Dx ? static_cast<UINT>((Width + abs(Dx) - 1) / abs(Dx)) : UINT_MAX;
+        if (min(RowBands, ColumnBands) <= m_MaxBands)
+        {
+            StepCount = (RowBands <= ColumnBands) ? PlanRowBands(SrcRect, Dx, Dy, Steps) : PlanColumnBands(SrcRect, Dx, Dy, Steps);
+            ++m_Stats.BandedMoves;
+        }
+        else
+        {
+            // Round trip through the staging surface
+            Steps[0].Src = *SrcRect;
+            Steps[0].Dest.x = DestRect->left;
+            Steps[0].Dest.y = DestRect->top;
+            Steps[0].Staged = true;
+            StepCount = 1;
+            ++m_Stats.StagedMoves;
+        }
+    }
+
+    m_Stats.Steps += StepCount;
+
+    return StepCount;
+}
+
+//
+// Horizontal bands |Dy| tall, the band nearest the destination is copied first so no band reads rows already written
+//
+UINT MOVEPLANNER::PlanRowBands(_In_ RECT* SrcRect, LONG Dx, LONG Dy, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps)
+{
+    LONG BandHeight = abs(Dy);
+    UINT StepCount = 0;
+    for (LONG Done = 0; Done < SrcRect->bottom - SrcRect->top; Done += BandHeight)
+    {
+        LONG Top;
+        LONG Bottom;
+        if (Dy < 0)
+        {
+            // Moving up, work top down
+            Top = SrcRect->top + Done;
+            Bottom = min(Top + BandHeight, SrcRect->bottom);
+        }
+        else
+        {
+            // Moving down, work bottom up
+            Bottom = SrcRect->bottom - Done;
+            Top = max(Bottom - BandHeight, SrcRect->top);
+        }
+
+        Steps[StepCount].Src.left = SrcRect->left;
+        Steps[StepCount].Src.top = Top;
+        Steps[StepCount].Src.right = SrcRect->right;
+        Steps[StepCount].Src.bottom = Bottom;
+        Steps[StepCount].Dest.x = SrcRect->left + Dx;
+        Steps[StepCount].Dest.y = Top + Dy;
+        Steps[StepCount].Staged = false;
+        ++StepCount;
+    }
+
+    return StepCount;
+}
+
+//
+// Vertical bands |Dx| wide, same ordering rule as PlanRowBands
+//
+UINT MOVEPLANNER::PlanColumnBands(_In_ RECT* SrcRect, LONG Dx, LONG Dy, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps)
+{
+    LONG BandWidth = abs(Dx);
+    UINT StepCount = 0;
+    for (LONG Done = 0; Done < SrcRect->right - SrcRect->left; Done += BandWidth)
+    {
+        LONG Left;
+        LONG Right;
+        if (Dx < 0)
+        {
+            // Moving left, work left to right
+            Left = SrcRect->left + Done;
+            Right = min(Left + BandWidth, SrcRect->right);
+        }
+        else
+        {
+            // Moving right, work right to left
+            Right = SrcRect->right - Done;
+            Left = max(Right - BandWidth, SrcRect->left);
+        }
+
+        Steps[StepCount].Src.left = Left;
+        Steps[StepCount].Src.top = SrcRect->top;
+        Steps[StepCount].Src.right = Right;
+        Steps[StepCount].Src.bottom = SrcRect->bottom;
+        Steps[StepCount].Dest.x = Left + Dx;
+        Steps[StepCount].Dest.y = SrcRect->top + Dy;
+        Steps[StepCount].Staged = false;
+        ++StepCount;
+    }
+
+    return StepCount;
+}
+
+//
+// Copies out the running totals
+//
+void MOVEPLANNER::GetStats(_Out_ MOVE_PLAN_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
@@ -0,0 +1,62 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _MOVEPLANNER_H_
+#define _MOVEPLANNER_H_
+
+#include "CommonTypes.h"
+
+// Most copies a single move is split into before falling back to the staging surface
+#define MOVE_PLAN_MAX_STEPS 32
+
+//
+// One copy within the shared surface, or through the staging surface when Staged is set
+//
+typedef struct _MOVE_STEP
+{
+    RECT Src;
+    POINT Dest;
+    bool Staged;
+} MOVE_STEP;
+
+//
+// Running totals kept by MOVEPLANNER
+//
+typedef struct _MOVE_PLAN_STATS
+{
+    UINT64 DirectMoves;
+    UINT64 BandedMoves;
+    UINT64 StagedMoves;
+    UINT64 Steps;
+} MOVE_PLAN_STATS;
+
+//
+// Plans how a move rect is copied within the shared surface.
+// Moves are applied in the order DXGI reports them, so a move only conflicts with itself: a
+// source that does not overlap its destination is copied directly, a scroll is split into bands
+// no taller (or wider) than the scroll distance and copied from the leading edge, and only moves
+// that would need too many bands go through the staging surface.
+//
+class MOVEPLANNER
+{
+    public:
+        MOVEPLANNER();
+        ~MOVEPLANNER();
+        void SetMaxBands(UINT MaxBands);
+        UINT PlanMove(_In_ RECT* SrcRect, _In_ RECT* DestRect, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps);
+        void GetStats(_Out_ MOVE_PLAN_STATS* Stats);
+
+    private:
+        UINT PlanRowBands(_In_ RECT* SrcRect, LONG Dx, LONG Dy, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps);
+        UINT PlanColumnBands(_In_ RECT* SrcRect, LONG Dx, LONG Dy, _Out_writes_to_(MOVE_PLAN_MAX_STEPS, return) MOVE_STEP* Steps);
+
+    // vars
+        UINT m_MaxBands;
+        MOVE_PLAN_STATS m_Stats;
+};
+
+#endif
@@ -5,6 +5,8 @@
 //
 // Copyright (c) Microsoft Corporation. All rights reserved
 
+#include <math.h>
+
 #include "OutputManager.h"
 using namespace DirectX;
 
@@ -14,6 +16,7 @@ VRDesktop_SZVR_GETData SZVR_GetData = NULL;
 
 void UpdateCameraPosition(XMVECTOR & camPos);
 void UpdateRadiusAndAngle(float &radius, float &halfAngle);
+bool IsViewMoving();
 #endif // VR_DESKTOP
 
 //#define DEBUG_VERTEX
@@ -35,17 +38,59 @@ OUTPUTMANAGER::OUTPUTMANAGER() : m_SwapChain(nullptr),
                                  m_InputLayout(nullptr),
                                  m_SharedSurf(nullptr),
                                  m_KeyMutex(nullptr),
+                                 m_OutputSurfaceCount(0),
+                                 m_OutputSurfaces(nullptr),
+                                 m_TargetCount(0),
+                                 m_Targets(nullptr),
                                  m_WindowHandle(nullptr),
                                  m_NeedsResize(false),
 #ifdef VR_DESKTOP
 								 m_ScreenTex(nullptr),
+								 m_ScreenRadius(0),
+								 m_ScreenHalfDegree(0),
+								 m_EyesTime(0),
+								 m_OverlayBuffer(nullptr),
+								 m_LatchedStamp(0),
+								 m_CountedStamp(0),
+								 m_OverlayFrames(0),
+								 m_ReusedEyeFrames(0),
+								 m_OverlayMoves(0),
+								 m_OverlayLatchTicks(0),
+								 m_OverlayMoveTicks(0),
+								 m_WindowUploads(0),
+								 m_WindowUploadRects(0),
+								 m_WindowUploadPixels(0),
+								 m_WindowSlotAllocations(0),
+								 m_WindowUploadTicks(0),
 #endif // VR_DESKTOP
-                                 m_OcclusionCookie(0)
+                                 m_OcclusionCookie(0),
+                                 m_SurfaceDamaged(false),
+                                 m_HaveRendered(false),
+                                 m_VBlankOutput(nullptr),
+                                 m_RenderedFrames(0),
+                                 m_SkippedFrames(0),
+                                 m_Pointer(nullptr),
+                                 m_PointerShadow(nullptr),
+                                 m_ShadowInUse(false),
+                                 m_ShadowBackdrops(0),
+                                 m_ReadbackBackdrops(0),
+                                 m_ShadowBackdropTicks(0),
+                                 m_ReadbackBackdropTicks(0),
+                                 m_PredictPointer(false)
 {
+#ifdef VR_DESKTOP
 	for (int i = 0; i < MAX_WINDOWS; ++i)
 	{
 		m_windows[i] = nullptr;
 	}
+	RtlZeroMemory(m_WindowSlots, sizeof(m_WindowSlots));
+	m_EyeViews[0] = nullptr;
+	m_EyeViews[1] = nullptr;
+	m_LatchTime.QuadPart = 0;
+#endif // VR_DESKTOP
+    RtlZeroMemory(&m_PtrInfo, sizeof(m_PtrInfo));
+    RtlZeroMemory(&m_Rendered, sizeof(m_Rendered));
+    QueryPerformanceFrequency(&m_QpcFrequency);
 }
 
 //
@@ -54,6 +99,12 @@ OUTPUTMANAGER::OUTPUTMANAGER() : m_SwapChain(nullptr),
 OUTPUTMANAGER::~OUTPUTMANAGER()
 {
     CleanRefs();
+
+    if (m_PtrInfo.PtrShapeBuffer)
+    {
+        delete [] m_PtrInfo.PtrShapeBuffer;
+        m_PtrInfo.PtrShapeBuffer = nullptr;
+    }
 }
 
 //
@@ -67,13 +118,20 @@ void OUTPUTMANAGER::WindowResize()
 //
 // Initialize all state
 //
-DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds)
+DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _In_ CAPTURE_OPTIONS* Capture, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds)
 {
     HRESULT hr;
 
     // Store window handle
     m_WindowHandle = Window;
 
+    // Pointer prediction keeps its other knobs at their defaults
+    PREDICT_OPTIONS PredictOptions;
+    POINTERPREDICTOR::GetDefaultOptions(&PredictOptions);
+    PredictOptions.Aggressiveness = Capture->PredictPointer;
+    m_Predictor.SetOptions(&PredictOptions);
+    m_PredictPointer = Capture->PredictPointer > 0.0f;
+
     // Driver types supported
     D3D_DRIVER_TYPE DriverTypes[] =
     {
@@ -110,6 +168,9 @@ DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _Out_ UINT*
         return ProcessFailure(m_Device, L"Device creation in OUTPUTMANAGER failed", L"Error", hr, SystemTransitionsExpectedErrors);
     }
 
+    // Cursor resources are made on this device as pointers show up
+    m_CursorCache.InitCache(m_Device, m_DeviceContext);
+
     // Get DXGI factory
     IDXGIDevice* DxgiDevice = nullptr;
     hr = m_Device->QueryInterface(__uuidof(IDXGIDevice), reinterpret_cast<void**>(&DxgiDevice));
@@ -175,7 +236,7 @@ DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _Out_ UINT*
     }
 
     // Create shared texture
-    DUPL_RETURN Return = CreateSharedSurf(SingleOutput, OutCount, DeskBounds);
+    DUPL_RETURN Return = CreateSharedSurf(SingleOutput, Capture, OutCount, DeskBounds);
     if (Return != DUPL_RETURN_SUCCESS)
     {
         return Return;
@@ -267,6 +328,24 @@ DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _Out_ UINT*
 #endif // VR_DESKTOP
 #endif // !DEBUG_LIB
 
+#ifdef VR_DESKTOP
+	// Windows too large to compare on the render thread alone are split across m_DiffPool
+	if (!m_DiffPool.GetThreadCount())
+	{
+		UINT Cores = std::thread::hardware_concurrency();
+		if (Cores > 1 && !m_DiffPool.Start(Cores - 1))
+		{
+			return ProcessFailure(nullptr, L"Failed to start window compare threads", L"Error", E_FAIL);
+		}
+	}
+	for (UINT i = 0; i < MAX_WINDOWS; ++i)
+	{
+		m_WindowDiffers[i].SetPool(&m_DiffPool);
+	}
+
+	// Windows are printed in the background from here on, DrawToScreen names which
+	Return = m_WindowCapture.Start();
+#endif // VR_DESKTOP
 
     return Return;
 }
@@ -274,7 +353,7 @@ DUPL_RETURN OUTPUTMANAGER::InitOutput(HWND Window, INT SingleOutput, _Out_ UINT*
 //
 // Recreate shared texture
 //
-DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds)
+DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _In_ CAPTURE_OPTIONS* Capture, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds)
 {
     HRESULT hr;
 
@@ -349,9 +428,22 @@ DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCou
         OutputCount = 1;
     }
 
+    // Each output gets its own surface so outputs never wait on each other, a single output gains nothing from it
+    // unless it is handed to the renderer through a mailbox
+    DUPL_RETURN Ret = DUPL_RETURN_SUCCESS;
+    if (((Capture->PerSurface && SingleOutput < 0) || Capture->Mailbox) && OutputCount > 0)
+    {
+        Ret = CreateOutputSurfaces(DxgiAdapter, SingleOutput, OutputCount, Capture->Mailbox, DeskBounds);
+    }
+
     DxgiAdapter->Release();
     DxgiAdapter = nullptr;
 
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
     // Set passed in output count variable
     *OutCount = OutputCount;
 
@@ -374,7 +466,7 @@ DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCou
     DeskTexD.Usage = D3D11_USAGE_DEFAULT;
     DeskTexD.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
     DeskTexD.CPUAccessFlags = 0;
-    DeskTexD.MiscFlags = D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
+    DeskTexD.MiscFlags = m_OutputSurfaceCount ? 0 : D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
 
     hr = m_Device->CreateTexture2D(&DeskTexD, nullptr, &m_SharedSurf);
     if (FAILED(hr))
@@ -396,10 +488,170 @@ DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCou
     }
 
     // Get keyed mutex
-    hr = m_SharedSurf->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&m_KeyMutex));
+    if (!m_OutputSurfaceCount)
+    {
+        hr = m_SharedSurf->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(&m_KeyMutex));
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to query for keyed mutex in OUTPUTMANAGER", L"Error", hr);
+        }
+    }
+
+    Ret = CreateSurfaceTargets(OutputCount, DeskBounds);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    // Capture threads aren't running yet so the tile map can be resized
+    return m_TileMap.Init(DeskTexD.Width, DeskTexD.Height);
+}
+
+//
+// Creates a surface and keyed mutex for each output, capture threads draw into these and the renderer copies them into m_SharedSurf.
+// With a mailbox every output gets MAILBOX_SLOTS of them.
+//
+DUPL_RETURN OUTPUTMANAGER::CreateOutputSurfaces(_In_ IDXGIAdapter* Adapter, INT SingleOutput, UINT OutputCount, bool Mailbox, _In_ RECT* DeskBounds)
+{
+    m_OutputSurfaces = new (std::nothrow) OUTPUT_SURFACE[OutputCount];
+    if (!m_OutputSurfaces)
+    {
+        return ProcessFailure(nullptr, L"Failed to allocate output surfaces in OUTPUTMANAGER", L"Error", E_OUTOFMEMORY);
+    }
+    RtlZeroMemory(m_OutputSurfaces, OutputCount * sizeof(OUTPUT_SURFACE));
+    m_OutputSurfaceCount = OutputCount;
+
+    for (UINT i = 0; i < OutputCount; ++i)
+    {
+        IDXGIOutput* DxgiOutput = nullptr;
+        HRESULT hr = Adapter->EnumOutputs((SingleOutput < 0) ? i : SingleOutput, &DxgiOutput);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to enumerate output for its shared surface", L"Error", hr, EnumOutputsExpectedErrors);
+        }
+        DXGI_OUTPUT_DESC DesktopDesc;
+        DxgiOutput->GetDesc(&DesktopDesc);
+        DxgiOutput->Release();
+        DxgiOutput = nullptr;
+
+        OUTPUT_SURFACE* Output = &m_OutputSurfaces[i];
+        Output->Desktop = DesktopDesc.DesktopCoordinates;
+        Output->X = DesktopDesc.DesktopCoordinates.left - DeskBounds->left;
+        Output->Y = DesktopDesc.DesktopCoordinates.top - DeskBounds->top;
+        UINT Width = DesktopDesc.DesktopCoordinates.right - DesktopDesc.DesktopCoordinates.left;
+        UINT Height = DesktopDesc.DesktopCoordinates.bottom - DesktopDesc.DesktopCoordinates.top;
+
+        if (!Mailbox)
+        {
+            DUPL_RETURN Ret = CreateOutputTexture(Width, Height, &Output->Surface, &Output->KeyMutex);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+            continue;
+        }
+
+        Output->Mailbox = new (std::nothrow) MAILBOX;
+        if (!Output->Mailbox)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate mailbox in OUTPUTMANAGER", L"Error", E_OUTOFMEMORY);
+        }
+
+        for (UINT Slot = 0; Slot < MAILBOX_SLOTS; ++Slot)
+        {
+            DUPL_RETURN Ret = CreateOutputTexture(Width, Height, &Output->Slots[Slot], &Output->SlotMutexes[Slot]);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Creates one shared surface of an output and gets its keyed mutex
+//
+DUPL_RETURN OUTPUTMANAGER::CreateOutputTexture(UINT Width, UINT Height, _Out_ ID3D11Texture2D** Surface, _Out_ IDXGIKeyedMutex** KeyMutex)
+{
+    D3D11_TEXTURE2D_DESC DeskTexD;
+    RtlZeroMemory(&DeskTexD, sizeof(D3D11_TEXTURE2D_DESC));
+    DeskTexD.Width = Width;
+    DeskTexD.Height = Height;
+    DeskTexD.MipLevels = 1;
+    DeskTexD.ArraySize = 1;
+    DeskTexD.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    DeskTexD.SampleDesc.Count = 1;
+    DeskTexD.Usage = D3D11_USAGE_DEFAULT;
+    DeskTexD.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    DeskTexD.CPUAccessFlags = 0;
+    DeskTexD.MiscFlags = D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
+
+    HRESULT hr = m_Device->CreateTexture2D(&DeskTexD, nullptr, Surface);
     if (FAILED(hr))
     {
-        return ProcessFailure(m_Device, L"Failed to query for keyed mutex in OUTPUTMANAGER", L"Error", hr);
+        return ProcessFailure(m_Device, L"Failed to create shared texture for output", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    hr = (*Surface)->QueryInterface(__uuidof(IDXGIKeyedMutex), reinterpret_cast<void**>(KeyMutex));
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to query for keyed mutex of output surface in OUTPUTMANAGER", L"Error", hr);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Fills in the surface each duplication thread draws into
+//
+DUPL_RETURN OUTPUTMANAGER::CreateSurfaceTargets(UINT OutputCount, _In_ RECT* DeskBounds)
+{
+    m_Targets = new (std::nothrow) SURFACE_TARGET[OutputCount];
+    if (!m_Targets)
+    {
+        return ProcessFailure(nullptr, L"Failed to allocate surface targets in OUTPUTMANAGER", L"Error", E_OUTOFMEMORY);
+    }
+    m_TargetCount = OutputCount;
+
+    RtlZeroMemory(m_Targets, OutputCount * sizeof(SURFACE_TARGET));
+
+    for (UINT i = 0; i < OutputCount; ++i)
+    {
+        if (m_OutputSurfaceCount && m_OutputSurfaces[i].Mailbox)
+        {
+            m_Targets[i].Mailbox = m_OutputSurfaces[i].Mailbox;
+            for (UINT Slot = 0; Slot < MAILBOX_SLOTS; ++Slot)
+            {
+                m_Targets[i].SlotHandles[Slot] = GetSharedHandle(m_OutputSurfaces[i].Slots[Slot]);
+                if (!m_Targets[i].SlotHandles[Slot])
+                {
+                    return ProcessFailure(m_Device, L"Failed to get handle of mailbox slot", L"Error", E_FAIL);
+                }
+            }
+            m_Targets[i].SurfaceX = m_OutputSurfaces[i].Desktop.left;
+            m_Targets[i].SurfaceY = m_OutputSurfaces[i].Desktop.top;
+            continue;
+        }
+
+        if (m_OutputSurfaceCount)
+        {
+            m_Targets[i].SharedHandle = GetSharedHandle(m_OutputSurfaces[i].Surface);
+            m_Targets[i].SurfaceX = m_OutputSurfaces[i].Desktop.left;
+            m_Targets[i].SurfaceY = m_OutputSurfaces[i].Desktop.top;
+        }
+        else
+        {
+            m_Targets[i].SharedHandle = GetSharedHandle(m_SharedSurf);
+            m_Targets[i].SurfaceX = DeskBounds->left;
+            m_Targets[i].SurfaceY = DeskBounds->top;
+        }
+
+        if (!m_Targets[i].SharedHandle)
+        {
+            return ProcessFailure(m_Device, L"Failed to get handle of shared surface", L"Error", E_FAIL);
+        }
     }
 
     return DUPL_RETURN_SUCCESS;
@@ -408,45 +660,115 @@ DUPL_RETURN OUTPUTMANAGER::CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCou
 //
 // Present to the application window
 //
-DUPL_RETURN OUTPUTMANAGER::UpdateApplicationWindow(_In_ PTR_INFO* PointerInfo, _Inout_ bool* Occluded)
+DUPL_RETURN OUTPUTMANAGER::UpdateApplicationWindow(_In_ POINTERSTATE* Pointer, _Inout_ bool* Occluded)
 {
     // In a typical desktop duplication application there would be an application running on one system collecting the desktop images
     // and another application running on a different system that receives the desktop images via a network and display the image. This
     // sample contains both these aspects into a single application.
     // This routine is the part of the sample that displays the desktop image onto the display
 
-    // Try and acquire sync on common display buffer
-    HRESULT hr = m_KeyMutex->AcquireSync(1, 100);
-    if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+    // Take a private copy of the pointer, this never waits on the capture threads
+    DUPL_RETURN Ret = Pointer->Read(&m_PtrInfo);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        // Another thread has the keyed mutex so try again later
-        return DUPL_RETURN_SUCCESS;
+        return Ret;
     }
-    else if (FAILED(hr))
+    m_Pointer = Pointer;
+    m_PointerShadow = Pointer->GetShadow();
+
+    // Draw the pointer where it should be once this frame is on screen
+    if (m_PredictPointer)
     {
-        return ProcessFailure(m_Device, L"Failed to acquire Keyed mutex in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        PredictPointer();
     }
 
+    HRESULT hr;
+    if (m_OutputSurfaceCount)
+    {
+        // Only this thread touches the desktop image, outputs with nothing new keep what was copied before
+        Ret = CollectOutputSurfaces();
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+    else
+    {
+        // Try and acquire sync on common display buffer
+        hr = m_KeyMutex->AcquireSync(1, 100);
+        if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+        {
+            // Another thread has the keyed mutex so try again later
+            return DUPL_RETURN_SUCCESS;
+        }
+        else if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to acquire Keyed mutex in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        // Capture threads only hand the surface over after drawing into it
+        m_SurfaceDamaged = true;
+    }
+
+    // Leave the last present on screen when this frame would look the same
+    RENDER_STATE State;
+    bool PointerOnly;
+    if (!NeedsRender(&State, &PointerOnly))
+    {
+        // The common surface counts as damaged whenever it was acquired so this is not reached holding it today,
+        // hand it back all the same rather than leave the capture threads waiting on it
+        if (m_KeyMutex)
+        {
+            hr = m_KeyMutex->ReleaseSync(0);
+            if (FAILED(hr))
+            {
+                return ProcessFailure(m_Device, L"Failed to Release Keyed mutex in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+            }
+        }
+
+        ++m_SkippedFrames;
+        WaitForVBlank();
+        return DUPL_RETURN_SUCCESS;
+    }
+    ++m_RenderedFrames;
+
     // Got mutex, so draw
-    DUPL_RETURN Ret = DrawFrame();
+#ifdef VR_DESKTOP
+	if (PointerOnly && m_EyeViews[0] && m_EyeViews[1] && State.PresentTime - m_EyesTime < RENDER_REFRESH_MS)
+	{
+		// Only the pointer changed, it goes over the eye textures of the last frame
+		++m_ReusedEyeFrames;
+		Ret = DrawDistortion();
+	}
+	else
+	{
+		// The pointer isn't drawn into the desktop, the distortion pass lays it over the eye textures
+		Ret = DrawFrame();
+		if (Ret == DUPL_RETURN_SUCCESS)
+		{
+			Ret = DrawToScreen();
+		}
+	}
+#else
+    Ret = DrawFrame();
     if (Ret == DUPL_RETURN_SUCCESS)
     {
-        // We have keyed mutex so we can access the mouse info
-        if (PointerInfo->Visible)
+        if (m_PtrInfo.Visible)
         {
             // Draw mouse into texture
-            Ret = DrawMouse(PointerInfo);
+            Ret = DrawMouse(&m_PtrInfo);
         }
     }
-#ifdef VR_DESKTOP
-	Ret = DrawToScreen();
 #endif // VR_DESKTOP
 
     // Release keyed mutex
-    hr = m_KeyMutex->ReleaseSync(0);
-    if (FAILED(hr))
+    if (m_KeyMutex)
     {
-        return ProcessFailure(m_Device, L"Failed to Release Keyed mutex in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        hr = m_KeyMutex->ReleaseSync(0);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to Release Keyed mutex in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
     }
 
     // Present to window if all worked
@@ -462,21 +784,295 @@ DUPL_RETURN OUTPUTMANAGER::UpdateApplicationWindow(_In_ PTR_INFO* PointerInfo, _
         {
             *Occluded = true;
         }
+
+#ifdef VR_DESKTOP
+		// Time the pointer took from its latch, and from DXGI seeing it move, to being presented
+		LARGE_INTEGER PresentTime;
+		QueryPerformanceCounter(&PresentTime);
+		++m_OverlayFrames;
+		m_OverlayLatchTicks += PresentTime.QuadPart - m_LatchTime.QuadPart;
+		if (m_PtrInfo.Visible && m_LatchedStamp && m_LatchedStamp != m_CountedStamp)
+		{
+			++m_OverlayMoves;
+			m_OverlayMoveTicks += PresentTime.QuadPart - m_LatchedStamp;
+			m_CountedStamp = m_LatchedStamp;
+		}
+
+		// What is on screen is the pointer latched in the distortion pass
+		State.PointerPosition = m_PtrInfo.Position;
+		State.PointerShape = m_PtrInfo.ShapeHash;
+		State.PointerVisible = m_PtrInfo.Visible;
+#endif // VR_DESKTOP
+
+        // Nothing was shown while occluded so the first frame after that is always drawn
+        m_HaveRendered = !*Occluded;
+        m_Rendered = State;
+        m_SurfaceDamaged = false;
     }
 
     return Ret;
 }
 
+//
+// Whether anything that goes into a frame changed since the last present: an output surface was copied,
+// the pointer moved or changed shape, the head turned or the view is being moved, the window was resized,
+// or the last present is RENDER_REFRESH_MS old. State is what this frame would be drawn from, PointerOnly is set
+// when the pointer is all that changed.
+//
+bool OUTPUTMANAGER::NeedsRender(_Out_ RENDER_STATE* State, _Out_ bool* PointerOnly)
+{
+    *PointerOnly = false;
+    RtlZeroMemory(State, sizeof(RENDER_STATE));
+    State->PointerPosition = m_PtrInfo.Position;
+    State->PointerShape = m_PtrInfo.ShapeHash;
+    State->PointerVisible = m_PtrInfo.Visible;
+    State->PresentTime = GetTickCount64();
+
+    bool ViewMoving = false;
+#ifdef VR_DESKTOP
+    float Input[1] = {1};
+    if (SZVR_GetData && SZVR_GetData(Input, State->Pose))
+    {
+        // Angle between the two orientations, in double since 1 - |cos| of a small angle is lost in a float
+        double Dot = static_cast<double>(State->Pose[0]) * m_Rendered.Pose[0] + static_cast<double>(State->Pose[1]) * m_Rendered.Pose[1] +
+                     static_cast<double>(State->Pose[2]) * m_Rendered.Pose[2] + static_cast<double>(State->Pose[3]) * m_Rendered.Pose[3];
+        double Degrees = 2.0 * acos(min(fabs(Dot), 1.0)) * (180.0 / 3.14159265358979323846);
+        ViewMoving = Degrees > RENDER_POSE_THRESHOLD_DEGREES;
+    }
+    ViewMoving = ViewMoving || IsViewMoving();
+#endif
+
+    if (!m_HaveRendered || m_SurfaceDamaged || m_NeedsResize || ViewMoving)
+    {
+        return true;
+    }
+
+    if (State->PointerVisible != m_Rendered.PointerVisible ||
+        (State->PointerVisible && (State->PointerShape != m_Rendered.PointerShape ||
+                                   State->PointerPosition.x != m_Rendered.PointerPosition.x ||
+                                   State->PointerPosition.y != m_Rendered.PointerPosition.y)))
+    {
+        *PointerOnly = true;
+        return true;
+    }
+
+    if (State->PresentTime - m_Rendered.PresentTime >= RENDER_REFRESH_MS)
+    {
+        return true;
+    }
+
+    // Poses are compared with the last present, not the last check, so slow drift still adds up to a new frame
+    return false;
+}
+
+//
+// Feeds the published pointer position to the predictor and moves the private copy to where the predictor expects
+// the pointer PREDICT_DISPLAY_LEAD_MS from now. Positions are timestamped by DXGI on the same clock as QPC.
+//
+void OUTPUTMANAGER::PredictPointer()
+{
+    if (!m_PtrInfo.Visible || !m_PtrInfo.LastTimeStamp.QuadPart)
+    {
+        m_Predictor.Reset();
+        return;
+    }
+
+    double Frequency = static_cast<double>(m_QpcFrequency.QuadPart);
+    m_Predictor.AddSample(m_PtrInfo.LastTimeStamp.QuadPart / Frequency, m_PtrInfo.Position.x, m_PtrInfo.Position.y);
+
+    LARGE_INTEGER Now;
+    QueryPerformanceCounter(&Now);
+    double X;
+    double Y;
+    if (m_Predictor.Predict((Now.QuadPart / Frequency) + (PREDICT_DISPLAY_LEAD_MS / 1000.0), &X, &Y))
+    {
+        m_PtrInfo.Position.x = static_cast<LONG>(floor(X + 0.5));
+        m_PtrInfo.Position.y = static_cast<LONG>(floor(Y + 0.5));
+    }
+}
+
+//
+// Stands in for the vsync wait of Present when a frame is skipped
+//
+void OUTPUTMANAGER::WaitForVBlank()
+{
+    if (!m_VBlankOutput && FAILED(m_SwapChain->GetContainingOutput(&m_VBlankOutput)))
+    {
+        m_VBlankOutput = nullptr;
+    }
+
+    if (!m_VBlankOutput || FAILED(m_VBlankOutput->WaitForVBlank()))
+    {
+        Sleep(1);
+    }
+}
+
+//
+// Copies every output surface a capture thread has drawn into since the last call into the desktop image.
+// A surface whose keyed mutex can't be had right away is either unchanged or being drawn into, it is picked up next time.
+// A mailbox hands over its latest slot without waiting, nobody else holds that slot's keyed mutex.
+//
+DUPL_RETURN OUTPUTMANAGER::CollectOutputSurfaces()
+{
+    for (UINT i = 0; i < m_OutputSurfaceCount; ++i)
+    {
+        OUTPUT_SURFACE* Output = &m_OutputSurfaces[i];
+        if (Output->Mailbox)
+        {
+            DUPL_RETURN Ret = CollectMailbox(Output);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+            continue;
+        }
+
+        HRESULT hr = Output->KeyMutex->AcquireSync(1, 0);
+        if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+        {
+            continue;
+        }
+        else if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to acquire keyed mutex of output surface in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        m_DeviceContext->CopySubresourceRegion(m_SharedSurf, 0, Output->X, Output->Y, 0, Output->Surface, 0, nullptr);
+        m_SurfaceDamaged = true;
+
+        hr = Output->KeyMutex->ReleaseSync(0);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to release keyed mutex of output surface in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies the latest slot of an output's mailbox into the desktop image if it wasn't copied yet
+//
+DUPL_RETURN OUTPUTMANAGER::CollectMailbox(_Inout_ OUTPUT_SURFACE* Output)
+{
+    UINT Slot;
+    if (Output->Mailbox->Acquire(&Slot))
+    {
+        Output->Pending = true;
+    }
+
+    if (!Output->Pending)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    // The keyed mutex only orders this device's reads after the capture device's writes
+    HRESULT hr = Output->SlotMutexes[Slot]->AcquireSync(0, 0);
+    if (hr == static_cast<HRESULT>(WAIT_TIMEOUT))
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+    else if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to acquire keyed mutex of mailbox slot in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    m_DeviceContext->CopySubresourceRegion(m_SharedSurf, 0, Output->X, Output->Y, 0, Output->Slots[Slot], 0, nullptr);
+    Output->Pending = false;
+    m_SurfaceDamaged = true;
+
+    hr = Output->SlotMutexes[Slot]->ReleaseSync(0);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to release keyed mutex of mailbox slot in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Releases the per output surfaces and the surface targets
+//
+void OUTPUTMANAGER::ReleaseOutputSurfaces()
+{
+    if (m_OutputSurfaces)
+    {
+        for (UINT i = 0; i < m_OutputSurfaceCount; ++i)
+        {
+            if (m_OutputSurfaces[i].KeyMutex)
+            {
+                m_OutputSurfaces[i].KeyMutex->Release();
+                m_OutputSurfaces[i].KeyMutex = nullptr;
+            }
+
+            if (m_OutputSurfaces[i].Surface)
+            {
+                m_OutputSurfaces[i].Surface->Release();
+                m_OutputSurfaces[i].Surface = nullptr;
+            }
+
+            for (UINT Slot = 0; Slot < MAILBOX_SLOTS; ++Slot)
+            {
+                if (m_OutputSurfaces[i].SlotMutexes[Slot])
+                {
+                    m_OutputSurfaces[i].SlotMutexes[Slot]->Release();
+                    m_OutputSurfaces[i].SlotMutexes[Slot] = nullptr;
+                }
+
+                if (m_OutputSurfaces[i].Slots[Slot])
+                {
+                    m_OutputSurfaces[i].Slots[Slot]->Release();
+                    m_OutputSurfaces[i].Slots[Slot] = nullptr;
+                }
+            }
+
+            // Report how many frames the renderer never saw and how often it had nothing new
+            if (m_OutputSurfaces[i].Mailbox)
+            {
+                MAILBOX_STATS MailboxStats;
+                m_OutputSurfaces[i].Mailbox->GetStats(&MailboxStats);
+                if (MailboxStats.Published)
+                {
+                    WCHAR StatsMsg[256];
+                    swprintf_s(StatsMsg, 256, L"Output surface %u mailbox: %llu published, %llu dropped, %llu consumed, %llu reused\n",
+                               i, MailboxStats.Published, MailboxStats.Dropped, MailboxStats.Consumed, MailboxStats.Reused);
+                    OutputDebugStringW(StatsMsg);
+                }
+                delete m_OutputSurfaces[i].Mailbox;
+                m_OutputSurfaces[i].Mailbox = nullptr;
+            }
+        }
+        delete [] m_OutputSurfaces;
+        m_OutputSurfaces = nullptr;
+    }
+    m_OutputSurfaceCount = 0;
+
+    if (m_Targets)
+    {
+        delete [] m_Targets;
+        m_Targets = nullptr;
+    }
+    m_TargetCount = 0;
+}
+
+//
+// Returns the surface each duplication thread draws into, one per output
+//
+SURFACE_TARGET* OUTPUTMANAGER::GetSurfaceTargets()
+{
+    return m_Targets;
+}
+
 //
 // Returns shared handle
 //
-HANDLE OUTPUTMANAGER::GetSharedHandle()
+HANDLE OUTPUTMANAGER::GetSharedHandle(_In_ ID3D11Texture2D* Surface)
 {
     HANDLE Hnd = nullptr;
 
     // QI IDXGIResource interface to synchronized shared surface.
     IDXGIResource* DXGIResource = nullptr;
-    HRESULT hr = m_SharedSurf->QueryInterface(__uuidof(IDXGIResource), reinterpret_cast<void**>(&DXGIResource));
+    HRESULT hr = Surface->QueryInterface(__uuidof(IDXGIResource), reinterpret_cast<void**>(&DXGIResource));
     if (SUCCEEDED(hr))
     {
         // Obtain handle to IDXGIResource object.
@@ -488,6 +1084,14 @@ HANDLE OUTPUTMANAGER::GetSharedHandle()
     return Hnd;
 }
 
+//
+// Returns the dirty tile map of the shared surface
+//
+TILEMAP* OUTPUTMANAGER::GetTileMap()
+{
+    return &m_TileMap;
+}
+
 //
 // Draw frame into backbuffer
 //
@@ -589,10 +1193,14 @@ DUPL_RETURN OUTPUTMANAGER::DrawFrame()
 }
 
 //
-// Process both masked and monochrome pointers
+// Process both masked and monochrome pointers into the cursor cache's scratch texture
 //
-DUPL_RETURN OUTPUTMANAGER::ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Outptr_result_bytebuffer_(*PtrHeight * *PtrWidth * BPP) BYTE** InitBuffer, _Out_ D3D11_BOX* Box)
+DUPL_RETURN OUTPUTMANAGER::ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Outptr_result_maybenull_ ID3D11ShaderResourceView** ShaderRes, _Out_ FLOAT* TexRight, _Out_ FLOAT* TexBottom)
 {
+    *ShaderRes = nullptr;
+    *TexRight = 1.0f;
+    *TexBottom = 1.0f;
+
     // Desktop dimensions
     D3D11_TEXTURE2D_DESC FullDesc;
     m_SharedSurf->GetDesc(&FullDesc);
@@ -643,134 +1251,178 @@ DUPL_RETURN OUTPUTMANAGER::ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInf
     *PtrLeft = (GivenLeft < 0) ? 0 : GivenLeft;
     *PtrTop = (GivenTop < 0) ? 0 : GivenTop;
 
-    // Staging buffer/texture
-    D3D11_TEXTURE2D_DESC CopyBufferDesc;
-    CopyBufferDesc.Width = *PtrWidth;
-    CopyBufferDesc.Height = *PtrHeight;
-    CopyBufferDesc.MipLevels = 1;
-    CopyBufferDesc.ArraySize = 1;
-    CopyBufferDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    CopyBufferDesc.SampleDesc.Count = 1;
-    CopyBufferDesc.SampleDesc.Quality = 0;
-    CopyBufferDesc.Usage = D3D11_USAGE_STAGING;
-    CopyBufferDesc.BindFlags = 0;
-    CopyBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-    CopyBufferDesc.MiscFlags = 0;
-
-    ID3D11Texture2D* CopyBuffer = nullptr;
-    HRESULT hr = m_Device->CreateTexture2D(&CopyBufferDesc, nullptr, &CopyBuffer);
-    if (FAILED(hr))
+    // Nothing of the pointer is on the desktop
+    if (*PtrWidth <= 0 || *PtrHeight <= 0)
     {
-        return ProcessFailure(m_Device, L"Failed creating staging texture for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        return DUPL_RETURN_SUCCESS;
     }
 
-    // Copy needed part of desktop image
-    Box->left = *PtrLeft;
-    Box->top = *PtrTop;
-    Box->right = *PtrLeft + *PtrWidth;
-    Box->bottom = *PtrTop + *PtrHeight;
-    m_DeviceContext->CopySubresourceRegion(CopyBuffer, 0, 0, 0, 0, m_SharedSurf, 0, Box);
-
-    // QI for IDXGISurface
-    IDXGISurface* CopySurface = nullptr;
-    hr = CopyBuffer->QueryInterface(__uuidof(IDXGISurface), (void **)&CopySurface);
-    CopyBuffer->Release();
-    CopyBuffer = nullptr;
-    if (FAILED(hr))
+    // Scratch resources only ever grow so steady state drawing creates nothing here
+    ID3D11Texture2D* Staging = nullptr;
+    ID3D11Texture2D* MaskedTex = nullptr;
+    BYTE* InitBuffer = nullptr;
+    DUPL_RETURN Ret = m_CursorCache.GetMaskedScratch(*PtrWidth, *PtrHeight, &Staging, &MaskedTex, ShaderRes, &InitBuffer);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        return ProcessFailure(nullptr, L"Failed to QI staging texture into IDXGISurface for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        *ShaderRes = nullptr;
+        return Ret;
     }
 
-    // Map pixels
-    DXGI_MAPPED_RECT MappedSurface;
-    hr = CopySurface->Map(&MappedSurface, DXGI_MAP_READ);
-    if (FAILED(hr))
+    UINT* InitBuffer32 = reinterpret_cast<UINT*>(InitBuffer);
+    UINT* Desktop32 = InitBuffer32;
+    UINT  DesktopPitchInPixels = *PtrWidth;
+
+    // The pointer shadow has the desktop under the pointer unless the pointer just moved out of it,
+    // the pixels go straight into the buffer the pointer is built in
+    D3D11_BOX Box;
+    Box.left = *PtrLeft;
+    Box.top = *PtrTop;
+    Box.front = 0;
+    Box.right = *PtrLeft + *PtrWidth;
+    Box.bottom = *PtrTop + *PtrHeight;
+    Box.back = 1;
+    RECT ShadowBox = { *PtrLeft, *PtrTop, *PtrLeft + *PtrWidth, *PtrTop + *PtrHeight };
+    LARGE_INTEGER BackdropStart;
+    LARGE_INTEGER BackdropEnd;
+    QueryPerformanceCounter(&BackdropStart);
+    m_ShadowInUse = (m_PointerShadow != nullptr);
+    bool Mapped = !m_ShadowInUse || !m_PointerShadow->Read(&ShadowBox, InitBuffer, *PtrWidth * BPP);
+    if (Mapped)
+    {
+        // Copy needed part of desktop image into the corner of the staging texture
+        m_DeviceContext->CopySubresourceRegion(Staging, 0, 0, 0, 0, m_SharedSurf, 0, &Box);
+
+        // Map pixels, this waits for the GPU
+        D3D11_MAPPED_SUBRESOURCE MappedSurface;
+        HRESULT hr = m_DeviceContext->Map(Staging, 0, D3D11_MAP_READ, 0, &MappedSurface);
+        if (FAILED(hr))
+        {
+            *ShaderRes = nullptr;
+            return ProcessFailure(m_Device, L"Failed to map surface for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+
+        Desktop32 = reinterpret_cast<UINT*>(MappedSurface.pData);
+        DesktopPitchInPixels = MappedSurface.RowPitch / sizeof(UINT);
+    }
+    QueryPerformanceCounter(&BackdropEnd);
+    if (Mapped)
     {
-        CopySurface->Release();
-        CopySurface = nullptr;
-        return ProcessFailure(m_Device, L"Failed to map surface for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        ++m_ReadbackBackdrops;
+        m_ReadbackBackdropTicks += BackdropEnd.QuadPart - BackdropStart.QuadPart;
     }
-
-    // New mouseshape buffer
-    *InitBuffer = new (std::nothrow) BYTE[*PtrWidth * *PtrHeight * BPP];
-    if (!(*InitBuffer))
+    else
     {
-        return ProcessFailure(nullptr, L"Failed to allocate memory for new mouse shape buffer.", L"Error", E_OUTOFMEMORY);
+        ++m_ShadowBackdrops;
+        m_ShadowBackdropTicks += BackdropEnd.QuadPart - BackdropStart.QuadPart;
     }
 
-    UINT* InitBuffer32 = reinterpret_cast<UINT*>(*InitBuffer);
-    UINT* Desktop32 = reinterpret_cast<UINT*>(MappedSurface.pBits);
-    UINT  DesktopPitchInPixels = MappedSurface.Pitch / sizeof(UINT);
-
     // What to skip (pixel offset)
     UINT SkipX = (GivenLeft < 0) ? (-1 * GivenLeft) : (0);
     UINT SkipY = (GivenTop < 0) ? (-1 * GivenTop) : (0);
 
+    // Whole rows go through the kernels the CPU runs best, the AND mask is the top half of a monochrome shape
     if (IsMono)
     {
+        MONO_ROW_PROC MonoRow = m_CursorKernels.GetMonoRow();
+        UINT XorOffset = (PtrInfo->ShapeInfo.Height / 2) * PtrInfo->ShapeInfo.Pitch;
         for (INT Row = 0; Row < *PtrHeight; ++Row)
         {
-            // Set mask
-            BYTE Mask = 0x80;
-            Mask = Mask >> (SkipX % 8);
-            for (INT Col = 0; Col < *PtrWidth; ++Col)
-            {
-                // Get masks using appropriate offsets
-                BYTE AndMask = PtrInfo->PtrShapeBuffer[((Col + SkipX) / 8) + ((Row + SkipY) * (PtrInfo->ShapeInfo.Pitch))] & Mask;
-                BYTE XorMask = PtrInfo->PtrShapeBuffer[((Col + SkipX) / 8) + ((Row + SkipY + (PtrInfo->ShapeInfo.Height / 2)) * (PtrInfo->ShapeInfo.Pitch))] & Mask;
-                UINT AndMask32 = (AndMask) ? 0xFFFFFFFF : 0xFF000000;
-                UINT XorMask32 = (XorMask) ? 0x00FFFFFF : 0x00000000;
-
-                // Set new pixel
-                InitBuffer32[(Row * *PtrWidth) + Col] = (Desktop32[(Row * DesktopPitchInPixels) + Col] & AndMask32) ^ XorMask32;
-
-                // Adjust mask
-                if (Mask == 0x01)
-                {
-                    Mask = 0x80;
-                }
-                else
-                {
-                    Mask = Mask >> 1;
-                }
-            }
+            const BYTE* AndRow = PtrInfo->PtrShapeBuffer + ((Row + SkipY) * PtrInfo->ShapeInfo.Pitch);
+            MonoRow(InitBuffer32 + (Row * *PtrWidth), Desktop32 + (Row * DesktopPitchInPixels), AndRow, AndRow + XorOffset, SkipX, *PtrWidth);
         }
     }
     else
     {
+        COLOR_ROW_PROC ColorRow = m_CursorKernels.GetColorRow();
         UINT* Buffer32 = reinterpret_cast<UINT*>(PtrInfo->PtrShapeBuffer);
-
-        // Iterate through pixels
+        UINT ShapePitchInPixels = PtrInfo->ShapeInfo.Pitch / sizeof(UINT);
         for (INT Row = 0; Row < *PtrHeight; ++Row)
         {
-            for (INT Col = 0; Col < *PtrWidth; ++Col)
+            ColorRow(InitBuffer32 + (Row * *PtrWidth), Desktop32 + (Row * DesktopPitchInPixels), Buffer32 + SkipX + ((Row + SkipY) * ShapePitchInPixels), *PtrWidth);
+        }
+    }
+
+    // Done with resource
+    if (Mapped)
+    {
+        m_DeviceContext->Unmap(Staging, 0);
+    }
+
+    // Only the corner the pointer covers is replaced, texture coordinates are scaled to match
+    Box.left = 0;
+    Box.top = 0;
+    Box.right = *PtrWidth;
+    Box.bottom = *PtrHeight;
+    m_DeviceContext->UpdateSubresource(MaskedTex, 0, &Box, InitBuffer, *PtrWidth * BPP, 0);
+
+    D3D11_TEXTURE2D_DESC ScratchDesc;
+    MaskedTex->GetDesc(&ScratchDesc);
+    *TexRight = *PtrWidth / static_cast<FLOAT>(ScratchDesc.Width);
+    *TexBottom = *PtrHeight / static_cast<FLOAT>(ScratchDesc.Height);
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Get the texture the pointer is drawn from and where it goes in the desktop image.
+// ShaderRes is null when none of the pointer is on the desktop.
+//
+DUPL_RETURN OUTPUTMANAGER::PreparePointer(_Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Outptr_result_maybenull_ ID3D11ShaderResourceView** ShaderRes, _Out_ FLOAT* TexRight, _Out_ FLOAT* TexBottom)
+{
+    *ShaderRes = nullptr;
+    *PtrLeft = 0;
+    *PtrTop = 0;
+    *PtrWidth = 0;
+    *PtrHeight = 0;
+
+    // Part of the texture the pointer uses, scratch textures can be larger than the pointer
+    *TexRight = 1.0f;
+    *TexBottom = 1.0f;
+
+    DUPL_RETURN Ret = DUPL_RETURN_SUCCESS;
+    switch (PtrInfo->ShapeInfo.Type)
+    {
+        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR:
+        {
+            *PtrLeft = PtrInfo->Position.x;
+            *PtrTop = PtrInfo->Position.y;
+
+            *PtrWidth = static_cast<INT>(PtrInfo->ShapeInfo.Width);
+            *PtrHeight = static_cast<INT>(PtrInfo->ShapeInfo.Height);
+
+            Ret = m_CursorCache.GetColorCursor(PtrInfo, ShaderRes);
+
+            // Capture threads can stop keeping the desktop under the pointer
+            if (m_ShadowInUse)
             {
-                // Set up mask
-                UINT MaskVal = 0xFF000000 & Buffer32[(Col + SkipX) + ((Row + SkipY) * (PtrInfo->ShapeInfo.Pitch / sizeof(UINT)))];
-                if (MaskVal)
-                {
-                    // Mask was 0xFF
-                    InitBuffer32[(Row * *PtrWidth) + Col] = (Desktop32[(Row * DesktopPitchInPixels) + Col] ^ Buffer32[(Col + SkipX) + ((Row + SkipY) * (PtrInfo->ShapeInfo.Pitch / sizeof(UINT)))]) | 0xFF000000;
-                }
-                else
-                {
-                    // Mask was 0x00
-                    InitBuffer32[(Row * *PtrWidth) + Col] = Buffer32[(Col + SkipX) + ((Row + SkipY) * (PtrInfo->ShapeInfo.Pitch / sizeof(UINT)))] | 0xFF000000;
-                }
+                m_PointerShadow->Reset();
+                m_ShadowInUse = false;
             }
+            break;
+        }
+
+        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME:
+        {
+            Ret = ProcessMonoMask(true, PtrInfo, PtrWidth, PtrHeight, PtrLeft, PtrTop, ShaderRes, TexRight, TexBottom);
+            break;
+        }
+
+        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
+        {
+            Ret = ProcessMonoMask(false, PtrInfo, PtrWidth, PtrHeight, PtrLeft, PtrTop, ShaderRes, TexRight, TexBottom);
+            break;
         }
+
+        default:
+            break;
     }
 
-    // Done with resource
-    hr = CopySurface->Unmap();
-    CopySurface->Release();
-    CopySurface = nullptr;
-    if (FAILED(hr))
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        return ProcessFailure(m_Device, L"Failed to unmap surface for pointer", L"Error", hr, SystemTransitionsExpectedErrors);
+        *ShaderRes = nullptr;
     }
 
-    return DUPL_RETURN_SUCCESS;
+    return Ret;
 }
 
 //
@@ -778,13 +1430,9 @@ DUPL_RETURN OUTPUTMANAGER::ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInf
 //
 DUPL_RETURN OUTPUTMANAGER::DrawMouse(_In_ PTR_INFO* PtrInfo)
 {
-    // Vars to be used
-    ID3D11Texture2D* MouseTex = nullptr;
+    // Vars to be used, all owned by the cursor cache
     ID3D11ShaderResourceView* ShaderRes = nullptr;
     ID3D11Buffer* VertexBufferMouse = nullptr;
-    D3D11_SUBRESOURCE_DATA InitData;
-    D3D11_TEXTURE2D_DESC Desc;
-    D3D11_SHADER_RESOURCE_VIEW_DESC SDesc;
 
     // Position will be changed based on mouse position
     VERTEX Vertices[NUMVERTICES] =
@@ -807,62 +1455,23 @@ DUPL_RETURN OUTPUTMANAGER::DrawMouse(_In_ PTR_INFO* PtrInfo)
     INT CenterY = (DesktopHeight / 2);
 
     // Clipping adjusted coordinates / dimensions
-    INT PtrWidth = 0;
-    INT PtrHeight = 0;
-    INT PtrLeft = 0;
-    INT PtrTop = 0;
-
-    // Buffer used if necessary (in case of monochrome or masked pointer)
-    BYTE* InitBuffer = nullptr;
-
-    // Used for copying pixels
-    D3D11_BOX Box;
-    Box.front = 0;
-    Box.back = 1;
-
-    Desc.MipLevels = 1;
-    Desc.ArraySize = 1;
-    Desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    Desc.SampleDesc.Count = 1;
-    Desc.SampleDesc.Quality = 0;
-    Desc.Usage = D3D11_USAGE_DEFAULT;
-    Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    Desc.CPUAccessFlags = 0;
-    Desc.MiscFlags = 0;
-
-    // Set shader resource properties
-    SDesc.Format = Desc.Format;
-    SDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    SDesc.Texture2D.MostDetailedMip = Desc.MipLevels - 1;
-    SDesc.Texture2D.MipLevels = Desc.MipLevels;
-
-    switch (PtrInfo->ShapeInfo.Type)
+    INT PtrWidth;
+    INT PtrHeight;
+    INT PtrLeft;
+    INT PtrTop;
+    FLOAT TexRight;
+    FLOAT TexBottom;
+
+    DUPL_RETURN Ret = PreparePointer(PtrInfo, &PtrLeft, &PtrTop, &PtrWidth, &PtrHeight, &ShaderRes, &TexRight, &TexBottom);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR:
-        {
-            PtrLeft = PtrInfo->Position.x;
-            PtrTop = PtrInfo->Position.y;
-
-            PtrWidth = static_cast<INT>(PtrInfo->ShapeInfo.Width);
-            PtrHeight = static_cast<INT>(PtrInfo->ShapeInfo.Height);
-
-            break;
-        }
-
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME:
-        {
-            ProcessMonoMask(true, PtrInfo, &PtrWidth, &PtrHeight, &PtrLeft, &PtrTop, &InitBuffer, &Box);
-            break;
-        }
-
-        case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR:
-        {
-            ProcessMonoMask(false, PtrInfo, &PtrWidth, &PtrHeight, &PtrLeft, &PtrTop, &InitBuffer, &Box);
-            break;
-        }
+        return Ret;
+    }
 
-        default:
-            break;
+    // Nothing to draw
+    if (!ShaderRes)
+    {
+        return DUPL_RETURN_SUCCESS;
     }
 
     // VERTEX creation
@@ -879,50 +1488,17 @@ DUPL_RETURN OUTPUTMANAGER::DrawMouse(_In_ PTR_INFO* PtrInfo)
     Vertices[5].Pos.x = ((PtrLeft + PtrWidth) - CenterX) / (FLOAT)CenterX;
     Vertices[5].Pos.y = -1 * (PtrTop - CenterY) / (FLOAT)CenterY;
 
-    // Set texture properties
-    Desc.Width = PtrWidth;
-    Desc.Height = PtrHeight;
-
-    // Set up init data
-    InitData.pSysMem = (PtrInfo->ShapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR) ? PtrInfo->PtrShapeBuffer : InitBuffer;
-    InitData.SysMemPitch = (PtrInfo->ShapeInfo.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR) ? PtrInfo->ShapeInfo.Pitch : PtrWidth * BPP;
-    InitData.SysMemSlicePitch = 0;
-
-    // Create mouseshape as texture
-    HRESULT hr = m_Device->CreateTexture2D(&Desc, &InitData, &MouseTex);
-    if (FAILED(hr))
-    {
-        return ProcessFailure(m_Device, L"Failed to create mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
-    }
-
-    // Create shader resource from texture
-    hr = m_Device->CreateShaderResourceView(MouseTex, &SDesc, &ShaderRes);
-    if (FAILED(hr))
+    for (UINT i = 0; i < NUMVERTICES; ++i)
     {
-        MouseTex->Release();
-        MouseTex = nullptr;
-        return ProcessFailure(m_Device, L"Failed to create shader resource from mouse pointer texture", L"Error", hr, SystemTransitionsExpectedErrors);
+        Vertices[i].TexCoord.x *= TexRight;
+        Vertices[i].TexCoord.y *= TexBottom;
     }
 
-    D3D11_BUFFER_DESC BDesc;
-    ZeroMemory(&BDesc, sizeof(D3D11_BUFFER_DESC));
-    BDesc.Usage = D3D11_USAGE_DEFAULT;
-    BDesc.ByteWidth = sizeof(VERTEX) * NUMVERTICES;
-    BDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    BDesc.CPUAccessFlags = 0;
-
-    ZeroMemory(&InitData, sizeof(D3D11_SUBRESOURCE_DATA));
-    InitData.pSysMem = Vertices;
-
-    // Create vertex buffer
-    hr = m_Device->CreateBuffer(&BDesc, &InitData, &VertexBufferMouse);
-    if (FAILED(hr))
+    // Fill the cached vertex buffer
+    Ret = m_CursorCache.SetQuad(Vertices, &VertexBufferMouse);
+    if (Ret != DUPL_RETURN_SUCCESS)
     {
-        ShaderRes->Release();
-        ShaderRes = nullptr;
-        MouseTex->Release();
-        MouseTex = nullptr;
-        return ProcessFailure(m_Device, L"Failed to create mouse pointer vertex buffer in OutputManager", L"Error", hr, SystemTransitionsExpectedErrors);
+        return Ret;
     }
 
     // Set resources
@@ -940,146 +1516,83 @@ DUPL_RETURN OUTPUTMANAGER::DrawMouse(_In_ PTR_INFO* PtrInfo)
     // Draw
     m_DeviceContext->Draw(NUMVERTICES, 0);
 
-    // Clean
-    if (VertexBufferMouse)
-    {
-        VertexBufferMouse->Release();
-        VertexBufferMouse = nullptr;
-    }
-    if (ShaderRes)
-    {
-        ShaderRes->Release();
-        ShaderRes = nullptr;
-    }
-    if (MouseTex)
-    {
-        MouseTex->Release();
-        MouseTex = nullptr;
-    }
-    if (InitBuffer)
-    {
-        delete [] InitBuffer;
-        InitBuffer = nullptr;
-    }
-
     return DUPL_RETURN_SUCCESS;
 }
 
 #ifdef VR_DESKTOP
-DUPL_RETURN OUTPUTMANAGER::DrawWindows(std::vector<HWND> windows)
+//
+// Hands the windows to capture to m_WindowCapture and uploads the captures that arrived since the last frame.
+// Never waits on a window, one that hasn't been captured yet keeps its last texture or isn't drawn.
+//
+DUPL_RETURN OUTPUTMANAGER::UpdateWindows(const std::vector<HWND>& windows)
 {
-	int totalWindow = windows.size();
-
-	if (totalWindow > 0)
+	for (UINT i = 0; i < MAX_WINDOWS; ++i)
 	{
-		for (int i = 0; i < totalWindow && i < MAX_WINDOWS; ++i)
+		m_WindowCapture.SetWindow(i, i < windows.size() ? windows[i] : nullptr);
+
+		const WINDOW_BUFFER* Frame;
+		if (!m_WindowCapture.Acquire(i, &Frame) || !Frame->Pixels)
 		{
-			RECT rc;
-			HWND hwnd = windows.at(i);
-
-			GetWindowRect(hwnd, &rc);
-			int winWidth = rc.right - rc.left;
-			int winHeight = rc.bottom - rc.top;
-
-			HDC hdcScreen = GetWindowDC(hwnd);
-			HDC hdc = CreateCompatibleDC(hdcScreen);
-			HBITMAP hbmp = CreateCompatibleBitmap(hdcScreen, winWidth, winHeight);
-			SelectObject(hdc, hbmp);
-			PrintWindow(hwnd, hdc, NULL);
-			//BitBlt(hdc, 0, 0, rc.right - rc.left, rc.bottom - rc.top, hdcScreen, 0, 0, SRCCOPY);
-
-			BITMAPINFOHEADER bmih;
-			ZeroMemory(&bmih, sizeof(BITMAPINFOHEADER));
-			bmih.biSize = sizeof(BITMAPINFOHEADER);
-			bmih.biPlanes = 1;
-			bmih.biBitCount = 32;
-			bmih.biWidth = winWidth;
-			bmih.biHeight = -winHeight;
-			bmih.biCompression = BI_RGB;
-			bmih.biSizeImage = 0;
-
-			int bytes_per_pixel = bmih.biBitCount / 8;
-			BYTE *pixels = (BYTE*)malloc(bytes_per_pixel * winWidth * winHeight);
-
-			BITMAPINFO bmi = { 0 };
-			bmi.bmiHeader = bmih;
-
-			int row_count;
-			row_count = GetDIBits(hdc, hbmp, 0, winHeight, pixels, &bmi, DIB_RGB_COLORS);
-
-			DeleteDC(hdc);
-			DeleteObject(hbmp);
-			ReleaseDC(NULL, hdcScreen);
-
-			D3D11_TEXTURE2D_DESC desc = CD3D11_TEXTURE2D_DESC(
-				DXGI_FORMAT_B8G8R8A8_UNORM,
-				winWidth,
-				winHeight,
-				1,
-				1,
-				D3D11_BIND_SHADER_RESOURCE,
-				D3D11_USAGE_DYNAMIC,
-				D3D11_CPU_ACCESS_WRITE,
-				1,
-				0,
-				0
-				);
-
-			D3D11_SUBRESOURCE_DATA data;
-			RtlZeroMemory(&data, sizeof(data));
-			data.pSysMem = pixels;
-			data.SysMemPitch = bytes_per_pixel*winWidth;
-			data.SysMemSlicePitch = bytes_per_pixel*winWidth*winHeight;
-
-			ID3D11Texture2D* windowTexture = nullptr;
-			ID3D11ShaderResourceView* windowSRV = nullptr;
-
-			HRESULT hr;
-			hr = m_Device->CreateTexture2D(&desc, &data, &windowTexture);
-			if (FAILED(hr))
-			{
-				return DUPL_RETURN_ERROR_EXPECTED;
-			}
+			continue;
+		}
 
-			data.pSysMem = nullptr;
-			free(pixels);
+		int winWidth = Frame->Width;
+		int winHeight = Frame->Height;
+		DUPL_RETURN Ret = ResizeWindowSlot(i, winWidth, winHeight);
+		if (Ret != DUPL_RETURN_SUCCESS)
+		{
+			return Ret;
+		}
 
-			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-			srvDesc.Format = desc.Format;
-			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MostDetailedMip = 0;
-			srvDesc.Texture2D.MipLevels = 1;
+		WINDOW_SLOT* Slot = &m_WindowSlots[i];
 
-			hr = m_Device->CreateShaderResourceView(windowTexture, &srvDesc, &windowSRV);
-			if (FAILED(hr))
-			{
-				return DUPL_RETURN_ERROR_EXPECTED;
-			}
+		// Only the tiles that changed since the last upload are written, the texture keeps the rest.
+		// If the differ runs out of memory it has forgotten the last frame, so the whole window goes up.
+		COMPOSE_RECT* DirtyRects;
+		unsigned DirtyCount;
+		COMPOSE_RECT Whole = {0, 0, winWidth, winHeight};
+		UINT Pitch = winWidth * BPP;
+		if (!m_WindowDiffers[i].Diff(Frame->Pixels, winWidth, winHeight, Pitch, &DirtyRects, &DirtyCount))
+		{
+			DirtyRects = &Whole;
+			DirtyCount = 1;
+		}
+		if (!DirtyCount)
+		{
+			continue;
+		}
 
-			m_widthSteps[i] = (float)winWidth / (float)winHeight;
+		LARGE_INTEGER UploadStart;
+		LARGE_INTEGER UploadEnd;
+		QueryPerformanceCounter(&UploadStart);
+		for (unsigned Dirty = 0; Dirty < DirtyCount; ++Dirty)
+		{
+			const COMPOSE_RECT& Rect = DirtyRects[Dirty];
+			D3D11_BOX Box;
+			Box.left = Rect.left;
+			Box.top = Rect.top;
+			Box.front = 0;
+			Box.right = Rect.right;
+			Box.bottom = Rect.bottom;
+			Box.back = 1;
+
+			const BYTE* Src = Frame->Pixels + (Rect.top * Pitch) + (Rect.left * BPP);
+			m_DeviceContext->UpdateSubresource(Slot->Texture, 0, &Box, Src, Pitch, 0);
+			m_WindowUploadPixels += static_cast<ULONGLONG>(Rect.right - Rect.left) * (Rect.bottom - Rect.top);
+		}
+		QueryPerformanceCounter(&UploadEnd);
+		++m_WindowUploads;
+		m_WindowUploadRects += DirtyCount;
+		m_WindowUploadTicks += UploadEnd.QuadPart - UploadStart.QuadPart;
 
-			if (m_windows[i])
-			{
-				m_windows[i]->Release();
-				m_windows[i] = nullptr;
-			}
+		m_widthSteps[i] = (float)winWidth / (float)winHeight;
+	}
 
-			if (windowSRV)
-			{
-				m_windows[i] = windowSRV;
-				m_windows[i]->AddRef();
-				windowSRV->Release();
-				windowSRV = nullptr;
-			}
+	return DUPL_RETURN_SUCCESS;
+}
 
-			if (windowTexture)
-			{
-				windowTexture->Release();
-				windowTexture = nullptr;
-			}
-		}
-	}
-	
+DUPL_RETURN OUTPUTMANAGER::DrawWindows()
+{
 		for (int i = 0; i < MAX_WINDOWS && m_windows[i] != nullptr; i++)
 		{
 			float width = m_widthSteps[i];
@@ -1093,7 +1606,7 @@ DUPL_RETURN OUTPUTMANAGER::DrawWindows(std::vector<HWND> windows)
 			float sita = XMConvertToRadians(-startAngle);	// sita range from -60 to 60
 			float delta = XMConvertToRadians((endAngle - startAngle) / (float)n);	// draw texture every 5 degree
 
-			float centerZ = 8.0f;	// circle center z-axis offset
+			float centerZ = SCREEN_CENTER_Z;	// circle center z-axis offset
 			float centerX = 0.0f;	// circle center x-axis offset
 
 			const int numVer = n * 4;
@@ -1238,6 +1751,85 @@ DUPL_RETURN OUTPUTMANAGER::DrawWindows(std::vector<HWND> windows)
  	return DUPL_RETURN_SUCCESS;
 }
 
+//
+// Make slot Index a Width by Height texture, a slot that already has that size is kept
+//
+DUPL_RETURN OUTPUTMANAGER::ResizeWindowSlot(UINT Index, INT Width, INT Height)
+{
+	WINDOW_SLOT* Slot = &m_WindowSlots[Index];
+	if (Slot->Texture && Slot->Width == Width && Slot->Height == Height)
+	{
+		return DUPL_RETURN_SUCCESS;
+	}
+
+	ReleaseWindowSlot(Index);
+	Slot->Width = Width;
+	Slot->Height = Height;
+
+	D3D11_TEXTURE2D_DESC desc = CD3D11_TEXTURE2D_DESC(
+		DXGI_FORMAT_B8G8R8A8_UNORM,
+		Width,
+		Height,
+		1,
+		1,
+		D3D11_BIND_SHADER_RESOURCE,
+		D3D11_USAGE_DEFAULT,
+		0,
+		1,
+		0,
+		0
+		);
+
+	HRESULT hr = m_Device->CreateTexture2D(&desc, nullptr, &Slot->Texture);
+	if (FAILED(hr))
+	{
+		ReleaseWindowSlot(Index);
+		return ProcessFailure(m_Device, L"Failed to create window texture in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	srvDesc.Format = desc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = 1;
+
+	hr = m_Device->CreateShaderResourceView(Slot->Texture, &srvDesc, &m_windows[Index]);
+	if (FAILED(hr))
+	{
+		ReleaseWindowSlot(Index);
+		return ProcessFailure(m_Device, L"Failed to create window shader resource in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+	}
+
+	// The new texture has nothing in it yet, the next diff has to see the whole window as changed
+	m_WindowDiffers[Index].Reset();
+	++m_WindowSlotAllocations;
+
+	return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Free everything slot Index holds
+//
+void OUTPUTMANAGER::ReleaseWindowSlot(UINT Index)
+{
+	WINDOW_SLOT* Slot = &m_WindowSlots[Index];
+
+	if (m_windows[Index])
+	{
+		m_windows[Index]->Release();
+		m_windows[Index] = nullptr;
+	}
+
+	if (Slot->Texture)
+	{
+		Slot->Texture->Release();
+		Slot->Texture = nullptr;
+	}
+
+	Slot->Width = 0;
+	Slot->Height = 0;
+}
+
 
 
 BOOL CALLBACK EnumProc(HWND hwnd, LPARAM lparam)
@@ -1302,6 +1894,13 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 	std::vector<HWND> winHandles;
 	EnumWindows(EnumProc, (LPARAM)&winHandles);
 
+	// Take in whatever the capture threads printed since the last frame, both eyes draw the same textures
+	DUPL_RETURN Ret = UpdateWindows(winHandles);
+	if (Ret != DUPL_RETURN_SUCCESS)
+	{
+		return Ret;
+	}
+
 	// create shader resource view
 	D3D11_TEXTURE2D_DESC FrameDesc;
 	m_ScreenTex->GetDesc(&FrameDesc);
@@ -1333,17 +1932,19 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 	ID3D11Buffer *pIBuffer = nullptr;
 
 
-	const int n = 40;
+	const int n = SCREEN_SEGMENTS;
 	
 	static float halfDegree = 25;
 	static float r = 10;							// radius
 	UpdateRadiusAndAngle(r, halfDegree);
+	m_ScreenRadius = r;
+	m_ScreenHalfDegree = halfDegree;
 
 	float sita = XMConvertToRadians(-halfDegree);	// sita range from -60 to 60
 	float delta = XMConvertToRadians(2*halfDegree/(float)n);	// draw texture every 5 degree
 	
 
-	float centerZ = 8.0f;	// circle center z-axis offset
+	float centerZ = SCREEN_CENTER_Z;	// circle center z-axis offset
 	float centerX = 0.0f;	// circle center x-axis offset
 	XMFLOAT3 center = XMFLOAT3(0.0f, 0.0f, -centerZ); // center of circle
 
@@ -1567,7 +2168,17 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 	// Begin to render texture for two eyes
 //////////////////////////////////////////////////////////////////////////////
 
-	ID3D11ShaderResourceView *pEyeShaderResource[2];	// Dont forget to release
+	// The last frame's eye textures are replaced
+	for (int index = 0; index < 2; ++index)
+	{
+		if (m_EyeViews[index])
+		{
+			m_EyeViews[index]->Release();
+			m_EyeViews[index] = nullptr;
+		}
+	}
+	m_EyesTime = GetTickCount64();
+
 	Eye_Type eyes[2] = { LEFT_EYE, RIGHT_EYE };
 	
 	// Outside of for loop, in case of directions of two eye are not the same
@@ -1618,6 +2229,7 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 		matPorj = XMMatrixPerspectiveFovLH(XMConvertToRadians(110), (FLOAT)Width / (FLOAT)Height, 0.03f, 100.0f);
 
 		cBuffer.Final = matView * matPorj;
+		XMStoreFloat4x4(&m_EyeTransforms[index], cBuffer.Final);
 
 		// Begin to set buffers
 		m_DeviceContext->ClearState();
@@ -1668,8 +2280,7 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 		m_DeviceContext->DrawIndexed(6, 6 * (n + 5), 0);
 
 		// Draw other windows
-		DrawWindows(winHandles);
-		winHandles.clear();
+		DrawWindows();
 
 		// Prepare for screen texture, store in pResource
 		ID3D11Texture2D *pEyeScreen = nullptr;
@@ -1694,7 +2305,7 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 		}
 		m_DeviceContext->CopyResource(pEyeTexture, pEyeScreen);
 
-		hr = m_Device->CreateShaderResourceView(pEyeTexture, NULL, &pEyeShaderResource[index]);
+		hr = m_Device->CreateShaderResourceView(pEyeTexture, NULL, &m_EyeViews[index]);
 		if (FAILED(hr))
 		{
 			return ProcessFailure(m_Device, L"Failed to create shader resource when drawing a frame(in screen)", L"Error", hr, SystemTransitionsExpectedErrors);
@@ -1713,12 +2324,48 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 		}
 	}
 
-//////////////////////////////////////////////////////////
-	// Begin to render seperate-screen
-////////////////////////////////////////////////////////
+	if (pVBuffer)
+	{
+		pVBuffer->Release();
+		pVBuffer = nullptr;
+	}
+
+	if (pIBuffer)
+	{
+		pIBuffer->Release();
+		pIBuffer = nullptr;
+	}
+
+	if (ScreenShaderResource)
+	{
+		ScreenShaderResource->Release();
+		ScreenShaderResource = nullptr;
+	}
+
+	if (pCBuffer)
+	{
+		pCBuffer->Release();
+		pCBuffer = nullptr;
+	}
+
+	if (zbuffer)
+	{
+		zbuffer->Release();
+		zbuffer = nullptr;
+	}
+
+	return DrawDistortion();
+}
 
+//
+// Distort the eye textures of the last DrawToScreen side by side into the back buffer, with the pointer on top
+//
+DUPL_RETURN OUTPUTMANAGER::DrawDistortion()
+{
 	ID3D11Buffer *pVEyeBuffer;
 	ID3D11Buffer *pIEyeBuffer;
+	D3D11_SUBRESOURCE_DATA InitData;
+	HRESULT hr;
 
 	VERTEX EyeVertices[] =
 	{
@@ -1767,7 +2414,10 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 	m_DeviceContext->ClearState();
 
 	m_DeviceContext->OMSetRenderTargets(1, &m_RTV, NULL);
-	
+
+	// Back buffers are flipped, without eyes rendered into it first this one still has an older frame outside the viewport
+	FLOAT black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	m_DeviceContext->ClearRenderTargetView(m_RTV, black);
 
 	// Set View Port according to screen resolution
 	float inputs[1] = { 0 };
@@ -1793,24 +2443,21 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 	m_DeviceContext->PSSetSamplers(0, 1, &m_SamplerLinear);
 
 	// left eye
-	m_DeviceContext->PSSetShaderResources(0, 1, &pEyeShaderResource[0]);
+	m_DeviceContext->PSSetShaderResources(0, 1, &m_EyeViews[0]);
 	// right eye
-	m_DeviceContext->PSSetShaderResources(1, 1, &pEyeShaderResource[1]);
-	m_DeviceContext->DrawIndexed(12, 0, 0);
+	m_DeviceContext->PSSetShaderResources(1, 1, &m_EyeViews[1]);
 
-	//m_SwapChain->SetFullscreenState(TRUE, NULL);
-
-	if (pEyeShaderResource[0])
+	// Pointer is read as late as possible, everything else of this pass is already set up
+	OVERLAY_CBUFFER Overlay;
+	DUPL_RETURN Ret = LatchPointer(&Overlay);
+	if (Ret == DUPL_RETURN_SUCCESS)
 	{
-		pEyeShaderResource[0]->Release();
-		pEyeShaderResource[0] = nullptr;
+		m_DeviceContext->UpdateSubresource(m_OverlayBuffer, 0, nullptr, &Overlay, 0, 0);
+		m_DeviceContext->PSSetConstantBuffers(0, 1, &m_OverlayBuffer);
+		m_DeviceContext->DrawIndexed(12, 0, 0);
 	}
 
-	if (pEyeShaderResource[1])
-	{
-		pEyeShaderResource[1]->Release();
-		pEyeShaderResource[1] = nullptr;
-	}
+	//m_SwapChain->SetFullscreenState(TRUE, NULL);
 
 	if (pVEyeBuffer)
 	{
@@ -1824,38 +2471,118 @@ DUPL_RETURN OUTPUTMANAGER::DrawToScreen()
 		pIEyeBuffer = nullptr;
 	}
 
-	if (pVBuffer)
+
+	return Ret;
+}
+
+//
+// Read the pointer the capture threads last published and find where it lands in each eye texture.
+// The pointer's texture is bound to t2, Overlay says where it goes.
+//
+DUPL_RETURN OUTPUTMANAGER::LatchPointer(_Out_ OVERLAY_CBUFFER* Overlay)
+{
+	RtlZeroMemory(Overlay, sizeof(OVERLAY_CBUFFER));
+
+	DUPL_RETURN Ret = m_Pointer->Read(&m_PtrInfo);
+	if (Ret != DUPL_RETURN_SUCCESS)
 	{
-		pVBuffer->Release();
-		pVBuffer = nullptr;
+		return Ret;
 	}
 
-	if (pIBuffer)
+	if (m_PredictPointer)
 	{
-		pIBuffer->Release();
-		pIBuffer = nullptr;
+		PredictPointer();
 	}
+	QueryPerformanceCounter(&m_LatchTime);
+	m_LatchedStamp = m_PtrInfo.LastTimeStamp.QuadPart;
 
-	if (ScreenShaderResource)
+	if (!m_PtrInfo.Visible)
 	{
-		ScreenShaderResource->Release();
-		ScreenShaderResource = nullptr;
+		return DUPL_RETURN_SUCCESS;
 	}
 
-	if (pCBuffer)
+	ID3D11ShaderResourceView* ShaderRes = nullptr;
+	INT PtrLeft;
+	INT PtrTop;
+	INT PtrWidth;
+	INT PtrHeight;
+	FLOAT TexRight;
+	FLOAT TexBottom;
+	Ret = PreparePointer(&m_PtrInfo, &PtrLeft, &PtrTop, &PtrWidth, &PtrHeight, &ShaderRes, &TexRight, &TexBottom);
+	if (Ret != DUPL_RETURN_SUCCESS || !ShaderRes)
 	{
-		pCBuffer->Release();
-		pCBuffer = nullptr;
+		return Ret;
 	}
 
-	if (zbuffer)
+	// The desktop image is stretched over the whole screen, so pointer corners in it are texture coordinates of the screen
+	D3D11_TEXTURE2D_DESC FullDesc;
+	m_SharedSurf->GetDesc(&FullDesc);
+	FLOAT Left = PtrLeft / (FLOAT)FullDesc.Width;
+	FLOAT Top = PtrTop / (FLOAT)FullDesc.Height;
+	FLOAT Right = (PtrLeft + PtrWidth) / (FLOAT)FullDesc.Width;
+	FLOAT Bottom = (PtrTop + PtrHeight) / (FLOAT)FullDesc.Height;
+
+	for (int index = 0; index < 2; ++index)
 	{
-		zbuffer->Release();
-		zbuffer = nullptr;
+		// The pointer is small enough to be a rectangle after projection, the one around its corners is used
+		XMFLOAT2 Corners[4];
+		if (!ProjectToEye(&m_EyeTransforms[index], Left, Top, &Corners[0]) ||
+			!ProjectToEye(&m_EyeTransforms[index], Right, Top, &Corners[1]) ||
+			!ProjectToEye(&m_EyeTransforms[index], Left, Bottom, &Corners[2]) ||
+			!ProjectToEye(&m_EyeTransforms[index], Right, Bottom, &Corners[3]))
+		{
+			continue;
+		}
+
+		XMFLOAT4 Rect(Corners[0].x, Corners[0].y, Corners[0].x, Corners[0].y);
+		for (int i = 1; i < 4; ++i)
+		{
+			Rect.x = min(Rect.x, Corners[i].x);
+			Rect.y = min(Rect.y, Corners[i].y);
+			Rect.z = max(Rect.z, Corners[i].x);
+			Rect.w = max(Rect.w, Corners[i].y);
+		}
+		Overlay->Rect[index] = Rect;
 	}
 
+	Overlay->Tex = XMFLOAT4(TexRight, TexBottom, 1.0f, 0.0f);
+	m_DeviceContext->PSSetShaderResources(2, 1, &ShaderRes);
+
 	return DUPL_RETURN_SUCCESS;
 }
+
+//
+// Where a point of the curved screen, given in its texture coordinates, lands in an eye texture rendered with Transform.
+// Follows the same straight segments DrawToScreen builds the screen from. Returns false for points behind the eye.
+//
+bool OUTPUTMANAGER::ProjectToEye(_In_ const XMFLOAT4X4* Transform, FLOAT U, FLOAT V, _Out_ XMFLOAT2* Eye)
+{
+	FLOAT Segment = U * SCREEN_SEGMENTS;
+	INT i = static_cast<INT>(floor(Segment));
+	i = max(0, min(SCREEN_SEGMENTS - 1, i));
+	FLOAT t = Segment - i;
+
+	float delta = XMConvertToRadians(2 * m_ScreenHalfDegree / (float)SCREEN_SEGMENTS);
+	float sita = XMConvertToRadians(-m_ScreenHalfDegree) + (i * delta);
+	float nextSita = sita + delta;
+
+	FLOAT X = (m_ScreenRadius * sin(sita)) + (t * m_ScreenRadius * (sin(nextSita) - sin(sita)));
+	FLOAT Y = 1.0f - (2.0f * V);
+	FLOAT Z = (m_ScreenRadius * cos(sita)) + (t * m_ScreenRadius * (cos(nextSita) - cos(sita))) - SCREEN_CENTER_Z;
+
+	XMVECTOR Clip = XMVector4Transform(XMVectorSet(X, Y, Z, 1.0f), XMLoadFloat4x4(Transform));
+	FLOAT W = XMVectorGetW(Clip);
+	if (W <= 0.0f)
+	{
+		*Eye = XMFLOAT2(0.0f, 0.0f);
+		return false;
+	}
+
+	Eye->x = ((XMVectorGetX(Clip) / W) + 1.0f) * 0.5f;
+	Eye->y = (1.0f - (XMVectorGetY(Clip) / W)) * 0.5f;
+
+	return true;
+}
 #endif // VR_DESKTOP
 
 //
@@ -1928,6 +2655,18 @@ DUPL_RETURN OUTPUTMANAGER::InitShaders()
 	{
 		return ProcessFailure(m_Device, L"Failed to create pixel shader in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
 	}
+
+	// Pointer overlay of the distortion pass, filled every frame
+	D3D11_BUFFER_DESC OverlayDesc;
+	RtlZeroMemory(&OverlayDesc, sizeof(OverlayDesc));
+	OverlayDesc.Usage = D3D11_USAGE_DEFAULT;
+	OverlayDesc.ByteWidth = sizeof(OVERLAY_CBUFFER);
+	OverlayDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	hr = m_Device->CreateBuffer(&OverlayDesc, nullptr, &m_OverlayBuffer);
+	if (FAILED(hr))
+	{
+		return ProcessFailure(m_Device, L"Failed to create pointer overlay buffer in OUTPUTMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+	}
 #endif // VR_DESKTOP
 
     return DUPL_RETURN_SUCCESS;
@@ -2018,6 +2757,163 @@ DUPL_RETURN OUTPUTMANAGER::ResizeSwapChain()
 //
 void OUTPUTMANAGER::CleanRefs()
 {
+    // Report how often drawing the pointer found its texture ready
+    CURSOR_CACHE_STATS CursorStats;
+    m_CursorCache.GetStats(&CursorStats);
+    if (CursorStats.Hits || CursorStats.Misses || CursorStats.MaskedDraws)
+    {
+        WCHAR StatsMsg[256];
+        static const WCHAR* KernelNames[] = { L"scalar", L"SSE2", L"AVX2" };
+        swprintf_s(StatsMsg, 256, L"Cursor cache: %llu hits, %llu misses, %llu evictions, %llu masked draws with %s kernels, %llu scratch grows\n",
+                   CursorStats.Hits, CursorStats.Misses, CursorStats.Evictions, CursorStats.MaskedDraws, KernelNames[m_CursorKernels.GetKernel()], CursorStats.ScratchGrows);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_CursorCache.CleanRefs();
+
+    // Report where the desktop under masked pointers came from and how long getting it took
+    if (m_ShadowBackdrops || m_ReadbackBackdrops)
+    {
+        LARGE_INTEGER Frequency;
+        QueryPerformanceFrequency(&Frequency);
+        POINTER_SHADOW_STATS ShadowStats;
+        RtlZeroMemory(&ShadowStats, sizeof(ShadowStats));
+        if (m_PointerShadow)
+        {
+            m_PointerShadow->GetStats(&ShadowStats);
+        }
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Pointer backdrop: %llu from shadow at %.1f us, %llu read back at %.1f us, %llu regions, %llu fills, %llu updates\n",
+                   m_ShadowBackdrops, m_ShadowBackdrops ? (m_ShadowBackdropTicks * 1000000.0) / (m_ShadowBackdrops * Frequency.QuadPart) : 0.0,
+                   m_ReadbackBackdrops, m_ReadbackBackdrops ? (m_ReadbackBackdropTicks * 1000000.0) / (m_ReadbackBackdrops * Frequency.QuadPart) : 0.0,
+                   ShadowStats.Requests, ShadowStats.Fills, ShadowStats.Updates);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_ShadowInUse = false;
+
+    // Report how far off the predicted pointer was compared to drawing the last reported position
+    PREDICT_STATS PredictStats;
+    m_Predictor.GetStats(&PredictStats);
+    if (PredictStats.Scored)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Pointer prediction: %llu samples, %.2f px mean error (%.2f px unpredicted), %.2f px rms, %.1f px max\n",
+                   PredictStats.Samples, PredictStats.ErrorSum / PredictStats.Scored, PredictStats.HoldErrorSum / PredictStats.Scored,
+                   sqrt(PredictStats.ErrorSquaredSum / PredictStats.Scored), PredictStats.MaxError);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_Predictor.Reset();
+    m_Predictor.ResetStats();
+
+    // Report how many frames were left on screen because nothing in them changed
+    if (m_RenderedFrames || m_SkippedFrames)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Renderer: %llu frames rendered, %llu skipped\n", m_RenderedFrames, m_SkippedFrames);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_HaveRendered = false;
+    m_SurfaceDamaged = false;
+
+    if (m_VBlankOutput)
+    {
+        m_VBlankOutput->Release();
+        m_VBlankOutput = nullptr;
+    }
+
+#ifdef VR_DESKTOP
+    // Report how many window captures were skipped because nothing in them changed
+    DIFF_STATS WindowStats;
+    RtlZeroMemory(&WindowStats, sizeof(WindowStats));
+    for (int i = 0; i < MAX_WINDOWS; ++i)
+    {
+        DIFF_STATS Stats;
+        m_WindowDiffers[i].GetStats(&Stats);
+        WindowStats.Frames += Stats.Frames;
+        WindowStats.UnchangedFrames += Stats.UnchangedFrames;
+        WindowStats.TilesChanged += Stats.TilesChanged;
+        WindowStats.TilesCompared += Stats.TilesCompared;
+        m_WindowDiffers[i].Reset();
+
+        // Window textures belong to the device being released
+        ReleaseWindowSlot(i);
+    }
+    if (WindowStats.Frames)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Window captures: %llu frames, %llu unchanged, %llu of %llu tiles changed\n",
+                   WindowStats.Frames, WindowStats.UnchangedFrames, WindowStats.TilesChanged, WindowStats.TilesCompared);
+        OutputDebugStringW(StatsMsg);
+    }
+
+    // Report how often each window was printed and what it cost, the threads are stopped so the totals hold still
+    m_WindowCapture.Stop();
+    for (UINT i = 0; i < MAX_WINDOWS; ++i)
+    {
+        WINDOW_CAPTURE_STATS Stats;
+        m_WindowCapture.GetStats(i, &Stats);
+        if (!Stats.Captures)
+        {
+            continue;
+        }
+
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Window %u: %.1f captures/s, %.2f ms per capture (%.2f ms max), %llu failed, %llu published, %llu dropped, %llu shown\n",
+                   i, Stats.ActiveTicks ? ((Stats.Captures - 1) * static_cast<double>(m_QpcFrequency.QuadPart)) / Stats.ActiveTicks : 0.0,
+                   (Stats.CaptureTicks * 1000.0) / (Stats.Captures * m_QpcFrequency.QuadPart), (Stats.MaxCaptureTicks * 1000.0) / m_QpcFrequency.QuadPart,
+                   Stats.Failures, Stats.Published, Stats.Dropped, Stats.Consumed);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_WindowCapture.ResetStats();
+
+    // Report what uploading the captures cost
+    if (m_WindowUploads || m_WindowSlotAllocations)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Window slots: %llu uploads at %.1f us, %llu rects of %.1f kpixels, %llu allocations\n",
+                   m_WindowUploads, m_WindowUploads ? (m_WindowUploadTicks * 1000000.0) / (m_WindowUploads * m_QpcFrequency.QuadPart) : 0.0,
+                   m_WindowUploadRects, m_WindowUploadRects ? m_WindowUploadPixels / (m_WindowUploadRects * 1000.0) : 0.0,
+                   m_WindowSlotAllocations);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_WindowUploads = 0;
+    m_WindowUploadRects = 0;
+    m_WindowUploadPixels = 0;
+    m_WindowSlotAllocations = 0;
+    m_WindowUploadTicks = 0;
+
+    // Report how late the pointer overlay was read and how long pointer motion took to be presented
+    if (m_OverlayFrames)
+    {
+        WCHAR StatsMsg[256];
+        swprintf_s(StatsMsg, 256, L"Pointer overlay: %llu frames, %llu on reused eye textures, %.2f ms latch to present, %.2f ms motion to present over %llu moves\n",
+                   m_OverlayFrames, m_ReusedEyeFrames, (m_OverlayLatchTicks * 1000.0) / (m_OverlayFrames * m_QpcFrequency.QuadPart),
+                   m_OverlayMoves ? (m_OverlayMoveTicks * 1000.0) / (m_OverlayMoves * m_QpcFrequency.QuadPart) : 0.0, m_OverlayMoves);
+        OutputDebugStringW(StatsMsg);
+    }
+    m_OverlayFrames = 0;
+    m_ReusedEyeFrames = 0;
+    m_OverlayMoves = 0;
+    m_OverlayLatchTicks = 0;
+    m_OverlayMoveTicks = 0;
+    m_CountedStamp = 0;
+
+    // Eye textures belong to the device being released
+    for (int index = 0; index < 2; ++index)
+    {
+        if (m_EyeViews[index])
+        {
+            m_EyeViews[index]->Release();
+            m_EyeViews[index] = nullptr;
+        }
+    }
+
+    if (m_OverlayBuffer)
+    {
+        m_OverlayBuffer->Release();
+        m_OverlayBuffer = nullptr;
+    }
+#endif
+
     if (m_VertexShader)
     {
         m_VertexShader->Release();
@@ -2084,6 +2980,8 @@ void OUTPUTMANAGER::CleanRefs()
         m_KeyMutex = nullptr;
     }
 
+    ReleaseOutputSurfaces();
+
     if (m_Factory)
     {
         if (m_OcclusionCookie)
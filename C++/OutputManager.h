@@ -13,9 +13,72 @@
 #include "CommonTypes.h"
 #include "warning.h"
 #include "WICTextureLoader.h"
+#include "TileMap.h"
+#include "CursorCache.h"
+#include "CursorKernels.h"
+#include "FrameDiffer.h"
+#include "PointerPredictor.h"
+#include "PointerState.h"
+#include "WindowCapture.h"
 #include <iostream>
 #include <vector>
 
+//
+// Surface and keyed mutex of one output when each output has its own, X and Y are where it goes in the desktop image.
+// With a mailbox Surface and KeyMutex are null and the output has MAILBOX_SLOTS surfaces instead, Pending is set
+// while the slot the mailbox last gave the renderer has not been copied yet.
+//
+typedef struct _OUTPUT_SURFACE
+{
+    ID3D11Texture2D* Surface;
+    IDXGIKeyedMutex* KeyMutex;
+    MAILBOX* Mailbox;
+    ID3D11Texture2D* Slots[MAILBOX_SLOTS];
+    IDXGIKeyedMutex* SlotMutexes[MAILBOX_SLOTS];
+    bool Pending;
+    RECT Desktop;
+    INT X;
+    INT Y;
+} OUTPUT_SURFACE;
+
+//
+// Texture the latest capture of one window is copied into, only made again when the window changes size.
+// Each capture only writes the rects its FRAMEDIFFER found changed since the last one.
+//
+typedef struct _WINDOW_SLOT
+{
+    INT Width;
+    INT Height;
+    ID3D11Texture2D* Texture;
+} WINDOW_SLOT;
+
+// Longest the window goes without a present, windows drawn from PrintWindow are not tracked as damage
+#define RENDER_REFRESH_MS 500
+
+// Head rotation between two poses up to this many degrees leaves the view unchanged
+#define RENDER_POSE_THRESHOLD_DEGREES 0.05
+
+// How far past the time a frame is drawn the pointer is predicted for, about when a frame presented now is on screen
+#define PREDICT_DISPLAY_LEAD_MS 16.0
+
+// Straight segments the curved screen is built from
+#define SCREEN_SEGMENTS 40
+
+// How far behind the eyes the center of the curved screen is
+#define SCREEN_CENTER_Z 8.0f
+
+//
+// What the last presented frame was drawn from, a frame drawn from the same state would look the same
+//
+typedef struct _RENDER_STATE
+{
+    POINT PointerPosition;
+    UINT64 PointerShape;
+    bool PointerVisible;
+    FLOAT Pose[4];
+    ULONGLONG PresentTime;
+} RENDER_STATE;
+
 //
 // Handles the task of drawing into a window.
 // Has the functionality to draw the mouse given a mouse shape buffer and position
@@ -25,28 +88,46 @@ class OUTPUTMANAGER
     public:
         OUTPUTMANAGER();
         ~OUTPUTMANAGER();
-        DUPL_RETURN InitOutput(HWND Window, INT SingleOutput, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds);
-        DUPL_RETURN UpdateApplicationWindow(_In_ PTR_INFO* PointerInfo, _Inout_ bool* Occluded);
+        DUPL_RETURN InitOutput(HWND Window, INT SingleOutput, _In_ CAPTURE_OPTIONS* Capture, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds);
+        DUPL_RETURN UpdateApplicationWindow(_In_ POINTERSTATE* Pointer, _Inout_ bool* Occluded);
         void CleanRefs();
-        HANDLE GetSharedHandle();
+        SURFACE_TARGET* GetSurfaceTargets();
+        TILEMAP* GetTileMap();
         void WindowResize();
 		void OnKey(unsigned vk, bool down);
 
     private:
     // Methods
-        DUPL_RETURN ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Outptr_result_bytebuffer_(*PtrHeight * *PtrWidth * BPP) BYTE** InitBuffer, _Out_ D3D11_BOX* Box);
+        DUPL_RETURN ProcessMonoMask(bool IsMono, _Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Outptr_result_maybenull_ ID3D11ShaderResourceView** ShaderRes, _Out_ FLOAT* TexRight, _Out_ FLOAT* TexBottom);
         DUPL_RETURN MakeRTV();
         void SetViewPort(UINT Width, UINT Height);
         DUPL_RETURN InitShaders();
         DUPL_RETURN InitGeometry();
-        DUPL_RETURN CreateSharedSurf(INT SingleOutput, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds);
+        DUPL_RETURN CreateSharedSurf(INT SingleOutput, _In_ CAPTURE_OPTIONS* Capture, _Out_ UINT* OutCount, _Out_ RECT* DeskBounds);
+        DUPL_RETURN CreateOutputSurfaces(_In_ IDXGIAdapter* Adapter, INT SingleOutput, UINT OutputCount, bool Mailbox, _In_ RECT* DeskBounds);
+        DUPL_RETURN CreateOutputTexture(UINT Width, UINT Height, _Out_ ID3D11Texture2D** Surface, _Out_ IDXGIKeyedMutex** KeyMutex);
+        DUPL_RETURN CreateSurfaceTargets(UINT OutputCount, _In_ RECT* DeskBounds);
+        DUPL_RETURN CollectOutputSurfaces();
+        DUPL_RETURN CollectMailbox(_Inout_ OUTPUT_SURFACE* Output);
+        void ReleaseOutputSurfaces();
+        bool NeedsRender(_Out_ RENDER_STATE* State, _Out_ bool* PointerOnly);
+        void PredictPointer();
+        void WaitForVBlank();
+        static HANDLE GetSharedHandle(_In_ ID3D11Texture2D* Surface);
         DUPL_RETURN DrawFrame();
-		DUPL_RETURN DrawWindows(std::vector<HWND> windows);
+		DUPL_RETURN UpdateWindows(const std::vector<HWND>& windows);
+		DUPL_RETURN DrawWindows();
+		DUPL_RETURN ResizeWindowSlot(UINT Index, INT Width, INT Height);
+		void ReleaseWindowSlot(UINT Index);
+        DUPL_RETURN PreparePointer(_Inout_ PTR_INFO* PtrInfo, _Out_ INT* PtrLeft, _Out_ INT* PtrTop, _Out_ INT* PtrWidth, _Out_ INT* PtrHeight, _Outptr_result_maybenull_ ID3D11ShaderResourceView** ShaderRes, _Out_ FLOAT* TexRight, _Out_ FLOAT* TexBottom);
         DUPL_RETURN DrawMouse(_In_ PTR_INFO* PtrInfo);
         DUPL_RETURN ResizeSwapChain();
 
 #ifdef VR_DESKTOP
 		DUPL_RETURN DrawToScreen();
+		DUPL_RETURN DrawDistortion();
+		DUPL_RETURN LatchPointer(_Out_ OVERLAY_CBUFFER* Overlay);
+		bool ProjectToEye(_In_ const DirectX::XMFLOAT4X4* Transform, FLOAT U, FLOAT V, _Out_ DirectX::XMFLOAT2* Eye);
 #endif // VR_DESKTOP
 
     // Vars
@@ -62,10 +143,43 @@ class OUTPUTMANAGER
         ID3D11InputLayout* m_InputLayout;
         ID3D11Texture2D* m_SharedSurf;
         IDXGIKeyedMutex* m_KeyMutex;
+
+        // With one surface per output m_SharedSurf is only the renderer's copy of the desktop and has no keyed mutex
+        UINT m_OutputSurfaceCount;
+        _Field_size_(m_OutputSurfaceCount) OUTPUT_SURFACE* m_OutputSurfaces;
+        UINT m_TargetCount;
+        _Field_size_(m_TargetCount) SURFACE_TARGET* m_Targets;
+        TILEMAP m_TileMap;
+        CURSORCACHE m_CursorCache;
+        CURSORKERNELS m_CursorKernels;
+        POINTERSTATE* m_Pointer;
+        PTR_INFO m_PtrInfo;
         HWND m_WindowHandle;
         bool m_NeedsResize;
         DWORD m_OcclusionCookie;
 
+        // Set when an output surface was copied into the desktop image since the last present
+        bool m_SurfaceDamaged;
+        bool m_HaveRendered;
+        RENDER_STATE m_Rendered;
+        IDXGIOutput* m_VBlankOutput;
+        ULONGLONG m_RenderedFrames;
+        ULONGLONG m_SkippedFrames;
+
+        // Desktop pixels under masked pointers come from the pointer shadow, or are read back from m_SharedSurf when it
+        // doesn't have them yet. Both are timed so the stall the shadow saves shows up in the stats.
+        POINTERSHADOW* m_PointerShadow;
+        bool m_ShadowInUse;
+        ULONGLONG m_ShadowBackdrops;
+        ULONGLONG m_ReadbackBackdrops;
+        LONGLONG m_ShadowBackdropTicks;
+        LONGLONG m_ReadbackBackdropTicks;
+
+        // Moves the pointer along its predicted path when PREDICT_OPTIONS::Aggressiveness is above 0
+        POINTERPREDICTOR m_Predictor;
+        bool m_PredictPointer;
+        LARGE_INTEGER m_QpcFrequency;
+
 #ifdef VR_DESKTOP
 		ID3D11Texture2D* m_ScreenTex;
 		ID3D11VertexShader* m_ScreenVertexShader;
@@ -75,8 +189,42 @@ class OUTPUTMANAGER
 		ID3D11PixelShader* m_WindowPixelShader;
 		ID3D11ShaderResourceView* m_windows[MAX_WINDOWS];
 		float m_widthSteps[MAX_WINDOWS];
+
+		// PrintWindow hands over whole windows, these tell which of them actually changed
+		FRAMEDIFFER m_WindowDiffers[MAX_WINDOWS];
+		BANDPOOL m_DiffPool;
+
+		// Windows are printed on m_WindowCapture's threads, m_windows[i] views m_WindowSlots[i].Texture
+		// the latest capture of window i is uploaded into
+		WINDOWCAPTURE m_WindowCapture;
+		WINDOW_SLOT m_WindowSlots[MAX_WINDOWS];
+		ULONGLONG m_WindowUploads;
+		ULONGLONG m_WindowUploadRects;
+		ULONGLONG m_WindowUploadPixels;
+		ULONGLONG m_WindowSlotAllocations;
+		LONGLONG m_WindowUploadTicks;
 		ID3D11ShaderResourceView* m_BackSky[6];	// background star sky
 
+		// Eye textures and what they were rendered with, kept so a frame where only the pointer moved
+		// is just the distortion pass again
+		ID3D11ShaderResourceView* m_EyeViews[2];
+		DirectX::XMFLOAT4X4 m_EyeTransforms[2];
+		FLOAT m_ScreenRadius;
+		FLOAT m_ScreenHalfDegree;
+		ULONGLONG m_EyesTime;
+
+		// The pointer is laid over the eye textures in the distortion pass, read again right before it is drawn.
+		// Latency is timed from that read to the present, and from when DXGI saw the pointer move.
+		ID3D11Buffer* m_OverlayBuffer;
+		LARGE_INTEGER m_LatchTime;
+		LONGLONG m_LatchedStamp;
+		LONGLONG m_CountedStamp;
+		ULONGLONG m_OverlayFrames;
+		ULONGLONG m_ReusedEyeFrames;
+		ULONGLONG m_OverlayMoves;
+		LONGLONG m_OverlayLatchTicks;
+		LONGLONG m_OverlayMoveTicks;
+
 #endif
 };
 
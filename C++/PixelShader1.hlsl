@@ -1,13 +1,37 @@
 Texture2D tx_right : register(t0);
 Texture2D tx_left : register(t1);
+Texture2D tx_pointer : register(t2);
 SamplerState samLinear : register(s0);
 
+// Where the pointer goes in each eye texture, latched right before this pass
+cbuffer Overlay : register(b0)
+{
+	float4 ptrRect[2];
+	float4 ptrTex;
+};
+
 struct PS_INPUT
 {
 	float4 Pos : SV_POSITION;
 	float2 Tex : TEXCOORD;
 };
 
+//--------------------------------------------------------------------------------------
+// Blends the pointer over an eye texture sample when uv is inside the pointer's rect
+//--------------------------------------------------------------------------------------
+float4 Overlay(float4 color, float2 uv, float4 rect)
+{
+	if (ptrTex.z <= 0 || uv.x < rect.x || uv.y < rect.y || uv.x >= rect.z || uv.y >= rect.w)
+	{
+		return color;
+	}
+
+	float2 ptruv = (uv - rect.xy) / (rect.zw - rect.xy) * ptrTex.xy;
+	float4 ptr = tx_pointer.Sample(samLinear, ptruv);
+
+	return float4(lerp(color.rgb, ptr.rgb, ptr.a), color.a);
+}
+
 //--------------------------------------------------------------------------------------
 // Pixel Shader
 //--------------------------------------------------------------------------------------
@@ -31,11 +55,11 @@ float4 PS(PS_INPUT input) : SV_Target
 	{
 		if (input.Pos.x <= 1280) // half of the screen width
 		{
-			return tx_left.Sample(samLinear, distorteduv);
+			return Overlay(tx_left.Sample(samLinear, distorteduv), distorteduv, ptrRect[1]);
 		}
-		else 
+		else
 		{
-			return tx_right.Sample(samLinear, distorteduv);
+			return Overlay(tx_right.Sample(samLinear, distorteduv), distorteduv, ptrRect[0]);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <cmath>
+#include <cstring>
+
+#include "PointerPredictor.h"
+
+POINTERPREDICTOR::POINTERPREDICTOR() : m_Newest(0),
+                                       m_Count(0)
+{
+    GetDefaultOptions(&m_Options);
+    memset(m_Samples, 0, sizeof(m_Samples));
+    memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+POINTERPREDICTOR::~POINTERPREDICTOR()
+{
+}
+
+//
+// Full extrapolation fitted over 50ms, at most 8000 pixels per second and a 60Hz frame ahead, fading out
+// between 25ms and 50ms after the newest sample
+//
+void POINTERPREDICTOR::GetDefaultOptions(PREDICT_OPTIONS* Options)
+{
+    Options->Aggressiveness = 1.0;
+    Options->Window = 0.05;
+    Options->MaxSpeed = 8000.0;
+    Options->MaxHorizon = 0.016;
+    Options->FadeTime = 0.025;
+    Options->StopTime = 0.05;
+}
+
+void POINTERPREDICTOR::SetOptions(const PREDICT_OPTIONS* Options)
+{
+    m_Options = *Options;
+}
+
+//
+// Forgets every sample, the statistics are kept
+//
+void POINTERPREDICTOR::Reset()
+{
+    m_Newest = 0;
+    m_Count = 0;
+}
+
+void POINTERPREDICTOR::ResetStats()
+{
+    memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+const POINTERPREDICTOR::SAMPLE& POINTERPREDICTOR::GetSample(unsigned Age)
+{
+    return m_Samples[(m_Newest + PREDICT_HISTORY - Age) % PREDICT_HISTORY];
+}
+
+//
+// Adds the position the pointer had at Time, returns false and ignores it when it is not newer than the last sample
+//
+bool POINTERPREDICTOR::AddSample(double Time, double X, double Y)
+{
+    if (m_Count)
+    {
+        const SAMPLE& Newest = GetSample(0);
+        if (Time <= Newest.Time)
+        {
+            return false;
+        }
+
+        if (Time - Newest.Time > m_Options.StopTime)
+        {
+            // Pointer stopped in between, what it did before says nothing about where it goes now
+            Reset();
+        }
+        else
+        {
+            // Score the prediction this sample would have replaced against drawing the previous sample
+            double PredictedX;
+            double PredictedY;
+            Predict(Time, &PredictedX, &PredictedY);
+            double Error = std::sqrt(((PredictedX - X) * (PredictedX - X)) + ((PredictedY - Y) * (PredictedY - Y)));
+            double HoldError = std::sqrt(((Newest.X - X) * (Newest.X - X)) + ((Newest.Y - Y) * (Newest.Y - Y)));
+            ++m_Stats.Scored;
+            m_Stats.ErrorSum += Error;
+            m_Stats.ErrorSquaredSum += Error * Error;
+            m_Stats.HoldErrorSum += HoldError;
+            if (Error > m_Stats.MaxError)
+            {
+                m_Stats.MaxError = Error;
+            }
+        }
+    }
+
+    m_Newest = (m_Newest + 1) % PREDICT_HISTORY;
+    SAMPLE* Sample = &m_Samples[m_Newest];
+    Sample->Time = Time;
+    Sample->X = X;
+    Sample->Y = Y;
+    if (m_Count < PREDICT_HISTORY)
+    {
+        ++m_Count;
+    }
+    ++m_Stats.Samples;
+
+    return true;
+}
+
+//
+// Least squares slope of position over time for the samples inside the window, 0 with fewer than two
+//
+void POINTERPREDICTOR::GetVelocity(double* VelocityX, double* VelocityY)
+{
+    *VelocityX = 0.0;
+    *VelocityY = 0.0;
+
+    // Times are taken relative to the newest sample so they stay small
+    const SAMPLE& Newest = GetSample(0);
+    unsigned Count = 0;
+    double SumT = 0.0;
+    double SumX = 0.0;
+    double SumY = 0.0;
+    for (unsigned Age = 0; Age < m_Count; ++Age)
+    {
+        const SAMPLE& Sample = GetSample(Age);
+        if (Newest.Time - Sample.Time > m_Options.Window && Count >= 2)
+        {
+            break;
+        }
+        SumT += Sample.Time - Newest.Time;
+        SumX += Sample.X;
+        SumY += Sample.Y;
+        ++Count;
+    }
+    if (Count < 2)
+    {
+        return;
+    }
+
+    double MeanT = SumT / Count;
+    double MeanX = SumX / Count;
+    double MeanY = SumY / Count;
+    double Stt = 0.0;
+    double Stx = 0.0;
+    double Sty = 0.0;
+    for (unsigned Age = 0; Age < Count; ++Age)
+    {
+        const SAMPLE& Sample = GetSample(Age);
+        double T = (Sample.Time - Newest.Time) - MeanT;
+        Stt += T * T;
+        Stx += T * (Sample.X - MeanX);
+        Sty += T * (Sample.Y - MeanY);
+    }
+    if (Stt <= 0.0)
+    {
+        return;
+    }
+
+    *VelocityX = Stx / Stt;
+    *VelocityY = Sty / Stt;
+
+    double Speed = std::sqrt((*VelocityX * *VelocityX) + (*VelocityY * *VelocityY));
+    if (Speed > m_Options.MaxSpeed)
+    {
+        *VelocityX *= m_Options.MaxSpeed / Speed;
+        *VelocityY *= m_Options.MaxSpeed / Speed;
+    }
+}
+
+//
+// Where the pointer is expected at Time, returns false when there is no sample yet
+//
+bool POINTERPREDICTOR::Predict(double Time, double* X, double* Y)
+{
+    if (!m_Count)
+    {
+        *X = 0.0;
+        *Y = 0.0;
+        return false;
+    }
+
+    const SAMPLE& Newest = GetSample(0);
+    *X = Newest.X;
+    *Y = Newest.Y;
+
+    // Past the stop time the pointer is taken to be resting where it was last seen
+    double Age = Time - Newest.Time;
+    if (Age <= 0.0 || Age >= m_Options.StopTime)
+    {
+        return true;
+    }
+    double Horizon = (Age < m_Options.MaxHorizon) ? Age : m_Options.MaxHorizon;
+
+    // Fades linearly from FadeTime to StopTime so the prediction slides back instead of jumping
+    double Fade = 1.0;
+    if (Age > m_Options.FadeTime && m_Options.StopTime > m_Options.FadeTime)
+    {
+        Fade = (m_Options.StopTime - Age) / (m_Options.StopTime - m_Options.FadeTime);
+    }
+
+    double VelocityX;
+    double VelocityY;
+    GetVelocity(&VelocityX, &VelocityY);
+    *X += VelocityX * Horizon * Fade * m_Options.Aggressiveness;
+    *Y += VelocityY * Horizon * Fade * m_Options.Aggressiveness;
+
+    return true;
+}
+
+//
+// Snapshot of the running totals
+//
+void POINTERPREDICTOR::GetStats(PREDICT_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
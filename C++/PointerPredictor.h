@@ -0,0 +1,98 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _POINTERPREDICTOR_H_
+#define _POINTERPREDICTOR_H_
+
+// Most pointer samples kept, older ones fall out of the velocity fit anyway
+#define PREDICT_HISTORY 16
+
+//
+// Knobs of POINTERPREDICTOR, times are in seconds and speeds in pixels per second
+//
+typedef struct _PREDICT_OPTIONS
+{
+    // Share of the extrapolation applied, 0 always gives the newest sample and 1 the full estimate
+    double Aggressiveness;
+
+    // Samples this far back from the newest one are fitted for the velocity, longer is smoother but slower to turn
+    double Window;
+
+    // Velocities are scaled down to this speed
+    double MaxSpeed;
+
+    // Furthest past the newest sample a prediction reaches, about a frame so a stop overshoots by at most that
+    double MaxHorizon;
+
+    // Once the newest sample is this old the extrapolation shrinks, reaching nothing at StopTime
+    double FadeTime;
+
+    // A gap this long between samples means the pointer stopped, DXGI only reports positions while it moves
+    double StopTime;
+} PREDICT_OPTIONS;
+
+//
+// Running totals kept by POINTERPREDICTOR. Every sample that arrives while the pointer is moving is
+// compared with what was predicted for its time and with the previous sample, which is what drawing
+// without prediction would have shown.
+//
+typedef struct _PREDICT_STATS
+{
+    unsigned long long Samples;
+    unsigned long long Scored;
+    double ErrorSum;
+    double ErrorSquaredSum;
+    double MaxError;
+    double HoldErrorSum;
+} PREDICT_STATS;
+
+//
+// Extrapolates the pointer to the time a frame is expected on screen so it doesn't trail by the
+// capture and render latency. The velocity is a least squares fit of the samples within the window
+// since the pointer last stopped, bounded in speed, and extrapolation is bounded in time. No new sample
+// may mean the pointer stopped, so the older the newest sample gets the less is extrapolated from it and
+// the prediction settles back onto it by the time the pointer counts as stopped.
+// Feed it samples in time order, timestamps that are not newer than the last one are ignored so the
+// same published position can be handed in every frame.
+// Only uses the C++ standard library so it can be exercised away from Windows.
+//
+class POINTERPREDICTOR
+{
+    public:
+        POINTERPREDICTOR();
+        ~POINTERPREDICTOR();
+        static void GetDefaultOptions(PREDICT_OPTIONS* Options);
+        void SetOptions(const PREDICT_OPTIONS* Options);
+        void Reset();
+        bool AddSample(double Time, double X, double Y);
+        bool Predict(double Time, double* X, double* Y);
+        void GetStats(PREDICT_STATS* Stats);
+        void ResetStats();
+
+    private:
+        struct SAMPLE
+        {
+            double Time;
+            double X;
+            double Y;
+        };
+
+        const SAMPLE& GetSample(unsigned Age);
+        void GetVelocity(double* VelocityX, double* VelocityY);
+
+    // vars
+        PREDICT_OPTIONS m_Options;
+
+        // Ring of samples since the pointer last stopped, age 0 is the newest
+        SAMPLE m_Samples[PREDICT_HISTORY];
+        unsigned m_Newest;
+        unsigned m_Count;
+
+        PREDICT_STATS m_Stats;
+};
+
+#endif
@@ -0,0 +1,202 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "PointerShadow.h"
+
+// Bytes in one row of the shadow
+#define POINTER_SHADOW_PITCH (POINTER_SHADOW_SIZE * BPP)
+
+POINTERSHADOW::POINTERSHADOW() : m_Pixels(nullptr),
+                                 m_Generation(0),
+                                 m_PartCount(0)
+{
+    InitializeSRWLock(&m_Lock);
+    SetRectEmpty(&m_Region);
+    RtlZeroMemory(m_Parts, sizeof(m_Parts));
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+POINTERSHADOW::~POINTERSHADOW()
+{
+    if (m_Pixels)
+    {
+        delete [] m_Pixels;
+        m_Pixels = nullptr;
+    }
+}
+
+//
+// Allocates the pixels, they are kept until the application exits
+//
+DUPL_RETURN POINTERSHADOW::Init()
+{
+    if (!m_Pixels)
+    {
+        m_Pixels = new (std::nothrow) BYTE[POINTER_SHADOW_SIZE * POINTER_SHADOW_PITCH];
+        if (!m_Pixels)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate pointer shadow in POINTERSHADOW", L"Error", E_OUTOFMEMORY);
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Forgets the region, copies still on their way from capture threads are dropped when they arrive
+//
+void POINTERSHADOW::Reset()
+{
+    AcquireSRWLockExclusive(&m_Lock);
+    SetRectEmpty(&m_Region);
+    if (++m_Generation == 0)
+    {
+        ++m_Generation;
+    }
+    m_PartCount = 0;
+    ReleaseSRWLockExclusive(&m_Lock);
+}
+
+//
+// Copies the desktop pixels under Box, in desktop image coordinates, into Dest.
+// Returns false when they aren't all here yet, the caller has to get them from the GPU then.
+//
+bool POINTERSHADOW::Read(_In_ const RECT* Box, _Out_writes_bytes_((Box->bottom - Box->top) * DestPitch) BYTE* Dest, UINT DestPitch)
+{
+    bool Hit = false;
+
+    AcquireSRWLockExclusive(&m_Lock);
+
+    if (m_Pixels && (Box->right - Box->left) <= POINTER_SHADOW_SIZE && (Box->bottom - Box->top) <= POINTER_SHADOW_SIZE)
+    {
+        if (Box->left < m_Region.left || Box->top < m_Region.top || Box->right > m_Region.right || Box->bottom > m_Region.bottom)
+        {
+            // Pointer left the region, capture threads start filling one around it from their next frame
+            Request(Box);
+        }
+        else if (IsCovered(Box))
+        {
+            UINT RowBytes = (Box->right - Box->left) * BPP;
+            const BYTE* Src = m_Pixels + ((Box->top - m_Region.top) * POINTER_SHADOW_PITCH) + ((Box->left - m_Region.left) * BPP);
+            for (LONG Row = Box->top; Row < Box->bottom; ++Row)
+            {
+                memcpy_s(Dest, RowBytes, Src, RowBytes);
+                Dest += DestPitch;
+                Src += POINTER_SHADOW_PITCH;
+            }
+            Hit = true;
+        }
+    }
+
+    if (Hit)
+    {
+        ++m_Stats.Hits;
+    }
+    else
+    {
+        ++m_Stats.Misses;
+    }
+
+    ReleaseSRWLockExclusive(&m_Lock);
+
+    return Hit;
+}
+
+//
+// Centers a new region on Box and forgets what was filled
+//
+void POINTERSHADOW::Request(_In_ const RECT* Box)
+{
+    m_Region.left = ((Box->left + Box->right) / 2) - (POINTER_SHADOW_SIZE / 2);
+    m_Region.top = ((Box->top + Box->bottom) / 2) - (POINTER_SHADOW_SIZE / 2);
+    m_Region.right = m_Region.left + POINTER_SHADOW_SIZE;
+    m_Region.bottom = m_Region.top + POINTER_SHADOW_SIZE;
+
+    // Generation 0 is what capture threads start out with so it never names a region
+    if (++m_Generation == 0)
+    {
+        ++m_Generation;
+    }
+    m_PartCount = 0;
+    ++m_Stats.Requests;
+}
+
+//
+// Whether the filled parts cover all of Box, parts come from different outputs so they never overlap
+//
+bool POINTERSHADOW::IsCovered(_In_ const RECT* Box)
+{
+    LONGLONG Covered = 0;
+    for (UINT i = 0; i < m_PartCount; ++i)
+    {
+        RECT Overlap;
+        if (IntersectRect(&Overlap, Box, &m_Parts[i]))
+        {
+            Covered += static_cast<LONGLONG>(Overlap.right - Overlap.left) * (Overlap.bottom - Overlap.top);
+        }
+    }
+
+    return Covered == static_cast<LONGLONG>(Box->right - Box->left) * (Box->bottom - Box->top);
+}
+
+//
+// Current region and its generation, capture threads hand the generation back with what they write
+//
+LONG POINTERSHADOW::GetRegion(_Out_ RECT* Region)
+{
+    AcquireSRWLockShared(&m_Lock);
+    *Region = m_Region;
+    LONG Generation = m_Generation;
+    ReleaseSRWLockShared(&m_Lock);
+
+    return Generation;
+}
+
+//
+// Copies Rect, which has to be inside the region of Generation, in from Src which points at its top left pixel.
+// Fill marks Rect as one output's whole part of the region. Pixels for a region that has moved on are dropped.
+//
+void POINTERSHADOW::Write(LONG Generation, _In_ const RECT* Rect, _In_ const BYTE* Src, UINT SrcPitch, bool Fill)
+{
+    AcquireSRWLockExclusive(&m_Lock);
+
+    RECT Clipped;
+    if (m_Pixels && Generation == m_Generation && IntersectRect(&Clipped, Rect, &m_Region))
+    {
+        Src += ((Clipped.top - Rect->top) * SrcPitch) + ((Clipped.left - Rect->left) * BPP);
+        BYTE* Dest = m_Pixels + ((Clipped.top - m_Region.top) * POINTER_SHADOW_PITCH) + ((Clipped.left - m_Region.left) * BPP);
+        UINT RowBytes = (Clipped.right - Clipped.left) * BPP;
+        for (LONG Row = Clipped.top; Row < Clipped.bottom; ++Row)
+        {
+            memcpy_s(Dest, RowBytes, Src, RowBytes);
+            Dest += POINTER_SHADOW_PITCH;
+            Src += SrcPitch;
+        }
+
+        if (!Fill)
+        {
+            ++m_Stats.Updates;
+        }
+        else if (m_PartCount < POINTER_SHADOW_PARTS)
+        {
+            m_Parts[m_PartCount++] = Clipped;
+            ++m_Stats.Fills;
+        }
+    }
+
+    ReleaseSRWLockExclusive(&m_Lock);
+}
+
+//
+// Snapshot of the running totals
+//
+void POINTERSHADOW::GetStats(_Out_ POINTER_SHADOW_STATS* Stats)
+{
+    AcquireSRWLockShared(&m_Lock);
+    *Stats = m_Stats;
+    ReleaseSRWLockShared(&m_Lock);
+}
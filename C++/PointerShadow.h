@@ -0,0 +1,69 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _POINTERSHADOW_H_
+#define _POINTERSHADOW_H_
+
+#include "CommonTypes.h"
+
+// Side of the square of desktop pixels kept around the pointer, twice the largest pointer Windows draws
+#define POINTER_SHADOW_SIZE 512
+
+// Most outputs a region is filled from, a pointer over any more has its pixels read back from the GPU
+#define POINTER_SHADOW_PARTS 16
+
+//
+// Running totals kept by POINTERSHADOW
+//
+typedef struct _POINTER_SHADOW_STATS
+{
+    UINT64 Requests;
+    UINT64 Fills;
+    UINT64 Updates;
+    UINT64 Hits;
+    UINT64 Misses;
+} POINTER_SHADOW_STATS;
+
+//
+// CPU copy of the desktop image around the pointer, so the render thread can build monochrome and
+// masked color pointers without reading the desktop back from the GPU.
+// The render thread picks the region: a read outside it moves the region over the pointer. Capture
+// threads fill their output's part of a new region once and then copy in whatever their frames
+// draw over it, a read only succeeds when every pixel it asks for has been filled.
+// Pixels come from the capture side so they can be a frame apart from the render thread's own image.
+//
+class POINTERSHADOW
+{
+    public:
+        POINTERSHADOW();
+        ~POINTERSHADOW();
+        DUPL_RETURN Init();
+        void Reset();
+        bool Read(_In_ const RECT* Box, _Out_writes_bytes_((Box->bottom - Box->top) * DestPitch) BYTE* Dest, UINT DestPitch);
+        LONG GetRegion(_Out_ RECT* Region);
+        void Write(LONG Generation, _In_ const RECT* Rect, _In_ const BYTE* Src, UINT SrcPitch, bool Fill);
+        void GetStats(_Out_ POINTER_SHADOW_STATS* Stats);
+
+    private:
+        void Request(_In_ const RECT* Box);
+        bool IsCovered(_In_ const RECT* Box);
+
+    // vars
+        SRWLOCK m_Lock;
+        _Field_size_bytes_(POINTER_SHADOW_SIZE * POINTER_SHADOW_SIZE * BPP) BYTE* m_Pixels;
+
+        // Region in desktop image coordinates, a new generation is taken every time it moves
+        RECT m_Region;
+        LONG m_Generation;
+
+        // Parts of the region capture threads have filled since it last moved
+        UINT m_PartCount;
+        RECT m_Parts[POINTER_SHADOW_PARTS];
+        POINTER_SHADOW_STATS m_Stats;
+};
+
+#endif
@@ -0,0 +1,259 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CaptureArena.h"
+#include "PointerState.h"
+
+POINTERSTATE::POINTERSTATE() : m_WriterLock(0),
+                               m_Sequence(0),
+                               m_Visible(false),
+                               m_WhoUpdatedPositionLast(0),
+                               m_ShapeSlot(0)
+{
+    m_Position.x = 0;
+    m_Position.y = 0;
+    m_LastTimeStamp.QuadPart = 0;
+    RtlZeroMemory(m_Slots, sizeof(m_Slots));
+}
+
+POINTERSTATE::~POINTERSTATE()
+{
+    for (UINT i = 0; i < POINTER_SHAPE_SLOTS; ++i)
+    {
+        if (m_Slots[i].Buffer)
+        {
+            delete [] m_Slots[i].Buffer;
+            m_Slots[i].Buffer = nullptr;
+        }
+    }
+}
+
+//
+// Allocates the shape slots and the pointer shadow, they are kept until the application exits
+//
+DUPL_RETURN POINTERSTATE::Init()
+{
+    for (UINT i = 0; i < POINTER_SHAPE_SLOTS; ++i)
+    {
+        if (!m_Slots[i].Buffer)
+        {
+            m_Slots[i].Buffer = new (std::nothrow) BYTE[POINTER_SHAPE_MAX_BYTES];
+            if (!m_Slots[i].Buffer)
+            {
+                return ProcessFailure(nullptr, L"Failed to allocate pointer shape slots in POINTERSTATE", L"Error", E_OUTOFMEMORY);
+            }
+        }
+    }
+
+    return m_Shadow.Init();
+}
+
+//
+// Forgets the pointer, only call while no capture thread is running
+//
+void POINTERSTATE::Reset()
+{
+    InterlockedIncrement(&m_Sequence);
+    m_Position.x = 0;
+    m_Position.y = 0;
+    m_Visible = false;
+    m_WhoUpdatedPositionLast = 0;
+    m_LastTimeStamp.QuadPart = 0;
+    for (UINT i = 0; i < POINTER_SHAPE_SLOTS; ++i)
+    {
+        InterlockedIncrement(&m_Slots[i].Sequence);
+        RtlZeroMemory(&m_Slots[i].ShapeInfo, sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO));
+        m_Slots[i].ShapeHash = 0;
+        m_Slots[i].Size = 0;
+        InterlockedIncrement(&m_Slots[i].Sequence);
+    }
+    InterlockedIncrement(&m_Sequence);
+    m_Shadow.Reset();
+}
+
+//
+// Spins until this thread is the only writer, writers only hold it for a few stores
+//
+void POINTERSTATE::LockWriters()
+{
+    while (InterlockedCompareExchange(&m_WriterLock, 1, 0) != 0)
+    {
+        YieldProcessor();
+    }
+}
+
+void POINTERSTATE::UnlockWriters()
+{
+    InterlockedExchange(&m_WriterLock, 0);
+}
+
+//
+// Publishes a position update from one output unless another output's update should win
+//
+void POINTERSTATE::PublishPosition(UINT Output, POINT Position, bool Visible, LARGE_INTEGER TimeStamp)
+{
+    LockWriters();
+
+    bool UpdatePosition = true;
+
+    // Make sure we don't update pointer position wrongly
+    // If pointer is invisible, make sure we did not get an update from another output that the last time that said pointer
+    // was visible, if so, don't set it to invisible or update.
+    if (!Visible && (m_WhoUpdatedPositionLast != Output))
+    {
+        UpdatePosition = false;
+    }
+
+    // If two outputs both say they have a visible, only update if new update has newer timestamp
+    if (Visible && m_Visible && (m_WhoUpdatedPositionLast != Output) && (m_LastTimeStamp.QuadPart > TimeStamp.QuadPart))
+    {
+        UpdatePosition = false;
+    }
+
+    if (UpdatePosition)
+    {
+        // Odd sequence tells readers to wait, the interlocked increments order the stores around it
+        InterlockedIncrement(&m_Sequence);
+        m_Position = Position;
+        m_Visible = Visible;
+        m_WhoUpdatedPositionLast = Output;
+        m_LastTimeStamp = TimeStamp;
+        InterlockedIncrement(&m_Sequence);
+    }
+
+    UnlockWriters();
+}
+
+//
+// Publishes a new shape. Shapes larger than a slot are not published and the previous shape stays.
+//
+void POINTERSTATE::PublishShape(_In_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_(Size) BYTE* Buffer, UINT Size, UINT64 ShapeHash)
+{
+    if (Size > POINTER_SHAPE_MAX_BYTES || !m_Slots[0].Buffer)
+    {
+        return;
+    }
+
+    LockWriters();
+
+    // Fill the slot readers are not pointed at
+    UINT NewSlot = m_ShapeSlot ^ 1;
+    POINTER_SHAPE_SLOT* Slot = &m_Slots[NewSlot];
+    InterlockedIncrement(&Slot->Sequence);
+    memcpy_s(Slot->Buffer, POINTER_SHAPE_MAX_BYTES, Buffer, Size);
+    Slot->ShapeInfo = *ShapeInfo;
+    Slot->ShapeHash = ShapeHash;
+    Slot->Size = Size;
+    InterlockedIncrement(&Slot->Sequence);
+
+    // Then point readers at it
+    InterlockedIncrement(&m_Sequence);
+    m_ShapeSlot = NewSlot;
+    InterlockedIncrement(&m_Sequence);
+
+    UnlockWriters();
+}
+
+//
+// Copies the latest published pointer into PtrInfo, which belongs to the caller.
+// Shape bytes are only copied when the shape differs from the one PtrInfo already has.
+//
+DUPL_RETURN POINTERSTATE::Read(_Inout_ PTR_INFO* PtrInfo)
+{
+    for (;;)
+    {
+        LONG Sequence = m_Sequence;
+        if (Sequence & 1)
+        {
+            YieldProcessor();
+            continue;
+        }
+        MemoryBarrier();
+
+        POINT Position = m_Position;
+        bool Visible = m_Visible;
+        UINT WhoUpdatedPositionLast = m_WhoUpdatedPositionLast;
+        LARGE_INTEGER LastTimeStamp = m_LastTimeStamp;
+        UINT ShapeSlot = m_ShapeSlot;
+
+        MemoryBarrier();
+        if (m_Sequence != Sequence)
+        {
+            continue;
+        }
+
+        // A slot being written was handed to a newer shape after the header was read, so start over
+        POINTER_SHAPE_SLOT* Slot = &m_Slots[ShapeSlot];
+        LONG SlotSequence = Slot->Sequence;
+        if (SlotSequence & 1)
+        {
+            YieldProcessor();
+            continue;
+        }
+        MemoryBarrier();
+
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo = Slot->ShapeInfo;
+        UINT64 ShapeHash = Slot->ShapeHash;
+        UINT Size = Slot->Size;
+        bool NewShape = (ShapeHash != PtrInfo->ShapeHash) || (memcmp(&ShapeInfo, &PtrInfo->ShapeInfo, sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO)) != 0);
+        if (NewShape && Size)
+        {
+            if (Size > POINTER_SHAPE_MAX_BYTES)
+            {
+                continue;
+            }
+
+            if (Size > PtrInfo->BufferSize)
+            {
+                UINT NewSize = CAPTUREARENA::GrowSize(PtrInfo->BufferSize, Size);
+                if (PtrInfo->PtrShapeBuffer)
+                {
+                    delete [] PtrInfo->PtrShapeBuffer;
+                    PtrInfo->PtrShapeBuffer = nullptr;
+                }
+                PtrInfo->BufferSize = 0;
+                PtrInfo->PtrShapeBuffer = new (std::nothrow) BYTE[NewSize];
+                if (!PtrInfo->PtrShapeBuffer)
+                {
+                    return ProcessFailure(nullptr, L"Failed to allocate memory for pointer shape in POINTERSTATE", L"Error", E_OUTOFMEMORY);
+                }
+                PtrInfo->BufferSize = NewSize;
+            }
+
+            // Until the copy is known to be whole the buffer holds no shape
+            RtlZeroMemory(&PtrInfo->ShapeInfo, sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO));
+            PtrInfo->ShapeHash = 0;
+            memcpy_s(PtrInfo->PtrShapeBuffer, PtrInfo->BufferSize, Slot->Buffer, Size);
+        }
+
+        MemoryBarrier();
+        if (Slot->Sequence != SlotSequence)
+        {
+            continue;
+        }
+
+        PtrInfo->Position = Position;
+        PtrInfo->Visible = Visible;
+        PtrInfo->WhoUpdatedPositionLast = WhoUpdatedPositionLast;
+        PtrInfo->LastTimeStamp = LastTimeStamp;
+        if (NewShape)
+        {
+            PtrInfo->ShapeInfo = ShapeInfo;
+            PtrInfo->ShapeHash = ShapeHash;
+        }
+
+        return DUPL_RETURN_SUCCESS;
+    }
+}
+
+//
+// Desktop pixels around the pointer, capture threads write them and the render thread reads them
+//
+POINTERSHADOW* POINTERSTATE::GetShadow()
+{
+    return &m_Shadow;
+}
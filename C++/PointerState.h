@@ -0,0 +1,70 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _POINTERSTATE_H_
+#define _POINTERSTATE_H_
+
+#include "CommonTypes.h"
+#include "PointerShadow.h"
+
+// Largest shape a slot holds, a 256x256 color pointer which is the largest size Windows draws
+#define POINTER_SHAPE_MAX_BYTES (256 * 256 * BPP)
+
+// Shapes are written into the slot readers are not looking at
+#define POINTER_SHAPE_SLOTS 2
+
+//
+// One published pointer shape, Sequence is odd while the slot is being written
+//
+typedef struct _POINTER_SHAPE_SLOT
+{
+    volatile LONG Sequence;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    UINT64 ShapeHash;
+    UINT Size;
+    _Field_size_bytes_(POINTER_SHAPE_MAX_BYTES) BYTE* Buffer;
+} POINTER_SHAPE_SLOT;
+
+//
+// Pointer position, visibility and shape shared between the capture threads and the render thread.
+// Capture threads publish under a short writer lock since deciding whether a position update wins
+// depends on what the other outputs published. Readers never take the lock: position and the
+// current shape slot are read under a sequence counter and retried if a writer got in, and the
+// shape bytes are checked against their slot's own sequence so a new shape going into the other
+// slot never makes the reader retry. Slots have a fixed size so a reader never touches freed memory.
+//
+class POINTERSTATE
+{
+    public:
+        POINTERSTATE();
+        ~POINTERSTATE();
+        DUPL_RETURN Init();
+        void Reset();
+        void PublishPosition(UINT Output, POINT Position, bool Visible, LARGE_INTEGER TimeStamp);
+        void PublishShape(_In_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_(Size) BYTE* Buffer, UINT Size, UINT64 ShapeHash);
+        DUPL_RETURN Read(_Inout_ PTR_INFO* PtrInfo);
+        POINTERSHADOW* GetShadow();
+
+    private:
+        void LockWriters();
+        void UnlockWriters();
+
+    // vars
+        volatile LONG m_WriterLock;
+        volatile LONG m_Sequence;
+        POINT m_Position;
+        bool m_Visible;
+        UINT m_WhoUpdatedPositionLast;
+        LARGE_INTEGER m_LastTimeStamp;
+        UINT m_ShapeSlot;
+        POINTER_SHAPE_SLOT m_Slots[POINTER_SHAPE_SLOTS];
+
+        // Desktop pixels around the pointer, kept by the capture threads for the render thread
+        POINTERSHADOW m_Shadow;
+};
+
+#endif
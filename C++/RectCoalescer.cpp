@@ -0,0 +1,190 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "RectCoalescer.h"
+
+// Defaults, frames above either limit are copied whole
+#define COALESCE_DEFAULT_MAX_RECTS      512
+#define COALESCE_DEFAULT_MAX_COVERAGE   0.6f
+
+// Default pixels a merge may add, roughly what one extra quad costs to set up and draw
+#define COALESCE_DEFAULT_RECT_COST      2048
+
+RECTCOALESCER::RECTCOALESCER() : m_Arena(nullptr),
+                                 m_MaxRects(COALESCE_DEFAULT_MAX_RECTS),
+                                 m_MaxCoverage(COALESCE_DEFAULT_MAX_COVERAGE),
+                                 m_RectCost(COALESCE_DEFAULT_RECT_COST)
+{
+    RtlZeroMemory(&m_Stats, sizeof(m_Stats));
+}
+
+RECTCOALESCER::~RECTCOALESCER()
+{
+}
+
+//
+// Frames with more than MaxRects rects, or whose rects add up to more than MaxCoverage of the frame, are copied whole
+//
+void RECTCOALESCER::SetFullCopyThreshold(UINT MaxRects, FLOAT MaxCoverage)
+{
+    m_MaxRects = MaxRects;
+    m_MaxCoverage = MaxCoverage;
+}
+
+//
+// Extra pixels a merge may copy before two separate rects are cheaper, 0 only merges rects that touch exactly
+//
+void RECTCOALESCER::SetRectCost(UINT Pixels)
+{
+    m_RectCost = Pixels;
+}
+
+//
+// Output rects come from Arena, must be set before the first Coalesce
+//
+void RECTCOALESCER::SetArena(_In_ CAPTUREARENA* Arena)
+{
+    m_Arena = Arena;
+}
+
+//
+// Clips Rect to the frame, returns false if nothing is left
+//
+bool RECTCOALESCER::ClipToFrame(_Inout_ RECT* Rect, UINT FrameWidth, UINT FrameHeight)
+{
+    Rect->left = max(Rect->left, 0L);
+    Rect->top = max(Rect->top, 0L);
+    Rect->right = min(Rect->right, static_cast<LONG>(FrameWidth));
+    Rect->bottom = min(Rect->bottom, static_cast<LONG>(FrameHeight));
+
+    return (Rect->right > Rect->left) && (Rect->bottom > Rect->top);
+}
+
+//
+// Cost model, merge when the bounding box wastes no more than m_RectCost pixels
+//
+bool RECTCOALESCER::ShouldMerge(_In_ RECT* First, _In_ RECT* Second)
+{
+    LONGLONG FirstArea = static_cast<LONGLONG>(First->right - First->left) * (First->bottom - First->top);
+    LONGLONG SecondArea = static_cast<LONGLONG>(Second->right - Second->left) * (Second->bottom - Second->top);
+
+    LONGLONG UnionArea = static_cast<LONGLONG>(max(First->right, Second->right) - min(First->left, Second->left)) *
+                         (max(First->bottom, Second->bottom) - min(First->top, Second->top));
+
+    LONG OverlapWidth = min(First->right, Second->right) - max(First->left, Second->left);
+    LONG OverlapHeight = min(First->bottom, Second->bottom) - max(First->top, Second->top);
+    LONGLONG OverlapArea = (OverlapWidth > 0 && OverlapHeight > 0) ? static_cast<LONGLONG>(OverlapWidth) * OverlapHeight : 0;
+
+    return (UnionArea - (FirstArea + SecondArea - OverlapArea)) <= static_cast<LONGLONG>(m_RectCost);
+}
+
+//
+// Coalesce DirtyBuffer into a set of rects that is cheaper to copy, OutBuffer stays valid until the next call
+//
+DUPL_RETURN RECTCOALESCER::Coalesce(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight, _Outptr_result_buffer_(*OutCount) RECT** OutBuffer, _Out_ UINT* OutCount)
+{
+    *OutBuffer = nullptr;
+    *OutCount = 0;
+
+    // Input is left untouched since the metadata buffer is shared with the trace recorder
+    BYTE* Buffer;
+    DUPL_RETURN Ret = m_Arena->Reserve(ARENA_SLOT_COALESCED_RECTS, max(DirtyCount, 1U) * sizeof(RECT), &Buffer);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+    RECT* Rects = reinterpret_cast<RECT*>(Buffer);
+    *OutBuffer = Rects;
+
+    UINT Count = 0;
+    UINT64 PixelsIn = 0;
+    for (UINT i = 0; i < DirtyCount; ++i)
+    {
+        Rects[Count] = DirtyBuffer[i];
+        if (ClipToFrame(&Rects[Count], FrameWidth, FrameHeight))
+        {
+            PixelsIn += static_cast<UINT64>(Rects[Count].right - Rects[Count].left) * (Rects[Count].bottom - Rects[Count].top);
+            ++Count;
+        }
+    }
+
+    ++m_Stats.Frames;
+    m_Stats.RectsIn += DirtyCount;
+    m_Stats.PixelsIn += PixelsIn;
+
+    if (!Count)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    UINT64 FrameArea = static_cast<UINT64>(FrameWidth) * FrameHeight;
+    if (Count > m_MaxRects || PixelsIn >= static_cast<UINT64>(m_MaxCoverage * FrameArea))
+    {
+        // Too fragmented or too big, one quad over the whole frame is cheapest
+        Rects[0].left = 0;
+        Rects[0].top = 0;
+        Rects[0].right = FrameWidth;
+        Rects[0].bottom = FrameHeight;
+        Count = 1;
+        ++m_Stats.FullCopies;
+    }
+    else
+    {
+        // Greedy pairwise merging, a rect that grew can reach rects already looked at so repeat until nothing changes
+        bool MergedInPass;
+        do
+        {
+            MergedInPass = false;
+            for (UINT i = 0; i < Count; ++i)
+            {
+                for (UINT j = i + 1; j < Count;)
+                {
+                    if (ShouldMerge(&Rects[i], &Rects[j]))
+                    {
+                        Rects[i].left = min(Rects[i].left, Rects[j].left);
+                        Rects[i].top = min(Rects[i].top, Rects[j].top);
+                        Rects[i].right = max(Rects[i].right, Rects[j].right);
+                        Rects[i].bottom = max(Rects[i].bottom, Rects[j].bottom);
+
+                        // Fill the hole with the last rect and look at j again
+                        Rects[j] = Rects[--Count];
+                        MergedInPass = true;
+                    }
+                    else
+                    {
+                        ++j;
+                    }
+                }
+            }
+        } while (MergedInPass);
+    }
+
+    UINT64 PixelsOut = 0;
+    for (UINT i = 0; i < Count; ++i)
+    {
+        PixelsOut += static_cast<UINT64>(Rects[i].right - Rects[i].left) * (Rects[i].bottom - Rects[i].top);
+    }
+
+    m_Stats.RectsOut += Count;
+    m_Stats.PixelsOut += PixelsOut;
+    if (PixelsOut > PixelsIn)
+    {
+        m_Stats.PixelsOverCopied += PixelsOut - PixelsIn;
+    }
+
+    *OutCount = Count;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies out the running totals
+//
+void RECTCOALESCER::GetStats(_Out_ COALESCE_STATS* Stats)
+{
+    *Stats = m_Stats;
+}
@@ -0,0 +1,55 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _RECTCOALESCER_H_
+#define _RECTCOALESCER_H_
+
+#include "CaptureArena.h"
+
+//
+// Running totals kept by RECTCOALESCER
+//
+typedef struct _COALESCE_STATS
+{
+    UINT64 Frames;
+    UINT64 FullCopies;
+    UINT64 RectsIn;
+    UINT64 RectsOut;
+    UINT64 PixelsIn;
+    UINT64 PixelsOut;
+    UINT64 PixelsOverCopied;
+} COALESCE_STATS;
+
+//
+// Merges the dirty rects of a frame before they are turned into vertices.
+// Two rects are merged when the pixels their bounding box adds are cheaper than drawing a separate
+// rect (RectCost pixels). Frames with too many rects or too much coverage become one full frame copy.
+//
+class RECTCOALESCER
+{
+    public:
+        RECTCOALESCER();
+        ~RECTCOALESCER();
+        void SetFullCopyThreshold(UINT MaxRects, FLOAT MaxCoverage);
+        void SetRectCost(UINT Pixels);
+        void SetArena(_In_ CAPTUREARENA* Arena);
+        DUPL_RETURN Coalesce(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight, _Outptr_result_buffer_(*OutCount) RECT** OutBuffer, _Out_ UINT* OutCount);
+        void GetStats(_Out_ COALESCE_STATS* Stats);
+
+    private:
+        bool ClipToFrame(_Inout_ RECT* Rect, UINT FrameWidth, UINT FrameHeight);
+        bool ShouldMerge(_In_ RECT* First, _In_ RECT* Second);
+
+    // vars
+        CAPTUREARENA* m_Arena;
+        UINT m_MaxRects;
+        FLOAT m_MaxCoverage;
+        UINT64 m_RectCost;
+        COALESCE_STATS m_Stats;
+};
+
+#endif
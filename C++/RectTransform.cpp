@@ -0,0 +1,415 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <emmintrin.h>
+
+#include "RectTransform.h"
+using namespace DirectX;
+
+//
+// Loads four RECTs and transposes them into left, top, right and bottom vectors
+//
+static void LoadRects(_In_reads_(4) const RECT* Rects, _Out_writes_(4) __m128i* Edges)
+{
+    __m128 Row0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&Rects[0])));
+    __m128 Row1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&Rects[1])));
+    __m128 Row2 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&Rects[2])));
+    __m128 Row3 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&Rects[3])));
+    _MM_TRANSPOSE4_PS(Row0, Row1, Row2, Row3);
+    Edges[EDGE_LEFT] = _mm_castps_si128(Row0);
+    Edges[EDGE_TOP] = _mm_castps_si128(Row1);
+    Edges[EDGE_RIGHT] = _mm_castps_si128(Row2);
+    Edges[EDGE_BOTTOM] = _mm_castps_si128(Row3);
+}
+
+//
+// Inverse of LoadRects
+//
+static void StoreRects(_In_reads_(4) const __m128i* Edges, _Out_writes_(4) RECT* Rects)
+{
+    __m128 Row0 = _mm_castsi128_ps(Edges[EDGE_LEFT]);
+    __m128 Row1 = _mm_castsi128_ps(Edges[EDGE_TOP]);
+    __m128 Row2 = _mm_castsi128_ps(Edges[EDGE_RIGHT]);
+    __m128 Row3 = _mm_castsi128_ps(Edges[EDGE_BOTTOM]);
+    _MM_TRANSPOSE4_PS(Row0, Row1, Row2, Row3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&Rects[0]), _mm_castps_si128(Row0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&Rects[1]), _mm_castps_si128(Row1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&Rects[2]), _mm_castps_si128(Row2));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&Rects[3]), _mm_castps_si128(Row3));
+}
+
+//
+// Evaluates one edge of an EDGE_AFFINE for four rects, negation is (x ^ -1) - (-1)
+//
+static __m128i ApplyEdge(_In_reads_(4) const __m128i* Edges, _In_ const EDGE_AFFINE* Affine, UINT Edge)
+{
+    __m128i Negate = _mm_set1_epi32(Affine->Negate[Edge]);
+    __m128i Value = _mm_sub_epi32(_mm_xor_si128(Edges[Affine->Src[Edge]], Negate), Negate);
+    Value = _mm_and_si128(Value, _mm_set1_epi32(Affine->Keep[Edge]));
+    return _mm_add_epi32(Value, _mm_set1_epi32(Affine->Constant[Edge]));
+}
+
+RECTTRANSFORM::RECTTRANSFORM() : m_DirtyPrepared(false),
+                                 m_MovesPrepared(false)
+{
+    RtlZeroMemory(&m_DirtyDeskDesc, sizeof(m_DirtyDeskDesc));
+    RtlZeroMemory(m_DirtyKey, sizeof(m_DirtyKey));
+    RtlZeroMemory(&m_DestAffine, sizeof(m_DestAffine));
+    RtlZeroMemory(&m_PosAffine, sizeof(m_PosAffine));
+    RtlZeroMemory(m_PosDivisor, sizeof(m_PosDivisor));
+    RtlZeroMemory(m_TexDivisor, sizeof(m_TexDivisor));
+    RtlZeroMemory(m_TexU, sizeof(m_TexU));
+    RtlZeroMemory(m_TexV, sizeof(m_TexV));
+    RtlZeroMemory(m_MoveKey, sizeof(m_MoveKey));
+    RtlZeroMemory(&m_MoveSrcAffine, sizeof(m_MoveSrcAffine));
+    RtlZeroMemory(&m_MoveDestAffine, sizeof(m_MoveDestAffine));
+}
+
+RECTTRANSFORM::~RECTTRANSFORM()
+{
+}
+
+//
+// Sets output edge Edge to (+/- input edge Src) + Constant
+//
+void RECTTRANSFORM::SetEdge(_Inout_ EDGE_AFFINE* Affine, UINT Edge, UINT Src, bool Negate, INT Constant)
+{
+    Affine->Src[Edge] = Src;
+    Affine->Negate[Edge] = Negate ? -1 : 0;
+    Affine->Keep[Edge] = -1;
+    Affine->Constant[Edge] = Constant;
+}
+
+//
+// Compiles the dirty rect transform for an output, cheap when nothing has changed since the last call
+//
+void RECTTRANSFORM::PrepareDirty(_In_ DXGI_OUTPUT_DESC* DeskDesc, INT OffsetX, INT OffsetY, _In_ D3D11_TEXTURE2D_DESC* FullDesc, _In_ D3D11_TEXTURE2D_DESC* ThisDesc)
+{
+    INT Key[6] = {OffsetX, OffsetY, static_cast<INT>(FullDesc->Width), static_cast<INT>(FullDesc->Height), static_cast<INT>(ThisDesc->Width), static_cast<INT>(ThisDesc->Height)};
+    if (m_DirtyPrepared && memcmp(Key, m_DirtyKey, sizeof(Key)) == 0 &&
+        m_DirtyDeskDesc.Rotation == DeskDesc->Rotation && EqualRect(&m_DirtyDeskDesc.DesktopCoordinates, &DeskDesc->DesktopCoordinates))
+    {
+        return;
+    }
+    memcpy_s(m_DirtyKey, sizeof(m_DirtyKey), Key, sizeof(Key));
+    m_DirtyDeskDesc = *DeskDesc;
+    m_DirtyPrepared = true;
+
+    INT CenterX = FullDesc->Width / 2;
+    INT CenterY = FullDesc->Height / 2;
+
+    INT Width = DeskDesc->DesktopCoordinates.right - DeskDesc->DesktopCoordinates.left;
+    INT Height = DeskDesc->DesktopCoordinates.bottom - DeskDesc->DesktopCoordinates.top;
+
+    // Rotation compensated destination rect, as (+/- source edge) + constant
+    EDGE_AFFINE Dest;
+    switch (DeskDesc->Rotation)
+    {
+        case DXGI_MODE_ROTATION_ROTATE90:
+        {
+            SetEdge(&Dest, EDGE_LEFT, EDGE_BOTTOM, true, Width);
+            SetEdge(&Dest, EDGE_TOP, EDGE_LEFT, false, 0);
+            SetEdge(&Dest, EDGE_RIGHT, EDGE_TOP, true, Width);
+            SetEdge(&Dest, EDGE_BOTTOM, EDGE_RIGHT, false, 0);
+
+            UINT TexU[4] = {EDGE_RIGHT, EDGE_LEFT, EDGE_RIGHT, EDGE_LEFT};
+            UINT TexV[4] = {EDGE_BOTTOM, EDGE_BOTTOM, EDGE_TOP, EDGE_TOP};
+            memcpy_s(m_TexU, sizeof(m_TexU), TexU, sizeof(TexU));
+            memcpy_s(m_TexV, sizeof(m_TexV), TexV, sizeof(TexV));
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE180:
+        {
+            SetEdge(&Dest, EDGE_LEFT, EDGE_RIGHT, true, Width);
+            SetEdge(&Dest, EDGE_TOP, EDGE_BOTTOM, true, Height);
+            SetEdge(&Dest, EDGE_RIGHT, EDGE_LEFT, true, Width);
+            SetEdge(&Dest, EDGE_BOTTOM, EDGE_TOP, true, Height);
+
+            UINT TexU[4] = {EDGE_RIGHT, EDGE_RIGHT, EDGE_LEFT, EDGE_LEFT};
+            UINT TexV[4] = {EDGE_TOP, EDGE_BOTTOM, EDGE_TOP, EDGE_BOTTOM};
+            memcpy_s(m_TexU, sizeof(m_TexU), TexU, sizeof(TexU));
+            memcpy_s(m_TexV, sizeof(m_TexV), TexV, sizeof(TexV));
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE270:
+        {
+            SetEdge(&Dest, EDGE_LEFT, EDGE_TOP, false, 0);
+            SetEdge(&Dest, EDGE_TOP, EDGE_RIGHT, true, Height);
+            SetEdge(&Dest, EDGE_RIGHT, EDGE_BOTTOM, false, 0);
+            SetEdge(&Dest, EDGE_BOTTOM, EDGE_LEFT, true, Height);
+
+            UINT TexU[4] = {EDGE_LEFT, EDGE_RIGHT, EDGE_LEFT, EDGE_RIGHT};
+            UINT TexV[4] = {EDGE_TOP, EDGE_TOP, EDGE_BOTTOM, EDGE_BOTTOM};
+            memcpy_s(m_TexU, sizeof(m_TexU), TexU, sizeof(TexU));
+            memcpy_s(m_TexV, sizeof(m_TexV), TexV, sizeof(TexV));
+            break;
+        }
+        default:
+        case DXGI_MODE_ROTATION_UNSPECIFIED:
+        case DXGI_MODE_ROTATION_IDENTITY:
+        {
+            SetEdge(&Dest, EDGE_LEFT, EDGE_LEFT, false, 0);
+            SetEdge(&Dest, EDGE_TOP, EDGE_TOP, false, 0);
+            SetEdge(&Dest, EDGE_RIGHT, EDGE_RIGHT, false, 0);
+            SetEdge(&Dest, EDGE_BOTTOM, EDGE_BOTTOM, false, 0);
+
+            UINT TexU[4] = {EDGE_LEFT, EDGE_LEFT, EDGE_RIGHT, EDGE_RIGHT};
+            UINT TexV[4] = {EDGE_BOTTOM, EDGE_TOP, EDGE_BOTTOM, EDGE_TOP};
+            memcpy_s(m_TexU, sizeof(m_TexU), TexU, sizeof(TexU));
+            memcpy_s(m_TexV, sizeof(m_TexV), TexV, sizeof(TexV));
+            break;
+        }
+    }
+
+    m_DestAffine = Dest;
+
+    // Fold the move into clip space numerators: x = Dest + origin - center, y = -(Dest + origin - center)
+    INT OriginX = DeskDesc->DesktopCoordinates.left - OffsetX - CenterX;
+    INT OriginY = DeskDesc->DesktopCoordinates.top - OffsetY - CenterY;
+    SetEdge(&m_PosAffine, EDGE_LEFT, Dest.Src[EDGE_LEFT], Dest.Negate[EDGE_LEFT] != 0, Dest.Constant[EDGE_LEFT] + OriginX);
+    SetEdge(&m_PosAffine, EDGE_RIGHT, Dest.Src[EDGE_RIGHT], Dest.Negate[EDGE_RIGHT] != 0, Dest.Constant[EDGE_RIGHT] + OriginX);
+    SetEdge(&m_PosAffine, EDGE_TOP, Dest.Src[EDGE_TOP], Dest.Negate[EDGE_TOP] == 0, -(Dest.Constant[EDGE_TOP] + OriginY));
+    SetEdge(&m_PosAffine, EDGE_BOTTOM, Dest.Src[EDGE_BOTTOM], Dest.Negate[EDGE_BOTTOM] == 0, -(Dest.Constant[EDGE_BOTTOM] + OriginY));
+
+    m_PosDivisor[EDGE_LEFT] = m_PosDivisor[EDGE_RIGHT] = static_cast<FLOAT>(CenterX);
+    m_PosDivisor[EDGE_TOP] = m_PosDivisor[EDGE_BOTTOM] = static_cast<FLOAT>(CenterY);
+    m_TexDivisor[EDGE_LEFT] = m_TexDivisor[EDGE_RIGHT] = static_cast<FLOAT>(ThisDesc->Width);
+    m_TexDivisor[EDGE_TOP] = m_TexDivisor[EDGE_BOTTOM] = static_cast<FLOAT>(ThisDesc->Height);
+}
+
+//
+// Fills NUMVERTICES vertices per dirty rect, same output as SetDirtyVert
+//
+void RECTTRANSFORM::TransformDirty(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, _Out_writes_(DirtyCount * NUMVERTICES) VERTEX* Vertices)
+{
+    __m128 PosDivisor[4];
+    __m128 TexDivisor[4];
+    for (UINT Edge = 0; Edge < 4; ++Edge)
+    {
+        PosDivisor[Edge] = _mm_set1_ps(m_PosDivisor[Edge]);
+        TexDivisor[Edge] = _mm_set1_ps(m_TexDivisor[Edge]);
+    }
+
+    for (UINT i = 0; i < DirtyCount; i += 4)
+    {
+        UINT Lanes = min(DirtyCount - i, 4U);
+
+        // Pad the last batch
+        RECT Tail[4];
+        RECT* Batch = DirtyBuffer + i;
+        if (Lanes < 4)
+        {
+            RtlZeroMemory(Tail, sizeof(Tail));
+            memcpy_s(Tail, sizeof(Tail), Batch, Lanes * sizeof(RECT));
+            Batch = Tail;
+        }
+
+        __m128i Edges[4];
+        LoadRects(Batch, Edges);
+
+        // Integer to float conversion and a true divide keep results identical to the scalar code
+        __m128 Pos[4];
+        __m128 Tex[4];
+        for (UINT Edge = 0; Edge < 4; ++Edge)
+        {
+            Pos[Edge] = _mm_div_ps(_mm_cvtepi32_ps(ApplyEdge(Edges, &m_PosAffine, Edge)), PosDivisor[Edge]);
+            Tex[Edge] = _mm_div_ps(_mm_cvtepi32_ps(Edges[Edge]), TexDivisor[Edge]);
+        }
+
+        const FLOAT* PosLanes = reinterpret_cast<const FLOAT*>(Pos);
+        const FLOAT* TexLanes = reinterpret_cast<const FLOAT*>(Tex);
+        for (UINT Lane = 0; Lane < Lanes; ++Lane)
+        {
+            VERTEX* Vert = Vertices + ((i + Lane) * NUMVERTICES);
+
+            FLOAT Left = PosLanes[(EDGE_LEFT * 4) + Lane];
+            FLOAT Top = PosLanes[(EDGE_TOP * 4) + Lane];
+            FLOAT Right = PosLanes[(EDGE_RIGHT * 4) + Lane];
+            FLOAT Bottom = PosLanes[(EDGE_BOTTOM * 4) + Lane];
+
+            Vert[0].Pos = XMFLOAT3(Left, Bottom, 0.0f);
+            Vert[1].Pos = XMFLOAT3(Left, Top, 0.0f);
+            Vert[2].Pos = XMFLOAT3(Right, Bottom, 0.0f);
+            Vert[3].Pos = Vert[2].Pos;
+            Vert[4].Pos = Vert[1].Pos;
+            Vert[5].Pos = XMFLOAT3(Right, Top, 0.0f);
+
+            Vert[0].TexCoord = XMFLOAT2(TexLanes[(m_TexU[0] * 4) + Lane], TexLanes[(m_TexV[0] * 4) + Lane]);
+            Vert[1].TexCoord = XMFLOAT2(TexLanes[(m_TexU[1] * 4) + Lane], TexLanes[(m_TexV[1] * 4) + Lane]);
+            Vert[2].TexCoord = XMFLOAT2(TexLanes[(m_TexU[2] * 4) + Lane], TexLanes[(m_TexV[2] * 4) + Lane]);
+            Vert[3].TexCoord = Vert[2].TexCoord;
+            Vert[4].TexCoord = Vert[1].TexCoord;
+            Vert[5].TexCoord = XMFLOAT2(TexLanes[(m_TexU[3] * 4) + Lane], TexLanes[(m_TexV[3] * 4) + Lane]);
+        }
+    }
+}
+
+//
+// Fills the rotation compensated rect each dirty rect covers on the output, the area TransformDirty draws
+//
+void RECTTRANSFORM::TransformDirtyRects(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, _Out_writes_(DirtyCount) RECT* DestRects)
+{
+    for (UINT i = 0; i < DirtyCount; i += 4)
+    {
+        UINT Lanes = min(DirtyCount - i, 4U);
+
+        // Pad the last batch
+        RECT Tail[4];
+        RECT* Batch = DirtyBuffer + i;
+        if (Lanes < 4)
+        {
+            RtlZeroMemory(Tail, sizeof(Tail));
+            memcpy_s(Tail, sizeof(Tail), Batch, Lanes * sizeof(RECT));
+            Batch = Tail;
+        }
+
+        __m128i Edges[4];
+        __m128i Dest[4];
+        LoadRects(Batch, Edges);
+        for (UINT Edge = 0; Edge < 4; ++Edge)
+        {
+            Dest[Edge] = ApplyEdge(Edges, &m_DestAffine, Edge);
+        }
+
+        if (Lanes < 4)
+        {
+            StoreRects(Dest, Tail);
+            memcpy_s(DestRects + i, Lanes * sizeof(RECT), Tail, Lanes * sizeof(RECT));
+        }
+        else
+        {
+            StoreRects(Dest, DestRects + i);
+        }
+    }
+}
+
+//
+// Compiles the move rect transform, cheap when nothing has changed since the last call
+//
+void RECTTRANSFORM::PrepareMoves(DXGI_MODE_ROTATION Rotation, INT TexWidth, INT TexHeight)
+{
+    if (m_MovesPrepared && m_MoveKey[0] == Rotation && m_MoveKey[1] == TexWidth && m_MoveKey[2] == TexHeight)
+    {
+        return;
+    }
+    m_MoveKey[0] = Rotation;
+    m_MoveKey[1] = TexWidth;
+    m_MoveKey[2] = TexHeight;
+    m_MovesPrepared = true;
+
+    // Source rect tables work on the unrotated source rect, destination tables on DestinationRect
+    switch (Rotation)
+    {
+        case DXGI_MODE_ROTATION_UNSPECIFIED:
+        case DXGI_MODE_ROTATION_IDENTITY:
+        {
+            SetEdge(&m_MoveSrcAffine, EDGE_LEFT, EDGE_LEFT, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_TOP, EDGE_TOP, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_RIGHT, EDGE_RIGHT, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_BOTTOM, EDGE_BOTTOM, false, 0);
+            m_MoveDestAffine = m_MoveSrcAffine;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE90:
+        {
+            SetEdge(&m_MoveSrcAffine, EDGE_LEFT, EDGE_BOTTOM, true, TexHeight);
+            SetEdge(&m_MoveSrcAffine, EDGE_TOP, EDGE_LEFT, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_RIGHT, EDGE_TOP, true, TexHeight);
+            SetEdge(&m_MoveSrcAffine, EDGE_BOTTOM, EDGE_RIGHT, false, 0);
+            m_MoveDestAffine = m_MoveSrcAffine;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE180:
+        {
+            SetEdge(&m_MoveSrcAffine, EDGE_LEFT, EDGE_RIGHT, true, TexWidth);
+            SetEdge(&m_MoveSrcAffine, EDGE_TOP, EDGE_BOTTOM, true, TexHeight);
+            SetEdge(&m_MoveSrcAffine, EDGE_RIGHT, EDGE_LEFT, true, TexWidth);
+            SetEdge(&m_MoveSrcAffine, EDGE_BOTTOM, EDGE_TOP, true, TexHeight);
+            m_MoveDestAffine = m_MoveSrcAffine;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE270:
+        {
+            // SetMoveRect takes the source left from SourcePoint.x here, kept as is for identical results
+            SetEdge(&m_MoveSrcAffine, EDGE_LEFT, EDGE_LEFT, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_TOP, EDGE_RIGHT, true, TexWidth);
+            SetEdge(&m_MoveSrcAffine, EDGE_RIGHT, EDGE_BOTTOM, false, 0);
+            SetEdge(&m_MoveSrcAffine, EDGE_BOTTOM, EDGE_LEFT, true, TexWidth);
+
+            SetEdge(&m_MoveDestAffine, EDGE_LEFT, EDGE_TOP, false, 0);
+            SetEdge(&m_MoveDestAffine, EDGE_TOP, EDGE_RIGHT, true, TexWidth);
+            SetEdge(&m_MoveDestAffine, EDGE_RIGHT, EDGE_BOTTOM, false, 0);
+            SetEdge(&m_MoveDestAffine, EDGE_BOTTOM, EDGE_LEFT, true, TexWidth);
+            break;
+        }
+        default:
+        {
+            // Unknown rotation gives empty rects
+            RtlZeroMemory(&m_MoveSrcAffine, sizeof(m_MoveSrcAffine));
+            RtlZeroMemory(&m_MoveDestAffine, sizeof(m_MoveDestAffine));
+            break;
+        }
+    }
+}
+
+//
+// Fills source and destination rects per move rect, same output as SetMoveRect
+//
+void RECTTRANSFORM::TransformMoves(_In_reads_(MoveCount) DXGI_OUTDUPL_MOVE_RECT* MoveBuffer, UINT MoveCount, _Out_writes_(MoveCount) RECT* SrcRects, _Out_writes_(MoveCount) RECT* DestRects)
+{
+    for (UINT i = 0; i < MoveCount; i += 4)
+    {
+        UINT Lanes = min(MoveCount - i, 4U);
+
+        // Gather the batch into rect form, padding the last one
+        RECT Dest[4];
+        INT SourceX[4];
+        INT SourceY[4];
+        RtlZeroMemory(Dest, sizeof(Dest));
+        RtlZeroMemory(SourceX, sizeof(SourceX));
+        RtlZeroMemory(SourceY, sizeof(SourceY));
+        for (UINT Lane = 0; Lane < Lanes; ++Lane)
+        {
+            Dest[Lane] = MoveBuffer[i + Lane].DestinationRect;
+            SourceX[Lane] = MoveBuffer[i + Lane].SourcePoint.x;
+            SourceY[Lane] = MoveBuffer[i + Lane].SourcePoint.y;
+        }
+
+        __m128i DestEdges[4];
+        LoadRects(Dest, DestEdges);
+
+        // Unrotated source rect is SourcePoint plus the destination size
+        __m128i SrcEdges[4];
+        SrcEdges[EDGE_LEFT] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SourceX));
+        SrcEdges[EDGE_TOP] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SourceY));
+        SrcEdges[EDGE_RIGHT] = _mm_add_epi32(SrcEdges[EDGE_LEFT], _mm_sub_epi32(DestEdges[EDGE_RIGHT], DestEdges[EDGE_LEFT]));
+        SrcEdges[EDGE_BOTTOM] = _mm_add_epi32(SrcEdges[EDGE_TOP], _mm_sub_epi32(DestEdges[EDGE_BOTTOM], DestEdges[EDGE_TOP]));
+
+        __m128i SrcOut[4];
+        __m128i DestOut[4];
+        for (UINT Edge = 0; Edge < 4; ++Edge)
+        {
+            SrcOut[Edge] = ApplyEdge(SrcEdges, &m_MoveSrcAffine, Edge);
+            DestOut[Edge] = ApplyEdge(DestEdges, &m_MoveDestAffine, Edge);
+        }
+
+        if (Lanes == 4)
+        {
+            StoreRects(SrcOut, SrcRects + i);
+            StoreRects(DestOut, DestRects + i);
+        }
+        else
+        {
+            RECT SrcTail[4];
+            RECT DestTail[4];
+            StoreRects(SrcOut, SrcTail);
+            StoreRects(DestOut, DestTail);
+            memcpy_s(SrcRects + i, Lanes * sizeof(RECT), SrcTail, Lanes * sizeof(RECT));
+            memcpy_s(DestRects + i, Lanes * sizeof(RECT), DestTail, Lanes * sizeof(RECT));
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _RECTTRANSFORM_H_
+#define _RECTTRANSFORM_H_
+
+#include "CommonTypes.h"
+
+// Edge order used by the transform tables
+#define EDGE_LEFT   0
+#define EDGE_TOP    1
+#define EDGE_RIGHT  2
+#define EDGE_BOTTOM 3
+
+//
+// Each output edge is (+/- one input edge) + Constant, or just Constant when Keep is zero
+//
+typedef struct _EDGE_AFFINE
+{
+    UINT Src[4];
+    INT Negate[4];
+    INT Keep[4];
+    INT Constant[4];
+} EDGE_AFFINE;
+
+//
+// Batch version of DISPLAYMANAGER::SetDirtyVert and SetMoveRect.
+// The rotation is compiled into integer edge tables once per output (and again only when the
+// output or frame size changes), then rects are transformed four at a time with SSE2 after being
+// transposed into left/top/right/bottom vectors. Results match the per rect code bit for bit.
+//
+class RECTTRANSFORM
+{
+    public:
+        RECTTRANSFORM();
+        ~RECTTRANSFORM();
+        void PrepareDirty(_In_ DXGI_OUTPUT_DESC* DeskDesc, INT OffsetX, INT OffsetY, _In_ D3D11_TEXTURE2D_DESC* FullDesc, _In_ D3D11_TEXTURE2D_DESC* ThisDesc);
+        void TransformDirty(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, _Out_writes_(DirtyCount * NUMVERTICES) VERTEX* Vertices);
+        void TransformDirtyRects(_In_reads_(DirtyCount) RECT* DirtyBuffer, UINT DirtyCount, _Out_writes_(DirtyCount) RECT* DestRects);
+        void PrepareMoves(DXGI_MODE_ROTATION Rotation, INT TexWidth, INT TexHeight);
+        void TransformMoves(_In_reads_(MoveCount) DXGI_OUTDUPL_MOVE_RECT* MoveBuffer, UINT MoveCount, _Out_writes_(MoveCount) RECT* SrcRects, _Out_writes_(MoveCount) RECT* DestRects);
+
+    private:
+        void SetEdge(_Inout_ EDGE_AFFINE* Affine, UINT Edge, UINT Src, bool Negate, INT Constant);
+
+    // vars
+        bool m_DirtyPrepared;
+        DXGI_OUTPUT_DESC m_DirtyDeskDesc;
+        INT m_DirtyKey[6];
+        EDGE_AFFINE m_DestAffine;
+        EDGE_AFFINE m_PosAffine;
+        FLOAT m_PosDivisor[4];
+        FLOAT m_TexDivisor[4];
+        UINT m_TexU[4];
+        UINT m_TexV[4];
+
+        bool m_MovesPrepared;
+        INT m_MoveKey[3];
+        EDGE_AFFINE m_MoveSrcAffine;
+        EDGE_AFFINE m_MoveDestAffine;
+};
+
+#endif
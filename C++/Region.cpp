@@ -0,0 +1,752 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <emmintrin.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "Region.h"
+
+// Smallest allocation for any of the box buffers
+#define REGION_MIN_CAPACITY 16
+
+//
+// qsort callbacks
+//
+static int __cdecl CompareTop(const void* First, const void* Second)
+{
+    LONG A = reinterpret_cast<const RECT*>(First)->top;
+    LONG B = reinterpret_cast<const RECT*>(Second)->top;
+    return (A < B) ? -1 : ((A > B) ? 1 : 0);
+}
+
+static int __cdecl CompareLeft(const void* First, const void* Second)
+{
+    LONG A = reinterpret_cast<const RECT*>(First)->left;
+    LONG B = reinterpret_cast<const RECT*>(Second)->left;
+    return (A < B) ? -1 : ((A > B) ? 1 : 0);
+}
+
+//
+// Whether a span is kept for a given membership in the two operands
+//
+static bool IsInside(REGION_OP Op, bool InA, bool InB)
+{
+    switch (Op)
+    {
+        case REGION_OP_UNION:
+            return InA || InB;
+        case REGION_OP_INTERSECT:
+            return InA && InB;
+        default:
+            return InA && !InB;
+    }
+}
+
+REGION::REGION() : m_Boxes(nullptr),
+                   m_Count(0),
+                   m_Capacity(0),
+                   m_Scratch(nullptr),
+                   m_ScratchCount(0),
+                   m_ScratchCapacity(0),
+                   m_LastBandStart(0),
+                   m_Spans(nullptr),
+                   m_SpanCapacity(0),
+                   m_Sort(nullptr),
+                   m_SortCapacity(0),
+                   m_Active(nullptr),
+                   m_ActiveCapacity(0)
+{
+    RtlZeroMemory(&m_Extents, sizeof(m_Extents));
+}
+
+REGION::~REGION()
+{
+    RECT** Buffers[] = {&m_Boxes, &m_Scratch, &m_Spans, &m_Sort, &m_Active};
+    for (UINT i = 0; i < ARRAYSIZE(Buffers); ++i)
+    {
+        if (*Buffers[i])
+        {
+            delete [] *Buffers[i];
+            *Buffers[i] = nullptr;
+        }
+    }
+}
+
+//
+// Makes Buffer hold at least Needed rects keeping the first Used, buffers only grow
+//
+DUPL_RETURN REGION::Reserve(_Inout_ RECT** Buffer, _Inout_ UINT* Capacity, UINT Used, UINT Needed)
+{
+    if (Needed <= *Capacity)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    UINT NewCapacity = max(max(Needed, *Capacity * 2), static_cast<UINT>(REGION_MIN_CAPACITY));
+    RECT* NewBuffer = new (std::nothrow) RECT[NewCapacity];
+    if (!NewBuffer)
+    {
+        return ProcessFailure(nullptr, L"Failed to allocate memory for region", L"Error", E_OUTOFMEMORY);
+    }
+
+    if (*Buffer)
+    {
+        if (Used)
+        {
+            memcpy_s(NewBuffer, NewCapacity * sizeof(RECT), *Buffer, Used * sizeof(RECT));
+        }
+        delete [] *Buffer;
+    }
+    *Buffer = NewBuffer;
+    *Capacity = NewCapacity;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Empties the region, buffers are kept for reuse
+//
+void REGION::Clear()
+{
+    m_Count = 0;
+    RtlZeroMemory(&m_Extents, sizeof(m_Extents));
+}
+
+//
+// Makes this region the same area as Other
+//
+DUPL_RETURN REGION::Copy(_In_ const REGION* Other)
+{
+    if (Other == this)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    DUPL_RETURN Ret = Reserve(&m_Boxes, &m_Capacity, 0, Other->m_Count);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    if (Other->m_Count)
+    {
+        memcpy_s(m_Boxes, m_Capacity * sizeof(RECT), Other->m_Boxes, Other->m_Count * sizeof(RECT));
+    }
+    m_Count = Other->m_Count;
+    m_Extents = Other->m_Extents;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Makes the region a single rect, an empty rect gives an empty region
+//
+DUPL_RETURN REGION::SetRect(_In_ const RECT* Rect)
+{
+    Clear();
+    if (Rect->right <= Rect->left || Rect->bottom <= Rect->top)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    DUPL_RETURN Ret = Reserve(&m_Boxes, &m_Capacity, 0, 1);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    m_Boxes[0] = *Rect;
+    m_Count = 1;
+    m_Extents = *Rect;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Makes the region the union of Rects, which may overlap and come in any order
+//
+DUPL_RETURN REGION::SetFromRects(_In_reads_(Count) const RECT* Rects, UINT Count)
+{
+    DUPL_RETURN Ret = Reserve(&m_Sort, &m_SortCapacity, 0, Count);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    if (Count)
+    {
+        memcpy_s(m_Sort, m_SortCapacity * sizeof(RECT), Rects, Count * sizeof(RECT));
+    }
+
+    return BuildFromRects(Count);
+}
+
+//
+// Makes the region the area DXGI reported as changed in a frame, move destinations included
+//
+DUPL_RETURN REGION::SetFromMetadata(_In_ FRAME_DATA* Data)
+{
+    if (!Data->FrameInfo.TotalMetadataBufferSize)
+    {
+        Clear();
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    UINT Count = Data->MoveCount + Data->DirtyCount;
+    DUPL_RETURN Ret = Reserve(&m_Sort, &m_SortCapacity, 0, Count);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    DXGI_OUTDUPL_MOVE_RECT* MoveRects = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(Data->MetaData);
+    for (UINT i = 0; i < Data->MoveCount; ++i)
+    {
+        m_Sort[i] = MoveRects[i].DestinationRect;
+    }
+    if (Data->DirtyCount)
+    {
+        memcpy_s(m_Sort + Data->MoveCount, (m_SortCapacity - Data->MoveCount) * sizeof(RECT),
+                 Data->MetaData + (Data->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)), Data->DirtyCount * sizeof(RECT));
+    }
+
+    return BuildFromRects(Count);
+}
+
+//
+// Sweeps down the Count rects in m_Sort building one band per change in the set of rects crossing it
+//
+DUPL_RETURN REGION::BuildFromRects(UINT Count)
+{
+    // Empty rects add nothing
+    UINT Valid = 0;
+    for (UINT i = 0; i < Count; ++i)
+    {
+        if (m_Sort[i].right > m_Sort[i].left && m_Sort[i].bottom > m_Sort[i].top)
+        {
+            m_Sort[Valid++] = m_Sort[i];
+        }
+    }
+
+    m_ScratchCount = 0;
+    m_LastBandStart = UINT_MAX;
+
+    DUPL_RETURN Ret = Reserve(&m_Active, &m_ActiveCapacity, 0, Valid);
+    if (Ret == DUPL_RETURN_SUCCESS)
+    {
+        Ret = Reserve(&m_Spans, &m_SpanCapacity, 0, Valid);
+    }
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    qsort(m_Sort, Valid, sizeof(RECT), CompareTop);
+
+    UINT Next = 0;
+    UINT ActiveCount = 0;
+    LONG Y = Valid ? m_Sort[0].top : 0;
+    while (Next < Valid || ActiveCount)
+    {
+        // Drop rects that end above this band
+        for (UINT i = 0; i < ActiveCount;)
+        {
+            if (m_Active[i].bottom <= Y)
+            {
+                m_Active[i] = m_Active[--ActiveCount];
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        // Pick up rects that start here
+        while (Next < Valid && m_Sort[Next].top <= Y)
+        {
+            m_Active[ActiveCount++] = m_Sort[Next++];
+        }
+
+        if (!ActiveCount)
+        {
+            if (Next == Valid)
+            {
+                break;
+            }
+            Y = m_Sort[Next].top;
+            continue;
+        }
+
+        // Band ends where the next rect starts or an active one ends
+        LONG Bottom = (Next < Valid) ? m_Sort[Next].top : LONG_MAX;
+        for (UINT i = 0; i < ActiveCount; ++i)
+        {
+            Bottom = min(Bottom, m_Active[i].bottom);
+        }
+
+        // Merge the spans of the active rects
+        memcpy_s(m_Spans, m_SpanCapacity * sizeof(RECT), m_Active, ActiveCount * sizeof(RECT));
+        qsort(m_Spans, ActiveCount, sizeof(RECT), CompareLeft);
+        UINT SpanCount = 0;
+        for (UINT i = 0; i < ActiveCount; ++i)
+        {
+            if (SpanCount && m_Spans[i].left <= m_Spans[SpanCount - 1].right)
+            {
+                m_Spans[SpanCount - 1].right = max(m_Spans[SpanCount - 1].right, m_Spans[i].right);
+            }
+            else
+            {
+                m_Spans[SpanCount].left = m_Spans[i].left;
+                m_Spans[SpanCount].right = m_Spans[i].right;
+                ++SpanCount;
+            }
+        }
+        for (UINT i = 0; i < SpanCount; ++i)
+        {
+            m_Spans[i].top = Y;
+            m_Spans[i].bottom = Bottom;
+        }
+
+        Ret = AppendBand(m_Spans, SpanCount);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+
+        Y = Bottom;
+    }
+
+    SwapScratch();
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Index one past the last box of the band starting at Start
+//
+UINT REGION::BandEnd(_In_reads_(Count) const RECT* Boxes, UINT Count, UINT Start)
+{
+    UINT End = Start + 1;
+    while (End < Count && Boxes[End].top == Boxes[Start].top)
+    {
+        ++End;
+    }
+
+    return End;
+}
+
+//
+// Whether two bands have the same horizontal spans, compares two boxes at a time
+//
+bool REGION::SameSpans(_In_reads_(Count) const RECT* First, _In_reads_(Count) const RECT* Second, UINT Count)
+{
+    UINT i = 0;
+    for (; i + 2 <= Count; i += 2)
+    {
+        // Two boxes per compare, only the left and right lanes have to match
+        __m128i A0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&First[i]));
+        __m128i B0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&Second[i]));
+        __m128i A1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&First[i + 1]));
+        __m128i B1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&Second[i + 1]));
+        int Mask = _mm_movemask_epi8(_mm_cmpeq_epi32(A0, B0)) & (_mm_movemask_epi8(_mm_cmpeq_epi32(A1, B1)));
+        if ((Mask & 0x0F0F) != 0x0F0F)
+        {
+            return false;
+        }
+    }
+
+    for (; i < Count; ++i)
+    {
+        if (First[i].left != Second[i].left || First[i].right != Second[i].right)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Appends a band to the scratch list, or stretches the previous band if it is directly above with the same spans
+//
+DUPL_RETURN REGION::AppendBand(_In_reads_(SpanCount) const RECT* Spans, UINT SpanCount)
+{
+    if (!SpanCount)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    if (m_LastBandStart != UINT_MAX &&
+        m_Scratch[m_LastBandStart].bottom == Spans[0].top &&
+        m_ScratchCount - m_LastBandStart == SpanCount &&
+        SameSpans(m_Scratch + m_LastBandStart, Spans, SpanCount))
+    {
+        for (UINT i = m_LastBandStart; i < m_ScratchCount; ++i)
+        {
+            m_Scratch[i].bottom = Spans[0].bottom;
+        }
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    DUPL_RETURN Ret = Reserve(&m_Scratch, &m_ScratchCapacity, m_ScratchCount, m_ScratchCount + SpanCount);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    memcpy_s(m_Scratch + m_ScratchCount, (m_ScratchCapacity - m_ScratchCount) * sizeof(RECT), Spans, SpanCount * sizeof(RECT));
+    m_LastBandStart = m_ScratchCount;
+    m_ScratchCount += SpanCount;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Combines the spans of one band from each operand, either may be empty, and appends the result
+//
+DUPL_RETURN REGION::CombineSpans(_In_reads_(CountA) const RECT* SpansA, UINT CountA, _In_reads_(CountB) const RECT* SpansB, UINT CountB, REGION_OP Op, LONG Top, LONG Bottom)
+{
+    DUPL_RETURN Ret = Reserve(&m_Spans, &m_SpanCapacity, 0, CountA + CountB);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    // Walk both span lists left to right, stepping to the next edge of either
+    UINT SpanCount = 0;
+    UINT i = 0;
+    UINT j = 0;
+    LONG X = min(CountA ? SpansA[0].left : LONG_MAX, CountB ? SpansB[0].left : LONG_MAX);
+    while (i < CountA || j < CountB)
+    {
+        if (i < CountA && SpansA[i].right <= X)
+        {
+            ++i;
+            continue;
+        }
+        if (j < CountB && SpansB[j].right <= X)
+        {
+            ++j;
+            continue;
+        }
+
+        bool InA = i < CountA && SpansA[i].left <= X;
+        bool InB = j < CountB && SpansB[j].left <= X;
+
+        LONG Next = LONG_MAX;
+        if (i < CountA)
+        {
+            Next = min(Next, InA ? SpansA[i].right : SpansA[i].left);
+        }
+        if (j < CountB)
+        {
+            Next = min(Next, InB ? SpansB[j].right : SpansB[j].left);
+        }
+
+        if (IsInside(Op, InA, InB))
+        {
+            // Spans that touch are joined
+            if (SpanCount && m_Spans[SpanCount - 1].right == X)
+            {
+                m_Spans[SpanCount - 1].right = Next;
+            }
+            else
+            {
+                m_Spans[SpanCount].left = X;
+                m_Spans[SpanCount].top = Top;
+                m_Spans[SpanCount].right = Next;
+                m_Spans[SpanCount].bottom = Bottom;
+                ++SpanCount;
+            }
+        }
+
+        X = Next;
+    }
+
+    return AppendBand(m_Spans, SpanCount);
+}
+
+//
+// Applies Op between this region and the banded boxes BoxesB, result replaces this region
+//
+DUPL_RETURN REGION::CombineBoxes(_In_reads_(CountB) const RECT* BoxesB, UINT CountB, _In_ const RECT* ExtentsB, REGION_OP Op)
+{
+    bool ExtentsOverlap = m_Count && CountB &&
+                          m_Extents.left < ExtentsB->right && ExtentsB->left < m_Extents.right &&
+                          m_Extents.top < ExtentsB->bottom && ExtentsB->top < m_Extents.bottom;
+
+    // Cases that need no band walk
+    switch (Op)
+    {
+        case REGION_OP_UNION:
+        {
+            if (!CountB)
+            {
+                return DUPL_RETURN_SUCCESS;
+            }
+            break;
+        }
+        case REGION_OP_INTERSECT:
+        {
+            if (!ExtentsOverlap)
+            {
+                Clear();
+                return DUPL_RETURN_SUCCESS;
+            }
+            break;
+        }
+        default:
+        {
+            if (!ExtentsOverlap)
+            {
+                return DUPL_RETURN_SUCCESS;
+            }
+            break;
+        }
+    }
+
+    m_ScratchCount = 0;
+    m_LastBandStart = UINT_MAX;
+
+    const RECT* BoxesA = m_Boxes;
+    UINT CountA = m_Count;
+    UINT i = 0;
+    UINT j = 0;
+    UINT EndA = CountA ? BandEnd(BoxesA, CountA, 0) : 0;
+    UINT EndB = CountB ? BandEnd(BoxesB, CountB, 0) : 0;
+    LONG Y = min(CountA ? BoxesA[0].top : LONG_MAX, CountB ? BoxesB[0].top : LONG_MAX);
+
+    // Walk the bands of both operands top to bottom, stepping to the next band edge of either
+    while ((Op == REGION_OP_UNION) ? (i < CountA || j < CountB) :
+           (Op == REGION_OP_INTERSECT) ? (i < CountA && j < CountB) : (i < CountA))
+    {
+        if (i < CountA && BoxesA[i].bottom <= Y)
+        {
+            i = EndA;
+            EndA = (i < CountA) ? BandEnd(BoxesA, CountA, i) : i;
+            continue;
+        }
+        if (j < CountB && BoxesB[j].bottom <= Y)
+        {
+            j = EndB;
+            EndB = (j < CountB) ? BandEnd(BoxesB, CountB, j) : j;
+            continue;
+        }
+
+        bool InA = i < CountA && BoxesA[i].top <= Y;
+        bool InB = j < CountB && BoxesB[j].top <= Y;
+
+        LONG Next = LONG_MAX;
+        if (i < CountA)
+        {
+            Next = min(Next, InA ? BoxesA[i].bottom : BoxesA[i].top);
+        }
+        if (j < CountB)
+        {
+            Next = min(Next, InB ? BoxesB[j].bottom : BoxesB[j].top);
+        }
+
+        if (InA || InB)
+        {
+            DUPL_RETURN Ret = CombineSpans(InA ? BoxesA + i : nullptr, InA ? EndA - i : 0, InB ? BoxesB + j : nullptr, InB ? EndB - j : 0, Op, Y, Next);
+            if (Ret != DUPL_RETURN_SUCCESS)
+            {
+                return Ret;
+            }
+        }
+
+        Y = Next;
+    }
+
+    SwapScratch();
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// this = this Op Other, Other may be this region
+//
+DUPL_RETURN REGION::Combine(_In_ const REGION* Other, REGION_OP Op)
+{
+    if (Other == this)
+    {
+        // Union and intersect with itself change nothing, subtract empties it
+        if (Op == REGION_OP_SUBTRACT)
+        {
+            Clear();
+        }
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    return CombineBoxes(Other->m_Boxes, Other->m_Count, &Other->m_Extents, Op);
+}
+
+//
+// A single non-empty rect is already a banded region so the rect versions skip building one
+//
+DUPL_RETURN REGION::UnionRect(_In_ const RECT* Rect)
+{
+    bool Empty = Rect->right <= Rect->left || Rect->bottom <= Rect->top;
+    return CombineBoxes(Rect, Empty ? 0 : 1, Rect, REGION_OP_UNION);
+}
+
+DUPL_RETURN REGION::IntersectRect(_In_ const RECT* Rect)
+{
+    bool Empty = Rect->right <= Rect->left || Rect->bottom <= Rect->top;
+    return CombineBoxes(Rect, Empty ? 0 : 1, Rect, REGION_OP_INTERSECT);
+}
+
+DUPL_RETURN REGION::SubtractRect(_In_ const RECT* Rect)
+{
+    bool Empty = Rect->right <= Rect->left || Rect->bottom <= Rect->top;
+    return CombineBoxes(Rect, Empty ? 0 : 1, Rect, REGION_OP_SUBTRACT);
+}
+
+//
+// Moves the whole region, one add per box
+//
+void REGION::Translate(INT Dx, INT Dy)
+{
+    __m128i Delta = _mm_setr_epi32(Dx, Dy, Dx, Dy);
+    for (UINT i = 0; i < m_Count; ++i)
+    {
+        __m128i* Box = reinterpret_cast<__m128i*>(&m_Boxes[i]);
+        _mm_storeu_si128(Box, _mm_add_epi32(_mm_loadu_si128(Box), Delta));
+    }
+
+    if (m_Count)
+    {
+        OffsetRect(&m_Extents, Dx, Dy);
+    }
+}
+
+//
+// Swaps in the result built by an operation
+//
+void REGION::SwapScratch()
+{
+    RECT* Boxes = m_Boxes;
+    UINT Capacity = m_Capacity;
+    m_Boxes = m_Scratch;
+    m_Capacity = m_ScratchCapacity;
+    m_Count = m_ScratchCount;
+    m_Scratch = Boxes;
+    m_ScratchCapacity = Capacity;
+    m_ScratchCount = 0;
+
+    ComputeExtents();
+}
+
+//
+// Top and bottom come from the first and last band, left and right need a pass over every box
+//
+void REGION::ComputeExtents()
+{
+    if (!m_Count)
+    {
+        RtlZeroMemory(&m_Extents, sizeof(m_Extents));
+        return;
+    }
+
+    // SSE2 has no 32 bit min and max so select with a compare
+    __m128i Min = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_Boxes[0]));
+    __m128i Max = Min;
+    for (UINT i = 1; i < m_Count; ++i)
+    {
+        __m128i Box = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_Boxes[i]));
+        __m128i Less = _mm_cmplt_epi32(Box, Min);
+        __m128i Greater = _mm_cmpgt_epi32(Box, Max);
+        Min = _mm_or_si128(_mm_and_si128(Less, Box), _mm_andnot_si128(Less, Min));
+        Max = _mm_or_si128(_mm_and_si128(Greater, Box), _mm_andnot_si128(Greater, Max));
+    }
+
+    RECT MinBox;
+    RECT MaxBox;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&MinBox), Min);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&MaxBox), Max);
+
+    m_Extents.left = MinBox.left;
+    m_Extents.top = m_Boxes[0].top;
+    m_Extents.right = MaxBox.right;
+    m_Extents.bottom = m_Boxes[m_Count - 1].bottom;
+}
+
+bool REGION::IsEmpty() const
+{
+    return m_Count == 0;
+}
+
+//
+// Whether any part of Rect is in the region, a binary search finds the first band that can overlap
+//
+bool REGION::Intersects(_In_ const RECT* Rect) const
+{
+    if (!m_Count || Rect->right <= Rect->left || Rect->bottom <= Rect->top ||
+        Rect->right <= m_Extents.left || Rect->left >= m_Extents.right ||
+        Rect->bottom <= m_Extents.top || Rect->top >= m_Extents.bottom)
+    {
+        return false;
+    }
+
+    // First box whose band ends below the top of Rect
+    UINT Low = 0;
+    UINT High = m_Count;
+    while (Low < High)
+    {
+        UINT Mid = (Low + High) / 2;
+        if (m_Boxes[Mid].bottom <= Rect->top)
+        {
+            Low = Mid + 1;
+        }
+        else
+        {
+            High = Mid;
+        }
+    }
+
+    for (UINT i = Low; i < m_Count && m_Boxes[i].top < Rect->bottom; ++i)
+    {
+        if (m_Boxes[i].left < Rect->right && Rect->left < m_Boxes[i].right)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// Number of pixels in the region
+//
+UINT64 REGION::GetArea() const
+{
+    UINT64 Area = 0;
+    for (UINT i = 0; i < m_Count; ++i)
+    {
+        Area += static_cast<UINT64>(m_Boxes[i].right - m_Boxes[i].left) * (m_Boxes[i].bottom - m_Boxes[i].top);
+    }
+
+    return Area;
+}
+
+//
+// Bounding box, all zero when empty
+//
+void REGION::GetExtents(_Out_ RECT* Extents) const
+{
+    *Extents = m_Extents;
+}
+
+//
+// Banded boxes, valid until the region is next changed
+//
+_Ret_writes_(*Count) const RECT* REGION::GetRects(_Out_ UINT* Count) const
+{
+    *Count = m_Count;
+    return m_Boxes;
+}
@@ -0,0 +1,85 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _REGION_H_
+#define _REGION_H_
+
+#include "CommonTypes.h"
+
+//
+// Set operations REGION supports, see REGION::Combine
+//
+typedef enum _REGION_OP
+{
+    REGION_OP_UNION     = 0,
+    REGION_OP_INTERSECT = 1,
+    REGION_OP_SUBTRACT  = 2
+} REGION_OP;
+
+//
+// An area of the desktop stored as y-x banded boxes, the same layout pixman and X11 use.
+// Boxes are sorted by top and then left, boxes in one band share top and bottom, boxes never
+// overlap or touch within a band, and vertically adjacent bands with identical spans are merged.
+// That keeps the box list unique for a given area so set operations are a single walk over the
+// bands of both operands.
+//
+class REGION
+{
+    public:
+        REGION();
+        ~REGION();
+        void Clear();
+        DUPL_RETURN Copy(_In_ const REGION* Other);
+        DUPL_RETURN SetRect(_In_ const RECT* Rect);
+        DUPL_RETURN SetFromRects(_In_reads_(Count) const RECT* Rects, UINT Count);
+        DUPL_RETURN SetFromMetadata(_In_ FRAME_DATA* Data);
+        DUPL_RETURN Combine(_In_ const REGION* Other, REGION_OP Op);
+        DUPL_RETURN UnionRect(_In_ const RECT* Rect);
+        DUPL_RETURN IntersectRect(_In_ const RECT* Rect);
+        DUPL_RETURN SubtractRect(_In_ const RECT* Rect);
+        void Translate(INT Dx, INT Dy);
+        bool IsEmpty() const;
+        bool Intersects(_In_ const RECT* Rect) const;
+        UINT64 GetArea() const;
+        void GetExtents(_Out_ RECT* Extents) const;
+        _Ret_writes_(*Count) const RECT* GetRects(_Out_ UINT* Count) const;
+
+    private:
+        DUPL_RETURN Reserve(_Inout_ RECT** Buffer, _Inout_ UINT* Capacity, UINT Used, UINT Needed);
+        DUPL_RETURN CombineBoxes(_In_reads_(CountB) const RECT* BoxesB, UINT CountB, _In_ const RECT* ExtentsB, REGION_OP Op);
+        DUPL_RETURN CombineSpans(_In_reads_(CountA) const RECT* SpansA, UINT CountA, _In_reads_(CountB) const RECT* SpansB, UINT CountB, REGION_OP Op, LONG Top, LONG Bottom);
+        DUPL_RETURN BuildFromRects(UINT Count);
+        DUPL_RETURN AppendBand(_In_reads_(SpanCount) const RECT* Spans, UINT SpanCount);
+        static UINT BandEnd(_In_reads_(Count) const RECT* Boxes, UINT Count, UINT Start);
+        static bool SameSpans(_In_reads_(Count) const RECT* First, _In_reads_(Count) const RECT* Second, UINT Count);
+        void SwapScratch();
+        void ComputeExtents();
+
+    // vars
+        _Field_size_(m_Capacity) RECT* m_Boxes;
+        UINT m_Count;
+        UINT m_Capacity;
+        RECT m_Extents;
+
+        // Combine builds its result here and then swaps it with m_Boxes
+        _Field_size_(m_ScratchCapacity) RECT* m_Scratch;
+        UINT m_ScratchCount;
+        UINT m_ScratchCapacity;
+        UINT m_LastBandStart;
+
+        // Spans of the band being built
+        _Field_size_(m_SpanCapacity) RECT* m_Spans;
+        UINT m_SpanCapacity;
+
+        // Input rects sorted by top and the rects crossing the current band, used when building from rects
+        _Field_size_(m_SortCapacity) RECT* m_Sort;
+        UINT m_SortCapacity;
+        _Field_size_(m_ActiveCapacity) RECT* m_Active;
+        UINT m_ActiveCapacity;
+};
+
+#endif
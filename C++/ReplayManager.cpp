@@ -0,0 +1,257 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "ReplayManager.h"
+
+//
+// Constructor sets up references / variables
+//
+REPLAYMANAGER::REPLAYMANAGER() : m_Speed(1.0f),
+                                 m_File(INVALID_HANDLE_VALUE),
+                                 m_Mapping(nullptr),
+                                 m_View(nullptr),
+                                 m_ViewSize(0),
+                                 m_CurrentRecord(nullptr),
+                                 m_Frame(nullptr),
+                                 m_Device(nullptr),
+                                 m_DeviceContext(nullptr)
+{
+    m_Path[0] = '\0';
+    m_QPCFrequency.QuadPart = 0;
+}
+
+//
+// Destructor unmaps the trace and releases references
+//
+REPLAYMANAGER::~REPLAYMANAGER()
+{
+    if (m_View)
+    {
+        UnmapViewOfFile(m_View);
+        m_View = nullptr;
+    }
+
+    if (m_Mapping)
+    {
+        CloseHandle(m_Mapping);
+        m_Mapping = nullptr;
+    }
+
+    if (m_File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+
+    if (m_Frame)
+    {
+        m_Frame->Release();
+        m_Frame = nullptr;
+    }
+
+    if (m_DeviceContext)
+    {
+        m_DeviceContext->Release();
+        m_DeviceContext = nullptr;
+    }
+
+    if (m_Device)
+    {
+        m_Device->Release();
+        m_Device = nullptr;
+    }
+}
+
+//
+// Takes the trace path and replay speed, must be called before InitSource
+//
+void REPLAYMANAGER::SetOptions(_In_ CAPTURE_OPTIONS* Options)
+{
+    strcpy_s(m_Path, MAX_PATH, Options->ReplayPath);
+    m_Speed = Options->ReplaySpeed;
+}
+
+//
+// Map the trace and create the texture frames are played back into
+//
+DUPL_RETURN REPLAYMANAGER::InitSource(_In_ ID3D11Device* Device, UINT Output)
+{
+    m_OutputNumber = Output;
+
+    // Take a reference on the device
+    m_Device = Device;
+    m_Device->AddRef();
+    m_Device->GetImmediateContext(&m_DeviceContext);
+
+    // Map the whole trace read-only
+    m_File = CreateFileA(m_Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        return ProcessFailure(nullptr, L"Failed to open capture trace in REPLAYMANAGER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(m_File, &FileSize) || FileSize.QuadPart < sizeof(CAPTURE_TRACE_HEADER) || static_cast<ULONGLONG>(FileSize.QuadPart) > static_cast<SIZE_T>(-1))
+    {
+        return ProcessFailure(nullptr, L"Capture trace is too small or too large to map in REPLAYMANAGER", L"Error", E_INVALIDARG);
+    }
+    m_ViewSize = static_cast<SIZE_T>(FileSize.QuadPart);
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping)
+    {
+        return ProcessFailure(nullptr, L"Failed to create file mapping for capture trace in REPLAYMANAGER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    m_View = reinterpret_cast<BYTE*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_View)
+    {
+        return ProcessFailure(nullptr, L"Failed to map capture trace in REPLAYMANAGER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    // Check the header and every record
+    if (!m_Reader.Open(m_View, m_ViewSize))
+    {
+        return ProcessFailure(nullptr, L"Capture trace is not valid or contains no frames in REPLAYMANAGER", L"Error", E_INVALIDARG);
+    }
+    const CAPTURE_TRACE_HEADER* Header = m_Reader.GetHeader();
+
+    QueryPerformanceFrequency(&m_QPCFrequency);
+    m_Pacer.Init(Header->QPCFrequency.QuadPart, m_QPCFrequency.QuadPart, m_Speed);
+
+    // Output description comes from the recording
+    m_OutputDesc.DesktopCoordinates = Header->DesktopCoordinates;
+    m_OutputDesc.Rotation = static_cast<DXGI_MODE_ROTATION>(Header->Rotation);
+    m_OutputDesc.AttachedToDesktop = TRUE;
+
+    // Texture handed out as the acquired desktop image, same shape as the one desktop duplication gives back
+    D3D11_TEXTURE2D_DESC Desc;
+    RtlZeroMemory(&Desc, sizeof(Desc));
+    Desc.Width = Header->FrameWidth;
+    Desc.Height = Header->FrameHeight;
+    Desc.MipLevels = 1;
+    Desc.ArraySize = 1;
+    Desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    Desc.SampleDesc.Count = 1;
+    Desc.Usage = D3D11_USAGE_DEFAULT;
+    Desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    HRESULT hr = m_Device->CreateTexture2D(&Desc, nullptr, &m_Frame);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to create replay frame texture in REPLAYMANAGER", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Writes the recorded dirty pixels into the replay frame
+//
+void REPLAYMANAGER::UploadPixels(_In_ TRACE_FRAME* Frame)
+{
+    TRACE_PIXEL_CURSOR Cursor = {0, 0};
+    RECT Rect;
+    const BYTE* Pixels;
+    while (m_Reader.NextDirtyPixels(Frame, &Cursor, &Rect, &Pixels))
+    {
+        D3D11_BOX Box;
+        Box.left = Rect.left;
+        Box.top = Rect.top;
+        Box.front = 0;
+        Box.right = Rect.right;
+        Box.bottom = Rect.bottom;
+        Box.back = 1;
+        m_DeviceContext->UpdateSubresource(m_Frame, 0, &Box, Pixels, (Rect.right - Rect.left) * BPP, 0);
+    }
+}
+
+//
+// Get next recorded frame and write it into Data
+//
+_Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS)
+DUPL_RETURN REPLAYMANAGER::GetFrame(UINT TimeoutInMilliseconds, _Out_ FRAME_DATA* Data, _Out_ bool* Timeout)
+{
+    // Loops back to the first frame at the end of the trace
+    TRACE_FRAME Frame;
+    m_Reader.GetFrame(&Frame);
+
+    // Hold the frame back until its recorded time comes around
+    LARGE_INTEGER Now;
+    QueryPerformanceCounter(&Now);
+    LONGLONG Due = m_Pacer.GetDue(Frame.PlaybackTime, Now.QuadPart);
+    if (Due > Now.QuadPart)
+    {
+        LONGLONG WaitMs = ((Due - Now.QuadPart) * 1000) / m_QPCFrequency.QuadPart;
+        if (WaitMs > TimeoutInMilliseconds)
+        {
+            Sleep(TimeoutInMilliseconds);
+            *Timeout = true;
+            return DUPL_RETURN_SUCCESS;
+        }
+        Sleep(static_cast<DWORD>(WaitMs));
+    }
+    *Timeout = false;
+
+    const CAPTURE_TRACE_RECORD* Record = Frame.Record;
+    if (Record->PixelBytes)
+    {
+        UploadPixels(&Frame);
+    }
+
+    Data->Frame = m_Frame;
+    Data->FrameInfo = Frame.FrameInfo;
+    Data->FrameInfo.TotalMetadataBufferSize = (Record->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)) + (Record->DirtyCount * sizeof(RECT));
+    Data->FrameInfo.PointerShapeBufferSize = Record->ShapeSize;
+    Data->MetaData = const_cast<BYTE*>(reinterpret_cast<const BYTE*>(Frame.MoveRects));
+    Data->MoveCount = Record->MoveCount;
+    Data->DirtyCount = Record->DirtyCount;
+
+    m_CurrentRecord = Record;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Copies out the pointer shape recorded with the current frame
+//
+DUPL_RETURN REPLAYMANAGER::GetPointerShape(UINT BufferSize, _Out_writes_bytes_(BufferSize) BYTE* Buffer, _Out_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo)
+{
+    if (!m_CurrentRecord || m_CurrentRecord->ShapeSize > BufferSize)
+    {
+        return ProcessFailure(nullptr, L"No recorded pointer shape for current frame in REPLAYMANAGER", L"Error", E_UNEXPECTED);
+    }
+
+    const BYTE* Shape = reinterpret_cast<const BYTE*>(m_CurrentRecord + 1) +
+                        (m_CurrentRecord->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)) +
+                        (m_CurrentRecord->DirtyCount * sizeof(RECT));
+    memcpy_s(Buffer, BufferSize, Shape, m_CurrentRecord->ShapeSize);
+    *ShapeInfo = m_CurrentRecord->ShapeInfo;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Release frame, moves on to the next record
+//
+DUPL_RETURN REPLAYMANAGER::DoneWithFrame()
+{
+    if (m_CurrentRecord)
+    {
+        m_Reader.DoneWithFrame();
+        m_CurrentRecord = nullptr;
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Number of times playback has wrapped around to the start of the trace
+//
+UINT REPLAYMANAGER::GetLoopCount()
+{
+    return m_Reader.GetLoopCount();
+}
@@ -0,0 +1,53 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _REPLAYMANAGER_H_
+#define _REPLAYMANAGER_H_
+
+#include "FrameSource.h"
+#include "TraceReader.h"
+
+//
+// Plays back a capture trace as if it came from desktop duplication.
+// Frames are paced by their recorded timestamps (scaled by the replay speed) or delivered
+// as fast as they are consumed, and playback loops when the end of the trace is reached.
+// TRACEREADER and TRACEPACER do the walking and the timing, this maps the file, sleeps and uploads the pixels.
+//
+class REPLAYMANAGER : public FRAMESOURCE
+{
+    public:
+        REPLAYMANAGER();
+        ~REPLAYMANAGER();
+        void SetOptions(_In_ CAPTURE_OPTIONS* Options);
+        _Success_(*Timeout == false && return == DUPL_RETURN_SUCCESS) DUPL_RETURN GetFrame(UINT TimeoutInMilliseconds, _Out_ FRAME_DATA* Data, _Out_ bool* Timeout);
+        DUPL_RETURN DoneWithFrame();
+        DUPL_RETURN InitSource(_In_ ID3D11Device* Device, UINT Output);
+        UINT GetLoopCount();
+
+    protected:
+        DUPL_RETURN GetPointerShape(UINT BufferSize, _Out_writes_bytes_(BufferSize) BYTE* Buffer, _Out_ DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo);
+
+    private:
+        void UploadPixels(_In_ TRACE_FRAME* Frame);
+
+    // vars
+        CHAR m_Path[MAX_PATH];
+        FLOAT m_Speed;
+        HANDLE m_File;
+        HANDLE m_Mapping;
+        _Field_size_bytes_(m_ViewSize) BYTE* m_View;
+        SIZE_T m_ViewSize;
+        TRACEREADER m_Reader;
+        TRACEPACER m_Pacer;
+        const CAPTURE_TRACE_RECORD* m_CurrentRecord;
+        LARGE_INTEGER m_QPCFrequency;
+        ID3D11Texture2D* m_Frame;
+        ID3D11Device* m_Device;
+        ID3D11DeviceContext* m_DeviceContext;
+};
+
+#endif
@@ -0,0 +1,361 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <new>
+
+#include "TaskScheduler.h"
+
+TASKSCHEDULER::TASKSCHEDULER() : m_NextPoll(CLOCK::duration::max().count()),
+                                 m_Queued(0),
+                                 m_Remaining(0),
+                                 m_Sleeping(0),
+                                 m_Stopping(false),
+                                 m_Runs(0),
+                                 m_IdleRuns(0),
+                                 m_Steals(0),
+                                 m_Sleeps(0)
+{
+}
+
+TASKSCHEDULER::~TASKSCHEDULER()
+{
+    Stop();
+}
+
+//
+// Adds a task, only allowed before Start
+//
+bool TASKSCHEDULER::AddTask(TASK_PROC Proc, void* Context)
+{
+    if (!m_Threads.empty() || !Proc)
+    {
+        return false;
+    }
+
+    TASK Task;
+    Task.Proc = Proc;
+    Task.Context = Context;
+    try
+    {
+        m_Tasks.push_back(Task);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Deals the tasks out to WorkerCount new workers, each calls WorkerInit once before running any.
+// Everything the workers need is allocated here so running tasks never allocates.
+//
+bool TASKSCHEDULER::Start(unsigned WorkerCount, TASK_WORKER_INIT WorkerInit, void* InitContext)
+{
+    if (!m_Threads.empty() || WorkerCount == 0)
+    {
+        return false;
+    }
+
+    unsigned TaskCount = static_cast<unsigned>(m_Tasks.size());
+    try
+    {
+        m_IdleTasks.reserve(TaskCount);
+        for (unsigned i = 0; i < WorkerCount; ++i)
+        {
+            WORKER* Worker = new WORKER;
+            m_Workers.push_back(Worker);
+            Worker->Queue.resize(TaskCount ? TaskCount : 1);
+            Worker->Head = 0;
+            Worker->Count = 0;
+            Worker->Rearmed.reserve(TaskCount);
+        }
+        for (unsigned i = 0; i < TaskCount; ++i)
+        {
+            WORKER* Worker = m_Workers[i % WorkerCount];
+            Worker->Queue[Worker->Count++] = i;
+        }
+
+        m_Queued = TaskCount;
+        m_Remaining = TaskCount;
+        m_Stopping = false;
+        m_NextPoll = CLOCK::duration::max().count();
+
+        for (unsigned i = 0; i < WorkerCount; ++i)
+        {
+            m_Threads.push_back(std::thread(&TASKSCHEDULER::WorkerLoop, this, i, WorkerInit, InitContext));
+        }
+    }
+    catch (...)
+    {
+        Stop();
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Runs every idle task again right away, for sources that can tell when they have work
+//
+void TASKSCHEDULER::Wake()
+{
+    std::lock_guard<std::mutex> Lock(m_IdleLock);
+    CLOCK::rep Now = CLOCK::now().time_since_epoch().count();
+    for (size_t i = 0; i < m_IdleTasks.size(); ++i)
+    {
+        m_IdleTasks[i].Due = Now;
+    }
+    m_NextPoll = Now;
+    m_IdleSignal.notify_all();
+}
+
+//
+// Blocks until every task has returned TASK_DONE
+//
+void TASKSCHEDULER::WaitForTasks()
+{
+    std::unique_lock<std::mutex> Lock(m_IdleLock);
+    m_DoneSignal.wait(Lock, [this] { return m_Remaining == 0; });
+}
+
+//
+// Joins the workers and forgets the tasks. Tasks that are not done yet are not run again.
+//
+void TASKSCHEDULER::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_IdleLock);
+        m_Stopping = true;
+        m_IdleSignal.notify_all();
+    }
+
+    for (size_t i = 0; i < m_Threads.size(); ++i)
+    {
+        if (m_Threads[i].joinable())
+        {
+            m_Threads[i].join();
+        }
+    }
+    m_Threads.clear();
+
+    for (size_t i = 0; i < m_Workers.size(); ++i)
+    {
+        delete m_Workers[i];
+    }
+    m_Workers.clear();
+
+    m_Tasks.clear();
+    m_IdleTasks.clear();
+    m_Queued = 0;
+    m_Remaining = 0;
+}
+
+//
+// Snapshot of the running totals
+//
+void TASKSCHEDULER::GetStats(SCHEDULER_STATS* Stats)
+{
+    Stats->Runs = m_Runs;
+    Stats->IdleRuns = m_IdleRuns;
+    Stats->Steals = m_Steals;
+    Stats->Sleeps = m_Sleeps;
+}
+
+//
+// Body of every worker thread
+//
+void TASKSCHEDULER::WorkerLoop(unsigned Index, TASK_WORKER_INIT WorkerInit, void* InitContext)
+{
+    if (WorkerInit)
+    {
+        WorkerInit(InitContext);
+    }
+
+    while (!m_Stopping)
+    {
+        RearmIdleTasks(Index);
+
+        unsigned Task;
+        bool Stolen;
+        if (PopTask(Index, &Task, &Stolen))
+        {
+            unsigned IdlePollMs = TASK_IDLE_POLL_DEFAULT_MS;
+            TASK_RESULT Result = m_Tasks[Task].Proc(m_Tasks[Task].Context, &IdlePollMs);
+            ++m_Runs;
+            if (Stolen)
+            {
+                ++m_Steals;
+            }
+
+            if (Result == TASK_RUN_AGAIN)
+            {
+                PushTask(Index, Task);
+            }
+            else if (Result == TASK_IDLE)
+            {
+                ++m_IdleRuns;
+                ParkTask(Task, IdlePollMs);
+            }
+            else if (--m_Remaining == 0)
+            {
+                std::lock_guard<std::mutex> Lock(m_IdleLock);
+                m_DoneSignal.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing queued anywhere, sleep until the next idle task is due unless work shows up first
+        // An idle task parked meanwhile with an earlier due time also ends the sleep, so it is waited for instead
+        std::unique_lock<std::mutex> Lock(m_IdleLock);
+        CLOCK::rep NextPoll = m_NextPoll;
+        if (!m_Stopping && m_Queued == 0 && CLOCK::now().time_since_epoch().count() < NextPoll)
+        {
+            ++m_Sleeps;
+            ++m_Sleeping;
+            auto Woken = [this, NextPoll] { return m_Stopping || m_Queued != 0 || m_NextPoll < NextPoll; };
+            if (NextPoll == CLOCK::duration::max().count())
+            {
+                m_IdleSignal.wait(Lock, Woken);
+            }
+            else
+            {
+                m_IdleSignal.wait_until(Lock, CLOCK::time_point(CLOCK::duration(NextPoll)), Woken);
+            }
+            --m_Sleeping;
+        }
+    }
+}
+
+//
+// Takes the oldest task off this worker's queue, or the newest off another worker's when it is empty
+//
+bool TASKSCHEDULER::PopTask(unsigned Index, unsigned* Task, bool* Stolen)
+{
+    if (m_Queued == 0)
+    {
+        return false;
+    }
+
+    unsigned WorkerCount = static_cast<unsigned>(m_Workers.size());
+    for (unsigned i = 0; i < WorkerCount; ++i)
+    {
+        WORKER* Worker = m_Workers[(Index + i) % WorkerCount];
+        std::lock_guard<std::mutex> Lock(Worker->Lock);
+        if (Worker->Count == 0)
+        {
+            continue;
+        }
+
+        unsigned Size = static_cast<unsigned>(Worker->Queue.size());
+        if (i == 0)
+        {
+            *Task = Worker->Queue[Worker->Head];
+            Worker->Head = (Worker->Head + 1) % Size;
+        }
+        else
+        {
+            *Task = Worker->Queue[(Worker->Head + Worker->Count - 1) % Size];
+        }
+        --Worker->Count;
+        --m_Queued;
+        *Stolen = (i != 0);
+        return true;
+    }
+
+    return false;
+}
+
+//
+// Queues a task on a worker and wakes a sleeping worker to take it
+//
+void TASKSCHEDULER::PushTask(unsigned Index, unsigned Task)
+{
+    WORKER* Worker = m_Workers[Index];
+    {
+        std::lock_guard<std::mutex> Lock(Worker->Lock);
+        Worker->Queue[(Worker->Head + Worker->Count) % Worker->Queue.size()] = Task;
+        ++Worker->Count;
+    }
+    ++m_Queued;
+
+    if (m_Sleeping != 0)
+    {
+        std::lock_guard<std::mutex> Lock(m_IdleLock);
+        m_IdleSignal.notify_one();
+    }
+}
+
+//
+// Parks a task that had nothing to do until IdlePollMs from now, sleeping workers are woken
+// when it is due before whatever they were waiting for
+//
+void TASKSCHEDULER::ParkTask(unsigned Task, unsigned IdlePollMs)
+{
+    IDLE_TASK Idle;
+    Idle.Task = Task;
+    Idle.Due = (CLOCK::now() + std::chrono::milliseconds(IdlePollMs)).time_since_epoch().count();
+
+    std::lock_guard<std::mutex> Lock(m_IdleLock);
+    m_IdleTasks.push_back(Idle);
+    if (Idle.Due < m_NextPoll)
+    {
+        m_NextPoll = Idle.Due;
+        if (m_Sleeping != 0)
+        {
+            m_IdleSignal.notify_all();
+        }
+    }
+}
+
+//
+// Once an idle task is due the worker that notices moves every due task onto its own queue,
+// the other workers steal them from there
+//
+void TASKSCHEDULER::RearmIdleTasks(unsigned Index)
+{
+    CLOCK::rep Now = CLOCK::now().time_since_epoch().count();
+    if (Now < m_NextPoll)
+    {
+        return;
+    }
+
+    WORKER* Worker = m_Workers[Index];
+    {
+        std::lock_guard<std::mutex> Lock(m_IdleLock);
+        if (Now < m_NextPoll)
+        {
+            return;
+        }
+
+        // Due tasks go, the rest move up and the earliest of them sets the next poll
+        CLOCK::rep NextPoll = CLOCK::duration::max().count();
+        size_t Kept = 0;
+        for (size_t i = 0; i < m_IdleTasks.size(); ++i)
+        {
+            if (m_IdleTasks[i].Due <= Now)
+            {
+                Worker->Rearmed.push_back(m_IdleTasks[i].Task);
+            }
+            else
+            {
+                NextPoll = std::min(NextPoll, m_IdleTasks[i].Due);
+                m_IdleTasks[Kept++] = m_IdleTasks[i];
+            }
+        }
+        m_IdleTasks.resize(Kept);
+        m_NextPoll = NextPoll;
+    }
+
+    for (size_t i = 0; i < Worker->Rearmed.size(); ++i)
+    {
+        PushTask(Index, Worker->Rearmed[i]);
+    }
+    Worker->Rearmed.clear();
+}
@@ -0,0 +1,121 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TASKSCHEDULER_H_
+#define _TASKSCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// How long an idle task waits before it is run again when it does not say
+#define TASK_IDLE_POLL_DEFAULT_MS 4
+
+//
+// What a task tells the scheduler after one run
+//
+typedef enum _TASK_RESULT
+{
+    TASK_RUN_AGAIN = 0,     // Made progress, queue it again right away
+    TASK_IDLE      = 1,     // Nothing to do, run it again after the poll interval it gave or a Wake
+    TASK_DONE      = 2      // Finished, never run again
+} TASK_RESULT;
+
+// A task returning TASK_IDLE may set IdlePollMs to when it expects work, it starts out as TASK_IDLE_POLL_DEFAULT_MS
+typedef TASK_RESULT (*TASK_PROC)(void* Context, unsigned* IdlePollMs);
+typedef void (*TASK_WORKER_INIT)(void* Context);
+
+//
+// Running totals kept by TASKSCHEDULER
+//
+typedef struct _SCHEDULER_STATS
+{
+    unsigned long long Runs;
+    unsigned long long IdleRuns;
+    unsigned long long Steals;
+    unsigned long long Sleeps;
+} SCHEDULER_STATS;
+
+//
+// Runs a fixed set of tasks on a fixed number of worker threads, independent of each other.
+// Every worker has its own queue: it runs tasks from the front of it and, when it is empty,
+// steals from the back of another worker's. A task that had nothing to do is parked until the
+// poll interval it asked for runs out or Wake is called, and is then handed to whichever worker
+// gets there first. Workers with nothing to run block until the earliest of those. A task is only
+// ever in one queue or running on one worker, so it never runs concurrently with itself.
+// Only uses the C++ standard library so it can be exercised away from Windows.
+//
+class TASKSCHEDULER
+{
+    public:
+        TASKSCHEDULER();
+        ~TASKSCHEDULER();
+        bool AddTask(TASK_PROC Proc, void* Context);
+        bool Start(unsigned WorkerCount, TASK_WORKER_INIT WorkerInit, void* InitContext);
+        void Wake();
+        void WaitForTasks();
+        void Stop();
+        void GetStats(SCHEDULER_STATS* Stats);
+
+    private:
+        typedef std::chrono::steady_clock CLOCK;
+
+        struct TASK
+        {
+            TASK_PROC Proc;
+            void* Context;
+        };
+
+        struct IDLE_TASK
+        {
+            unsigned Task;
+            CLOCK::rep Due;
+        };
+
+        // Queue is a ring of task indexes, it never holds more than every task so it never grows
+        struct WORKER
+        {
+            std::mutex Lock;
+            std::vector<unsigned> Queue;
+            unsigned Head;
+            unsigned Count;
+            std::vector<unsigned> Rearmed;
+        };
+
+        void WorkerLoop(unsigned Index, TASK_WORKER_INIT WorkerInit, void* InitContext);
+        bool PopTask(unsigned Index, unsigned* Task, bool* Stolen);
+        void PushTask(unsigned Index, unsigned Task);
+        void ParkTask(unsigned Task, unsigned IdlePollMs);
+        void RearmIdleTasks(unsigned Index);
+
+    // vars
+        std::vector<TASK> m_Tasks;
+        std::vector<WORKER*> m_Workers;
+        std::vector<std::thread> m_Threads;
+
+        // Protects m_IdleTasks, sleeping workers wait on m_IdleSignal until m_NextPoll, the earliest due idle task
+        std::mutex m_IdleLock;
+        std::condition_variable m_IdleSignal;
+        std::condition_variable m_DoneSignal;
+        std::vector<IDLE_TASK> m_IdleTasks;
+        std::atomic<CLOCK::rep> m_NextPoll;
+
+        std::atomic<unsigned> m_Queued;
+        std::atomic<unsigned> m_Remaining;
+        std::atomic<unsigned> m_Sleeping;
+        std::atomic<bool> m_Stopping;
+
+        std::atomic<unsigned long long> m_Runs;
+        std::atomic<unsigned long long> m_IdleRuns;
+        std::atomic<unsigned long long> m_Steals;
+        std::atomic<unsigned long long> m_Sleeps;
+};
+
+#endif
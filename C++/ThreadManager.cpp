@@ -10,28 +10,63 @@
 DWORD WINAPI DDProc(_In_ void* Param);
 
 THREADMANAGER::THREADMANAGER() : m_ThreadCount(0),
+                                 m_ArenaCount(0),
+                                 m_Arenas(nullptr),
+                                 m_StatsCount(0),
+                                 m_Stats(nullptr),
                                  m_ThreadHandles(nullptr),
-                                 m_ThreadData(nullptr)
+                                 m_ThreadData(nullptr),
+                                 m_Tasks(nullptr),
+                                 m_ExpectedErrorEvent(nullptr)
 {
-    RtlZeroMemory(&m_PtrInfo, sizeof(m_PtrInfo));
 }
 
 THREADMANAGER::~THREADMANAGER()
 {
     Clean();
+
+    if (m_Arenas)
+    {
+        for (UINT i = 0; i < m_ArenaCount; ++i)
+        {
+            delete m_Arenas[i];
+        }
+        delete [] m_Arenas;
+        m_Arenas = nullptr;
+    }
+    m_ArenaCount = 0;
+
+    if (m_Stats)
+    {
+        for (UINT i = 0; i < m_StatsCount; ++i)
+        {
+            delete m_Stats[i];
+        }
+        delete [] m_Stats;
+        m_Stats = nullptr;
+    }
+    m_StatsCount = 0;
 }
 
 //
-// Clean up resources
+// Clean up resources, the pointer shape slots, capture arenas and capture statistics are kept for the next Initialize
 //
 void THREADMANAGER::Clean()
 {
-    if (m_PtrInfo.PtrShapeBuffer)
+    m_Pointer.Reset();
+
+    // Workers have to be gone before the tasks they run
+    m_Scheduler.Stop();
+    m_BandPool.Stop();
+    if (m_Tasks)
     {
-        delete [] m_PtrInfo.PtrShapeBuffer;
-        m_PtrInfo.PtrShapeBuffer = nullptr;
+        for (UINT i = 0; i < m_ThreadCount; ++i)
+        {
+            delete m_Tasks[i];
+        }
+        delete [] m_Tasks;
+        m_Tasks = nullptr;
     }
-    RtlZeroMemory(&m_PtrInfo, sizeof(m_PtrInfo));
 
     if (m_ThreadHandles)
     {
@@ -104,7 +139,7 @@ void THREADMANAGER::CleanDx(_Inout_ DX_RESOURCES* Data)
 //
 // Start up threads for DDA
 //
-DUPL_RETURN THREADMANAGER::Initialize(INT SingleOutput, UINT OutputCount, HANDLE UnexpectedErrorEvent, HANDLE ExpectedErrorEvent, HANDLE TerminateThreadsEvent, HANDLE SharedHandle, _In_ RECT* DesktopDim)
+DUPL_RETURN THREADMANAGER::Initialize(INT SingleOutput, UINT OutputCount, HANDLE UnexpectedErrorEvent, HANDLE ExpectedErrorEvent, HANDLE TerminateThreadsEvent, _In_reads_(OutputCount) SURFACE_TARGET* Targets, _In_ TILEMAP* TileMap, _In_ RECT* DesktopDim, _In_ CAPTURE_OPTIONS* Capture)
 {
     m_ThreadCount = OutputCount;
     m_ThreadHandles = new (std::nothrow) HANDLE[m_ThreadCount];
@@ -113,19 +148,125 @@ DUPL_RETURN THREADMANAGER::Initialize(INT SingleOutput, UINT OutputCount, HANDLE
     {
         return ProcessFailure(nullptr, L"Failed to allocate array for threads", L"Error", E_OUTOFMEMORY);
     }
+    RtlZeroMemory(m_ThreadHandles, m_ThreadCount * sizeof(HANDLE));
+
+    // Outputs become tasks on a fixed number of workers instead of getting a thread each
+    UINT WorkerCount = min(Capture->Workers, m_ThreadCount);
+    if (WorkerCount)
+    {
+        m_Tasks = new (std::nothrow) CAPTURETASK*[m_ThreadCount];
+        if (!m_Tasks)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate array for capture tasks", L"Error", E_OUTOFMEMORY);
+        }
+        RtlZeroMemory(m_Tasks, m_ThreadCount * sizeof(CAPTURETASK*));
+    }
+    m_ExpectedErrorEvent = ExpectedErrorEvent;
+
+    DUPL_RETURN Ret = m_Pointer.Init();
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    // One arena per thread, existing ones keep their capacity from the previous run
+    if (m_ThreadCount > m_ArenaCount)
+    {
+        CAPTUREARENA** Arenas = new (std::nothrow) CAPTUREARENA*[m_ThreadCount];
+        if (!Arenas)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate array for capture arenas", L"Error", E_OUTOFMEMORY);
+        }
+        RtlZeroMemory(Arenas, m_ThreadCount * sizeof(CAPTUREARENA*));
+        for (UINT i = 0; i < m_ArenaCount; ++i)
+        {
+            Arenas[i] = m_Arenas[i];
+        }
+        if (m_Arenas)
+        {
+            delete [] m_Arenas;
+        }
+        m_Arenas = Arenas;
+        m_ArenaCount = m_ThreadCount;
+    }
+    for (UINT i = 0; i < m_ThreadCount; ++i)
+    {
+        if (!m_Arenas[i])
+        {
+            m_Arenas[i] = new (std::nothrow) CAPTUREARENA;
+            if (!m_Arenas[i])
+            {
+                return ProcessFailure(nullptr, L"Failed to allocate capture arena", L"Error", E_OUTOFMEMORY);
+            }
+        }
+    }
+
+    // Statistics keep counting across reinitialization the same way
+    if (m_ThreadCount > m_StatsCount)
+    {
+        CAPTURESTATS** Stats = new (std::nothrow) CAPTURESTATS*[m_ThreadCount];
+        if (!Stats)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate array for capture statistics", L"Error", E_OUTOFMEMORY);
+        }
+        RtlZeroMemory(Stats, m_ThreadCount * sizeof(CAPTURESTATS*));
+        for (UINT i = 0; i < m_StatsCount; ++i)
+        {
+            Stats[i] = m_Stats[i];
+        }
+        if (m_Stats)
+        {
+            delete [] m_Stats;
+        }
+        m_Stats = Stats;
+        m_StatsCount = m_ThreadCount;
+    }
+    for (UINT i = 0; i < m_ThreadCount; ++i)
+    {
+        if (!m_Stats[i])
+        {
+            m_Stats[i] = new (std::nothrow) CAPTURESTATS;
+            if (!m_Stats[i])
+            {
+                return ProcessFailure(nullptr, L"Failed to allocate capture statistics", L"Error", E_OUTOFMEMORY);
+            }
+        }
+    }
 
     // Create appropriate # of threads for duplication
-    DUPL_RETURN Ret = DUPL_RETURN_SUCCESS;
     for (UINT i = 0; i < m_ThreadCount; ++i)
     {
         m_ThreadData[i].UnexpectedErrorEvent = UnexpectedErrorEvent;
         m_ThreadData[i].ExpectedErrorEvent = ExpectedErrorEvent;
         m_ThreadData[i].TerminateThreadsEvent = TerminateThreadsEvent;
         m_ThreadData[i].Output = (SingleOutput < 0) ? i : SingleOutput;
-        m_ThreadData[i].TexSharedHandle = SharedHandle;
+        m_ThreadData[i].TexSharedHandle = Targets[i].SharedHandle;
         m_ThreadData[i].OffsetX = DesktopDim->left;
         m_ThreadData[i].OffsetY = DesktopDim->top;
-        m_ThreadData[i].PtrInfo = &m_PtrInfo;
+        m_ThreadData[i].SurfaceX = Targets[i].SurfaceX;
+        m_ThreadData[i].SurfaceY = Targets[i].SurfaceY;
+        m_ThreadData[i].Mailbox = Targets[i].Mailbox;
+        for (UINT Slot = 0; Slot < MAILBOX_SLOTS; ++Slot)
+        {
+            m_ThreadData[i].SlotHandles[Slot] = Targets[i].SlotHandles[Slot];
+        }
+        m_ThreadData[i].Pointer = &m_Pointer;
+        m_ThreadData[i].Arena = m_Arenas[i];
+        m_ThreadData[i].TileMap = TileMap;
+        m_ThreadData[i].Stats = m_Stats[i];
+        m_ThreadData[i].BandPool = &m_BandPool;
+        m_ThreadData[i].CaptureFps = 0.0f;
+
+        // Each output plays back and records its own trace when more than one is being duplicated
+        m_ThreadData[i].Capture = *Capture;
+        if (Capture->ReplayPath[0] && m_ThreadCount > 1)
+        {
+            sprintf_s(m_ThreadData[i].Capture.ReplayPath, MAX_PATH, "%s.%u", Capture->ReplayPath, m_ThreadData[i].Output);
+        }
+        if (Capture->RecordPath[0] && m_ThreadCount > 1)
+        {
+            sprintf_s(m_ThreadData[i].Capture.RecordPath, MAX_PATH, "%s.%u", Capture->RecordPath, m_ThreadData[i].Output);
+        }
 
         RtlZeroMemory(&m_ThreadData[i].DxRes, sizeof(DX_RESOURCES));
         Ret = InitializeDx(&m_ThreadData[i].DxRes);
@@ -134,6 +275,30 @@ DUPL_RETURN THREADMANAGER::Initialize(INT SingleOutput, UINT OutputCount, HANDLE
             return Ret;
         }
 
+        // A software device composes on the CPU, start the band threads before the first output that needs them
+        if (m_ThreadData[i].DxRes.DriverType != D3D_DRIVER_TYPE_HARDWARE)
+        {
+            m_ThreadData[i].Capture.CpuCompose = true;
+        }
+        if (m_ThreadData[i].Capture.CpuCompose && !m_BandPool.GetThreadCount())
+        {
+            UINT Cores = std::thread::hardware_concurrency();
+            if (Cores > 1 && !m_BandPool.Start(Cores - 1))
+            {
+                return ProcessFailure(nullptr, L"Failed to start CPU composition threads", L"Error", E_FAIL);
+            }
+        }
+
+        if (m_Tasks)
+        {
+            m_Tasks[i] = new (std::nothrow) CAPTURETASK(&m_ThreadData[i]);
+            if (!m_Tasks[i] || !m_Scheduler.AddTask(RunCaptureTask, m_Tasks[i]))
+            {
+                return ProcessFailure(nullptr, L"Failed to create capture task", L"Error", E_OUTOFMEMORY);
+            }
+            continue;
+        }
+
         DWORD ThreadId;
         m_ThreadHandles[i] = CreateThread(nullptr, 0, DDProc, &m_ThreadData[i], 0, &ThreadId);
         if (m_ThreadHandles[i] == nullptr)
@@ -142,9 +307,35 @@ DUPL_RETURN THREADMANAGER::Initialize(INT SingleOutput, UINT OutputCount, HANDLE
         }
     }
 
+    if (m_Tasks && !m_Scheduler.Start(WorkerCount, InitWorker, this))
+    {
+        return ProcessFailure(nullptr, L"Failed to start capture workers", L"Error", E_FAIL);
+    }
+
     return Ret;
 }
 
+//
+// Runs once on every worker before it runs any capture task
+//
+void THREADMANAGER::InitWorker(_In_ void* Context)
+{
+    THREADMANAGER* Manager = reinterpret_cast<THREADMANAGER*>(Context);
+    if (CAPTURETASK::AttachInputDesktop() != DUPL_RETURN_SUCCESS)
+    {
+        // We do not have access to the desktop so request a retry
+        SetEvent(Manager->m_ExpectedErrorEvent);
+    }
+}
+
+//
+// Scheduler entry point of a capture task
+//
+TASK_RESULT THREADMANAGER::RunCaptureTask(_In_ void* Context, _Inout_ unsigned* IdlePollMs)
+{
+    return reinterpret_cast<CAPTURETASK*>(Context)->Run(IdlePollMs);
+}
+
 //
 // Get DX_RESOURCES
 //
@@ -181,6 +372,7 @@ DUPL_RETURN THREADMANAGER::InitializeDx(_Out_ DX_RESOURCES* Data)
         if (SUCCEEDED(hr))
         {
             // Device creation success, no need to loop anymore
+            Data->DriverType = DriverTypes[DriverTypeIndex];
             break;
         }
     }
@@ -239,20 +431,70 @@ DUPL_RETURN THREADMANAGER::InitializeDx(_Out_ DX_RESOURCES* Data)
 }
 
 //
-// Getter for the PTR_INFO structure
+// Getter for the pointer state the capture threads publish to
 //
-PTR_INFO* THREADMANAGER::GetPointerInfo()
+POINTERSTATE* THREADMANAGER::GetPointerState()
 {
-    return &m_PtrInfo;
+    return &m_Pointer;
 }
 
 //
-// Waits infinitely for all spawned threads to terminate
+// Returns the measured capture rate of an output, 0 if it is not being duplicated or has no frames yet
+//
+FLOAT THREADMANAGER::GetCaptureFps(UINT Output)
+{
+    for (UINT i = 0; i < m_ThreadCount; ++i)
+    {
+        if (m_ThreadData[i].Output == Output)
+        {
+            return m_ThreadData[i].CaptureFps;
+        }
+    }
+
+    return 0.0f;
+}
+
+//
+// Waits infinitely for all spawned threads or capture tasks to terminate
 //
 void THREADMANAGER::WaitForThreadTermination()
 {
-    if (m_ThreadCount != 0)
+    if (m_Tasks)
+    {
+        m_Scheduler.WaitForTasks();
+
+        SCHEDULER_STATS Stats;
+        m_Scheduler.GetStats(&Stats);
+        m_Scheduler.Stop();
+        if (Stats.Runs)
+        {
+            WCHAR StatsMsg[256];
+            swprintf_s(StatsMsg, 256, L"Capture workers: %llu runs, %llu idle, %llu stolen, %llu sleeps\n",
+                       Stats.Runs, Stats.IdleRuns, Stats.Steals, Stats.Sleeps);
+            OutputDebugStringW(StatsMsg);
+        }
+    }
+    else if (m_ThreadCount != 0)
     {
         WaitForMultipleObjectsEx(m_ThreadCount, m_ThreadHandles, TRUE, INFINITE, FALSE);
     }
 }
+
+//
+// Writes a snapshot of every running output's capture statistics
+//
+DUPL_RETURN THREADMANAGER::ExportStats(_In_ STATSEXPORTER* Exporter)
+{
+    for (UINT i = 0; i < m_ThreadCount; ++i)
+    {
+        CAPTURE_STATS Stats;
+        m_ThreadData[i].Stats->Snapshot(&Stats);
+        DUPL_RETURN Ret = Exporter->Write(m_ThreadData[i].Output, &Stats);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
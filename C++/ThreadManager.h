@@ -8,7 +8,12 @@
 #ifndef _THREADMANAGER_H_
 #define _THREADMANAGER_H_
 
-#include "CommonTypes.h"
+#include "CaptureArena.h"
+#include "CaptureStats.h"
+#include "CaptureTask.h"
+#include "CpuCompositor.h"
+#include "PointerState.h"
+#include "TaskScheduler.h"
 
 class THREADMANAGER
 {
@@ -16,18 +21,34 @@ class THREADMANAGER
         THREADMANAGER();
         ~THREADMANAGER();
         void Clean();
-        DUPL_RETURN Initialize(INT SingleOutput, UINT OutputCount, HANDLE UnexpectedErrorEvent, HANDLE ExpectedErrorEvent, HANDLE TerminateThreadsEvent, HANDLE SharedHandle, _In_ RECT* DesktopDim);
-        PTR_INFO* GetPointerInfo();
+        DUPL_RETURN Initialize(INT SingleOutput, UINT OutputCount, HANDLE UnexpectedErrorEvent, HANDLE ExpectedErrorEvent, HANDLE TerminateThreadsEvent, _In_reads_(OutputCount) SURFACE_TARGET* Targets, _In_ TILEMAP* TileMap, _In_ RECT* DesktopDim, _In_ CAPTURE_OPTIONS* Capture);
+        POINTERSTATE* GetPointerState();
+        FLOAT GetCaptureFps(UINT Output);
+        DUPL_RETURN ExportStats(_In_ STATSEXPORTER* Exporter);
         void WaitForThreadTermination();
 
     private:
         DUPL_RETURN InitializeDx(_Out_ DX_RESOURCES* Data);
         void CleanDx(_Inout_ DX_RESOURCES* Data);
+        static void InitWorker(_In_ void* Context);
+        static TASK_RESULT RunCaptureTask(_In_ void* Context, _Inout_ unsigned* IdlePollMs);
 
-        PTR_INFO m_PtrInfo;
+        POINTERSTATE m_Pointer;
         UINT m_ThreadCount;
+        UINT m_ArenaCount;
+        _Field_size_(m_ArenaCount) CAPTUREARENA** m_Arenas;
+        UINT m_StatsCount;
+        _Field_size_(m_StatsCount) CAPTURESTATS** m_Stats;
         _Field_size_(m_ThreadCount) HANDLE* m_ThreadHandles;
         _Field_size_(m_ThreadCount) THREAD_DATA* m_ThreadData;
+
+        // Only used when outputs are captured as tasks on shared workers, the thread handles stay null then
+        TASKSCHEDULER m_Scheduler;
+        _Field_size_(m_ThreadCount) CAPTURETASK** m_Tasks;
+        HANDLE m_ExpectedErrorEvent;
+
+        // Started by the first output that composes on the CPU
+        BANDPOOL m_BandPool;
 };
 
 #endif
@@ -0,0 +1,303 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <limits.h>
+
+#include "TileMap.h"
+
+//
+// Whether Generation is Since or newer, correct across wraparound as long as the two are within 2^31 of each other
+//
+static bool IsAtOrAfter(LONG Generation, LONG Since)
+{
+    return static_cast<LONG>(static_cast<ULONG>(Generation) - static_cast<ULONG>(Since)) >= 0;
+}
+
+TILEMAP::TILEMAP() : m_Width(0),
+                     m_Height(0),
+                     m_TilesX(0),
+                     m_TilesY(0),
+                     m_Tiles(nullptr),
+                     m_Generation(0)
+{
+}
+
+TILEMAP::~TILEMAP()
+{
+    if (m_Tiles)
+    {
+        delete [] m_Tiles;
+        m_Tiles = nullptr;
+    }
+}
+
+//
+// Sizes the map for a Width by Height surface and marks every tile changed.
+// Must not run while capture threads are stamping, the generation counter carries over so
+// generations readers already hold stay meaningful.
+//
+DUPL_RETURN TILEMAP::Init(UINT Width, UINT Height)
+{
+    // The surface was just created so its contents are new everywhere
+    LONG Generation = NextGeneration();
+
+    if (m_Tiles && Width == m_Width && Height == m_Height)
+    {
+        MarkAll(Generation);
+    }
+    else
+    {
+        if (m_Tiles)
+        {
+            delete [] m_Tiles;
+            m_Tiles = nullptr;
+        }
+        m_Width = 0;
+        m_Height = 0;
+        m_TilesX = 0;
+        m_TilesY = 0;
+
+        UINT TilesX = (Width + TILE_SIZE - 1) >> TILE_SHIFT;
+        UINT TilesY = (Height + TILE_SIZE - 1) >> TILE_SHIFT;
+
+        m_Tiles = new (std::nothrow) LONG[TilesX * TilesY];
+        if (!m_Tiles)
+        {
+            return ProcessFailure(nullptr, L"Failed to allocate dirty tile map", L"Error", E_OUTOFMEMORY);
+        }
+
+        m_Width = Width;
+        m_Height = Height;
+        m_TilesX = TilesX;
+        m_TilesY = TilesY;
+
+        // Fresh memory can't be stamped since Stamp never moves a tile back
+        for (UINT i = 0; i < TilesX * TilesY; ++i)
+        {
+            m_Tiles[i] = Generation;
+        }
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Hands out the generation for one update of the surface
+//
+LONG TILEMAP::NextGeneration()
+{
+    return InterlockedIncrement(&m_Generation);
+}
+
+//
+// Newest generation handed out so far, pass it to the queries later to see what changed after now
+//
+LONG TILEMAP::GetGeneration()
+{
+    return m_Generation;
+}
+
+//
+// Moves one tile forward to Generation, a slower writer with an older generation never moves it back
+//
+void TILEMAP::Stamp(UINT Index, LONG Generation)
+{
+    LONG Old = m_Tiles[Index];
+    while (!IsAtOrAfter(Old, Generation))
+    {
+        LONG Seen = InterlockedCompareExchange(&m_Tiles[Index], Generation, Old);
+        if (Seen == Old)
+        {
+            break;
+        }
+        Old = Seen;
+    }
+}
+
+//
+// Converts Rect into the range of tiles it touches, false if it lies outside the surface
+//
+bool TILEMAP::ClipToTiles(_In_ const RECT* Rect, _Out_ RECT* Tiles)
+{
+    LONG Left = max(Rect->left, 0L);
+    LONG Top = max(Rect->top, 0L);
+    LONG Right = min(Rect->right, static_cast<LONG>(m_Width));
+    LONG Bottom = min(Rect->bottom, static_cast<LONG>(m_Height));
+    if (Left >= Right || Top >= Bottom)
+    {
+        RtlZeroMemory(Tiles, sizeof(RECT));
+        return false;
+    }
+
+    Tiles->left = Left >> TILE_SHIFT;
+    Tiles->top = Top >> TILE_SHIFT;
+    Tiles->right = ((Right - 1) >> TILE_SHIFT) + 1;
+    Tiles->bottom = ((Bottom - 1) >> TILE_SHIFT) + 1;
+    return true;
+}
+
+//
+// Stamps every tile the rects touch, rects are moved by OffsetX and OffsetY into surface coordinates first
+//
+void TILEMAP::MarkRects(_In_reads_(Count) const RECT* Rects, UINT Count, INT OffsetX, INT OffsetY, LONG Generation)
+{
+    if (!m_Tiles)
+    {
+        return;
+    }
+
+    for (UINT i = 0; i < Count; ++i)
+    {
+        RECT Rect = Rects[i];
+        OffsetRect(&Rect, OffsetX, OffsetY);
+
+        RECT Tiles;
+        if (!ClipToTiles(&Rect, &Tiles))
+        {
+            continue;
+        }
+
+        for (LONG y = Tiles.top; y < Tiles.bottom; ++y)
+        {
+            for (LONG x = Tiles.left; x < Tiles.right; ++x)
+            {
+                Stamp((y * m_TilesX) + x, Generation);
+            }
+        }
+    }
+}
+
+//
+// Stamps the whole surface
+//
+void TILEMAP::MarkAll(LONG Generation)
+{
+    UINT TileCount = m_TilesX * m_TilesY;
+    for (UINT i = 0; i < TileCount; ++i)
+    {
+        Stamp(i, Generation);
+    }
+}
+
+//
+// Whether a tile was stamped with Since or later
+//
+bool TILEMAP::IsTileChanged(UINT TileX, UINT TileY, LONG Since)
+{
+    if (TileX >= m_TilesX || TileY >= m_TilesY)
+    {
+        return false;
+    }
+
+    return IsAtOrAfter(m_Tiles[(TileY * m_TilesX) + TileX], Since);
+}
+
+//
+// Sets Bounds to the part of Rect, in surface coordinates, covered by tiles stamped with Since or later.
+// Returns false when none were.
+//
+bool TILEMAP::GetChangedBounds(_In_ const RECT* Rect, LONG Since, _Out_ RECT* Bounds)
+{
+    RtlZeroMemory(Bounds, sizeof(RECT));
+
+    RECT Tiles;
+    if (!m_Tiles || !ClipToTiles(Rect, &Tiles))
+    {
+        return false;
+    }
+
+    RECT Changed = { LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN };
+    for (LONG y = Tiles.top; y < Tiles.bottom; ++y)
+    {
+        for (LONG x = Tiles.left; x < Tiles.right; ++x)
+        {
+            if (IsAtOrAfter(m_Tiles[(y * m_TilesX) + x], Since))
+            {
+                Changed.left = min(Changed.left, x);
+                Changed.top = min(Changed.top, y);
+                Changed.right = max(Changed.right, x + 1);
+                Changed.bottom = max(Changed.bottom, y + 1);
+            }
+        }
+    }
+
+    if (Changed.left >= Changed.right)
+    {
+        return false;
+    }
+
+    Bounds->left = max(Changed.left << TILE_SHIFT, Rect->left);
+    Bounds->top = max(Changed.top << TILE_SHIFT, Rect->top);
+    Bounds->right = min(Changed.right << TILE_SHIFT, Rect->right);
+    Bounds->bottom = min(Changed.bottom << TILE_SHIFT, Rect->bottom);
+    return true;
+}
+
+//
+// Walks the runs of tiles stamped with Since or later along each row under Rect, in surface coordinates.
+// Start with *Cursor at 0, every call sets Run to the next run cut to Rect and returns false once there
+// are no more. The cursor is all the state so any number of threads can walk at once.
+//
+bool TILEMAP::NextChangedRun(_In_ const RECT* Rect, LONG Since, _Inout_ UINT* Cursor, _Out_ RECT* Run)
+{
+    RtlZeroMemory(Run, sizeof(RECT));
+
+    RECT Tiles;
+    if (!m_Tiles || !ClipToTiles(Rect, &Tiles))
+    {
+        return false;
+    }
+
+    UINT x = *Cursor % m_TilesX;
+    UINT y = *Cursor / m_TilesX;
+    if (y < static_cast<UINT>(Tiles.top))
+    {
+        y = Tiles.top;
+        x = Tiles.left;
+    }
+
+    for (; y < static_cast<UINT>(Tiles.bottom); ++y, x = Tiles.left)
+    {
+        volatile LONG* Row = m_Tiles + (y * m_TilesX);
+        x = max(x, static_cast<UINT>(Tiles.left));
+        while (x < static_cast<UINT>(Tiles.right) && !IsAtOrAfter(Row[x], Since))
+        {
+            ++x;
+        }
+        if (x == static_cast<UINT>(Tiles.right))
+        {
+            continue;
+        }
+
+        UINT Start = x;
+        while (x < static_cast<UINT>(Tiles.right) && IsAtOrAfter(Row[x], Since))
+        {
+            ++x;
+        }
+
+        // The next call picks up after this run, on the next row once the run reaches the edge
+        *Cursor = (y * m_TilesX) + x;
+
+        Run->left = max(static_cast<LONG>(Start << TILE_SHIFT), Rect->left);
+        Run->top = max(static_cast<LONG>(y << TILE_SHIFT), Rect->top);
+        Run->right = min(static_cast<LONG>(x << TILE_SHIFT), min(Rect->right, static_cast<LONG>(m_Width)));
+        Run->bottom = min(static_cast<LONG>((y + 1) << TILE_SHIFT), min(Rect->bottom, static_cast<LONG>(m_Height)));
+        return true;
+    }
+
+    *Cursor = m_TilesX * m_TilesY;
+    return false;
+}
+
+//
+// Number of tile columns and rows
+//
+void TILEMAP::GetTileCounts(_Out_ UINT* TilesX, _Out_ UINT* TilesY)
+{
+    *TilesX = m_TilesX;
+    *TilesY = m_TilesY;
+}
@@ -0,0 +1,55 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TILEMAP_H_
+#define _TILEMAP_H_
+
+#include "CommonTypes.h"
+
+// Tiles are TILE_SIZE pixels square, TILE_SIZE is 1 << TILE_SHIFT
+#define TILE_SHIFT 6
+#define TILE_SIZE  (1 << TILE_SHIFT)
+
+//
+// Tracks which parts of the shared surface changed, one generation number per tile.
+// Capture threads take a new generation per frame and stamp the tiles their moves and dirty rects
+// land on. Readers take a generation with GetGeneration and later ask which tiles were stamped
+// with it or anything newer. Nothing here takes a lock, stamps only ever move a tile forward and
+// generations are compared with wraparound so the counter can run indefinitely.
+// Nothing is missed only per writer: a thread that takes its generation after stamping its own frames sees
+// every tile it stamps later, one extra time at worst. With several writers the generations of a slower one
+// can be overtaken, so a reader only asks about tiles that the writer it took its generation on stamps.
+//
+class TILEMAP
+{
+    public:
+        TILEMAP();
+        ~TILEMAP();
+        DUPL_RETURN Init(UINT Width, UINT Height);
+        LONG NextGeneration();
+        LONG GetGeneration();
+        void MarkRects(_In_reads_(Count) const RECT* Rects, UINT Count, INT OffsetX, INT OffsetY, LONG Generation);
+        void MarkAll(LONG Generation);
+        bool IsTileChanged(UINT TileX, UINT TileY, LONG Since);
+        bool GetChangedBounds(_In_ const RECT* Rect, LONG Since, _Out_ RECT* Bounds);
+        bool NextChangedRun(_In_ const RECT* Rect, LONG Since, _Inout_ UINT* Cursor, _Out_ RECT* Run);
+        void GetTileCounts(_Out_ UINT* TilesX, _Out_ UINT* TilesY);
+
+    private:
+        void Stamp(UINT Index, LONG Generation);
+        bool ClipToTiles(_In_ const RECT* Rect, _Out_ RECT* Tiles);
+
+    // vars
+        UINT m_Width;
+        UINT m_Height;
+        UINT m_TilesX;
+        UINT m_TilesY;
+        _Field_size_(m_TilesX * m_TilesY) volatile LONG* m_Tiles;
+        volatile LONG m_Generation;
+};
+
+#endif
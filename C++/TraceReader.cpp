@@ -0,0 +1,289 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <limits.h>
+
+#include "TraceReader.h"
+
+//
+// Constructor sets up variables
+//
+TRACEREADER::TRACEREADER() : m_Trace(nullptr),
+                             m_Size(0),
+                             m_Header(nullptr),
+                             m_End(0),
+                             m_Cursor(0),
+                             m_RecordCount(0),
+                             m_LoopCount(0),
+                             m_LoopTicks(0),
+                             m_PlaybackTicks(0)
+{
+}
+
+//
+// Destructor, the trace belongs to the caller
+//
+TRACEREADER::~TRACEREADER()
+{
+}
+
+//
+// Checks the header and every record of the trace, and works out how far each loop moves the times on.
+// Fails if the header is not valid or there is not a single whole record.
+//
+bool TRACEREADER::Open(_In_reads_bytes_(Size) const BYTE* Trace, SIZE_T Size)
+{
+    m_Trace = Trace;
+    m_Size = Size;
+    m_Header = nullptr;
+    m_RecordCount = 0;
+    m_LoopCount = 0;
+    m_LoopTicks = 0;
+    m_PlaybackTicks = 0;
+
+    if (Size < sizeof(CAPTURE_TRACE_HEADER))
+    {
+        return false;
+    }
+
+    const CAPTURE_TRACE_HEADER* Header = reinterpret_cast<const CAPTURE_TRACE_HEADER*>(Trace);
+    if (Header->Magic != CAPTURE_TRACE_MAGIC || Header->Version != CAPTURE_TRACE_VERSION ||
+        Header->HeaderSize < sizeof(CAPTURE_TRACE_HEADER) || Header->HeaderSize > Size ||
+        Header->QPCFrequency.QuadPart <= 0 || Header->FrameWidth == 0 || Header->FrameHeight == 0)
+    {
+        return false;
+    }
+    m_Header = Header;
+
+    // Span of every time the trace carries, 0 means the time was not updated by that frame
+    LONGLONG FirstAcquire = 0;
+    LONGLONG LastAcquire = 0;
+    LONGLONG Earliest = LLONG_MAX;
+    LONGLONG Latest = LLONG_MIN;
+    SIZE_T Offset = Header->HeaderSize;
+    while (IsRecordValid(Offset))
+    {
+        const CAPTURE_TRACE_RECORD* Record = reinterpret_cast<const CAPTURE_TRACE_RECORD*>(Trace + Offset);
+        LONGLONG Times[3] = {Record->AcquireTime.QuadPart, Record->FrameInfo.LastPresentTime.QuadPart, Record->FrameInfo.LastMouseUpdateTime.QuadPart};
+        for (UINT i = 0; i < ARRAYSIZE(Times); ++i)
+        {
+            if (Times[i])
+            {
+                Earliest = min(Earliest, Times[i]);
+                Latest = max(Latest, Times[i]);
+            }
+        }
+
+        if (!m_RecordCount)
+        {
+            FirstAcquire = Record->AcquireTime.QuadPart;
+        }
+        LastAcquire = Record->AcquireTime.QuadPart;
+        ++m_RecordCount;
+        Offset += Record->RecordSize;
+    }
+    m_End = Offset;
+    m_Cursor = Header->HeaderSize;
+
+    if (!m_RecordCount)
+    {
+        return false;
+    }
+
+    // The next loop starts one average frame interval after the last frame, a single frame repeats at 60Hz
+    LONGLONG Interval = (m_RecordCount > 1) ? (LastAcquire - FirstAcquire) / (m_RecordCount - 1) : 0;
+    if (Interval <= 0)
+    {
+        Interval = max(Header->QPCFrequency.QuadPart / 60, 1LL);
+    }
+    m_PlaybackTicks = max(LastAcquire - FirstAcquire, 0LL) + Interval;
+    m_LoopTicks = (Latest >= Earliest) ? max(Latest - Earliest + Interval, m_PlaybackTicks) : m_PlaybackTicks;
+
+    return true;
+}
+
+//
+// Checks that the record at Offset and all of its payloads lie inside the trace
+//
+bool TRACEREADER::IsRecordValid(SIZE_T Offset)
+{
+    if (Offset >= m_Size || m_Size - Offset < sizeof(CAPTURE_TRACE_RECORD))
+    {
+        return false;
+    }
+
+    const CAPTURE_TRACE_RECORD* Record = reinterpret_cast<const CAPTURE_TRACE_RECORD*>(m_Trace + Offset);
+    if (Record->RecordSize < sizeof(CAPTURE_TRACE_RECORD) || Record->RecordSize > m_Size - Offset)
+    {
+        return false;
+    }
+
+    ULONGLONG PayloadSize = (static_cast<ULONGLONG>(Record->MoveCount) * sizeof(DXGI_OUTDUPL_MOVE_RECT)) +
+                            (static_cast<ULONGLONG>(Record->DirtyCount) * sizeof(RECT)) +
+                            Record->ShapeSize + Record->PixelBytes;
+
+    return PayloadSize <= Record->RecordSize - sizeof(CAPTURE_TRACE_RECORD);
+}
+
+//
+// Header of the opened trace
+//
+const CAPTURE_TRACE_HEADER* TRACEREADER::GetHeader()
+{
+    return m_Header;
+}
+
+//
+// Recorded time moved on by the loops played so far, a time that was not updated stays 0
+//
+LONGLONG TRACEREADER::Rebase(LONGLONG Time)
+{
+    return Time ? Time + (m_LoopCount * m_LoopTicks) : 0;
+}
+
+//
+// Current record, looping back to the first one at the end of the trace. Asking again before DoneWithFrame gives the same record.
+//
+void TRACEREADER::GetFrame(_Out_ TRACE_FRAME* Frame)
+{
+    if (m_Cursor >= m_End)
+    {
+        m_Cursor = m_Header->HeaderSize;
+        ++m_LoopCount;
+    }
+
+    const CAPTURE_TRACE_RECORD* Record = reinterpret_cast<const CAPTURE_TRACE_RECORD*>(m_Trace + m_Cursor);
+    Frame->Record = Record;
+    Frame->PlaybackTime = Record->AcquireTime.QuadPart + (m_LoopCount * m_PlaybackTicks);
+    Frame->AcquireTime.QuadPart = Rebase(Record->AcquireTime.QuadPart);
+    Frame->FrameInfo = Record->FrameInfo;
+    Frame->FrameInfo.LastPresentTime.QuadPart = Rebase(Record->FrameInfo.LastPresentTime.QuadPart);
+    Frame->FrameInfo.LastMouseUpdateTime.QuadPart = Rebase(Record->FrameInfo.LastMouseUpdateTime.QuadPart);
+
+    // Payloads follow the record in the order the trace lays them out
+    Frame->MoveRects = reinterpret_cast<const DXGI_OUTDUPL_MOVE_RECT*>(Record + 1);
+    Frame->DirtyRects = reinterpret_cast<const RECT*>(Frame->MoveRects + Record->MoveCount);
+    Frame->Shape = reinterpret_cast<const BYTE*>(Frame->DirtyRects + Record->DirtyCount);
+    Frame->Pixels = Frame->Shape + Record->ShapeSize;
+}
+
+//
+// Moves on to the next record
+//
+void TRACEREADER::DoneWithFrame()
+{
+    if (m_Cursor < m_End)
+    {
+        m_Cursor += reinterpret_cast<const CAPTURE_TRACE_RECORD*>(m_Trace + m_Cursor)->RecordSize;
+    }
+}
+
+//
+// Next dirty rect of Frame that carries pixels and where they are, tightly packed rows of BPP bytes.
+// Returns false once the rects or the pixel payload run out.
+//
+bool TRACEREADER::NextDirtyPixels(_In_ const TRACE_FRAME* Frame, _Inout_ TRACE_PIXEL_CURSOR* Cursor, _Out_ RECT* Rect, _Outptr_ const BYTE** Pixels)
+{
+    const CAPTURE_TRACE_RECORD* Record = Frame->Record;
+    while (Cursor->Rect < Record->DirtyCount)
+    {
+        const RECT* Dirty = &Frame->DirtyRects[Cursor->Rect++];
+        if (!IsTraceRectInFrame(Dirty, m_Header->FrameWidth, m_Header->FrameHeight))
+        {
+            continue;
+        }
+
+        UINT Size = (Dirty->right - Dirty->left) * (Dirty->bottom - Dirty->top) * BPP;
+        if (Size > Record->PixelBytes - Cursor->Offset)
+        {
+            Cursor->Rect = Record->DirtyCount;
+            break;
+        }
+
+        *Rect = *Dirty;
+        *Pixels = Frame->Pixels + Cursor->Offset;
+        Cursor->Offset += Size;
+        return true;
+    }
+
+    return false;
+}
+
+//
+// Number of whole records in the trace
+//
+UINT TRACEREADER::GetRecordCount()
+{
+    return m_RecordCount;
+}
+
+//
+// Number of times playback has wrapped around to the start of the trace
+//
+UINT TRACEREADER::GetLoopCount()
+{
+    return m_LoopCount;
+}
+
+//
+// How far each loop moves the replayed times on, in trace QPC ticks
+//
+LONGLONG TRACEREADER::GetLoopTicks()
+{
+    return m_LoopTicks;
+}
+
+//
+// Constructor sets up variables
+//
+TRACEPACER::TRACEPACER() : m_TraceFrequency(1),
+                           m_ClockFrequency(1),
+                           m_Speed(1.0f),
+                           m_Started(false),
+                           m_TraceStart(0),
+                           m_PlaybackStart(0)
+{
+}
+
+//
+// Destructor
+//
+TRACEPACER::~TRACEPACER()
+{
+}
+
+//
+// Takes the tick rates of the trace and of the local clock, the next frame asked about anchors playback again
+//
+void TRACEPACER::Init(LONGLONG TraceFrequency, LONGLONG ClockFrequency, FLOAT Speed)
+{
+    m_TraceFrequency = TraceFrequency;
+    m_ClockFrequency = ClockFrequency;
+    m_Speed = Speed;
+    m_Started = false;
+}
+
+//
+// Local clock time the frame recorded at TraceTime is due, Now is the local clock
+//
+LONGLONG TRACEPACER::GetDue(LONGLONG TraceTime, LONGLONG Now)
+{
+    if (!m_Started)
+    {
+        m_Started = true;
+        m_TraceStart = TraceTime;
+        m_PlaybackStart = Now;
+    }
+
+    if (m_Speed <= 0.0f)
+    {
+        return Now;
+    }
+
+    double Offset = static_cast<double>(TraceTime - m_TraceStart) / static_cast<double>(m_TraceFrequency) / m_Speed;
+    return m_PlaybackStart + static_cast<LONGLONG>(Offset * static_cast<double>(m_ClockFrequency));
+}
@@ -0,0 +1,103 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TRACEREADER_H_
+#define _TRACEREADER_H_
+
+#include "CaptureTrace.h"
+
+//
+// One record of a capture trace as TRACEREADER hands it out. The payload pointers point into the trace,
+// the times are the recorded ones moved on by the loops played so far. PlaybackTime is the trace time
+// the frame is due at, where every loop follows the previous one a frame interval after its last frame.
+//
+typedef struct _TRACE_FRAME
+{
+    const CAPTURE_TRACE_RECORD* Record;
+    LONGLONG PlaybackTime;
+    LARGE_INTEGER AcquireTime;
+    DXGI_OUTDUPL_FRAME_INFO FrameInfo;
+    const DXGI_OUTDUPL_MOVE_RECT* MoveRects;
+    const RECT* DirtyRects;
+    const BYTE* Shape;
+    const BYTE* Pixels;
+} TRACE_FRAME;
+
+//
+// Where TRACEREADER::NextDirtyPixels is in the dirty rects of a frame, start it zeroed
+//
+typedef struct _TRACE_PIXEL_CURSOR
+{
+    UINT Rect;
+    UINT Offset;
+} TRACE_PIXEL_CURSOR;
+
+//
+// Walks a capture trace held in memory, the trace is validated up front so the records handed out can be used in place.
+// Playback loops at the end of the trace, a truncated last record ends it too. Every loop moves the replayed times on by
+// the span of all times in the trace so they keep going forward, timestamps going backwards would be dropped by
+// POINTERPREDICTOR. That span can start long before the first frame with a stale pointer update, so the loops are
+// paced on the span of the frames alone.
+// Only needs the trace layout so it can be exercised away from Windows, REPLAYMANAGER maps the file and uploads the pixels.
+//
+class TRACEREADER
+{
+    public:
+        TRACEREADER();
+        ~TRACEREADER();
+        bool Open(_In_reads_bytes_(Size) const BYTE* Trace, SIZE_T Size);
+        const CAPTURE_TRACE_HEADER* GetHeader();
+        void GetFrame(_Out_ TRACE_FRAME* Frame);
+        void DoneWithFrame();
+        bool NextDirtyPixels(_In_ const TRACE_FRAME* Frame, _Inout_ TRACE_PIXEL_CURSOR* Cursor, _Out_ RECT* Rect, _Outptr_ const BYTE** Pixels);
+        UINT GetRecordCount();
+        UINT GetLoopCount();
+        LONGLONG GetLoopTicks();
+
+    private:
+        bool IsRecordValid(SIZE_T Offset);
+        LONGLONG Rebase(LONGLONG Time);
+
+    // vars
+        _Field_size_bytes_(m_Size) const BYTE* m_Trace;
+        SIZE_T m_Size;
+        const CAPTURE_TRACE_HEADER* m_Header;
+
+        // Offset just past the last valid record
+        SIZE_T m_End;
+        SIZE_T m_Cursor;
+        UINT m_RecordCount;
+        UINT m_LoopCount;
+
+        // How far each loop moves the times and the playback on, in trace QPC ticks
+        LONGLONG m_LoopTicks;
+        LONGLONG m_PlaybackTicks;
+};
+
+//
+// Works out when a replayed frame is due on the local clock from its trace time, scaled by the replay speed.
+// The first frame asked about anchors the trace to the clock. Times are taken and returned as numbers so the
+// caller owns the clock and the waiting, a speed of 0 or less makes every frame due at once.
+//
+class TRACEPACER
+{
+    public:
+        TRACEPACER();
+        ~TRACEPACER();
+        void Init(LONGLONG TraceFrequency, LONGLONG ClockFrequency, FLOAT Speed);
+        LONGLONG GetDue(LONGLONG TraceTime, LONGLONG Now);
+
+    private:
+        LONGLONG m_TraceFrequency;
+        LONGLONG m_ClockFrequency;
+        FLOAT m_Speed;
+        bool m_Started;
+        LONGLONG m_TraceStart;
+        LONGLONG m_PlaybackStart;
+};
+
+#endif
@@ -0,0 +1,243 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "TraceRecorder.h"
+
+//
+// Constructor sets up references / variables
+//
+TRACERECORDER::TRACERECORDER() : m_File(INVALID_HANDLE_VALUE),
+                                 m_RecordPixels(false),
+                                 m_HeaderWritten(false),
+                                 m_StagingFrame(nullptr),
+                                 m_Device(nullptr),
+                                 m_DeviceContext(nullptr)
+{
+    RtlZeroMemory(&m_Header, sizeof(m_Header));
+}
+
+//
+// Destructor closes the trace and releases references
+//
+TRACERECORDER::~TRACERECORDER()
+{
+    if (m_File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+
+    if (m_StagingFrame)
+    {
+        m_StagingFrame->Release();
+        m_StagingFrame = nullptr;
+    }
+
+    if (m_DeviceContext)
+    {
+        m_DeviceContext->Release();
+        m_DeviceContext = nullptr;
+    }
+
+    if (m_Device)
+    {
+        m_Device->Release();
+        m_Device = nullptr;
+    }
+}
+
+//
+// Open the trace file, the header is written with the first frame once the frame size is known
+//
+DUPL_RETURN TRACERECORDER::InitRecorder(_In_ ID3D11Device* Device, _In_ CAPTURE_OPTIONS* Options, UINT Output, _In_ DXGI_OUTPUT_DESC* DeskDesc)
+{
+    m_Device = Device;
+    m_Device->AddRef();
+    m_Device->GetImmediateContext(&m_DeviceContext);
+
+    m_RecordPixels = Options->RecordPixels;
+
+    LARGE_INTEGER QPCFrequency;
+    QueryPerformanceFrequency(&QPCFrequency);
+    TRACEWRITER::InitHeader(&m_Header, m_RecordPixels ? CAPTURE_TRACE_FLAG_PIXELS : 0, Output, &DeskDesc->DesktopCoordinates, DeskDesc->Rotation, QPCFrequency);
+
+    // After a system transition the same trace is continued rather than overwritten
+    m_File = CreateFileA(Options->RecordPath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, Options->RecordAppend ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        return ProcessFailure(nullptr, L"Failed to create capture trace in TRACERECORDER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Writes the trace header, or checks it against the one already in the file when continuing a trace
+//
+DUPL_RETURN TRACERECORDER::WriteHeader(_In_ ID3D11Texture2D* Frame)
+{
+    D3D11_TEXTURE2D_DESC FrameDesc;
+    Frame->GetDesc(&FrameDesc);
+    m_Header.FrameWidth = FrameDesc.Width;
+    m_Header.FrameHeight = FrameDesc.Height;
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(m_File, &FileSize))
+    {
+        return ProcessFailure(nullptr, L"Failed to get capture trace size in TRACERECORDER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    if (FileSize.QuadPart)
+    {
+        CAPTURE_TRACE_HEADER Existing;
+        DWORD Read = 0;
+        if (!ReadFile(m_File, &Existing, sizeof(Existing), &Read, nullptr) || Read != sizeof(Existing) ||
+            memcmp(&Existing, &m_Header, sizeof(CAPTURE_TRACE_HEADER)) != 0)
+        {
+            return ProcessFailure(nullptr, L"Desktop layout changed while recording, capture trace cannot be continued", L"Error", E_FAIL);
+        }
+
+        LARGE_INTEGER Zero = {0};
+        SetFilePointerEx(m_File, Zero, nullptr, FILE_END);
+    }
+    else
+    {
+        DWORD Written = 0;
+        if (!WriteFile(m_File, &m_Header, sizeof(m_Header), &Written, nullptr) || Written != sizeof(m_Header))
+        {
+            return ProcessFailure(nullptr, L"Failed to write capture trace header in TRACERECORDER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+        }
+    }
+
+    m_HeaderWritten = true;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Builds the record for the current frame, call after GetMouse while still holding the keyed mutex
+//
+DUPL_RETURN TRACERECORDER::RecordFrame(_In_ FRAME_DATA* Data, _In_ PTR_INFO* PtrInfo, LARGE_INTEGER AcquireTime)
+{
+    // The counts are stale when the frame carried no metadata
+    UINT MoveCount = Data->FrameInfo.TotalMetadataBufferSize ? Data->MoveCount : 0;
+    UINT DirtyCount = Data->FrameInfo.TotalMetadataBufferSize ? Data->DirtyCount : 0;
+
+    // Only a shape that GetMouse just fetched for this frame is recorded
+    UINT ShapeSize = Data->FrameInfo.PointerShapeBufferSize;
+    if (!PtrInfo->PtrShapeBuffer || ShapeSize > PtrInfo->BufferSize)
+    {
+        ShapeSize = 0;
+    }
+
+    return m_Writer.BeginRecord(&Data->FrameInfo, AcquireTime, MoveCount, DirtyCount, Data->MetaData, ShapeSize, &PtrInfo->ShapeInfo, PtrInfo->PtrShapeBuffer);
+}
+
+//
+// Reads back the dirty rects of the acquired frame and appends them to the record
+//
+DUPL_RETURN TRACERECORDER::AppendPixels(_In_ FRAME_DATA* Data)
+{
+    CAPTURE_TRACE_RECORD* Record = m_Writer.GetRecord();
+    UINT DirtyCount = Record->DirtyCount;
+    RECT* DirtyRects = reinterpret_cast<RECT*>(Data->MetaData + (Record->MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
+    if (!TRACEWRITER::GetPixelBytes(DirtyRects, DirtyCount, m_Header.FrameWidth, m_Header.FrameHeight))
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    HRESULT hr;
+    if (!m_StagingFrame)
+    {
+        D3D11_TEXTURE2D_DESC Desc;
+        Data->Frame->GetDesc(&Desc);
+        Desc.Usage = D3D11_USAGE_STAGING;
+        Desc.BindFlags = 0;
+        Desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        Desc.MiscFlags = 0;
+        hr = m_Device->CreateTexture2D(&Desc, nullptr, &m_StagingFrame);
+        if (FAILED(hr))
+        {
+            return ProcessFailure(m_Device, L"Failed to create staging texture for capture trace in TRACERECORDER", L"Error", hr, SystemTransitionsExpectedErrors);
+        }
+    }
+
+    // Only the dirty rects are copied across
+    for (UINT i = 0; i < DirtyCount; ++i)
+    {
+        if (IsTraceRectInFrame(&DirtyRects[i], m_Header.FrameWidth, m_Header.FrameHeight))
+        {
+            D3D11_BOX Box;
+            Box.left = DirtyRects[i].left;
+            Box.top = DirtyRects[i].top;
+            Box.front = 0;
+            Box.right = DirtyRects[i].right;
+            Box.bottom = DirtyRects[i].bottom;
+            Box.back = 1;
+            m_DeviceContext->CopySubresourceRegion(m_StagingFrame, 0, DirtyRects[i].left, DirtyRects[i].top, 0, Data->Frame, 0, &Box);
+        }
+    }
+
+    D3D11_MAPPED_SUBRESOURCE Mapped;
+    hr = m_DeviceContext->Map(m_StagingFrame, 0, D3D11_MAP_READ, 0, &Mapped);
+    if (FAILED(hr))
+    {
+        return ProcessFailure(m_Device, L"Failed to map staging texture for capture trace in TRACERECORDER", L"Error", hr, SystemTransitionsExpectedErrors);
+    }
+
+    DUPL_RETURN Ret = m_Writer.AppendPixels(DirtyRects, DirtyCount, m_Header.FrameWidth, m_Header.FrameHeight, reinterpret_cast<BYTE*>(Mapped.pData), Mapped.RowPitch);
+
+    m_DeviceContext->Unmap(m_StagingFrame, 0);
+
+    return Ret;
+}
+
+//
+// Adds the pixel payload if requested and appends the finished record to the trace, call before DoneWithFrame
+//
+DUPL_RETURN TRACERECORDER::Flush(_In_ FRAME_DATA* Data)
+{
+    if (!m_Writer.GetRecord())
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    DUPL_RETURN Ret;
+    if (!m_HeaderWritten)
+    {
+        Ret = WriteHeader(Data->Frame);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+
+    if (m_RecordPixels && m_Writer.GetRecord()->DirtyCount)
+    {
+        Ret = AppendPixels(Data);
+        if (Ret != DUPL_RETURN_SUCCESS)
+        {
+            return Ret;
+        }
+    }
+
+    const BYTE* Record;
+    UINT RecordSize;
+    Ret = m_Writer.EndRecord(&Record, &RecordSize);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    DWORD Written = 0;
+    if (!WriteFile(m_File, Record, RecordSize, &Written, nullptr) || Written != RecordSize)
+    {
+        return ProcessFailure(nullptr, L"Failed to write capture trace record in TRACERECORDER", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
@@ -0,0 +1,42 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TRACERECORDER_H_
+#define _TRACERECORDER_H_
+
+#include "TraceWriter.h"
+
+//
+// Appends acquired frames to a capture trace that REPLAYMANAGER can play back.
+// RecordFrame is cheap and runs while the keyed mutex is held so the pointer shape is consistent,
+// Flush does the optional pixel readback and the file write once the mutex has been released.
+//
+class TRACERECORDER
+{
+    public:
+        TRACERECORDER();
+        ~TRACERECORDER();
+        DUPL_RETURN InitRecorder(_In_ ID3D11Device* Device, _In_ CAPTURE_OPTIONS* Options, UINT Output, _In_ DXGI_OUTPUT_DESC* DeskDesc);
+        DUPL_RETURN RecordFrame(_In_ FRAME_DATA* Data, _In_ PTR_INFO* PtrInfo, LARGE_INTEGER AcquireTime);
+        DUPL_RETURN Flush(_In_ FRAME_DATA* Data);
+
+    private:
+        DUPL_RETURN WriteHeader(_In_ ID3D11Texture2D* Frame);
+        DUPL_RETURN AppendPixels(_In_ FRAME_DATA* Data);
+
+    // vars
+        HANDLE m_File;
+        bool m_RecordPixels;
+        bool m_HeaderWritten;
+        CAPTURE_TRACE_HEADER m_Header;
+        TRACEWRITER m_Writer;
+        ID3D11Texture2D* m_StagingFrame;
+        ID3D11Device* m_Device;
+        ID3D11DeviceContext* m_DeviceContext;
+};
+
+#endif
@@ -0,0 +1,201 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "TraceWriter.h"
+
+//
+// Constructor sets up variables
+//
+TRACEWRITER::TRACEWRITER() : m_Buffer(nullptr),
+                             m_BufferSize(0),
+                             m_Used(0)
+{
+}
+
+//
+// Destructor frees the record buffer
+//
+TRACEWRITER::~TRACEWRITER()
+{
+    if (m_Buffer)
+    {
+        delete [] m_Buffer;
+        m_Buffer = nullptr;
+    }
+}
+
+//
+// Fills in a trace header, the frame size is left for the caller once the first frame is known
+//
+void TRACEWRITER::InitHeader(_Out_ CAPTURE_TRACE_HEADER* Header, UINT Flags, UINT Output, _In_ const RECT* DesktopCoordinates, UINT Rotation, LARGE_INTEGER QPCFrequency)
+{
+    RtlZeroMemory(Header, sizeof(CAPTURE_TRACE_HEADER));
+    Header->Magic = CAPTURE_TRACE_MAGIC;
+    Header->Version = CAPTURE_TRACE_VERSION;
+    Header->HeaderSize = sizeof(CAPTURE_TRACE_HEADER);
+    Header->Flags = Flags;
+    Header->Output = Output;
+    Header->DesktopCoordinates = *DesktopCoordinates;
+    Header->Rotation = Rotation;
+    Header->QPCFrequency = QPCFrequency;
+}
+
+//
+// Size of the pixel payload for the dirty rects, rects outside the frame carry none
+//
+UINT TRACEWRITER::GetPixelBytes(_In_reads_(DirtyCount) const RECT* DirtyRects, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight)
+{
+    UINT PixelBytes = 0;
+    for (UINT i = 0; i < DirtyCount; ++i)
+    {
+        if (IsTraceRectInFrame(&DirtyRects[i], FrameWidth, FrameHeight))
+        {
+            PixelBytes += (DirtyRects[i].right - DirtyRects[i].left) * (DirtyRects[i].bottom - DirtyRects[i].top) * BPP;
+        }
+    }
+
+    return PixelBytes;
+}
+
+//
+// Makes sure the record buffer can hold Size bytes, keeping what has been built so far
+//
+DUPL_RETURN TRACEWRITER::Reserve(UINT Size)
+{
+    if (Size <= m_BufferSize)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    BYTE* NewBuffer = new (std::nothrow) BYTE[Size];
+    if (!NewBuffer)
+    {
+        return ProcessFailure(nullptr, L"Failed to allocate memory for capture trace record in TRACEWRITER", L"Error", E_OUTOFMEMORY);
+    }
+
+    if (m_Buffer)
+    {
+        memcpy_s(NewBuffer, Size, m_Buffer, m_Used);
+        delete [] m_Buffer;
+    }
+    m_Buffer = NewBuffer;
+    m_BufferSize = Size;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Starts a record for a frame. MetaData holds the move rects followed by the dirty rects like the
+// desktop duplication metadata buffer, the shape is left out when ShapeSize is 0.
+//
+DUPL_RETURN TRACEWRITER::BeginRecord(_In_ const DXGI_OUTDUPL_FRAME_INFO* FrameInfo, LARGE_INTEGER AcquireTime, UINT MoveCount, UINT DirtyCount, _In_opt_ const BYTE* MetaData,
+                                     UINT ShapeSize, _In_opt_ const DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_opt_(ShapeSize) const BYTE* Shape)
+{
+    UINT MetaDataBytes = (MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)) + (DirtyCount * sizeof(RECT));
+
+    m_Used = 0;
+    DUPL_RETURN Ret = Reserve(sizeof(CAPTURE_TRACE_RECORD) + MetaDataBytes + ShapeSize);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    CAPTURE_TRACE_RECORD* Record = reinterpret_cast<CAPTURE_TRACE_RECORD*>(m_Buffer);
+    RtlZeroMemory(Record, sizeof(CAPTURE_TRACE_RECORD));
+    Record->MoveCount = MoveCount;
+    Record->DirtyCount = DirtyCount;
+    Record->ShapeSize = ShapeSize;
+    Record->AcquireTime = AcquireTime;
+    Record->FrameInfo = *FrameInfo;
+    Record->FrameInfo.PointerShapeBufferSize = ShapeSize;
+    m_Used = sizeof(CAPTURE_TRACE_RECORD);
+
+    // Move rects followed by dirty rects, same layout as the metadata buffer
+    if (MetaDataBytes)
+    {
+        memcpy_s(m_Buffer + m_Used, m_BufferSize - m_Used, MetaData, MetaDataBytes);
+        m_Used += MetaDataBytes;
+    }
+
+    if (ShapeSize)
+    {
+        Record->ShapeInfo = *ShapeInfo;
+        memcpy_s(m_Buffer + m_Used, m_BufferSize - m_Used, Shape, ShapeSize);
+        m_Used += ShapeSize;
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Appends the pixels of the dirty rects that lie in the frame, read from Frame with Pitch bytes between rows
+//
+DUPL_RETURN TRACEWRITER::AppendPixels(_In_reads_(DirtyCount) const RECT* DirtyRects, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight, _In_ const BYTE* Frame, UINT Pitch)
+{
+    UINT PixelBytes = GetPixelBytes(DirtyRects, DirtyCount, FrameWidth, FrameHeight);
+    if (!PixelBytes)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    // Room for the padding too so ending the record does not grow the buffer again
+    DUPL_RETURN Ret = Reserve(m_Used + PixelBytes + CAPTURE_TRACE_ALIGN);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+
+    BYTE* Dest = m_Buffer + m_Used;
+    for (UINT i = 0; i < DirtyCount; ++i)
+    {
+        if (IsTraceRectInFrame(&DirtyRects[i], FrameWidth, FrameHeight))
+        {
+            UINT RowBytes = (DirtyRects[i].right - DirtyRects[i].left) * BPP;
+            const BYTE* Src = Frame + (DirtyRects[i].top * Pitch) + (DirtyRects[i].left * BPP);
+            for (LONG Row = DirtyRects[i].top; Row < DirtyRects[i].bottom; ++Row)
+            {
+                memcpy_s(Dest, RowBytes, Src, RowBytes);
+                Dest += RowBytes;
+                Src += Pitch;
+            }
+        }
+    }
+
+    reinterpret_cast<CAPTURE_TRACE_RECORD*>(m_Buffer)->PixelBytes = PixelBytes;
+    m_Used += PixelBytes;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Pads the record so the next one starts aligned and hands it out, it stays valid until the next BeginRecord
+//
+DUPL_RETURN TRACEWRITER::EndRecord(_Outptr_ const BYTE** Record, _Out_ UINT* RecordSize)
+{
+    UINT Size = (m_Used + CAPTURE_TRACE_ALIGN - 1) & ~(CAPTURE_TRACE_ALIGN - 1);
+    DUPL_RETURN Ret = Reserve(Size);
+    if (Ret != DUPL_RETURN_SUCCESS)
+    {
+        return Ret;
+    }
+    RtlZeroMemory(m_Buffer + m_Used, Size - m_Used);
+    reinterpret_cast<CAPTURE_TRACE_RECORD*>(m_Buffer)->RecordSize = Size;
+    m_Used = 0;
+
+    *Record = m_Buffer;
+    *RecordSize = Size;
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Record begun and not yet ended, nullptr if there is none
+//
+CAPTURE_TRACE_RECORD* TRACEWRITER::GetRecord()
+{
+    return m_Used ? reinterpret_cast<CAPTURE_TRACE_RECORD*>(m_Buffer) : nullptr;
+}
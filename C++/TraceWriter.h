@@ -0,0 +1,42 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TRACEWRITER_H_
+#define _TRACEWRITER_H_
+
+#include "CaptureTrace.h"
+
+//
+// Builds capture trace records in memory, one at a time. TRACERECORDER feeds it acquired frames and a readback of
+// their pixels and writes the finished records to the file.
+// Only needs the trace layout so it can be exercised away from Windows.
+//
+class TRACEWRITER
+{
+    public:
+        TRACEWRITER();
+        ~TRACEWRITER();
+        static void InitHeader(_Out_ CAPTURE_TRACE_HEADER* Header, UINT Flags, UINT Output, _In_ const RECT* DesktopCoordinates, UINT Rotation, LARGE_INTEGER QPCFrequency);
+        static UINT GetPixelBytes(_In_reads_(DirtyCount) const RECT* DirtyRects, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight);
+        DUPL_RETURN BeginRecord(_In_ const DXGI_OUTDUPL_FRAME_INFO* FrameInfo, LARGE_INTEGER AcquireTime, UINT MoveCount, UINT DirtyCount, _In_opt_ const BYTE* MetaData,
+                                UINT ShapeSize, _In_opt_ const DXGI_OUTDUPL_POINTER_SHAPE_INFO* ShapeInfo, _In_reads_bytes_opt_(ShapeSize) const BYTE* Shape);
+        DUPL_RETURN AppendPixels(_In_reads_(DirtyCount) const RECT* DirtyRects, UINT DirtyCount, UINT FrameWidth, UINT FrameHeight, _In_ const BYTE* Frame, UINT Pitch);
+        DUPL_RETURN EndRecord(_Outptr_ const BYTE** Record, _Out_ UINT* RecordSize);
+        CAPTURE_TRACE_RECORD* GetRecord();
+
+    private:
+        DUPL_RETURN Reserve(UINT Size);
+
+    // vars
+        _Field_size_bytes_(m_BufferSize) BYTE* m_Buffer;
+        UINT m_BufferSize;
+
+        // Bytes of the record begun so far, 0 when there is none
+        UINT m_Used;
+};
+
+#endif
@@ -0,0 +1,322 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "WindowCapture.h"
+
+#ifdef VR_DESKTOP
+
+WINDOWCAPTURE::WINDOWCAPTURE() : m_StopEvent(nullptr),
+                                 m_ThreadCount(0)
+{
+    for (UINT i = 0; i < MAX_WINDOWS; ++i)
+    {
+        FEED* Feed = &m_Feeds[i];
+        Feed->Window = nullptr;
+        Feed->Busy = 0;
+        Feed->NextCapture = 0;
+        RtlZeroMemory(Feed->Buffers, sizeof(Feed->Buffers));
+        RtlZeroMemory(&Feed->Stats, sizeof(Feed->Stats));
+        Feed->FirstCapture = 0;
+        RtlZeroMemory(&Feed->MailboxBase, sizeof(Feed->MailboxBase));
+    }
+    RtlZeroMemory(m_Threads, sizeof(m_Threads));
+    QueryPerformanceFrequency(&m_Frequency);
+}
+
+WINDOWCAPTURE::~WINDOWCAPTURE()
+{
+    Stop();
+
+    for (UINT i = 0; i < MAX_WINDOWS; ++i)
+    {
+        for (UINT j = 0; j < MAILBOX_SLOTS; ++j)
+        {
+            ReleaseBuffer(&m_Feeds[i].Buffers[j]);
+        }
+    }
+}
+
+//
+// Starts the capture threads, windows are only captured once SetWindow names them
+//
+DUPL_RETURN WINDOWCAPTURE::Start()
+{
+    if (m_ThreadCount)
+    {
+        return DUPL_RETURN_SUCCESS;
+    }
+
+    m_StopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (!m_StopEvent)
+    {
+        return ProcessFailure(nullptr, L"Failed to create stop event in WINDOWCAPTURE", L"Error", HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    for (UINT i = 0; i < WINDOW_CAPTURE_THREADS; ++i)
+    {
+        DWORD ThreadId;
+        m_Threads[i] = CreateThread(nullptr, 0, WorkerProc, this, 0, &ThreadId);
+        if (!m_Threads[i])
+        {
+            HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            Stop();
+            return ProcessFailure(nullptr, L"Failed to create window capture thread in WINDOWCAPTURE", L"Error", hr);
+        }
+        ++m_ThreadCount;
+    }
+
+    return DUPL_RETURN_SUCCESS;
+}
+
+//
+// Waits for the capture threads to finish what they are printing, published frames stay readable
+//
+void WINDOWCAPTURE::Stop()
+{
+    if (m_StopEvent)
+    {
+        SetEvent(m_StopEvent);
+    }
+
+    if (m_ThreadCount)
+    {
+        WaitForMultipleObjectsEx(m_ThreadCount, m_Threads, TRUE, INFINITE, FALSE);
+        for (UINT i = 0; i < m_ThreadCount; ++i)
+        {
+            CloseHandle(m_Threads[i]);
+            m_Threads[i] = nullptr;
+        }
+        m_ThreadCount = 0;
+    }
+
+    if (m_StopEvent)
+    {
+        CloseHandle(m_StopEvent);
+        m_StopEvent = nullptr;
+    }
+
+    for (UINT i = 0; i < MAX_WINDOWS; ++i)
+    {
+        m_Feeds[i].Window = nullptr;
+    }
+}
+
+//
+// Window captured into slot Index from the next capture on, null stops capturing into it
+//
+void WINDOWCAPTURE::SetWindow(UINT Index, HWND Window)
+{
+    m_Feeds[Index].Window = Window;
+}
+
+//
+// Frame is the latest capture of slot Index, it stays untouched until the next Acquire of that slot.
+// Returns false when nothing new was captured since the last call, Frame is then the one already had.
+//
+bool WINDOWCAPTURE::Acquire(UINT Index, _Outptr_ const WINDOW_BUFFER** Frame)
+{
+    unsigned Slot;
+    bool Fresh = m_Feeds[Index].Mailbox.Acquire(&Slot);
+    *Frame = &m_Feeds[Index].Buffers[Slot];
+
+    return Fresh;
+}
+
+//
+// Totals of slot Index since the last ResetStats, only consistent while the threads are stopped
+//
+void WINDOWCAPTURE::GetStats(UINT Index, _Out_ WINDOW_CAPTURE_STATS* Stats)
+{
+    FEED* Feed = &m_Feeds[Index];
+    *Stats = Feed->Stats;
+
+    MAILBOX_STATS MailboxStats;
+    Feed->Mailbox.GetStats(&MailboxStats);
+    Stats->Published = MailboxStats.Published - Feed->MailboxBase.Published;
+    Stats->Dropped = MailboxStats.Dropped - Feed->MailboxBase.Dropped;
+    Stats->Consumed = MailboxStats.Consumed - Feed->MailboxBase.Consumed;
+}
+
+//
+// Only call while the threads are stopped
+//
+void WINDOWCAPTURE::ResetStats()
+{
+    for (UINT i = 0; i < MAX_WINDOWS; ++i)
+    {
+        FEED* Feed = &m_Feeds[i];
+        RtlZeroMemory(&Feed->Stats, sizeof(Feed->Stats));
+        Feed->FirstCapture = 0;
+        Feed->Mailbox.GetStats(&Feed->MailboxBase);
+    }
+}
+
+DWORD WINAPI WINDOWCAPTURE::WorkerProc(_In_ void* Param)
+{
+    static_cast<WINDOWCAPTURE*>(Param)->WorkerLoop();
+    return 0;
+}
+
+//
+// Captures every window that is due and nobody else is capturing, then sleeps until the next one is due
+//
+void WINDOWCAPTURE::WorkerLoop()
+{
+    UINT First = 0;
+    for (;;)
+    {
+        LARGE_INTEGER Now;
+        QueryPerformanceCounter(&Now);
+
+        DWORD Sleep = WINDOW_CAPTURE_MS;
+        for (UINT n = 0; n < MAX_WINDOWS; ++n)
+        {
+            FEED* Feed = &m_Feeds[(First + n) % MAX_WINDOWS];
+            if (!Feed->Window || InterlockedCompareExchange(&Feed->Busy, 1, 0) != 0)
+            {
+                continue;
+            }
+
+            if (Now.QuadPart >= Feed->NextCapture)
+            {
+                Capture(Feed, Now.QuadPart);
+                Sleep = 0;
+            }
+            else
+            {
+                DWORD Remaining = static_cast<DWORD>(((Feed->NextCapture - Now.QuadPart) * 1000) / m_Frequency.QuadPart);
+                Sleep = min(Sleep, Remaining);
+            }
+
+            InterlockedExchange(&Feed->Busy, 0);
+        }
+
+        // Threads start their round at different windows so they don't queue up behind the same slow one
+        First = (First + 1) % MAX_WINDOWS;
+
+        if (WaitForSingleObject(m_StopEvent, Sleep) != WAIT_TIMEOUT)
+        {
+            break;
+        }
+    }
+}
+
+//
+// Prints the feed's window into its back buffer and publishes it, a window that can't be printed publishes nothing
+//
+void WINDOWCAPTURE::Capture(_Inout_ FEED* Feed, LONGLONG Now)
+{
+    Feed->NextCapture = Now + ((m_Frequency.QuadPart * WINDOW_CAPTURE_MS) / 1000);
+
+    HWND Window = Feed->Window;
+    RECT WindowRect;
+    if (!Window || !GetWindowRect(Window, &WindowRect))
+    {
+        ++Feed->Stats.Failures;
+        return;
+    }
+
+    INT Width = WindowRect.right - WindowRect.left;
+    INT Height = WindowRect.bottom - WindowRect.top;
+    WINDOW_BUFFER* Buffer = &Feed->Buffers[Feed->Mailbox.GetWriteSlot()];
+    if (Width <= 0 || Height <= 0 || !ResizeBuffer(Buffer, Width, Height))
+    {
+        ++Feed->Stats.Failures;
+        return;
+    }
+
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
+    QueryPerformanceCounter(&Start);
+    BOOL Printed = PrintWindow(Window, Buffer->Dc, 0);
+    GdiFlush();
+    QueryPerformanceCounter(&End);
+
+    if (!Feed->Stats.Captures)
+    {
+        Feed->FirstCapture = Start.QuadPart;
+    }
+    ++Feed->Stats.Captures;
+    Feed->Stats.ActiveTicks = Start.QuadPart - Feed->FirstCapture;
+    LONGLONG Ticks = End.QuadPart - Start.QuadPart;
+    Feed->Stats.CaptureTicks += Ticks;
+    if (Ticks > Feed->Stats.MaxCaptureTicks)
+    {
+        Feed->Stats.MaxCaptureTicks = Ticks;
+    }
+
+    if (!Printed)
+    {
+        ++Feed->Stats.Failures;
+        return;
+    }
+
+    Feed->Mailbox.Publish();
+}
+
+//
+// Makes Buffer a Width by Height DIB section selected into its own DC, a buffer already that size is kept
+//
+bool WINDOWCAPTURE::ResizeBuffer(_Inout_ WINDOW_BUFFER* Buffer, INT Width, INT Height)
+{
+    if (Buffer->Bitmap && Buffer->Width == Width && Buffer->Height == Height)
+    {
+        return true;
+    }
+
+    ReleaseBuffer(Buffer);
+
+    // Top down 32 bit rows, the layout of the window textures
+    BITMAPINFO Info;
+    RtlZeroMemory(&Info, sizeof(Info));
+    Info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    Info.bmiHeader.biPlanes = 1;
+    Info.bmiHeader.biBitCount = 32;
+    Info.bmiHeader.biWidth = Width;
+    Info.bmiHeader.biHeight = -Height;
+    Info.bmiHeader.biCompression = BI_RGB;
+
+    Buffer->Dc = CreateCompatibleDC(nullptr);
+    if (Buffer->Dc)
+    {
+        Buffer->Bitmap = CreateDIBSection(Buffer->Dc, &Info, DIB_RGB_COLORS, reinterpret_cast<void**>(&Buffer->Pixels), nullptr, 0);
+    }
+    if (!Buffer->Bitmap)
+    {
+        ReleaseBuffer(Buffer);
+        return false;
+    }
+
+    Buffer->OldBitmap = SelectObject(Buffer->Dc, Buffer->Bitmap);
+    Buffer->Width = Width;
+    Buffer->Height = Height;
+
+    return true;
+}
+
+void WINDOWCAPTURE::ReleaseBuffer(_Inout_ WINDOW_BUFFER* Buffer)
+{
+    if (Buffer->Bitmap)
+    {
+        SelectObject(Buffer->Dc, Buffer->OldBitmap);
+        DeleteObject(Buffer->Bitmap);
+        Buffer->Bitmap = nullptr;
+    }
+
+    if (Buffer->Dc)
+    {
+        DeleteDC(Buffer->Dc);
+        Buffer->Dc = nullptr;
+    }
+
+    Buffer->OldBitmap = nullptr;
+    Buffer->Pixels = nullptr;
+    Buffer->Width = 0;
+    Buffer->Height = 0;
+}
+
+#endif // VR_DESKTOP
@@ -0,0 +1,107 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _WINDOWCAPTURE_H_
+#define _WINDOWCAPTURE_H_
+
+#include "CommonTypes.h"
+#include "Mailbox.h"
+
+// Only the VR desktop draws windows, MAX_WINDOWS comes with it
+#ifdef VR_DESKTOP
+
+// Threads windows are captured on, a window that is slow to print only holds up the thread printing it
+#define WINDOW_CAPTURE_THREADS 2
+
+// Shortest time between the starts of two captures of the same window
+#define WINDOW_CAPTURE_MS 16
+
+//
+// One captured frame of a window. PrintWindow draws straight into the DIB section, Pixels are its
+// top down 32 bit rows, Width * BPP bytes apart.
+//
+typedef struct _WINDOW_BUFFER
+{
+    HDC Dc;
+    HBITMAP Bitmap;
+    HGDIOBJ OldBitmap;
+    BYTE* Pixels;
+    INT Width;
+    INT Height;
+} WINDOW_BUFFER;
+
+//
+// Running totals of one window kept by WINDOWCAPTURE, ticks are QPC ticks
+//
+typedef struct _WINDOW_CAPTURE_STATS
+{
+    UINT64 Captures;
+    UINT64 Failures;
+    UINT64 Published;
+    UINT64 Dropped;
+    UINT64 Consumed;
+    LONGLONG CaptureTicks;
+    LONGLONG MaxCaptureTicks;
+
+    // From the start of the first capture to the start of the last one
+    LONGLONG ActiveTicks;
+} WINDOW_CAPTURE_STATS;
+
+//
+// Captures up to MAX_WINDOWS windows with PrintWindow on background threads so the render thread never
+// waits on an application drawing itself. Every window has a MAILBOX of three DIB sections: the thread
+// capturing it prints into the back one and publishes it, the render thread takes the latest one without
+// blocking and reads it until its next Acquire. A window is captured by one thread at a time, at most
+// every WINDOW_CAPTURE_MS, and DIB sections are only made again when the window changes size.
+//
+class WINDOWCAPTURE
+{
+    public:
+        WINDOWCAPTURE();
+        ~WINDOWCAPTURE();
+        DUPL_RETURN Start();
+        void Stop();
+        void SetWindow(UINT Index, HWND Window);
+        bool Acquire(UINT Index, _Outptr_ const WINDOW_BUFFER** Frame);
+        void GetStats(UINT Index, _Out_ WINDOW_CAPTURE_STATS* Stats);
+        void ResetStats();
+
+    private:
+        typedef struct _FEED
+        {
+            // Window to capture, set by the render thread and picked up with the next capture
+            HWND volatile Window;
+
+            // Set while a thread captures this window, only that thread touches the rest of the feed
+            volatile LONG Busy;
+            LONGLONG NextCapture;
+            MAILBOX Mailbox;
+            WINDOW_BUFFER Buffers[MAILBOX_SLOTS];
+
+            // Written by the capturing thread, read once the threads are stopped
+            WINDOW_CAPTURE_STATS Stats;
+            LONGLONG FirstCapture;
+            MAILBOX_STATS MailboxBase;
+        } FEED;
+
+        static DWORD WINAPI WorkerProc(_In_ void* Param);
+        void WorkerLoop();
+        void Capture(_Inout_ FEED* Feed, LONGLONG Now);
+        static bool ResizeBuffer(_Inout_ WINDOW_BUFFER* Buffer, INT Width, INT Height);
+        static void ReleaseBuffer(_Inout_ WINDOW_BUFFER* Buffer);
+
+    // vars
+        FEED m_Feeds[MAX_WINDOWS];
+        HANDLE m_StopEvent;
+        UINT m_ThreadCount;
+        HANDLE m_Threads[WINDOW_CAPTURE_THREADS];
+        LARGE_INTEGER m_Frequency;
+};
+
+#endif // VR_DESKTOP
+
+#endif
@@ -0,0 +1,147 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CaptureArena.h"
+#include "TestHarness.h"
+
+//
+// Prepare sizes every slot once, and a thread starting again on the same arena keeps what it had
+//
+static void TestPrepare()
+{
+    CAPTUREARENA Arena;
+    TEST_CHECK(Arena.Prepare() == DUPL_RETURN_SUCCESS);
+
+    ARENA_STATS Stats;
+    Arena.GetStats(&Stats);
+    BYTE* Buffers[ARENA_SLOT_COUNT];
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        TEST_CHECK(Stats.Capacity[i] == ARENA_INITIAL_SIZE && Stats.Grows[i] == 1 && Stats.HighWater[i] == 0);
+
+        // The whole capacity is there to use without growing
+        TEST_CHECK(Arena.Reserve(static_cast<ARENA_SLOT>(i), ARENA_INITIAL_SIZE, &Buffers[i]) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Buffers[i] != nullptr);
+        memset(Buffers[i], static_cast<int>(i), ARENA_INITIAL_SIZE);
+    }
+
+    TEST_CHECK(Arena.Prepare() == DUPL_RETURN_SUCCESS);
+    Arena.GetStats(&Stats);
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        BYTE* Buffer;
+        TEST_CHECK(Arena.Reserve(static_cast<ARENA_SLOT>(i), 1, &Buffer) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Buffer == Buffers[i] && Buffer[ARENA_INITIAL_SIZE - 1] == i);
+        TEST_CHECK(Stats.Grows[i] == 1 && Stats.HighWater[i] == ARENA_INITIAL_SIZE);
+    }
+}
+
+//
+// A request that doesn't fit grows only its own slot, to at least double on a granularity boundary. Capacity and the
+// high-water mark stay put when requests get smaller again, and a grown slot survives another Prepare.
+//
+static void TestPerSlotGrowth()
+{
+    CAPTUREARENA Arena;
+    TEST_CHECK(Arena.Prepare() == DUPL_RETURN_SUCCESS);
+
+    BYTE* Before[ARENA_SLOT_COUNT];
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        TEST_CHECK(Arena.Reserve(static_cast<ARENA_SLOT>(i), 16, &Before[i]) == DUPL_RETURN_SUCCESS);
+    }
+
+    UINT Large = (ARENA_INITIAL_SIZE * 3) + 1;
+    BYTE* Buffer;
+    TEST_CHECK(Arena.Reserve(ARENA_SLOT_COALESCED_RECTS, Large, &Buffer) == DUPL_RETURN_SUCCESS);
+    memset(Buffer, 0xA5, Large);
+
+    ARENA_STATS Stats;
+    Arena.GetStats(&Stats);
+    UINT Capacity = Stats.Capacity[ARENA_SLOT_COALESCED_RECTS];
+    TEST_CHECK(Capacity >= Large && Capacity >= 2 * ARENA_INITIAL_SIZE && Capacity % ARENA_GRANULARITY == 0);
+    TEST_CHECK(Capacity < Large + ARENA_GRANULARITY);
+    TEST_CHECK(Stats.Grows[ARENA_SLOT_COALESCED_RECTS] == 2 && Stats.HighWater[ARENA_SLOT_COALESCED_RECTS] == Large);
+    for (UINT i = 0; i < ARENA_SLOT_COUNT; ++i)
+    {
+        if (i != ARENA_SLOT_COALESCED_RECTS)
+        {
+            BYTE* Other;
+            TEST_CHECK(Arena.Reserve(static_cast<ARENA_SLOT>(i), 16, &Other) == DUPL_RETURN_SUCCESS);
+            TEST_CHECK(Other == Before[i]);
+            TEST_CHECK(Stats.Capacity[i] == ARENA_INITIAL_SIZE && Stats.Grows[i] == 1 && Stats.HighWater[i] == 16);
+        }
+    }
+
+    // Smaller frames reuse the grown buffer and the high-water mark remembers the largest
+    BYTE* Smaller;
+    TEST_CHECK(Arena.Reserve(ARENA_SLOT_COALESCED_RECTS, 100, &Smaller) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(Smaller == Buffer);
+    TEST_CHECK(Arena.Prepare() == DUPL_RETURN_SUCCESS);
+    Arena.GetStats(&Stats);
+    TEST_CHECK(Stats.Capacity[ARENA_SLOT_COALESCED_RECTS] == Capacity && Stats.Grows[ARENA_SLOT_COALESCED_RECTS] == 2);
+    TEST_CHECK(Stats.HighWater[ARENA_SLOT_COALESCED_RECTS] == Large);
+
+    // Just past the capacity at least doubles it
+    TEST_CHECK(Arena.Reserve(ARENA_SLOT_COALESCED_RECTS, Capacity + 1, &Buffer) == DUPL_RETURN_SUCCESS);
+    Arena.GetStats(&Stats);
+    TEST_CHECK(Stats.Capacity[ARENA_SLOT_COALESCED_RECTS] == 2 * Capacity && Stats.Grows[ARENA_SLOT_COALESCED_RECTS] == 3);
+    TEST_CHECK(Stats.HighWater[ARENA_SLOT_COALESCED_RECTS] == Capacity + 1);
+}
+
+//
+// A request count that creeps up every frame settles after a few grows rather than one per frame
+//
+static void TestSlowRiseSettles()
+{
+    CAPTUREARENA Arena;
+    UINT Size = 1000;
+    UINT Largest = 0;
+    for (UINT Frame = 0; Frame < 500; ++Frame)
+    {
+        BYTE* Buffer;
+        TEST_CHECK(Arena.Reserve(ARENA_SLOT_METADATA, Size, &Buffer) == DUPL_RETURN_SUCCESS);
+        Buffer[Size - 1] = 1;
+        Largest = max(Largest, Size);
+        Size += (Size / 100) + 1;
+    }
+
+    // From 1000 to about 150 times that, doubling each time
+    ARENA_STATS Stats;
+    Arena.GetStats(&Stats);
+    TEST_CHECK(Stats.HighWater[ARENA_SLOT_METADATA] == Largest);
+    TEST_CHECK(Stats.Capacity[ARENA_SLOT_METADATA] >= Largest);
+    TEST_CHECK(Stats.Grows[ARENA_SLOT_METADATA] <= 9);
+
+    // Slots that were never asked for have nothing
+    TEST_CHECK(Stats.Capacity[ARENA_SLOT_MOVE_RECTS] == 0 && Stats.Grows[ARENA_SLOT_MOVE_RECTS] == 0);
+}
+
+//
+// Growth rounding, including near the top of the range where doubling or rounding would wrap
+//
+static void TestGrowSize()
+{
+    TEST_CHECK(CAPTUREARENA::GrowSize(0, 1) == ARENA_GRANULARITY);
+    TEST_CHECK(CAPTUREARENA::GrowSize(0, ARENA_GRANULARITY) == ARENA_GRANULARITY);
+    TEST_CHECK(CAPTUREARENA::GrowSize(ARENA_GRANULARITY, ARENA_GRANULARITY + 1) == 2 * ARENA_GRANULARITY);
+    TEST_CHECK(CAPTUREARENA::GrowSize(ARENA_GRANULARITY, (2 * ARENA_GRANULARITY) + 1) == 3 * ARENA_GRANULARITY);
+    TEST_CHECK(CAPTUREARENA::GrowSize(100, 150) == ARENA_GRANULARITY);
+    TEST_CHECK(CAPTUREARENA::GrowSize((UINT_MAX / 2) + 1, (UINT_MAX / 2) + 2) == UINT_MAX);
+    TEST_CHECK(CAPTUREARENA::GrowSize(0, UINT_MAX - 1) == UINT_MAX - 1);
+    TEST_CHECK(CAPTUREARENA::GrowSize(0, UINT_MAX - ARENA_GRANULARITY) == UINT_MAX - (ARENA_GRANULARITY - 1));
+}
+
+int main()
+{
+    TestPrepare();
+    TestPerSlotGrowth();
+    TestSlowRiseSettles();
+    TestGrowSize();
+
+    return TestResult();
+}
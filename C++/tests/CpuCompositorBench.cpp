@@ -0,0 +1,127 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <thread>
+#include <vector>
+
+#include "CpuCompositor.h"
+#include "TestHarness.h"
+
+//
+// Whether the framebuffer holds Src under every rect
+//
+static bool Matches(CPUCOMPOSITOR* Compositor, const std::vector<unsigned char>& Src, unsigned SrcPitch, const COMPOSE_RECT* Rects, unsigned RectCount)
+{
+    for (unsigned i = 0; i < RectCount; ++i)
+    {
+        for (int y = Rects[i].top; y < Rects[i].bottom; ++y)
+        {
+            if (memcmp(Compositor->GetPixels() + (y * Compositor->GetPitch()) + (Rects[i].left * COMPOSE_BPP),
+                       &Src[(y * SrcPitch) + (Rects[i].left * COMPOSE_BPP)], (Rects[i].right - Rects[i].left) * COMPOSE_BPP))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//
+// Nanoseconds per ApplyDirty of the rects, and the GB/s that makes
+//
+static double BenchDirty(CPUCOMPOSITOR* Compositor, const std::vector<unsigned char>& Src, unsigned SrcPitch, const COMPOSE_RECT* Rects, unsigned RectCount,
+                         unsigned long long Bytes, unsigned Iterations, double* Bandwidth)
+{
+    double Nanoseconds = BenchNanoseconds(Iterations, 3, [&]
+    {
+        Compositor->ApplyDirty(Rects, RectCount, &Src[0], SrcPitch);
+    });
+    TEST_CHECK(Matches(Compositor, Src, SrcPitch, Rects, RectCount));
+    *Bandwidth = Bytes / Nanoseconds;
+    return Nanoseconds;
+}
+
+int main(int argc, char** argv)
+{
+    bool Quick = BenchIsQuick(argc, argv);
+    unsigned Width = Quick ? 1920 : 3840;
+    unsigned Height = Quick ? 1080 : 2160;
+    unsigned Iterations = Quick ? 3 : 100;
+    unsigned SrcPitch = Width * COMPOSE_BPP;
+
+    std::vector<unsigned char> Src(static_cast<size_t>(SrcPitch) * Height);
+    TESTRANDOM Random(1);
+    for (size_t i = 0; i < Src.size(); i += 8)
+    {
+        unsigned long long Value = Random.Next();
+        memcpy(&Src[i], &Value, 8);
+    }
+
+    BANDPOOL Pool;
+    unsigned Cores = std::thread::hardware_concurrency();
+    TEST_CHECK(Pool.Start(Cores > 1 ? Cores - 1 : 0));
+    CPUCOMPOSITOR Single;
+    CPUCOMPOSITOR Banded;
+    Banded.SetPool(&Pool);
+    TEST_CHECK(Single.Resize(Width, Height));
+    TEST_CHECK(Banded.Resize(Width, Height));
+    printf("%ux%u framebuffer, %u pool threads\n", Width, Height, Pool.GetThreadCount());
+
+    // The bandwidth everything is measured against, one memcpy of the whole frame
+    std::vector<unsigned char> Dest(Src.size());
+    double Copy = BenchNanoseconds(Iterations, 3, [&]
+    {
+        memcpy(&Dest[0], &Src[0], Src.size());
+    });
+    TEST_CHECK(Dest == Src);
+    printf("memcpy         %7.3f ms  %6.2f GB/s\n", Copy / 1e6, Src.size() / Copy);
+
+    // The whole frame dirty, and a typical update of a few windows' worth of rects
+    COMPOSE_RECT Whole = {0, 0, static_cast<int>(Width), static_cast<int>(Height)};
+    COMPOSE_RECT Windows[] = {
+        {0, 0, static_cast<int>(Width / 2), static_cast<int>(Height / 2)},
+        {static_cast<int>(Width / 3), static_cast<int>(Height / 4), static_cast<int>(Width), static_cast<int>(Height * 3 / 4)},
+        {100, static_cast<int>(Height - 200), 700, static_cast<int>(Height - 100)},
+    };
+    unsigned long long WindowBytes = 0;
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        WindowBytes += static_cast<unsigned long long>(Windows[i].right - Windows[i].left) * (Windows[i].bottom - Windows[i].top) * COMPOSE_BPP;
+    }
+
+    double SingleBandwidth;
+    double BandedBandwidth;
+    double SingleWhole = BenchDirty(&Single, Src, SrcPitch, &Whole, 1, Src.size(), Iterations, &SingleBandwidth);
+    double BandedWhole = BenchDirty(&Banded, Src, SrcPitch, &Whole, 1, Src.size(), Iterations, &BandedBandwidth);
+    printf("whole frame    %7.3f ms  %6.2f GB/s  banded %7.3f ms  %6.2f GB/s\n", SingleWhole / 1e6, SingleBandwidth, BandedWhole / 1e6, BandedBandwidth);
+
+    double SingleWindows = BenchDirty(&Single, Src, SrcPitch, Windows, 3, WindowBytes, Iterations, &SingleBandwidth);
+    double BandedWindows = BenchDirty(&Banded, Src, SrcPitch, Windows, 3, WindowBytes, Iterations, &BandedBandwidth);
+    printf("windows        %7.3f ms  %6.2f GB/s  banded %7.3f ms  %6.2f GB/s\n", SingleWindows / 1e6, SingleBandwidth, BandedWindows / 1e6, BandedBandwidth);
+
+    // Scrolling most of the frame up and back down by a line of text, each move overlapping its own source
+    COMPOSE_MOVE Scroll[2];
+    Scroll[0].Dest = {0, 0, static_cast<int>(Width), static_cast<int>(Height - 40)};
+    Scroll[0].SrcX = 0;
+    Scroll[0].SrcY = 40;
+    Scroll[1].Dest = {0, 40, static_cast<int>(Width), static_cast<int>(Height)};
+    Scroll[1].SrcX = 0;
+    Scroll[1].SrcY = 0;
+    Single.ApplyDirty(&Whole, 1, &Src[0], SrcPitch);
+    double Moves = BenchNanoseconds(Iterations, 3, [&]
+    {
+        Single.ApplyMoves(Scroll, 2);
+    });
+
+    // Each round trip loses the 40 rows scrolled off the top, everything below them is back where it was
+    COMPOSE_RECT Kept = {0, 40, static_cast<int>(Width), static_cast<int>(Height)};
+    TEST_CHECK(Matches(&Single, Src, SrcPitch, &Kept, 1));
+    double MovedBytes = 2.0 * Width * (Height - 40) * COMPOSE_BPP;
+    printf("scroll         %7.3f ms  %6.2f GB/s\n", Moves / 1e6, MovedBytes / Moves);
+
+    return TestResult();
+}
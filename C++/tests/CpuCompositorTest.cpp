@@ -0,0 +1,366 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "CpuCompositor.h"
+#include "TestHarness.h"
+
+//
+// Framebuffer contents as one pixel per entry, Width * Height of them without the row padding
+//
+static void ReadPixels(CPUCOMPOSITOR* Compositor, unsigned Width, unsigned Height, std::vector<unsigned>* Pixels)
+{
+    Pixels->resize(static_cast<size_t>(Width) * Height);
+    for (unsigned y = 0; y < Height; ++y)
+    {
+        memcpy(&(*Pixels)[y * Width], Compositor->GetPixels() + (y * Compositor->GetPitch()), Width * COMPOSE_BPP);
+    }
+}
+
+static void WritePixels(CPUCOMPOSITOR* Compositor, unsigned Width, unsigned Height, const std::vector<unsigned>& Pixels)
+{
+    for (unsigned y = 0; y < Height; ++y)
+    {
+        memcpy(Compositor->GetPixels() + (y * Compositor->GetPitch()), &Pixels[y * Width], Width * COMPOSE_BPP);
+    }
+}
+
+//
+// A move as DXGI defines it: every destination pixel gets the pixel the source offset points at before the move,
+// as long as both lie on the framebuffer
+//
+static void ReferenceMove(std::vector<unsigned>* Pixels, unsigned Width, unsigned Height, const COMPOSE_MOVE& Move)
+{
+    std::vector<unsigned> Before = *Pixels;
+    int DeltaX = Move.SrcX - Move.Dest.left;
+    int DeltaY = Move.SrcY - Move.Dest.top;
+    for (int y = Move.Dest.top; y < Move.Dest.bottom; ++y)
+    {
+        for (int x = Move.Dest.left; x < Move.Dest.right; ++x)
+        {
+            int SrcX = x + DeltaX;
+            int SrcY = y + DeltaY;
+            if (x >= 0 && y >= 0 && x < static_cast<int>(Width) && y < static_cast<int>(Height) &&
+                SrcX >= 0 && SrcY >= 0 && SrcX < static_cast<int>(Width) && SrcY < static_cast<int>(Height))
+            {
+                (*Pixels)[(y * Width) + x] = Before[(SrcY * Width) + SrcX];
+            }
+        }
+    }
+}
+
+//
+// A move whose source overlaps its destination, shifted in one of eight directions by up to Reach pixels,
+// sometimes hanging off the framebuffer
+//
+static COMPOSE_MOVE RandomMove(TESTRANDOM* Random, unsigned Width, unsigned Height, unsigned Direction, int Reach)
+{
+    static const int Directions[][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+    COMPOSE_MOVE Move;
+    Move.Dest.left = static_cast<int>(Random->Below(Width + 20)) - 10;
+    Move.Dest.top = static_cast<int>(Random->Below(Height + 20)) - 10;
+    Move.Dest.right = Move.Dest.left + 1 + static_cast<int>(Random->Below(Width));
+    Move.Dest.bottom = Move.Dest.top + 1 + static_cast<int>(Random->Below(Height));
+    int Distance = 1 + static_cast<int>(Random->Below(Reach));
+    Move.SrcX = Move.Dest.left - (Directions[Direction][0] * Distance);
+    Move.SrcY = Move.Dest.top - (Directions[Direction][1] * Distance);
+    return Move;
+}
+
+//
+// Moves in every direction, along the same rows and columns and diagonally, overlapping their own sources
+// and clipped at every edge, give what copying through a second buffer gives. The row padding is never written.
+//
+static void TestMoves()
+{
+    const unsigned Sizes[][2] = {{1, 1}, {17, 9}, {64, 64}, {333, 121}};
+    TESTRANDOM Random(1);
+    for (unsigned s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); ++s)
+    {
+        unsigned Width = Sizes[s][0];
+        unsigned Height = Sizes[s][1];
+        CPUCOMPOSITOR Compositor;
+        TEST_CHECK(Compositor.Resize(Width, Height));
+        TEST_CHECK(Compositor.GetPitch() % COMPOSE_ROW_ALIGN == 0);
+        TEST_CHECK(reinterpret_cast<size_t>(Compositor.GetPixels()) % COMPOSE_ROW_ALIGN == 0);
+
+        std::vector<unsigned> Expected(Width * Height);
+        for (size_t i = 0; i < Expected.size(); ++i)
+        {
+            Expected[i] = static_cast<unsigned>(Random.Next());
+        }
+        WritePixels(&Compositor, Width, Height, Expected);
+
+        std::vector<unsigned> Actual;
+        for (unsigned Iteration = 0; Iteration < 400; ++Iteration)
+        {
+            // A few moves per frame, applied in order like DXGI's move rects
+            COMPOSE_MOVE Moves[3];
+            unsigned MoveCount = 1 + Random.Below(3);
+            for (unsigned m = 0; m < MoveCount; ++m)
+            {
+                Moves[m] = RandomMove(&Random, Width, Height, Random.Below(8), std::max(1, static_cast<int>(Width) / 2));
+                ReferenceMove(&Expected, Width, Height, Moves[m]);
+            }
+            Compositor.ApplyMoves(Moves, MoveCount);
+
+            ReadPixels(&Compositor, Width, Height, &Actual);
+            TEST_CHECK(Actual == Expected);
+            if (Actual != Expected)
+            {
+                return;
+            }
+        }
+
+        // Resize left the padding at zero and no move reaches it
+        for (unsigned y = 0; y < Height; ++y)
+        {
+            const unsigned char* Padding = Compositor.GetPixels() + (y * Compositor.GetPitch()) + (Width * COMPOSE_BPP);
+            for (unsigned b = 0; b < Compositor.GetPitch() - (Width * COMPOSE_BPP); ++b)
+            {
+                TEST_CHECK(Padding[b] == 0);
+            }
+        }
+    }
+}
+
+//
+// A move that lies entirely off the framebuffer, or whose source does, changes nothing and counts nothing
+//
+static void TestMovesOffscreen()
+{
+    CPUCOMPOSITOR Compositor;
+    TEST_CHECK(Compositor.Resize(100, 50));
+    std::vector<unsigned> Before(100 * 50);
+    for (size_t i = 0; i < Before.size(); ++i)
+    {
+        Before[i] = static_cast<unsigned>(i);
+    }
+    WritePixels(&Compositor, 100, 50, Before);
+
+    COMPOSE_MOVE Moves[3];
+    Moves[0].Dest = {100, 0, 150, 10};
+    Moves[0].SrcX = 0;
+    Moves[0].SrcY = 0;
+    Moves[1].Dest = {0, 0, 10, 10};
+    Moves[1].SrcX = 0;
+    Moves[1].SrcY = 60;
+    Moves[2].Dest = {-20, -20, -10, -10};
+    Moves[2].SrcX = 5;
+    Moves[2].SrcY = 5;
+    Compositor.ApplyMoves(Moves, 3);
+
+    std::vector<unsigned> After;
+    ReadPixels(&Compositor, 100, 50, &After);
+    TEST_CHECK(After == Before);
+
+    COMPOSE_STATS Stats;
+    Compositor.GetStats(&Stats);
+    TEST_CHECK(Stats.MovedBytes == 0);
+
+    // A 10 by 10 move counts its bytes
+    Moves[0].Dest = {10, 10, 20, 20};
+    Moves[0].SrcX = 15;
+    Moves[0].SrcY = 12;
+    Compositor.ApplyMoves(Moves, 1);
+    Compositor.GetStats(&Stats);
+    TEST_CHECK(Stats.MovedBytes == 10 * 10 * COMPOSE_BPP);
+}
+
+//
+// Overlapping dirty rects, some off the framebuffer, split across a pool give the same pixels as copying them
+// on one thread, and both give the source image exactly under the rects
+//
+static void TestDirtyBanded()
+{
+    const unsigned Width = 1920;
+    const unsigned Height = 1080;
+    const unsigned SrcPitch = (Width * COMPOSE_BPP) + 64;
+    TESTRANDOM Random(2);
+    std::vector<unsigned char> Src(static_cast<size_t>(SrcPitch) * Height);
+
+    BANDPOOL Pool;
+    TEST_CHECK(Pool.Start(3));
+    TEST_CHECK(Pool.GetThreadCount() == 3);
+    CPUCOMPOSITOR Banded;
+    Banded.SetPool(&Pool);
+    CPUCOMPOSITOR Single;
+    TEST_CHECK(Banded.Resize(Width, Height));
+    TEST_CHECK(Single.Resize(Width, Height));
+
+    std::vector<unsigned> Expected(Width * Height, 0);
+    std::vector<unsigned> BandedPixels;
+    std::vector<unsigned> SinglePixels;
+    unsigned long long CopiedBytes = 0;
+    for (unsigned Frame = 0; Frame < 12; ++Frame)
+    {
+        for (size_t i = 0; i < Src.size(); i += 8)
+        {
+            unsigned long long Value = Random.Next();
+            memcpy(&Src[i], &Value, 8);
+        }
+
+        // Big overlapping rects so the frame is split into bands, small ones that land inside a band or across two
+        std::vector<COMPOSE_RECT> Rects;
+        unsigned RectCount = 2 + Random.Below(12);
+        for (unsigned r = 0; r < RectCount; ++r)
+        {
+            bool Big = (r < 2);
+            COMPOSE_RECT Rect;
+            Rect.left = static_cast<int>(Random.Below(Big ? Width / 2 : Width)) - 40;
+            Rect.top = static_cast<int>(Random.Below(Big ? Height / 2 : Height)) - 40;
+            Rect.right = Rect.left + (Big ? 900 : 1) + static_cast<int>(Random.Below(Big ? 900 : 160));
+            Rect.bottom = Rect.top + (Big ? 500 : 1) + static_cast<int>(Random.Below(Big ? 500 : 80));
+            Rects.push_back(Rect);
+
+            int Left = std::max(Rect.left, 0);
+            int Top = std::max(Rect.top, 0);
+            int Right = std::min(Rect.right, static_cast<int>(Width));
+            int Bottom = std::min(Rect.bottom, static_cast<int>(Height));
+            for (int y = Top; y < Bottom; ++y)
+            {
+                memcpy(&Expected[(y * Width) + Left], &Src[(y * SrcPitch) + (Left * COMPOSE_BPP)], (Right - Left) * COMPOSE_BPP);
+            }
+            if (Left < Right && Top < Bottom)
+            {
+                CopiedBytes += static_cast<unsigned long long>(Right - Left) * (Bottom - Top) * COMPOSE_BPP;
+            }
+        }
+
+        Banded.ApplyDirty(&Rects[0], RectCount, &Src[0], SrcPitch);
+        Single.ApplyDirty(&Rects[0], RectCount, &Src[0], SrcPitch);
+        ReadPixels(&Banded, Width, Height, &BandedPixels);
+        ReadPixels(&Single, Width, Height, &SinglePixels);
+        TEST_CHECK(BandedPixels == SinglePixels);
+        TEST_CHECK(SinglePixels == Expected);
+    }
+
+    COMPOSE_STATS BandedStats;
+    COMPOSE_STATS SingleStats;
+    Banded.GetStats(&BandedStats);
+    Single.GetStats(&SingleStats);
+    TEST_CHECK(BandedStats.Frames == 12 && SingleStats.Frames == 12);
+    TEST_CHECK(BandedStats.BandedFrames == 12);
+    TEST_CHECK(SingleStats.BandedFrames == 0);
+    TEST_CHECK(BandedStats.CopiedBytes == CopiedBytes && SingleStats.CopiedBytes == CopiedBytes);
+}
+
+//
+// Small dirty sets stay on the calling thread even with a pool, nothing on the framebuffer counts as no frame
+//
+static void TestDirtySmall()
+{
+    BANDPOOL Pool;
+    TEST_CHECK(Pool.Start(2));
+    CPUCOMPOSITOR Compositor;
+    Compositor.SetPool(&Pool);
+    TEST_CHECK(Compositor.Resize(640, 480));
+
+    std::vector<unsigned> Src(640 * 480, 0x11223344u);
+    COMPOSE_RECT Small = {10, 10, 20, 20};
+    Compositor.ApplyDirty(&Small, 1, reinterpret_cast<unsigned char*>(&Src[0]), 640 * COMPOSE_BPP);
+    COMPOSE_RECT Outside = {700, 0, 800, 10};
+    Compositor.ApplyDirty(&Outside, 1, reinterpret_cast<unsigned char*>(&Src[0]), 640 * COMPOSE_BPP);
+
+    COMPOSE_STATS Stats;
+    Compositor.GetStats(&Stats);
+    TEST_CHECK(Stats.Frames == 1 && Stats.BandedFrames == 0 && Stats.CopiedBytes == 100 * COMPOSE_BPP);
+
+    std::vector<unsigned> Pixels;
+    ReadPixels(&Compositor, 640, 480, &Pixels);
+    TEST_CHECK(Pixels[(10 * 640) + 10] == 0x11223344u && Pixels[(19 * 640) + 19] == 0x11223344u);
+    TEST_CHECK(Pixels[(20 * 640) + 20] == 0 && Pixels[(9 * 640) + 10] == 0);
+
+    // A new size starts from black
+    TEST_CHECK(Compositor.Resize(320, 240));
+    ReadPixels(&Compositor, 320, 240, &Pixels);
+    TEST_CHECK(std::count(Pixels.begin(), Pixels.end(), 0u) == static_cast<long>(Pixels.size()));
+}
+
+//
+// Rows of every length and alignment come out the same as memcpy, including the streamed ones
+//
+static void TestCopyRow()
+{
+    TESTRANDOM Random(3);
+    std::vector<unsigned char> Src(4096 + 64);
+    std::vector<unsigned char> Dest(4096 + 64);
+    for (size_t i = 0; i < Src.size(); ++i)
+    {
+        Src[i] = static_cast<unsigned char>(Random.Next());
+    }
+
+    for (unsigned Iteration = 0; Iteration < 2000; ++Iteration)
+    {
+        size_t Bytes = Random.Below(4096);
+        size_t SrcOffset = Random.Below(32);
+        size_t DestOffset = Random.Below(32);
+        std::fill(Dest.begin(), Dest.end(), 0xAB);
+        CPUCOMPOSITOR::CopyRow(&Dest[DestOffset], &Src[SrcOffset], Bytes);
+        TEST_CHECK(memcmp(&Dest[DestOffset], &Src[SrcOffset], Bytes) == 0);
+        TEST_CHECK(DestOffset == 0 || Dest[DestOffset - 1] == 0xAB);
+        TEST_CHECK(Dest[DestOffset + Bytes] == 0xAB);
+    }
+}
+
+//
+// Every band of every job runs once, with jobs run from several threads at once and from a pool without threads
+//
+static void TestPool()
+{
+    BANDPOOL Empty;
+    TEST_CHECK(Empty.Start(0));
+    std::vector<std::atomic<unsigned>> Hits(100);
+    auto Count = [](void* Context, unsigned Band)
+    {
+        (*reinterpret_cast<std::vector<std::atomic<unsigned>>*>(Context))[Band]++;
+    };
+    Empty.Run(Count, &Hits, 100);
+    for (size_t i = 0; i < Hits.size(); ++i)
+    {
+        TEST_CHECK(Hits[i] == 1);
+    }
+
+    BANDPOOL Pool;
+    TEST_CHECK(Pool.Start(COMPOSE_MAX_THREADS + 5));
+    TEST_CHECK(Pool.GetThreadCount() == COMPOSE_MAX_THREADS);
+    std::vector<std::atomic<unsigned>> Shared(64);
+    std::vector<std::thread> Callers;
+    for (unsigned t = 0; t < 3; ++t)
+    {
+        Callers.push_back(std::thread([&]
+        {
+            for (unsigned Job = 0; Job < 200; ++Job)
+            {
+                Pool.Run(Count, &Shared, 64);
+            }
+        }));
+    }
+    for (size_t i = 0; i < Callers.size(); ++i)
+    {
+        Callers[i].join();
+    }
+    for (size_t i = 0; i < Shared.size(); ++i)
+    {
+        TEST_CHECK(Shared[i] == 3 * 200);
+    }
+}
+
+int main()
+{
+    TestMoves();
+    TestMovesOffscreen();
+    TestDirtyBanded();
+    TestDirtySmall();
+    TestCopyRow();
+    TestPool();
+
+    return TestResult();
+}
@@ -0,0 +1,95 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "CursorKernels.h"
+#include "TestHarness.h"
+
+static const char* KernelNames[] = {"scalar", "sse2", "avx2"};
+
+//
+// Blends whole Size by Size pointers with every level the CPU runs, each checked against the scalar one.
+// SkipX starts the masks off a byte boundary the way a pointer clipped at the left edge of the desktop does.
+//
+static void BenchPointer(unsigned Size, unsigned SkipX, unsigned Iterations)
+{
+    TESTRANDOM Random(Size + SkipX);
+    unsigned MaskPitch = (Size + SkipX + 7) / 8;
+    std::vector<unsigned char> AndMask(MaskPitch * Size);
+    std::vector<unsigned char> XorMask(MaskPitch * Size);
+    std::vector<unsigned> Desktop(Size * Size);
+    std::vector<unsigned> Shape(Size * Size);
+    for (size_t i = 0; i < AndMask.size(); ++i)
+    {
+        AndMask[i] = static_cast<unsigned char>(Random.Next());
+        XorMask[i] = static_cast<unsigned char>(Random.Next());
+    }
+    for (size_t i = 0; i < Desktop.size(); ++i)
+    {
+        Desktop[i] = static_cast<unsigned>(Random.Next());
+        Shape[i] = static_cast<unsigned>(Random.Next()) & (Random.Below(2) ? 0xFFFFFFFFu : 0x00FFFFFFu);
+    }
+
+    std::vector<unsigned> MonoReference(Size * Size);
+    std::vector<unsigned> ColorReference(Size * Size);
+    std::vector<unsigned> Dest(Size * Size);
+    double ScalarMono = 0.0;
+    double ScalarColor = 0.0;
+    CURSOR_KERNEL Supported = CURSORKERNELS::GetSupported();
+    for (int Kernel = CURSOR_KERNEL_SCALAR; Kernel <= Supported; ++Kernel)
+    {
+        MONO_ROW_PROC MonoRow = CURSORKERNELS::GetMonoRow(static_cast<CURSOR_KERNEL>(Kernel));
+        COLOR_ROW_PROC ColorRow = CURSORKERNELS::GetColorRow(static_cast<CURSOR_KERNEL>(Kernel));
+
+        double Mono = BenchNanoseconds(Iterations, 5, [&]
+        {
+            for (unsigned Row = 0; Row < Size; ++Row)
+            {
+                MonoRow(&Dest[Row * Size], &Desktop[Row * Size], &AndMask[Row * MaskPitch], &XorMask[Row * MaskPitch], SkipX, Size);
+            }
+        });
+        if (Kernel == CURSOR_KERNEL_SCALAR)
+        {
+            MonoReference = Dest;
+            ScalarMono = Mono;
+        }
+        TEST_CHECK(Dest == MonoReference);
+
+        double Color = BenchNanoseconds(Iterations, 5, [&]
+        {
+            for (unsigned Row = 0; Row < Size; ++Row)
+            {
+                ColorRow(&Dest[Row * Size], &Desktop[Row * Size], &Shape[Row * Size], Size);
+            }
+        });
+        if (Kernel == CURSOR_KERNEL_SCALAR)
+        {
+            ColorReference = Dest;
+            ScalarColor = Color;
+        }
+        TEST_CHECK(Dest == ColorReference);
+
+        printf("%3ux%-3u skip %u  %-6s  mono %8.0f ns (%4.1fx)  color %8.0f ns (%4.1fx)\n",
+               Size, Size, SkipX, KernelNames[Kernel], Mono, ScalarMono / Mono, Color, ScalarColor / Color);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned Iterations = BenchIsQuick(argc, argv) ? 20 : 20000;
+
+    // The usual pointer sizes and a large one, as scaled up on high DPI outputs
+    const unsigned Sizes[] = {32, 48, 64, 256};
+    for (unsigned i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); ++i)
+    {
+        BenchPointer(Sizes[i], 0, Iterations);
+        BenchPointer(Sizes[i], 3, Iterations);
+    }
+
+    return TestResult();
+}
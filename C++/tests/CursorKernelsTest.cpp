@@ -0,0 +1,167 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "CursorKernels.h"
+#include "TestHarness.h"
+
+// Longest row the equivalence tests build, past every vector width and tail length
+#define KERNEL_TEST_MAX_WIDTH 80
+
+// Most mask bits skipped before a row's first pixel
+#define KERNEL_TEST_MAX_SKIP 16
+
+//
+// The documented rules, one pixel at a time: a set AND bit keeps the desktop pixel and a clear one
+// keeps only its alpha, a set XOR bit then inverts the color
+//
+static unsigned ReferenceMono(unsigned Desktop, const unsigned char* AndRow, const unsigned char* XorRow, unsigned Bit)
+{
+    bool And = (AndRow[Bit / 8] >> (7 - (Bit % 8))) & 1;
+    bool Xor = (XorRow[Bit / 8] >> (7 - (Bit % 8))) & 1;
+    unsigned Pixel = And ? Desktop : (Desktop & 0xFF000000u);
+    return Xor ? (Pixel ^ 0x00FFFFFFu) : Pixel;
+}
+
+//
+// A shape pixel with any alpha is XOR'd with the desktop, one without replaces it, and the result is opaque
+//
+static unsigned ReferenceColor(unsigned Desktop, unsigned Shape)
+{
+    unsigned Pixel = (Shape >> 24) ? (Desktop ^ Shape) : Shape;
+    return Pixel | 0xFF000000u;
+}
+
+//
+// Alpha bytes the color kernel has to tell apart, biased towards the edges of the test
+//
+static unsigned RandomPixel(TESTRANDOM* Random)
+{
+    static const unsigned Alphas[] = {0x00, 0x01, 0x7F, 0x80, 0xFE, 0xFF};
+    unsigned Color = static_cast<unsigned>(Random->Next()) & 0x00FFFFFFu;
+    unsigned Alpha = Random->Below(2) ? Alphas[Random->Below(6)] : Random->Below(256);
+    return Color | (Alpha << 24);
+}
+
+//
+// Every level the CPU runs gives the reference pixels for every width, mask offset and alignment,
+// into a separate row and in place over the desktop
+//
+static void TestMonoRows()
+{
+    TESTRANDOM Random(1);
+    CURSOR_KERNEL Supported = CURSORKERNELS::GetSupported();
+    std::vector<unsigned> Desktop(KERNEL_TEST_MAX_WIDTH + 1);
+    std::vector<unsigned> Dest(KERNEL_TEST_MAX_WIDTH + 2);
+    std::vector<unsigned> InPlace(KERNEL_TEST_MAX_WIDTH + 1);
+    unsigned char AndRow[(KERNEL_TEST_MAX_WIDTH + KERNEL_TEST_MAX_SKIP) / 8 + 1];
+    unsigned char XorRow[sizeof(AndRow)];
+
+    for (unsigned Iteration = 0; Iteration < 4000; ++Iteration)
+    {
+        unsigned Width = Random.Below(KERNEL_TEST_MAX_WIDTH + 1);
+        unsigned SkipX = Random.Below(KERNEL_TEST_MAX_SKIP);
+        unsigned Offset = Random.Below(2);
+        for (unsigned i = 0; i < sizeof(AndRow); ++i)
+        {
+            AndRow[i] = static_cast<unsigned char>(Random.Next());
+            XorRow[i] = static_cast<unsigned char>(Random.Next());
+        }
+        for (unsigned i = 0; i < Desktop.size(); ++i)
+        {
+            Desktop[i] = RandomPixel(&Random);
+        }
+
+        for (int Kernel = CURSOR_KERNEL_SCALAR; Kernel <= Supported; ++Kernel)
+        {
+            MONO_ROW_PROC MonoRow = CURSORKERNELS::GetMonoRow(static_cast<CURSOR_KERNEL>(Kernel));
+
+            // The pixel past the row must be left alone
+            Dest[Offset + Width] = 0x12345678u;
+            MonoRow(&Dest[Offset], &Desktop[Offset], AndRow, XorRow, SkipX, Width);
+            InPlace = Desktop;
+            MonoRow(&InPlace[Offset], &InPlace[Offset], AndRow, XorRow, SkipX, Width);
+
+            for (unsigned Col = 0; Col < Width; ++Col)
+            {
+                unsigned Expected = ReferenceMono(Desktop[Offset + Col], AndRow, XorRow, SkipX + Col);
+                TEST_CHECK(Dest[Offset + Col] == Expected);
+                TEST_CHECK(InPlace[Offset + Col] == Expected);
+            }
+            TEST_CHECK(Dest[Offset + Width] == 0x12345678u);
+        }
+    }
+}
+
+static void TestColorRows()
+{
+    TESTRANDOM Random(2);
+    CURSOR_KERNEL Supported = CURSORKERNELS::GetSupported();
+    std::vector<unsigned> Desktop(KERNEL_TEST_MAX_WIDTH + 1);
+    std::vector<unsigned> Shape(KERNEL_TEST_MAX_WIDTH + 1);
+    std::vector<unsigned> Dest(KERNEL_TEST_MAX_WIDTH + 2);
+    std::vector<unsigned> InPlace(KERNEL_TEST_MAX_WIDTH + 1);
+
+    for (unsigned Iteration = 0; Iteration < 4000; ++Iteration)
+    {
+        unsigned Width = Random.Below(KERNEL_TEST_MAX_WIDTH + 1);
+        unsigned Offset = Random.Below(2);
+        for (unsigned i = 0; i < Desktop.size(); ++i)
+        {
+            Desktop[i] = RandomPixel(&Random);
+            Shape[i] = RandomPixel(&Random);
+        }
+
+        for (int Kernel = CURSOR_KERNEL_SCALAR; Kernel <= Supported; ++Kernel)
+        {
+            COLOR_ROW_PROC ColorRow = CURSORKERNELS::GetColorRow(static_cast<CURSOR_KERNEL>(Kernel));
+
+            Dest[Offset + Width] = 0x12345678u;
+            ColorRow(&Dest[Offset], &Desktop[Offset], &Shape[Offset], Width);
+            InPlace = Desktop;
+            ColorRow(&InPlace[Offset], &InPlace[Offset], &Shape[Offset], Width);
+
+            for (unsigned Col = 0; Col < Width; ++Col)
+            {
+                unsigned Expected = ReferenceColor(Desktop[Offset + Col], Shape[Offset + Col]);
+                TEST_CHECK(Dest[Offset + Col] == Expected);
+                TEST_CHECK(InPlace[Offset + Col] == Expected);
+            }
+            TEST_CHECK(Dest[Offset + Width] == 0x12345678u);
+        }
+    }
+}
+
+//
+// Selecting a level the CPU doesn't run falls back to the best one it does
+//
+static void TestSelect()
+{
+    CURSOR_KERNEL Supported = CURSORKERNELS::GetSupported();
+    CURSORKERNELS Kernels;
+    TEST_CHECK(Kernels.GetKernel() == Supported);
+    TEST_CHECK(Kernels.GetMonoRow() == CURSORKERNELS::GetMonoRow(Supported));
+    TEST_CHECK(Kernels.GetColorRow() == CURSORKERNELS::GetColorRow(Supported));
+
+    Kernels.Select(CURSOR_KERNEL_SCALAR);
+    TEST_CHECK(Kernels.GetKernel() == CURSOR_KERNEL_SCALAR);
+    TEST_CHECK(Kernels.GetMonoRow() == CURSORKERNELS::GetMonoRow(CURSOR_KERNEL_SCALAR));
+
+    Kernels.Select(CURSOR_KERNEL_AVX2);
+    TEST_CHECK(Kernels.GetKernel() == Supported);
+    TEST_CHECK(Kernels.GetColorRow() == CURSORKERNELS::GetColorRow(Supported));
+}
+
+int main()
+{
+    TestMonoRows();
+    TestColorRows();
+    TestSelect();
+
+    return TestResult();
+}
@@ -0,0 +1,293 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "DirtyAccumulator.h"
+#include "TestHarness.h"
+
+// Desktop the frames are acquired from
+#define ACCUMULATE_TEST_WIDTH   64
+#define ACCUMULATE_TEST_HEIGHT  48
+
+//
+// A frame as DDProc would hand it over, the texture is filled with a value per frame and pixel
+//
+typedef struct _TEST_FRAME
+{
+    FRAME_DATA Data;
+    std::vector<BYTE> MetaData;
+} TEST_FRAME;
+
+//
+// Value of the pixel at X, Y in frame Index
+//
+static DWORD PixelValue(UINT Index, UINT X, UINT Y)
+{
+    return (Index << 24) | (Y << 12) | X;
+}
+
+//
+// Acquired frame Index of Width by Height with the given moves and dirty rects, a nonzero MouseTime carries a pointer update
+//
+static void MakeFrame(ID3D11Device* Device, UINT Index, UINT Width, UINT Height, const std::vector<DXGI_OUTDUPL_MOVE_RECT>& Moves, const std::vector<RECT>& Dirty,
+                      LONGLONG MouseTime, TEST_FRAME* Frame)
+{
+    D3D11_TEXTURE2D_DESC Desc;
+    RtlZeroMemory(&Desc, sizeof(Desc));
+    Desc.Width = Width;
+    Desc.Height = Height;
+    Desc.MipLevels = 1;
+    Desc.ArraySize = 1;
+    Desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    Desc.SampleDesc.Count = 1;
+
+    RtlZeroMemory(&Frame->Data, sizeof(FRAME_DATA));
+    TEST_CHECK(SUCCEEDED(Device->CreateTexture2D(&Desc, nullptr, &Frame->Data.Frame)));
+    for (UINT y = 0; y < Height; ++y)
+    {
+        for (UINT x = 0; x < Width; ++x)
+        {
+            DWORD Value = PixelValue(Index, x, y);
+            memcpy(Frame->Data.Frame->GetPixel(x, y), &Value, sizeof(Value));
+        }
+    }
+
+    Frame->MetaData.assign(reinterpret_cast<const BYTE*>(Moves.data()), reinterpret_cast<const BYTE*>(Moves.data() + Moves.size()));
+    Frame->MetaData.insert(Frame->MetaData.end(), reinterpret_cast<const BYTE*>(Dirty.data()), reinterpret_cast<const BYTE*>(Dirty.data() + Dirty.size()));
+    Frame->Data.MetaData = Frame->MetaData.data();
+    Frame->Data.MoveCount = static_cast<UINT>(Moves.size());
+    Frame->Data.DirtyCount = static_cast<UINT>(Dirty.size());
+    Frame->Data.FrameInfo.TotalMetadataBufferSize = static_cast<UINT>(Frame->MetaData.size());
+    Frame->Data.FrameInfo.AccumulatedFrames = 1;
+    Frame->Data.FrameInfo.LastMouseUpdateTime.QuadPart = MouseTime;
+    Frame->Data.FrameInfo.PointerPosition.Position.x = static_cast<LONG>(Index);
+    Frame->Data.FrameInfo.PointerPosition.Visible = TRUE;
+}
+
+//
+// Marks the pixels of Rect in Owner with Index, clipped to the desktop
+//
+static void Cover(std::vector<int>* Owner, const RECT& Rect, int Index)
+{
+    for (LONG y = max(Rect.top, 0L); y < min(Rect.bottom, static_cast<LONG>(ACCUMULATE_TEST_HEIGHT)); ++y)
+    {
+        for (LONG x = max(Rect.left, 0L); x < min(Rect.right, static_cast<LONG>(ACCUMULATE_TEST_WIDTH)); ++x)
+        {
+            (*Owner)[(y * ACCUMULATE_TEST_WIDTH) + x] = Index;
+        }
+    }
+}
+
+//
+// The pending frame's boxes cover exactly the pixels with an owner, once each, and the private texture holds what
+// the newest frame to touch each of them had there
+//
+static void CheckPending(FRAME_DATA* Pending, const std::vector<int>& Owner)
+{
+    TEST_CHECK(Pending->MoveCount == 0);
+    TEST_CHECK(Pending->FrameInfo.TotalMetadataBufferSize == Pending->DirtyCount * sizeof(RECT));
+    TEST_CHECK(Pending->FrameInfo.PointerShapeBufferSize == 0);
+
+    std::vector<int> Covered(Owner.size(), 0);
+    const RECT* Boxes = reinterpret_cast<const RECT*>(Pending->MetaData);
+    for (UINT i = 0; i < Pending->DirtyCount; ++i)
+    {
+        TEST_CHECK(Boxes[i].left >= 0 && Boxes[i].top >= 0 && Boxes[i].right <= ACCUMULATE_TEST_WIDTH && Boxes[i].bottom <= ACCUMULATE_TEST_HEIGHT);
+        for (LONG y = Boxes[i].top; y < Boxes[i].bottom; ++y)
+        {
+            for (LONG x = Boxes[i].left; x < Boxes[i].right; ++x)
+            {
+                ++Covered[(y * ACCUMULATE_TEST_WIDTH) + x];
+            }
+        }
+    }
+
+    bool Match = true;
+    for (UINT y = 0; y < ACCUMULATE_TEST_HEIGHT; ++y)
+    {
+        for (UINT x = 0; x < ACCUMULATE_TEST_WIDTH; ++x)
+        {
+            int Index = Owner[(y * ACCUMULATE_TEST_WIDTH) + x];
+            Match = Match && (Covered[(y * ACCUMULATE_TEST_WIDTH) + x] == ((Index >= 0) ? 1 : 0));
+            if (Index >= 0)
+            {
+                DWORD Value;
+                memcpy(&Value, Pending->Frame->GetPixel(x, y), sizeof(Value));
+                Match = Match && (Value == PixelValue(Index, x, y));
+            }
+        }
+    }
+    TEST_CHECK(Match);
+}
+
+//
+// Frames deferred while the shared surface is busy merge into one region, moved areas count as dirty, overlap is
+// copied once and what hangs off the desktop is dropped
+//
+static void TestDeferMergesIntoRegion()
+{
+    ID3D11Device Device;
+    DIRTYACCUMULATOR Accumulator;
+    Accumulator.InitAccumulator(&Device);
+    TEST_CHECK(!Accumulator.HasPending());
+
+    std::vector<int> Owner(ACCUMULATE_TEST_WIDTH * ACCUMULATE_TEST_HEIGHT, -1);
+
+    // Two overlapping dirty rects and a move whose destination overlaps one of them
+    DXGI_OUTDUPL_MOVE_RECT Move;
+    Move.SourcePoint.x = 0;
+    Move.SourcePoint.y = 0;
+    Move.DestinationRect = {20, 20, 40, 30};
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> Moves(1, Move);
+    std::vector<RECT> Dirty = {{0, 0, 16, 16}, {8, 8, 24, 24}};
+    TEST_FRAME First;
+    MakeFrame(&Device, 1, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, Moves, Dirty, 0, &First);
+    TEST_CHECK(Accumulator.CanDefer(&First.Data));
+    TEST_CHECK(Accumulator.Defer(&First.Data) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(Accumulator.HasPending());
+    TEST_CHECK(Device.TexturesCreated == 2);
+
+    // Union of 16x16, 16x16 and 20x10 less the overlaps of 8x8 and 4x4
+    TEST_CHECK(Device.Context.CopiedPixels == 256 + 256 + 200 - 64 - 16);
+    Cover(&Owner, Move.DestinationRect, 1);
+    Cover(&Owner, Dirty[0], 1);
+    Cover(&Owner, Dirty[1], 1);
+
+    // The next frame overlaps the first and hangs off the right edge, an empty rect adds nothing
+    std::vector<RECT> Later = {{12, 12, 30, 22}, {56, 40, 80, 60}, {5, 5, 5, 9}};
+    TEST_FRAME Second;
+    MakeFrame(&Device, 2, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), Later, 0, &Second);
+    UINT64 Copied = Device.Context.CopiedPixels;
+    TEST_CHECK(Accumulator.Defer(&Second.Data) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(Device.Context.CopiedPixels - Copied == (18 * 10) + (8 * 8));
+    TEST_CHECK(Device.TexturesCreated == 3);
+    Cover(&Owner, Later[0], 2);
+    Cover(&Owner, Later[1], 2);
+
+    FRAME_DATA Pending;
+    Accumulator.GetPendingFrame(&Pending);
+    TEST_CHECK(Pending.FrameInfo.AccumulatedFrames == 2);
+    TEST_CHECK(Pending.FrameInfo.LastMouseUpdateTime.QuadPart == 0);
+    CheckPending(&Pending, Owner);
+
+    ACCUMULATE_STATS Stats;
+    Accumulator.GetStats(&Stats);
+    TEST_CHECK(Stats.DeferredFrames == 2 && Stats.RectsDeferred == 6);
+    TEST_CHECK(Stats.Flushes == 1 && Stats.RectsFlushed == Pending.DirtyCount);
+
+    // Once drawn nothing is left and the next deferral starts over
+    Accumulator.Clear();
+    TEST_CHECK(!Accumulator.HasPending());
+    TEST_FRAME Third;
+    std::vector<RECT> Small = {{1, 1, 3, 3}};
+    MakeFrame(&Device, 3, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), Small, 0, &Third);
+    TEST_CHECK(Accumulator.Defer(&Third.Data) == DUPL_RETURN_SUCCESS);
+    std::vector<int> ThirdOwner(Owner.size(), -1);
+    Cover(&ThirdOwner, Small[0], 3);
+    Accumulator.GetPendingFrame(&Pending);
+    TEST_CHECK(Pending.FrameInfo.AccumulatedFrames == 1 && Pending.DirtyCount == 1);
+    CheckPending(&Pending, ThirdOwner);
+
+    // The private texture was made once and kept
+    TEST_CHECK(Device.TexturesCreated == 4);
+
+    First.Data.Frame->Release();
+    Second.Data.Frame->Release();
+    Third.Data.Frame->Release();
+}
+
+//
+// Only the newest pointer update is kept, frames without one leave it alone and a pointer move alone is pending too.
+// A new shape can't be deferred since it is only readable while the frame is held.
+//
+static void TestPointerIsCarried()
+{
+    ID3D11Device Device;
+    DIRTYACCUMULATOR Accumulator;
+    Accumulator.InitAccumulator(&Device);
+
+    TEST_FRAME Moved;
+    MakeFrame(&Device, 1, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), std::vector<RECT>(), 100, &Moved);
+    TEST_CHECK(Accumulator.Defer(&Moved.Data) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(Accumulator.HasPending());
+
+    FRAME_DATA Pending;
+    Accumulator.GetPendingFrame(&Pending);
+    TEST_CHECK(Pending.DirtyCount == 0 && Pending.FrameInfo.TotalMetadataBufferSize == 0);
+    TEST_CHECK(Pending.FrameInfo.LastMouseUpdateTime.QuadPart == 100 && Pending.FrameInfo.PointerPosition.Position.x == 1);
+
+    TEST_FRAME MovedAgain;
+    MakeFrame(&Device, 2, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), std::vector<RECT>(), 200, &MovedAgain);
+    TEST_CHECK(Accumulator.Defer(&MovedAgain.Data) == DUPL_RETURN_SUCCESS);
+    TEST_FRAME Still;
+    std::vector<RECT> Dirty = {{0, 0, 4, 4}};
+    MakeFrame(&Device, 3, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), Dirty, 0, &Still);
+    TEST_CHECK(Accumulator.Defer(&Still.Data) == DUPL_RETURN_SUCCESS);
+
+    Accumulator.GetPendingFrame(&Pending);
+    TEST_CHECK(Pending.FrameInfo.AccumulatedFrames == 3 && Pending.DirtyCount == 1);
+    TEST_CHECK(Pending.FrameInfo.LastMouseUpdateTime.QuadPart == 200 && Pending.FrameInfo.PointerPosition.Position.x == 2);
+
+    Accumulator.Clear();
+    TEST_CHECK(!Accumulator.HasPending());
+
+    TEST_FRAME Shape;
+    MakeFrame(&Device, 4, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), std::vector<RECT>(), 300, &Shape);
+    Shape.Data.FrameInfo.PointerShapeBufferSize = 64;
+    TEST_CHECK(!Accumulator.CanDefer(&Shape.Data));
+
+    Moved.Data.Frame->Release();
+    MovedAgain.Data.Frame->Release();
+    Still.Data.Frame->Release();
+    Shape.Data.Frame->Release();
+}
+
+//
+// A frame of another size remakes the private texture, what was pending is lost with it so the whole new frame is taken
+//
+static void TestResizeTakesWholeFrame()
+{
+    ID3D11Device Device;
+    DIRTYACCUMULATOR Accumulator;
+    Accumulator.InitAccumulator(&Device);
+
+    std::vector<RECT> Dirty = {{0, 0, 8, 8}};
+    TEST_FRAME Before;
+    MakeFrame(&Device, 1, ACCUMULATE_TEST_WIDTH / 2, ACCUMULATE_TEST_HEIGHT / 2, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), Dirty, 0, &Before);
+    TEST_CHECK(Accumulator.Defer(&Before.Data) == DUPL_RETURN_SUCCESS);
+
+    TEST_FRAME After;
+    MakeFrame(&Device, 2, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT, std::vector<DXGI_OUTDUPL_MOVE_RECT>(), Dirty, 0, &After);
+    UINT64 Copied = Device.Context.CopiedPixels;
+    TEST_CHECK(Accumulator.Defer(&After.Data) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(Device.Context.CopiedPixels - Copied == ACCUMULATE_TEST_WIDTH * ACCUMULATE_TEST_HEIGHT);
+
+    FRAME_DATA Pending;
+    Accumulator.GetPendingFrame(&Pending);
+    D3D11_TEXTURE2D_DESC Desc;
+    Pending.Frame->GetDesc(&Desc);
+    TEST_CHECK(Desc.Width == ACCUMULATE_TEST_WIDTH && Desc.Height == ACCUMULATE_TEST_HEIGHT);
+    TEST_CHECK(Pending.FrameInfo.AccumulatedFrames == 2);
+
+    std::vector<int> Owner(ACCUMULATE_TEST_WIDTH * ACCUMULATE_TEST_HEIGHT, -1);
+    RECT Whole = {0, 0, ACCUMULATE_TEST_WIDTH, ACCUMULATE_TEST_HEIGHT};
+    Cover(&Owner, Whole, 2);
+    CheckPending(&Pending, Owner);
+
+    Before.Data.Frame->Release();
+    After.Data.Frame->Release();
+}
+
+int main()
+{
+    TestDeferMergesIntoRegion();
+    TestPointerIsCarried();
+    TestResizeTakesWholeFrame();
+
+    return TestResult();
+}
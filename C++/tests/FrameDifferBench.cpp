@@ -0,0 +1,176 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "FrameDiffer.h"
+#include "TestHarness.h"
+
+//
+// Two frames that differ in a set of rects, diffing them in turn changes those rects every time
+//
+typedef struct _BENCH_CASE
+{
+    const char* Name;
+    std::vector<COMPOSE_RECT> Changes;
+} BENCH_CASE;
+
+static void Fill(std::vector<unsigned char>* Frame, unsigned Width, unsigned Height, unsigned long long Seed)
+{
+    TESTRANDOM Random(Seed);
+    Frame->resize(static_cast<size_t>(Width) * Height * COMPOSE_BPP);
+    for (size_t i = 0; i < Frame->size(); i += 8)
+    {
+        unsigned long long Value = Random.Next();
+        memcpy(&(*Frame)[i], &Value, 8);
+    }
+}
+
+//
+// Diffs Iterations frames alternating between two and returns nanoseconds per frame.
+// The rects from the last diff must cover every tile of Changes.
+//
+static double BenchDiffer(FRAMEDIFFER* Differ, const std::vector<unsigned char>& First, const std::vector<unsigned char>& Second,
+                          unsigned Width, unsigned Height, const std::vector<COMPOSE_RECT>& Changes, unsigned Iterations)
+{
+    COMPOSE_RECT* Rects;
+    unsigned Count;
+    Differ->Reset();
+    Differ->Diff(&First[0], Width, Height, Width * COMPOSE_BPP, &Rects, &Count);
+
+    unsigned Frame = 0;
+    double Nanoseconds = BenchNanoseconds(Iterations, 3, [&]
+    {
+        const std::vector<unsigned char>& Pixels = (++Frame & 1) ? Second : First;
+        TEST_CHECK(Differ->Diff(&Pixels[0], Width, Height, Width * COMPOSE_BPP, &Rects, &Count));
+    });
+
+    // Every changed pixel lies in a rect and nothing is reported when nothing changed
+    TEST_CHECK(Changes.empty() == (Count == 0));
+    for (size_t i = 0; i < Changes.size(); ++i)
+    {
+        bool Found = false;
+        for (unsigned r = 0; r < Count && !Found; ++r)
+        {
+            Found = Rects[r].left <= Changes[i].left && Rects[r].top <= Changes[i].top && Rects[r].right > Changes[i].left && Rects[r].bottom > Changes[i].top;
+        }
+        TEST_CHECK(Found);
+    }
+
+    return Nanoseconds;
+}
+
+//
+// What the differ is measured against: one memcmp of the whole frame, which only says whether anything changed,
+// and that memcmp per tile with the changed tiles copied into a kept frame
+//
+static double BenchFlatMemcmp(const std::vector<unsigned char>& First, const std::vector<unsigned char>& Second, unsigned Iterations)
+{
+    std::vector<unsigned char> Kept = First;
+    volatile int Sink = 0;
+    unsigned Frame = 0;
+    return BenchNanoseconds(Iterations, 3, [&]
+    {
+        Sink = Sink + (memcmp(&Kept[0], (++Frame & 1) ? &Second[0] : &First[0], First.size()) != 0);
+    });
+}
+
+static double BenchTileMemcmp(const std::vector<unsigned char>& First, const std::vector<unsigned char>& Second, unsigned Width, unsigned Height, unsigned Iterations)
+{
+    std::vector<unsigned char> Kept = First;
+    size_t RowBytes = static_cast<size_t>(Width) * COMPOSE_BPP;
+    size_t TileBytes = static_cast<size_t>(DIFF_TILE_SIZE) * COMPOSE_BPP;
+    volatile unsigned Sink = 0;
+    unsigned Frame = 0;
+    return BenchNanoseconds(Iterations, 3, [&]
+    {
+        const unsigned char* Pixels = (++Frame & 1) ? &Second[0] : &First[0];
+        unsigned Changed = 0;
+        for (unsigned Top = 0; Top < Height; Top += DIFF_TILE_SIZE)
+        {
+            unsigned Bottom = std::min(Top + DIFF_TILE_SIZE, Height);
+            for (size_t Offset = 0; Offset < RowBytes; Offset += TileBytes)
+            {
+                size_t Bytes = std::min(TileBytes, RowBytes - Offset);
+                unsigned Row = Top;
+                while (Row < Bottom && !memcmp(&Kept[Row * RowBytes + Offset], Pixels + Row * RowBytes + Offset, Bytes))
+                {
+                    ++Row;
+                }
+                if (Row == Bottom)
+                {
+                    continue;
+                }
+                ++Changed;
+                for (; Row < Bottom; ++Row)
+                {
+                    memcpy(&Kept[Row * RowBytes + Offset], Pixels + Row * RowBytes + Offset, Bytes);
+                }
+            }
+        }
+        Sink = Sink + Changed;
+    });
+}
+
+int main(int argc, char** argv)
+{
+    bool Quick = BenchIsQuick(argc, argv);
+    unsigned Width = Quick ? 1920 : 3840;
+    unsigned Height = Quick ? 1080 : 2160;
+    unsigned Iterations = Quick ? 4 : 40;
+
+    // A still window, a caret blinking and a few characters typed, a scrolled half and everything
+    std::vector<BENCH_CASE> Cases(4);
+    Cases[0].Name = "unchanged";
+    Cases[1].Name = "typing";
+    Cases[1].Changes.push_back({100, 200, 108, 216});
+    Cases[1].Changes.push_back({900, 640, 912, 660});
+    Cases[1].Changes.push_back({1500, 1000, 1501, 1020});
+    Cases[2].Name = "half";
+    Cases[2].Changes.push_back({0, static_cast<int>(Height / 2), static_cast<int>(Width), static_cast<int>(Height)});
+    Cases[3].Name = "all";
+    Cases[3].Changes.push_back({0, 0, static_cast<int>(Width), static_cast<int>(Height)});
+
+    std::vector<unsigned char> First;
+    std::vector<unsigned char> Noise;
+    Fill(&First, Width, Height, 1);
+    Fill(&Noise, Width, Height, 2);
+
+    BANDPOOL Pool;
+    unsigned Cores = std::thread::hardware_concurrency();
+    TEST_CHECK(Pool.Start(Cores > 1 ? Cores - 1 : 0));
+    FRAMEDIFFER Single;
+    FRAMEDIFFER Banded;
+    Banded.SetPool(&Pool);
+
+    printf("%ux%u frames, %u pool threads\n", Width, Height, Pool.GetThreadCount());
+    for (size_t c = 0; c < Cases.size(); ++c)
+    {
+        // The second frame is the first with the changed rects taken from the noise frame
+        std::vector<unsigned char> Second = First;
+        for (size_t i = 0; i < Cases[c].Changes.size(); ++i)
+        {
+            const COMPOSE_RECT& Rect = Cases[c].Changes[i];
+            for (int y = Rect.top; y < Rect.bottom; ++y)
+            {
+                size_t Offset = (static_cast<size_t>(y) * Width + Rect.left) * COMPOSE_BPP;
+                memcpy(&Second[Offset], &Noise[Offset], (Rect.right - Rect.left) * COMPOSE_BPP);
+            }
+        }
+
+        double Flat = BenchFlatMemcmp(First, Second, Iterations);
+        double Tiles = BenchTileMemcmp(First, Second, Width, Height, Iterations);
+        double Diff = BenchDiffer(&Single, First, Second, Width, Height, Cases[c].Changes, Iterations);
+        double Pooled = BenchDiffer(&Banded, First, Second, Width, Height, Cases[c].Changes, Iterations);
+        printf("%-10s flat memcmp %7.3f ms  tile memcmp+copy %7.3f ms  differ %7.3f ms  pooled %7.3f ms\n",
+               Cases[c].Name, Flat / 1e6, Tiles / 1e6, Diff / 1e6, Pooled / 1e6);
+    }
+
+    return TestResult();
+}
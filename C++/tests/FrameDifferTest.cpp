@@ -0,0 +1,208 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <vector>
+
+#include "FrameDiffer.h"
+#include "TestHarness.h"
+
+//
+// A BGRA frame with Pitch bytes per row, Pitch may be more than the pixels need
+//
+typedef struct _TEST_FRAME
+{
+    unsigned Width;
+    unsigned Height;
+    unsigned Pitch;
+    std::vector<unsigned char> Bytes;
+} TEST_FRAME;
+
+static void MakeFrame(unsigned Width, unsigned Height, unsigned Padding, TESTRANDOM* Random, TEST_FRAME* Frame)
+{
+    Frame->Width = Width;
+    Frame->Height = Height;
+    Frame->Pitch = (Width * COMPOSE_BPP) + Padding;
+    Frame->Bytes.resize(static_cast<size_t>(Frame->Pitch) * Height);
+    for (size_t i = 0; i < Frame->Bytes.size(); ++i)
+    {
+        Frame->Bytes[i] = static_cast<unsigned char>(Random->Next());
+    }
+}
+
+//
+// Changes a few pixels inside a random rect, or only the padding past the end of the rows
+//
+static void Scribble(TEST_FRAME* Frame, TESTRANDOM* Random)
+{
+    unsigned Left = Random->Below(Frame->Width);
+    unsigned Top = Random->Below(Frame->Height);
+    unsigned Right = Left + 1 + Random->Below(std::min(Frame->Width - Left, 80U));
+    unsigned Bottom = Top + 1 + Random->Below(std::min(Frame->Height - Top, 80U));
+    unsigned Writes = 1 + Random->Below(4);
+    for (unsigned i = 0; i < Writes; ++i)
+    {
+        unsigned x = Left + Random->Below(Right - Left);
+        unsigned y = Top + Random->Below(Bottom - Top);
+        Frame->Bytes[(y * Frame->Pitch) + (x * COMPOSE_BPP) + Random->Below(COMPOSE_BPP)] ^= static_cast<unsigned char>(1 + Random->Below(255));
+    }
+
+    if (Frame->Pitch > Frame->Width * COMPOSE_BPP && Random->Below(4) == 0)
+    {
+        Frame->Bytes[(Random->Below(Frame->Height) * Frame->Pitch) + (Frame->Width * COMPOSE_BPP)] ^= 0xFF;
+    }
+}
+
+//
+// Which tiles differ between two frames, one entry per tile
+//
+static void ReferenceTiles(const TEST_FRAME* Old, const TEST_FRAME* New, std::vector<unsigned char>* Changed)
+{
+    unsigned TilesX = (New->Width + DIFF_TILE_SIZE - 1) >> DIFF_TILE_SHIFT;
+    unsigned TilesY = (New->Height + DIFF_TILE_SIZE - 1) >> DIFF_TILE_SHIFT;
+    Changed->assign(TilesX * TilesY, 0);
+    for (unsigned y = 0; y < New->Height; ++y)
+    {
+        for (unsigned x = 0; x < New->Width * COMPOSE_BPP; ++x)
+        {
+            if (Old->Bytes[(y * Old->Pitch) + x] != New->Bytes[(y * New->Pitch) + x])
+            {
+                (*Changed)[((y >> DIFF_TILE_SHIFT) * TilesX) + ((x / COMPOSE_BPP) >> DIFF_TILE_SHIFT)] = 1;
+            }
+        }
+    }
+}
+
+//
+// Rects are tile aligned or end at the frame's edge, never overlap and cover exactly the changed tiles
+//
+static void CheckRects(const TEST_FRAME* Frame, const COMPOSE_RECT* Rects, unsigned Count, const std::vector<unsigned char>& Expected)
+{
+    unsigned TilesX = (Frame->Width + DIFF_TILE_SIZE - 1) >> DIFF_TILE_SHIFT;
+    std::vector<unsigned char> Covered(Expected.size(), 0);
+    for (unsigned i = 0; i < Count; ++i)
+    {
+        const COMPOSE_RECT& Rect = Rects[i];
+        TEST_CHECK(Rect.left >= 0 && Rect.top >= 0 && Rect.left < Rect.right && Rect.top < Rect.bottom);
+        TEST_CHECK(Rect.right <= static_cast<int>(Frame->Width) && Rect.bottom <= static_cast<int>(Frame->Height));
+        TEST_CHECK((Rect.left % DIFF_TILE_SIZE) == 0 && (Rect.top % DIFF_TILE_SIZE) == 0);
+        TEST_CHECK((Rect.right % DIFF_TILE_SIZE) == 0 || Rect.right == static_cast<int>(Frame->Width));
+        TEST_CHECK((Rect.bottom % DIFF_TILE_SIZE) == 0 || Rect.bottom == static_cast<int>(Frame->Height));
+
+        for (int y = Rect.top >> DIFF_TILE_SHIFT; y <= (Rect.bottom - 1) >> DIFF_TILE_SHIFT; ++y)
+        {
+            for (int x = Rect.left >> DIFF_TILE_SHIFT; x <= (Rect.right - 1) >> DIFF_TILE_SHIFT; ++x)
+            {
+                TEST_CHECK(!Covered[(y * TilesX) + x]);
+                Covered[(y * TilesX) + x] = 1;
+            }
+        }
+    }
+
+    TEST_CHECK(Covered == Expected);
+}
+
+//
+// Runs Frames frames of scribbles through a differ and checks every set of rects against the reference
+//
+static void RunSequence(FRAMEDIFFER* Differ, unsigned Width, unsigned Height, unsigned Padding, unsigned Frames, unsigned long long Seed)
+{
+    TESTRANDOM Random(Seed);
+    TEST_FRAME Previous;
+    MakeFrame(Width, Height, Padding, &Random, &Previous);
+
+    COMPOSE_RECT* Rects;
+    unsigned Count;
+    TEST_CHECK(Differ->Diff(&Previous.Bytes[0], Width, Height, Previous.Pitch, &Rects, &Count));
+    TEST_CHECK(Count == 1);
+    TEST_CHECK(Rects[0].left == 0 && Rects[0].top == 0 && Rects[0].right == static_cast<int>(Width) && Rects[0].bottom == static_cast<int>(Height));
+
+    std::vector<unsigned char> Expected;
+    for (unsigned Frame = 0; Frame < Frames; ++Frame)
+    {
+        // Some frames change nothing, some only padding and some several places at once
+        TEST_FRAME Next = Previous;
+        unsigned Changes = Random.Below(5);
+        for (unsigned i = 0; i < Changes; ++i)
+        {
+            Scribble(&Next, &Random);
+        }
+
+        ReferenceTiles(&Previous, &Next, &Expected);
+        TEST_CHECK(Differ->Diff(&Next.Bytes[0], Width, Height, Next.Pitch, &Rects, &Count));
+        CheckRects(&Next, Rects, Count, Expected);
+        Previous = Next;
+    }
+}
+
+//
+// Frame sizes on and off tile boundaries, with and without padding past the rows
+//
+static void TestAgainstReference()
+{
+    const unsigned Sizes[][3] = {{1, 1, 0}, {32, 32, 0}, {33, 31, 12}, {100, 70, 0}, {333, 257, 20}, {640, 64, 0}, {7, 300, 4}};
+    for (unsigned i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); ++i)
+    {
+        FRAMEDIFFER Differ;
+        RunSequence(&Differ, Sizes[i][0], Sizes[i][1], Sizes[i][2], 300, 100 + i);
+    }
+}
+
+//
+// Frames big enough to be split across a pool give the same rects as comparing on one thread
+//
+static void TestBanded()
+{
+    BANDPOOL Pool;
+    TEST_CHECK(Pool.Start(3));
+    FRAMEDIFFER Differ;
+    Differ.SetPool(&Pool);
+    RunSequence(&Differ, 2560, 1440, 64, 6, 7);
+    RunSequence(&Differ, 2600, 1500, 0, 6, 8);
+
+    DIFF_STATS Stats;
+    Differ.GetStats(&Stats);
+    TEST_CHECK(Stats.Frames == 14);
+}
+
+//
+// A new size or Reset makes the next frame dirty as a whole, the stats count what was compared
+//
+static void TestResetAndStats()
+{
+    TESTRANDOM Random(3);
+    TEST_FRAME Frame;
+    MakeFrame(100, 50, 0, &Random, &Frame);
+    FRAMEDIFFER Differ;
+    COMPOSE_RECT* Rects;
+    unsigned Count;
+
+    TEST_CHECK(Differ.Diff(&Frame.Bytes[0], 100, 50, Frame.Pitch, &Rects, &Count) && Count == 1);
+    TEST_CHECK(Differ.Diff(&Frame.Bytes[0], 100, 50, Frame.Pitch, &Rects, &Count) && Count == 0 && !Rects);
+    Differ.Reset();
+    TEST_CHECK(Differ.Diff(&Frame.Bytes[0], 100, 50, Frame.Pitch, &Rects, &Count) && Count == 1);
+    TEST_CHECK(Differ.Diff(&Frame.Bytes[0], 50, 100, 50 * COMPOSE_BPP, &Rects, &Count) && Count == 1);
+    TEST_CHECK(Rects[0].right == 50 && Rects[0].bottom == 100);
+    TEST_CHECK(Differ.Diff(nullptr, 50, 100, 50 * COMPOSE_BPP, &Rects, &Count) && Count == 0);
+
+    DIFF_STATS Stats;
+    Differ.GetStats(&Stats);
+    TEST_CHECK(Stats.Frames == 4);
+    TEST_CHECK(Stats.UnchangedFrames == 1);
+    TEST_CHECK(Stats.TilesCompared == (3 * 4 * 2) + (2 * 4));
+    TEST_CHECK(Stats.TilesChanged == (2 * 4 * 2) + (2 * 4));
+    TEST_CHECK(Stats.RectsOut == 3);
+}
+
+int main()
+{
+    TestAgainstReference();
+    TestBanded();
+    TestResetAndStats();
+
+    return TestResult();
+}
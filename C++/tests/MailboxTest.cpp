@@ -0,0 +1,332 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Mailbox.h"
+#include "TestHarness.h"
+#include "TileMap.h"
+
+// Words in every slot of the handoff stress, all carry the sequence number of the frame
+#define STRESS_SLOT_WORDS 64
+
+//
+// The writer and reader never hold the same slot and the three slots are always distinct
+//
+static void TestSlotRules()
+{
+    MAILBOX Mailbox;
+    unsigned Front;
+    TEST_CHECK(!Mailbox.Acquire(&Front));
+    TEST_CHECK(Front != Mailbox.GetWriteSlot());
+
+    // Two publishes before a read drop the first
+    unsigned First = Mailbox.GetWriteSlot();
+    Mailbox.Publish();
+    unsigned Second = Mailbox.GetWriteSlot();
+    TEST_CHECK(Second != First && Second != Front);
+    Mailbox.Publish();
+    TEST_CHECK(Mailbox.GetWriteSlot() == First);
+
+    TEST_CHECK(Mailbox.Acquire(&Front));
+    TEST_CHECK(Front == Second);
+    TEST_CHECK(!Mailbox.Acquire(&Front));
+    TEST_CHECK(Front == Second);
+    TEST_CHECK(Mailbox.GetWriteSlot() != Front);
+
+    MAILBOX_STATS Stats;
+    Mailbox.GetStats(&Stats);
+    TEST_CHECK(Stats.Published == 2);
+    TEST_CHECK(Stats.Dropped == 1);
+    TEST_CHECK(Stats.Consumed == 1);
+    TEST_CHECK(Stats.Reused == 2);
+}
+
+//
+// One writer filling slots with sequence numbers as fast as it can and one reader checking them.
+// Neither side may ever see the other in its slot, frames only move forward and none are torn,
+// and once drained every published frame was either read or dropped.
+//
+static void TestConcurrentHandoff()
+{
+    const unsigned long long Frames = 2000000;
+    MAILBOX Mailbox;
+    static unsigned long long Slots[MAILBOX_SLOTS][STRESS_SLOT_WORDS];
+    std::atomic<int> Owners[MAILBOX_SLOTS];
+    for (unsigned i = 0; i < MAILBOX_SLOTS; ++i)
+    {
+        Owners[i] = 0;
+    }
+    std::atomic<bool> Done(false);
+    std::atomic<unsigned> Shared(0);
+    std::atomic<unsigned> Torn(0);
+    std::atomic<unsigned> Backward(0);
+
+    std::thread Writer([&]
+    {
+        for (unsigned long long Sequence = 1; Sequence <= Frames; ++Sequence)
+        {
+            unsigned Slot = Mailbox.GetWriteSlot();
+            if (Owners[Slot].exchange(1) != 0)
+            {
+                ++Shared;
+            }
+            for (unsigned i = 0; i < STRESS_SLOT_WORDS; ++i)
+            {
+                Slots[Slot][i] = Sequence;
+            }
+            Owners[Slot] = 0;
+            Mailbox.Publish();
+        }
+        Done = true;
+    });
+
+    unsigned long long Last = 0;
+    unsigned long long Reads = 0;
+    auto Read = [&]
+    {
+        unsigned Slot;
+        if (!Mailbox.Acquire(&Slot))
+        {
+            return;
+        }
+        if (Owners[Slot].exchange(2) != 0)
+        {
+            ++Shared;
+        }
+        unsigned long long Sequence = Slots[Slot][0];
+        for (unsigned i = 1; i < STRESS_SLOT_WORDS; ++i)
+        {
+            if (Slots[Slot][i] != Sequence)
+            {
+                ++Torn;
+                break;
+            }
+        }
+        if (Sequence <= Last)
+        {
+            ++Backward;
+        }
+        Last = Sequence;
+        ++Reads;
+        Owners[Slot] = 0;
+
+        // Give the writer time on a single core
+        std::this_thread::yield();
+    };
+
+    while (!Done)
+    {
+        Read();
+    }
+    Writer.join();
+    Read();
+
+    MAILBOX_STATS Stats;
+    Mailbox.GetStats(&Stats);
+    TEST_CHECK(Shared == 0);
+    TEST_CHECK(Torn == 0);
+    TEST_CHECK(Backward == 0);
+    TEST_CHECK(Last == Frames);
+    TEST_CHECK(Reads > 1);
+    TEST_CHECK(Stats.Published == Frames);
+    TEST_CHECK(Stats.Consumed == Reads);
+    TEST_CHECK(Stats.Published == Stats.Consumed + Stats.Dropped);
+}
+
+//
+// CPU stand-in for a surface, one word per pixel
+//
+typedef struct _TEST_SURFACE
+{
+    UINT Width;
+    UINT Height;
+    std::vector<unsigned> Pixels;
+} TEST_SURFACE;
+
+static void CopyBox(_Inout_ TEST_SURFACE* Dest, _In_ const TEST_SURFACE* Src, _In_ const RECT* Box)
+{
+    for (LONG y = Box->top; y < Box->bottom; ++y)
+    {
+        for (LONG x = Box->left; x < Box->right; ++x)
+        {
+            Dest->Pixels[(y * Dest->Width) + x] = Src->Pixels[(y * Src->Width) + x];
+        }
+    }
+}
+
+static unsigned long long Checksum(_In_ const TEST_SURFACE* Surface)
+{
+    unsigned long long Hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < Surface->Pixels.size(); ++i)
+    {
+        Hash = (Hash ^ Surface->Pixels[i]) * 1099511628211ULL;
+    }
+    return Hash;
+}
+
+//
+// What CAPTURETASK::CopyChangedTiles does: every run of changed tiles on the output, moved into surface
+// coordinates. Returns the pixels copied.
+//
+static unsigned long long CopyChangedTiles(_In_ TILEMAP* TileMap, _In_ const RECT* OutputRect, INT SurfaceOffsetX, INT SurfaceOffsetY, LONG Since, _Inout_ TEST_SURFACE* Slot, _In_ const TEST_SURFACE* Surface)
+{
+    unsigned long long Copied = 0;
+    UINT Cursor = 0;
+    RECT Copy;
+    while (TileMap->NextChangedRun(OutputRect, Since, &Cursor, &Copy))
+    {
+        OffsetRect(&Copy, -SurfaceOffsetX, -SurfaceOffsetY);
+        CopyBox(Slot, Surface, &Copy);
+        Copied += (Copy.right - Copy.left) * (Copy.bottom - Copy.top);
+    }
+
+    return Copied;
+}
+
+//
+// Slots brought up to date with only the tiles drawn since each was last published read back exactly
+// the frame that was published into them, while another output stamps its own tiles, some of which
+// straddle the edge of this one, with generations taken out of order with this output's.
+//
+static void TestIncrementalSlots()
+{
+    const unsigned Frames = 5000;
+
+    // The tile map covers two outputs side by side, this one starts off a tile boundary
+    const LONG MapWidth = 700;
+    const LONG MapHeight = 300;
+    const RECT OutputRect = { 300, 10, 700, 290 };
+    const INT SurfaceOffsetX = OutputRect.left;
+    const INT SurfaceOffsetY = OutputRect.top;
+
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(MapWidth, MapHeight) == DUPL_RETURN_SUCCESS);
+
+    TEST_SURFACE Surface;
+    Surface.Width = OutputRect.right - OutputRect.left;
+    Surface.Height = OutputRect.bottom - OutputRect.top;
+    Surface.Pixels.assign(Surface.Width * Surface.Height, 0);
+    TEST_SURFACE Slots[MAILBOX_SLOTS];
+    for (unsigned i = 0; i < MAILBOX_SLOTS; ++i)
+    {
+        Slots[i] = Surface;
+        Slots[i].Pixels.assign(Surface.Pixels.size(), 0xDEADBEEF);
+    }
+    unsigned SlotFrames[MAILBOX_SLOTS] = {};
+    std::vector<unsigned long long> Expected(Frames + 1, 0);
+
+    MAILBOX Mailbox;
+    std::atomic<bool> Done(false);
+    std::atomic<unsigned> Mismatches(0);
+    unsigned long long Copied = 0;
+
+    // The neighbouring output only ever stamps its own side
+    std::thread Neighbour([&]
+    {
+        TESTRANDOM Random(7);
+        while (!Done)
+        {
+            LONG Generation = TileMap.NextGeneration();
+            RECT Dirty;
+            Dirty.left = Random.Below(OutputRect.left);
+            Dirty.top = Random.Below(MapHeight);
+            Dirty.right = Dirty.left + 1 + Random.Below(OutputRect.left - Dirty.left);
+            Dirty.bottom = Dirty.top + 1 + Random.Below(MapHeight - Dirty.top);
+            std::this_thread::yield();
+            TileMap.MarkRects(&Dirty, 1, 0, 0, Generation);
+        }
+    });
+
+    std::thread Writer([&]
+    {
+        TESTRANDOM Random(11);
+        bool SlotFilled[MAILBOX_SLOTS] = {};
+        LONG SlotSince[MAILBOX_SLOTS] = {};
+        for (unsigned Frame = 1; Frame <= Frames; ++Frame)
+        {
+            // Draw a few rects into the private surface, the way DISPLAYMANAGER stamps a frame
+            LONG Generation = TileMap.NextGeneration();
+            unsigned RectCount = 1 + Random.Below(2);
+            for (unsigned r = 0; r < RectCount; ++r)
+            {
+                RECT Dirty;
+                Dirty.left = Random.Below(Surface.Width);
+                Dirty.top = Random.Below(Surface.Height);
+                Dirty.right = Dirty.left + 1 + Random.Below(min(Surface.Width - Dirty.left, 48U));
+                Dirty.bottom = Dirty.top + 1 + Random.Below(min(Surface.Height - Dirty.top, 48U));
+                for (LONG y = Dirty.top; y < Dirty.bottom; ++y)
+                {
+                    for (LONG x = Dirty.left; x < Dirty.right; ++x)
+                    {
+                        Surface.Pixels[(y * Surface.Width) + x] = (Frame * 31) + r;
+                    }
+                }
+                TileMap.MarkRects(&Dirty, 1, SurfaceOffsetX, SurfaceOffsetY, Generation);
+            }
+            Expected[Frame] = Checksum(&Surface);
+
+            // Publish as CAPTURETASK::PublishSlot does
+            unsigned Slot = Mailbox.GetWriteSlot();
+            LONG Published = TileMap.GetGeneration();
+            if (SlotFilled[Slot])
+            {
+                Copied += CopyChangedTiles(&TileMap, &OutputRect, SurfaceOffsetX, SurfaceOffsetY, SlotSince[Slot], &Slots[Slot], &Surface);
+            }
+            else
+            {
+                Slots[Slot].Pixels = Surface.Pixels;
+                Copied += Surface.Pixels.size();
+            }
+            SlotFilled[Slot] = true;
+            SlotSince[Slot] = Published + 1;
+            SlotFrames[Slot] = Frame;
+            Mailbox.Publish();
+        }
+        Done = true;
+    });
+
+    unsigned Reads = 0;
+    auto Read = [&]
+    {
+        unsigned Slot;
+        if (Mailbox.Acquire(&Slot))
+        {
+            if (Checksum(&Slots[Slot]) != Expected[SlotFrames[Slot]])
+            {
+                ++Mismatches;
+            }
+            ++Reads;
+        }
+        std::this_thread::yield();
+    };
+
+    while (!Done)
+    {
+        Read();
+    }
+    Writer.join();
+    Neighbour.join();
+    Read();
+
+    TEST_CHECK(Mismatches == 0);
+    TEST_CHECK(Reads > 0);
+
+    // How much is saved depends on how often the reader got in between publishes, so it is only reported
+    printf("incremental publish copied %.1f%% of the pixels a full copy would\n", (100.0 * Copied) / (static_cast<double>(Frames) * Surface.Pixels.size()));
+}
+
+int main()
+{
+    TestSlotRules();
+    TestConcurrentHandoff();
+    TestIncrementalSlots();
+
+    return TestResult();
+}
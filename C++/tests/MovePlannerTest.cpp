@@ -0,0 +1,224 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "MovePlanner.h"
+#include "TestHarness.h"
+
+// Pixels along each side, the surface starts at (-SURFACE_ORIGIN, -SURFACE_ORIGIN) so moves can go off the top left
+#define SURFACE_SIZE   800
+#define SURFACE_ORIGIN 160
+
+//
+// Surface of pixel ids, every pixel starts out holding its own position
+//
+class SURFACE
+{
+    public:
+        SURFACE() : m_Pixels(SURFACE_SIZE * SURFACE_SIZE)
+        {
+            for (unsigned i = 0; i < m_Pixels.size(); ++i)
+            {
+                m_Pixels[i] = i;
+            }
+        }
+
+        unsigned& At(LONG X, LONG Y)
+        {
+            return m_Pixels[((Y + SURFACE_ORIGIN) * SURFACE_SIZE) + X + SURFACE_ORIGIN];
+        }
+
+        bool operator==(const SURFACE& Other) const
+        {
+            return m_Pixels == Other.m_Pixels;
+        }
+
+        // What a copy through the staging surface does, and what the move should end up as
+        void Move(const RECT& Src, POINT Dest)
+        {
+            std::vector<unsigned> Staging;
+            for (LONG y = Src.top; y < Src.bottom; ++y)
+            {
+                for (LONG x = Src.left; x < Src.right; ++x)
+                {
+                    Staging.push_back(At(x, y));
+                }
+            }
+
+            unsigned Next = 0;
+            for (LONG y = Src.top; y < Src.bottom; ++y)
+            {
+                for (LONG x = Src.left; x < Src.right; ++x)
+                {
+                    At(Dest.x + (x - Src.left), Dest.y + (y - Src.top)) = Staging[Next++];
+                }
+            }
+        }
+
+    private:
+        std::vector<unsigned> m_Pixels;
+};
+
+static bool Overlaps(const RECT& Src, POINT Dest)
+{
+    LONG Width = Src.right - Src.left;
+    LONG Height = Src.bottom - Src.top;
+
+    return Dest.x < Src.right && Dest.x + Width > Src.left && Dest.y < Src.bottom && Dest.y + Height > Src.top;
+}
+
+//
+// Plans the move of Src by (Dx, Dy), runs the steps in order and checks they give the same surface as an ideal move.
+// A direct copy must never overlap itself since CopySubresourceRegion leaves that undefined.
+//
+static UINT CheckMove(MOVEPLANNER* Planner, RECT Src, LONG Dx, LONG Dy, bool ExpectStaged)
+{
+    RECT Dest = {Src.left + Dx, Src.top + Dy, Src.right + Dx, Src.bottom + Dy};
+    MOVE_STEP Steps[MOVE_PLAN_MAX_STEPS];
+    UINT StepCount = Planner->PlanMove(&Src, &Dest, Steps);
+    TEST_CHECK(StepCount <= MOVE_PLAN_MAX_STEPS);
+
+    SURFACE Planned;
+    bool Staged = false;
+    for (UINT i = 0; i < StepCount; ++i)
+    {
+        if (Steps[i].Staged)
+        {
+            Staged = true;
+        }
+        else
+        {
+            TEST_CHECK(!Overlaps(Steps[i].Src, Steps[i].Dest));
+        }
+        Planned.Move(Steps[i].Src, Steps[i].Dest);
+    }
+
+    SURFACE Expected;
+    if (Dx || Dy)
+    {
+        POINT Target = {Dest.left, Dest.top};
+        Expected.Move(Src, Target);
+    }
+
+    TEST_CHECK(Planned == Expected);
+    TEST_CHECK(Staged == ExpectStaged);
+
+    return StepCount;
+}
+
+//
+// Scrolling text up and down by a line or a page, the common case, needs no staging
+//
+static void TestVerticalScroll()
+{
+    MOVEPLANNER Planner;
+    RECT View = {8, 16, 248, 240};
+
+    TEST_CHECK(CheckMove(&Planner, View, 0, -16, false) == 14);
+    TEST_CHECK(CheckMove(&Planner, View, 0, 16, false) == 14);
+    TEST_CHECK(CheckMove(&Planner, View, 0, -100, false) == 3);
+    TEST_CHECK(CheckMove(&Planner, View, 0, 100, false) == 3);
+
+    // Scrolled further than the view is tall, source and destination don't meet
+    RECT Small = {0, 0, 64, 64};
+    TEST_CHECK(CheckMove(&Planner, Small, 0, 64, false) == 1);
+    TEST_CHECK(CheckMove(&Planner, Small, 100, 100, false) == 1);
+}
+
+static void TestHorizontalAndDiagonal()
+{
+    MOVEPLANNER Planner;
+    RECT View = {16, 16, 240, 240};
+
+    TEST_CHECK(CheckMove(&Planner, View, -32, 0, false) == 7);
+    TEST_CHECK(CheckMove(&Planner, View, 32, 0, false) == 7);
+
+    // Bands go along whichever axis needs fewer of them
+    TEST_CHECK(CheckMove(&Planner, View, 8, -14, false) == 16);
+    TEST_CHECK(CheckMove(&Planner, View, -14, 8, false) == 16);
+    CheckMove(&Planner, View, 9, 11, false);
+    CheckMove(&Planner, View, -11, -9, false);
+}
+
+//
+// Single pixel scrolls would take a band per row, past the limit they go through the staging surface
+//
+static void TestStagedFallback()
+{
+    MOVEPLANNER Planner;
+    RECT View = {0, 0, 200, 200};
+
+    TEST_CHECK(CheckMove(&Planner, View, 0, -1, true) == 1);
+    TEST_CHECK(CheckMove(&Planner, View, 3, 2, true) == 1);
+
+    Planner.SetMaxBands(1);
+    TEST_CHECK(CheckMove(&Planner, View, 0, -150, true) == 1);
+    TEST_CHECK(CheckMove(&Planner, View, 0, 200, false) == 1);
+
+    MOVE_PLAN_STATS Stats;
+    Planner.GetStats(&Stats);
+    TEST_CHECK(Stats.StagedMoves == 3);
+    TEST_CHECK(Stats.DirectMoves == 1);
+    TEST_CHECK(Stats.BandedMoves == 0);
+    TEST_CHECK(Stats.Steps == 4);
+}
+
+static void TestNothingToMove()
+{
+    MOVEPLANNER Planner;
+    RECT View = {10, 10, 50, 50};
+    RECT Empty = {10, 10, 10, 50};
+
+    TEST_CHECK(CheckMove(&Planner, View, 0, 0, false) == 0);
+    TEST_CHECK(CheckMove(&Planner, Empty, 0, 5, false) == 0);
+}
+
+//
+// Every scroll distance in both directions of both axes, and random diagonal ones
+//
+static void TestAllScrollDistances()
+{
+    MOVEPLANNER Planner;
+    RECT View = {224, 224, 416, 416};
+    LONG Size = View.bottom - View.top;
+
+    for (LONG Distance = 1; Distance <= Size; ++Distance)
+    {
+        bool Staged = static_cast<UINT>((Size + Distance - 1) / Distance) > MOVE_PLAN_MAX_STEPS;
+        if (Distance >= Size)
+        {
+            Staged = false;
+        }
+        CheckMove(&Planner, View, 0, Distance, Staged);
+        CheckMove(&Planner, View, 0, -Distance, Staged);
+        CheckMove(&Planner, View, Distance, 0, Staged);
+        CheckMove(&Planner, View, -Distance, 0, Staged);
+    }
+
+    TESTRANDOM Random(4);
+    for (unsigned i = 0; i < 300; ++i)
+    {
+        LONG Dx = static_cast<LONG>(Random.Below(64)) - 32;
+        LONG Dy = static_cast<LONG>(Random.Below(64)) - 32;
+        MOVE_STEP Steps[MOVE_PLAN_MAX_STEPS];
+        RECT Dest = {View.left + Dx, View.top + Dy, View.right + Dx, View.bottom + Dy};
+        bool Staged = Planner.PlanMove(&View, &Dest, Steps) == 1 && Steps[0].Staged;
+        CheckMove(&Planner, View, Dx, Dy, Staged);
+    }
+}
+
+int main()
+{
+    TestVerticalScroll();
+    TestHorizontalAndDiagonal();
+    TestStagedFallback();
+    TestNothingToMove();
+    TestAllScrollDistances();
+
+    return TestResult();
+}
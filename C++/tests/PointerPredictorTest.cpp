@@ -0,0 +1,328 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <cmath>
+#include <cstdio>
+
+#include "PointerPredictor.h"
+#include "TestHarness.h"
+
+// Pointer positions reach the desktop at about this rate, give or take the jitter
+#define TRACE_SAMPLE_HZ 60.0
+#define TRACE_SAMPLE_JITTER 0.002
+
+// Frames are rendered at this rate, each sees the newest sample published this long before it starts
+#define TRACE_FRAME_HZ 90.0
+#define TRACE_CAPTURE_LATENCY 0.004
+
+// How far ahead of the frame start the pointer is predicted, as PredictPointer does
+#define TRACE_DISPLAY_LEAD 0.016
+
+#define TEST_PI 3.14159265358979323846
+
+//
+// Where the hand really put the pointer at a time, in pixels
+//
+typedef void (*TRACE_PROC)(double Time, double* X, double* Y);
+
+// A steady diagonal sweep at 1500 pixels per second
+static void TraceLine(double Time, double* X, double* Y)
+{
+    *X = 100.0 + (1200.0 * Time);
+    *Y = 100.0 + (900.0 * Time);
+}
+
+// Circling with a radius of 300 pixels once every 1.2 seconds
+static void TraceCircle(double Time, double* X, double* Y)
+{
+    double Angle = 2.0 * TEST_PI * Time / 1.2;
+    *X = 960.0 + (300.0 * std::cos(Angle));
+    *Y = 540.0 + (300.0 * std::sin(Angle));
+}
+
+// A reach of 800 by 300 pixels over 0.4 seconds with the smooth speed profile of a hand, then resting
+static void TraceReach(double Time, double* X, double* Y)
+{
+    double T = (Time < 0.4) ? (Time / 0.4) : 1.0;
+    double S = (T * T * T) * (10.0 - (15.0 * T) + (6.0 * T * T));
+    *X = 200.0 + (800.0 * S);
+    *Y = 700.0 - (300.0 * S);
+}
+
+//
+// What a trace replay measured, distances are in pixels between the drawn and the real pointer when the frame is shown
+//
+typedef struct _REPLAY_RESULT
+{
+    unsigned Frames;
+    double PredictedErrorSum;
+    double HeldErrorSum;
+
+    // Furthest the drawn pointer got past the resting position and the first frame time it was drawn right on it
+    double RestOvershoot;
+    double RestSettledTime;
+} REPLAY_RESULT;
+
+//
+// Replays Duration seconds of a trace the way OutputManager sees it: positions rounded to whole pixels, only
+// reported when they change, and each frame handing the newest published one to AddSample before predicting
+// where the pointer is once the frame is on screen
+//
+static void Replay(TRACE_PROC Trace, double Duration, POINTERPREDICTOR* Predictor, REPLAY_RESULT* Result, double RestTime, unsigned long long Seed)
+{
+    TESTRANDOM Random(Seed);
+    memset(Result, 0, sizeof(*Result));
+    Result->RestSettledTime = -1.0;
+
+    double RestX;
+    double RestY;
+    Trace(Duration, &RestX, &RestY);
+
+    double SampleTime = 0.0;
+    double SampleX = -1.0;
+    double SampleY = -1.0;
+    double PublishedTime = -1.0;
+    double PublishedX = 0.0;
+    double PublishedY = 0.0;
+    for (double FrameTime = 0.0; FrameTime < Duration; FrameTime += 1.0 / TRACE_FRAME_HZ)
+    {
+        // Everything sampled before the capture latency is published by now, the newest one wins
+        while (SampleTime <= FrameTime - TRACE_CAPTURE_LATENCY)
+        {
+            double X;
+            double Y;
+            Trace(SampleTime, &X, &Y);
+            X = std::floor(X + 0.5);
+            Y = std::floor(Y + 0.5);
+            if (X != SampleX || Y != SampleY)
+            {
+                SampleX = X;
+                SampleY = Y;
+                PublishedTime = SampleTime;
+                PublishedX = X;
+                PublishedY = Y;
+            }
+            SampleTime += (1.0 / TRACE_SAMPLE_HZ) + (TRACE_SAMPLE_JITTER * ((2.0 * Random.Unit()) - 1.0));
+        }
+        if (PublishedTime < 0.0)
+        {
+            continue;
+        }
+
+        Predictor->AddSample(PublishedTime, PublishedX, PublishedY);
+        double X;
+        double Y;
+        TEST_CHECK(Predictor->Predict(FrameTime + TRACE_DISPLAY_LEAD, &X, &Y));
+
+        double TrueX;
+        double TrueY;
+        Trace(FrameTime + TRACE_DISPLAY_LEAD, &TrueX, &TrueY);
+        ++Result->Frames;
+        Result->PredictedErrorSum += std::sqrt(((X - TrueX) * (X - TrueX)) + ((Y - TrueY) * (Y - TrueY)));
+        Result->HeldErrorSum += std::sqrt(((PublishedX - TrueX) * (PublishedX - TrueX)) + ((PublishedY - TrueY) * (PublishedY - TrueY)));
+
+        if (FrameTime + TRACE_DISPLAY_LEAD >= RestTime)
+        {
+            double Overshoot = std::sqrt(((X - RestX) * (X - RestX)) + ((Y - RestY) * (Y - RestY)));
+            if (Overshoot > Result->RestOvershoot)
+            {
+                Result->RestOvershoot = Overshoot;
+            }
+            if (Result->RestSettledTime < 0.0 && X == RestX && Y == RestY)
+            {
+                Result->RestSettledTime = FrameTime + TRACE_DISPLAY_LEAD;
+            }
+            else if (X != RestX || Y != RestY)
+            {
+                Result->RestSettledTime = -1.0;
+            }
+        }
+    }
+}
+
+//
+// While the pointer moves, drawing the prediction is closer to where it really is than drawing the newest
+// sample, both for the frames shown and for the samples the predictor scores itself against. The frames gain
+// less as a sample is usually older than the horizon by the time its frame is shown.
+//
+static void TestMovingTraces()
+{
+    const TRACE_PROC Traces[] = {TraceLine, TraceCircle};
+    const char* Names[] = {"line", "circle"};
+    for (unsigned i = 0; i < sizeof(Traces) / sizeof(Traces[0]); ++i)
+    {
+        POINTERPREDICTOR Predictor;
+        REPLAY_RESULT Result;
+        Replay(Traces[i], 1.0, &Predictor, &Result, 2.0, 10 + i);
+
+        PREDICT_STATS Stats;
+        Predictor.GetStats(&Stats);
+        printf("%-6s frames %u  shown error %.1f px, %.1f px held  scored %llu of %llu samples, error %.1f px, %.1f px held, max %.1f px\n",
+               Names[i], Result.Frames, Result.PredictedErrorSum / Result.Frames, Result.HeldErrorSum / Result.Frames,
+               Stats.Scored, Stats.Samples, Stats.ErrorSum / Stats.Scored, Stats.HoldErrorSum / Stats.Scored, Stats.MaxError);
+
+        TEST_CHECK(Result.Frames > 80);
+        TEST_CHECK(Result.PredictedErrorSum < 0.7 * Result.HeldErrorSum);
+
+        // Every sample after the first is scored as nothing stops for long enough to reset
+        TEST_CHECK(Stats.Samples > 50);
+        TEST_CHECK(Stats.Scored == Stats.Samples - 1);
+        TEST_CHECK(Stats.ErrorSum < 0.5 * Stats.HoldErrorSum);
+        TEST_CHECK(std::sqrt(Stats.ErrorSquaredSum / Stats.Scored) <= Stats.MaxError);
+    }
+}
+
+//
+// When the hand stops the prediction may run past the resting point by no more than the fastest speed of the
+// reach times the horizon, and is drawn exactly on it from the stop time after the last sample onwards
+//
+static void TestReachThenStop()
+{
+    PREDICT_OPTIONS Options;
+    POINTERPREDICTOR::GetDefaultOptions(&Options);
+
+    POINTERPREDICTOR Predictor;
+    REPLAY_RESULT Result;
+    Replay(TraceReach, 0.8, &Predictor, &Result, 0.4, 20);
+
+    // Peak speed of the smooth reach is 1.875 times its average
+    double PeakSpeed = 1.875 * std::sqrt((800.0 * 800.0) + (300.0 * 300.0)) / 0.4;
+    printf("reach  frames %u  shown error %.1f px, %.1f px held  overshoot %.1f px  settled at %.3f s\n",
+           Result.Frames, Result.PredictedErrorSum / Result.Frames, Result.HeldErrorSum / Result.Frames,
+           Result.RestOvershoot, Result.RestSettledTime);
+
+    TEST_CHECK(Result.PredictedErrorSum < Result.HeldErrorSum);
+    TEST_CHECK(Result.RestOvershoot <= (PeakSpeed * Options.MaxHorizon) + 1.0);
+    TEST_CHECK(Result.RestSettledTime > 0.0);
+    TEST_CHECK(Result.RestSettledTime <= 0.4 + Options.StopTime + TRACE_DISPLAY_LEAD + (1.0 / TRACE_FRAME_HZ));
+}
+
+//
+// The prediction reaches at most MaxHorizon past the newest sample, shrinks steadily once the sample is older than
+// FadeTime and is the sample itself from StopTime on
+//
+static void TestHorizonAndFade()
+{
+    PREDICT_OPTIONS Options;
+    POINTERPREDICTOR::GetDefaultOptions(&Options);
+    POINTERPREDICTOR Predictor;
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        TEST_CHECK(Predictor.AddSample(i * 0.01, i * 10.0, 0.0));
+    }
+
+    // 1000 pixels per second from the sample at 40ms and 40 pixels
+    double X;
+    double Y;
+    double Previous = 40.0;
+    for (double Age = 0.001; Age < 0.08; Age += 0.001)
+    {
+        TEST_CHECK(Predictor.Predict(0.04 + Age, &X, &Y));
+        TEST_CHECK(Y == 0.0);
+        TEST_CHECK(X >= 40.0 && X <= 40.0 + (1000.0 * Options.MaxHorizon) + 1e-9);
+        if (Age <= Options.MaxHorizon)
+        {
+            TEST_CHECK(std::fabs(X - (40.0 + (1000.0 * Age))) < 1e-6);
+        }
+        else if (Age > Options.FadeTime && Age < Options.StopTime)
+        {
+            TEST_CHECK(X < Previous);
+        }
+        if (Age >= Options.StopTime)
+        {
+            TEST_CHECK(X == 40.0);
+        }
+
+        // Never a jump of more than the fade rate allows in a millisecond
+        TEST_CHECK(std::fabs(X - Previous) <= (1000.0 * Options.MaxHorizon * 0.001 / (Options.StopTime - Options.FadeTime)) + 1.0 + 1e-9);
+        Previous = X;
+    }
+}
+
+//
+// Aggressiveness scales the extrapolation, MaxSpeed bounds the velocity
+//
+static void TestOptions()
+{
+    PREDICT_OPTIONS Options;
+    POINTERPREDICTOR::GetDefaultOptions(&Options);
+    double X;
+    double Y;
+
+    POINTERPREDICTOR Still;
+    Options.Aggressiveness = 0.0;
+    Still.SetOptions(&Options);
+    Still.AddSample(0.0, 0.0, 0.0);
+    Still.AddSample(0.01, 10.0, 20.0);
+    TEST_CHECK(Still.Predict(0.02, &X, &Y) && X == 10.0 && Y == 20.0);
+
+    POINTERPREDICTOR Half;
+    Options.Aggressiveness = 0.5;
+    Half.SetOptions(&Options);
+    Half.AddSample(0.0, 0.0, 0.0);
+    Half.AddSample(0.01, 10.0, 0.0);
+    TEST_CHECK(Half.Predict(0.02, &X, &Y) && std::fabs(X - 15.0) < 1e-9);
+
+    // 20000 pixels per second is flung far beyond the speed limit
+    POINTERPREDICTOR Fast;
+    Options.Aggressiveness = 1.0;
+    Fast.SetOptions(&Options);
+    Fast.AddSample(0.0, 0.0, 0.0);
+    Fast.AddSample(0.01, 0.0, 200.0);
+    TEST_CHECK(Fast.Predict(0.01 + Options.MaxHorizon, &X, &Y));
+    TEST_CHECK(std::fabs(Y - (200.0 + (Options.MaxSpeed * Options.MaxHorizon))) < 1e-6);
+}
+
+//
+// Old samples are ignored, a gap past the stop time starts over without scoring and Reset keeps the stats
+//
+static void TestSamplesAndStats()
+{
+    POINTERPREDICTOR Predictor;
+    double X;
+    double Y;
+    TEST_CHECK(!Predictor.Predict(1.0, &X, &Y) && X == 0.0 && Y == 0.0);
+
+    TEST_CHECK(Predictor.AddSample(1.0, 0.0, 0.0));
+    TEST_CHECK(Predictor.AddSample(1.01, 10.0, 0.0));
+    TEST_CHECK(!Predictor.AddSample(1.01, 50.0, 0.0));
+    TEST_CHECK(!Predictor.AddSample(0.5, 50.0, 0.0));
+    TEST_CHECK(Predictor.AddSample(1.02, 20.0, 0.0));
+
+    PREDICT_STATS Stats;
+    Predictor.GetStats(&Stats);
+    TEST_CHECK(Stats.Samples == 3 && Stats.Scored == 2);
+
+    // The sample at 1.02 was predicted exactly from the two before, holding would have been 10 pixels off
+    TEST_CHECK(std::fabs(Stats.HoldErrorSum - 20.0) < 1e-9);
+    TEST_CHECK(Stats.ErrorSum < Stats.HoldErrorSum);
+
+    // Moving off again after a rest, the first sample has no velocity to go on
+    TEST_CHECK(Predictor.AddSample(1.5, 100.0, 100.0));
+    TEST_CHECK(Predictor.Predict(1.51, &X, &Y) && X == 100.0 && Y == 100.0);
+    Predictor.GetStats(&Stats);
+    TEST_CHECK(Stats.Samples == 4 && Stats.Scored == 2);
+
+    Predictor.Reset();
+    TEST_CHECK(!Predictor.Predict(1.51, &X, &Y));
+    Predictor.GetStats(&Stats);
+    TEST_CHECK(Stats.Samples == 4);
+    Predictor.ResetStats();
+    Predictor.GetStats(&Stats);
+    TEST_CHECK(Stats.Samples == 0 && Stats.Scored == 0 && Stats.ErrorSum == 0.0);
+}
+
+int main()
+{
+    TestMovingTraces();
+    TestReachThenStop();
+    TestHorizonAndFade();
+    TestOptions();
+    TestSamplesAndStats();
+
+    return TestResult();
+}
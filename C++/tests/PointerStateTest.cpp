@@ -0,0 +1,252 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "PointerState.h"
+#include "TestHarness.h"
+
+// Capture threads publishing at once in the stress test, one per output
+#define STRESS_WRITERS 3
+
+// Render threads reading at once in the stress test, the application has one but more shake out more interleavings
+#define STRESS_READERS 2
+
+// Positions and shapes every writer publishes
+#define STRESS_PUBLISHES 500000
+
+// Largest shape the stress writers publish, well under a slot so the test stays quick
+#define STRESS_MAX_SHAPE (16 * 1024)
+
+static LARGE_INTEGER Time(LONGLONG Ticks)
+{
+    LARGE_INTEGER TimeStamp;
+    TimeStamp.QuadPart = Ticks;
+
+    return TimeStamp;
+}
+
+static void FreePtrInfo(PTR_INFO* PtrInfo)
+{
+    delete [] PtrInfo->PtrShapeBuffer;
+    RtlZeroMemory(PtrInfo, sizeof(PTR_INFO));
+}
+
+//
+// The rules that decide between outputs: an invisible report only counts from the output that last showed
+// the pointer, and between two visible reports from different outputs the newer one wins
+//
+static void TestPositionRules()
+{
+    POINTERSTATE State;
+    TEST_CHECK(State.Init() == DUPL_RETURN_SUCCESS);
+    PTR_INFO PtrInfo;
+    RtlZeroMemory(&PtrInfo, sizeof(PtrInfo));
+
+    State.PublishPosition(1, {100, 200}, true, Time(10));
+    TEST_CHECK(State.Read(&PtrInfo) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(PtrInfo.Position.x == 100 && PtrInfo.Position.y == 200 && PtrInfo.Visible && PtrInfo.WhoUpdatedPositionLast == 1);
+
+    // Output 0 doesn't have the pointer, that doesn't hide it on output 1
+    State.PublishPosition(0, {0, 0}, false, Time(20));
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.Visible && PtrInfo.Position.x == 100 && PtrInfo.WhoUpdatedPositionLast == 1);
+
+    // A late visible report from another output loses, a newer one wins
+    State.PublishPosition(2, {5, 5}, true, Time(5));
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.WhoUpdatedPositionLast == 1);
+    State.PublishPosition(2, {5, 5}, true, Time(30));
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.WhoUpdatedPositionLast == 2 && PtrInfo.Position.x == 5 && PtrInfo.LastTimeStamp.QuadPart == 30);
+
+    // The output that has it can always hide it
+    State.PublishPosition(2, {6, 6}, false, Time(1));
+    State.Read(&PtrInfo);
+    TEST_CHECK(!PtrInfo.Visible && PtrInfo.Position.x == 6);
+
+    State.Reset();
+    State.Read(&PtrInfo);
+    TEST_CHECK(!PtrInfo.Visible && PtrInfo.Position.x == 0 && PtrInfo.LastTimeStamp.QuadPart == 0);
+
+    FreePtrInfo(&PtrInfo);
+}
+
+//
+// Shapes reach the reader whole, are copied only when they change and oversized ones are dropped
+//
+static void TestShapes()
+{
+    POINTERSTATE State;
+    TEST_CHECK(State.Init() == DUPL_RETURN_SUCCESS);
+    PTR_INFO PtrInfo;
+    RtlZeroMemory(&PtrInfo, sizeof(PtrInfo));
+
+    std::vector<BYTE> Shape(32 * 32 * BPP, 0x5A);
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    RtlZeroMemory(&ShapeInfo, sizeof(ShapeInfo));
+    ShapeInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR;
+    ShapeInfo.Width = 32;
+    ShapeInfo.Height = 32;
+    ShapeInfo.Pitch = 32 * BPP;
+    State.PublishShape(&ShapeInfo, Shape.data(), static_cast<UINT>(Shape.size()), 7);
+
+    TEST_CHECK(State.Read(&PtrInfo) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(PtrInfo.ShapeHash == 7 && PtrInfo.ShapeInfo.Width == 32);
+    TEST_CHECK(PtrInfo.BufferSize >= Shape.size() && !memcmp(PtrInfo.PtrShapeBuffer, Shape.data(), Shape.size()));
+
+    // Same shape again, the reader's copy is left alone
+    PtrInfo.PtrShapeBuffer[0] = 0;
+    State.PublishShape(&ShapeInfo, Shape.data(), static_cast<UINT>(Shape.size()), 7);
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.PtrShapeBuffer[0] == 0);
+
+    std::vector<BYTE> TooBig(POINTER_SHAPE_MAX_BYTES + 1, 1);
+    State.PublishShape(&ShapeInfo, TooBig.data(), static_cast<UINT>(TooBig.size()), 8);
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.ShapeHash == 7);
+
+    FreePtrInfo(&PtrInfo);
+}
+
+//
+// Writer Output publishes shape and position number Index, everything a reader sees can be derived from Value
+//
+static UINT64 StressValue(UINT Output, UINT Index)
+{
+    return (static_cast<UINT64>(Index) * STRESS_WRITERS) + Output + 1;
+}
+
+static UINT StressShapeSize(UINT64 Value)
+{
+    return 1 + static_cast<UINT>((Value * 7919) % STRESS_MAX_SHAPE);
+}
+
+//
+// Several capture threads publish while readers copy, a torn position or shape would break the relations
+// every publish keeps between its fields and bytes
+//
+static void TestConcurrentPublishAndRead()
+{
+    POINTERSTATE State;
+    TEST_CHECK(State.Init() == DUPL_RETURN_SUCCESS);
+
+    std::atomic<UINT> WritersLeft(STRESS_WRITERS);
+    std::atomic<UINT64> Torn(0);
+    std::atomic<UINT64> ShapesSeen(0);
+    std::vector<std::thread> Threads;
+
+    for (UINT Output = 0; Output < STRESS_WRITERS; ++Output)
+    {
+        Threads.emplace_back([&State, &WritersLeft, Output]() {
+            std::vector<BYTE> Shape(STRESS_MAX_SHAPE);
+            for (UINT Index = 0; Index < STRESS_PUBLISHES; ++Index)
+            {
+                UINT64 Value = StressValue(Output, Index);
+                UINT Size = StressShapeSize(Value);
+                memset(Shape.data(), static_cast<BYTE>(Value), Size);
+
+                DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+                RtlZeroMemory(&ShapeInfo, sizeof(ShapeInfo));
+                ShapeInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR;
+                ShapeInfo.Width = static_cast<UINT>(Value);
+                ShapeInfo.Height = Size;
+                State.PublishShape(&ShapeInfo, Shape.data(), Size, Value);
+
+                POINT Position = {static_cast<LONG>(Value), static_cast<LONG>(Value)};
+                State.PublishPosition(Output, Position, true, Time(Value));
+            }
+            --WritersLeft;
+        });
+    }
+
+    for (UINT Reader = 0; Reader < STRESS_READERS; ++Reader)
+    {
+        Threads.emplace_back([&State, &WritersLeft, &Torn, &ShapesSeen]() {
+            PTR_INFO PtrInfo;
+            RtlZeroMemory(&PtrInfo, sizeof(PtrInfo));
+            UINT64 LastHash = 0;
+            UINT64 LocalTorn = 0;
+            UINT64 LocalShapes = 0;
+
+            while (WritersLeft)
+            {
+                if (State.Read(&PtrInfo) != DUPL_RETURN_SUCCESS)
+                {
+                    ++LocalTorn;
+                    break;
+                }
+
+                if (PtrInfo.Visible)
+                {
+                    LONG Value = PtrInfo.Position.x;
+                    if (PtrInfo.Position.y != Value || PtrInfo.LastTimeStamp.QuadPart != Value ||
+                        PtrInfo.WhoUpdatedPositionLast != static_cast<UINT>((Value - 1) % STRESS_WRITERS))
+                    {
+                        ++LocalTorn;
+                    }
+                }
+
+                if (PtrInfo.ShapeHash && PtrInfo.ShapeHash != LastHash)
+                {
+                    LastHash = PtrInfo.ShapeHash;
+                    ++LocalShapes;
+
+                    UINT Size = StressShapeSize(PtrInfo.ShapeHash);
+                    if (PtrInfo.ShapeInfo.Width != static_cast<UINT>(PtrInfo.ShapeHash) || PtrInfo.ShapeInfo.Height != Size)
+                    {
+                        ++LocalTorn;
+                        continue;
+                    }
+                    BYTE Expected = static_cast<BYTE>(PtrInfo.ShapeHash);
+                    for (UINT i = 0; i < Size; ++i)
+                    {
+                        if (PtrInfo.PtrShapeBuffer[i] != Expected)
+                        {
+                            ++LocalTorn;
+                            break;
+                        }
+                    }
+                }
+
+                // With fewer cores than threads the writers then only stop where their time slice runs out, often mid publish
+                std::this_thread::yield();
+            }
+
+            Torn += LocalTorn;
+            ShapesSeen += LocalShapes;
+            FreePtrInfo(&PtrInfo);
+        });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    TEST_CHECK(Torn == 0);
+    TEST_CHECK(ShapesSeen > 0);
+
+    // Once everyone is done the last publish of some writer is what a reader gets
+    PTR_INFO PtrInfo;
+    RtlZeroMemory(&PtrInfo, sizeof(PtrInfo));
+    State.Read(&PtrInfo);
+    TEST_CHECK(PtrInfo.Visible && PtrInfo.Position.x >= static_cast<LONG>(StressValue(0, STRESS_PUBLISHES - 1)));
+    TEST_CHECK(PtrInfo.ShapeHash >= StressValue(0, STRESS_PUBLISHES - 1));
+    FreePtrInfo(&PtrInfo);
+}
+
+int main()
+{
+    TestPositionRules();
+    TestShapes();
+    TestConcurrentPublishAndRead();
+
+    return TestResult();
+}
@@ -0,0 +1,220 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "RectCoalescer.h"
+#include "TestHarness.h"
+
+#define FRAME_WIDTH  1920
+#define FRAME_HEIGHT 1080
+
+//
+// True when every pixel of In that lies inside the frame is also covered by Out
+//
+static bool Covers(const std::vector<RECT>& In, const RECT* Out, UINT OutCount)
+{
+    std::vector<unsigned char> Covered(FRAME_WIDTH * FRAME_HEIGHT, 0);
+    for (UINT i = 0; i < OutCount; ++i)
+    {
+        for (LONG y = Out[i].top; y < Out[i].bottom; ++y)
+        {
+            memset(&Covered[(y * FRAME_WIDTH) + Out[i].left], 1, Out[i].right - Out[i].left);
+        }
+    }
+
+    for (const RECT& Rect : In)
+    {
+        for (LONG y = max(Rect.top, 0); y < min(Rect.bottom, FRAME_HEIGHT); ++y)
+        {
+            for (LONG x = max(Rect.left, 0); x < min(Rect.right, FRAME_WIDTH); ++x)
+            {
+                if (!Covered[(y * FRAME_WIDTH) + x])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool InsideFrame(const RECT* Rects, UINT Count)
+{
+    for (UINT i = 0; i < Count; ++i)
+    {
+        if (Rects[i].left < 0 || Rects[i].top < 0 || Rects[i].right > FRAME_WIDTH || Rects[i].bottom > FRAME_HEIGHT ||
+            Rects[i].left >= Rects[i].right || Rects[i].top >= Rects[i].bottom)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// A typing burst, one small rect per glyph along a few lines, ends up as one rect per line
+//
+static void TestTypingBurst(CAPTUREARENA* Arena)
+{
+    RECTCOALESCER Coalescer;
+    Coalescer.SetArena(Arena);
+
+    std::vector<RECT> In;
+    for (LONG Line = 0; Line < 3; ++Line)
+    {
+        for (LONG Glyph = 0; Glyph < 100; ++Glyph)
+        {
+            RECT Rect = {100 + (Glyph * 8), 200 + (Line * 40), 108 + (Glyph * 8), 216 + (Line * 40)};
+            In.push_back(Rect);
+        }
+    }
+
+    RECT* Out;
+    UINT OutCount;
+    TEST_CHECK(Coalescer.Coalesce(In.data(), static_cast<UINT>(In.size()), FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount >= 1 && OutCount <= 3);
+    TEST_CHECK(Covers(In, Out, OutCount));
+
+    COALESCE_STATS Stats;
+    Coalescer.GetStats(&Stats);
+    TEST_CHECK(Stats.Frames == 1);
+    TEST_CHECK(Stats.RectsIn == In.size());
+    TEST_CHECK(Stats.RectsOut == OutCount);
+    TEST_CHECK(Stats.FullCopies == 0);
+    TEST_CHECK(Stats.PixelsIn == 300 * 8 * 16);
+    TEST_CHECK(Stats.PixelsOut == Stats.PixelsIn + Stats.PixelsOverCopied);
+}
+
+//
+// Rects far apart would waste more than they save, so they stay separate
+//
+static void TestDistantRects(CAPTUREARENA* Arena)
+{
+    RECTCOALESCER Coalescer;
+    Coalescer.SetArena(Arena);
+
+    RECT In[2] = {{0, 0, 10, 10}, {1000, 1000, 1010, 1010}};
+    RECT* Out;
+    UINT OutCount;
+    TEST_CHECK(Coalescer.Coalesce(In, 2, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 2);
+
+    // With no extra pixels allowed only exactly touching rects merge
+    Coalescer.SetRectCost(0);
+    RECT Touching[2] = {{0, 0, 10, 10}, {10, 0, 20, 10}};
+    TEST_CHECK(Coalescer.Coalesce(Touching, 2, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 1);
+    TEST_CHECK(Out[0].left == 0 && Out[0].top == 0 && Out[0].right == 20 && Out[0].bottom == 10);
+
+    COALESCE_STATS Stats;
+    Coalescer.GetStats(&Stats);
+    TEST_CHECK(Stats.PixelsOverCopied == 0);
+}
+
+//
+// Too many rects or too much coverage turn into one copy of the whole frame
+//
+static void TestFullCopy(CAPTUREARENA* Arena)
+{
+    RECTCOALESCER Coalescer;
+    Coalescer.SetArena(Arena);
+    Coalescer.SetFullCopyThreshold(16, 0.5f);
+
+    RECT* Out;
+    UINT OutCount;
+    RECT Big = {0, 0, 1900, 1000};
+    TEST_CHECK(Coalescer.Coalesce(&Big, 1, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 1);
+    TEST_CHECK(Out[0].left == 0 && Out[0].top == 0 && Out[0].right == FRAME_WIDTH && Out[0].bottom == FRAME_HEIGHT);
+
+    std::vector<RECT> Scattered;
+    for (LONG i = 0; i < 17; ++i)
+    {
+        RECT Rect = {i * 100, i * 60, (i * 100) + 4, (i * 60) + 4};
+        Scattered.push_back(Rect);
+    }
+    TEST_CHECK(Coalescer.Coalesce(Scattered.data(), static_cast<UINT>(Scattered.size()), FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 1);
+
+    COALESCE_STATS Stats;
+    Coalescer.GetStats(&Stats);
+    TEST_CHECK(Stats.FullCopies == 2);
+}
+
+//
+// Rects off the frame are dropped and the rest clipped to it, a frame with nothing left has no rects
+//
+static void TestClipping(CAPTUREARENA* Arena)
+{
+    RECTCOALESCER Coalescer;
+    Coalescer.SetArena(Arena);
+
+    RECT* Out;
+    UINT OutCount;
+    RECT Outside[2] = {{-50, -50, -10, -10}, {FRAME_WIDTH, 0, FRAME_WIDTH + 10, 10}};
+    TEST_CHECK(Coalescer.Coalesce(Outside, 2, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 0);
+
+    RECT Straddling = {-20, -20, 20, 20};
+    TEST_CHECK(Coalescer.Coalesce(&Straddling, 1, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(OutCount == 1);
+    TEST_CHECK(Out[0].left == 0 && Out[0].top == 0 && Out[0].right == 20 && Out[0].bottom == 20);
+}
+
+//
+// Whatever comes in, the output covers it, stays inside the frame and is never more rects
+//
+static void TestRandomCoverage(CAPTUREARENA* Arena)
+{
+    RECTCOALESCER Coalescer;
+    Coalescer.SetArena(Arena);
+    TESTRANDOM Random(3);
+
+    for (unsigned Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        Coalescer.SetRectCost(Random.Below(8192));
+
+        std::vector<RECT> In;
+        unsigned Count = 1 + Random.Below(64);
+        for (unsigned i = 0; i < Count; ++i)
+        {
+            RECT Rect;
+            Rect.left = static_cast<LONG>(Random.Below(FRAME_WIDTH + 200)) - 100;
+            Rect.top = static_cast<LONG>(Random.Below(FRAME_HEIGHT + 200)) - 100;
+            Rect.right = Rect.left + 1 + Random.Below(200);
+            Rect.bottom = Rect.top + 1 + Random.Below(120);
+            In.push_back(Rect);
+        }
+
+        RECT* Out;
+        UINT OutCount;
+        TEST_CHECK(Coalescer.Coalesce(In.data(), Count, FRAME_WIDTH, FRAME_HEIGHT, &Out, &OutCount) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(OutCount <= Count);
+        TEST_CHECK(InsideFrame(Out, OutCount));
+        TEST_CHECK(Covers(In, Out, OutCount));
+    }
+}
+
+int main()
+{
+    CAPTUREARENA Arena;
+    if (Arena.Prepare() != DUPL_RETURN_SUCCESS)
+    {
+        return 1;
+    }
+
+    TestTypingBurst(&Arena);
+    TestDistantRects(&Arena);
+    TestFullCopy(&Arena);
+    TestClipping(&Arena);
+    TestRandomCoverage(&Arena);
+
+    return TestResult();
+}
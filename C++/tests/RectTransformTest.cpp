@@ -0,0 +1,285 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "RectTransform.h"
+#include "TestHarness.h"
+
+using namespace DirectX;
+
+//
+// DISPLAYMANAGER::SetMoveRect as it was before RECTTRANSFORM, the reference the batch code has to match
+//
+static void ReferenceMoveRect(RECT* SrcRect, RECT* DestRect, DXGI_MODE_ROTATION Rotation, DXGI_OUTDUPL_MOVE_RECT* MoveRect, INT TexWidth, INT TexHeight)
+{
+    switch (Rotation)
+    {
+        case DXGI_MODE_ROTATION_UNSPECIFIED:
+        case DXGI_MODE_ROTATION_IDENTITY:
+        {
+            SrcRect->left = MoveRect->SourcePoint.x;
+            SrcRect->top = MoveRect->SourcePoint.y;
+            SrcRect->right = MoveRect->SourcePoint.x + MoveRect->DestinationRect.right - MoveRect->DestinationRect.left;
+            SrcRect->bottom = MoveRect->SourcePoint.y + MoveRect->DestinationRect.bottom - MoveRect->DestinationRect.top;
+
+            *DestRect = MoveRect->DestinationRect;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE90:
+        {
+            SrcRect->left = TexHeight - (MoveRect->SourcePoint.y + MoveRect->DestinationRect.bottom - MoveRect->DestinationRect.top);
+            SrcRect->top = MoveRect->SourcePoint.x;
+            SrcRect->right = TexHeight - MoveRect->SourcePoint.y;
+            SrcRect->bottom = MoveRect->SourcePoint.x + MoveRect->DestinationRect.right - MoveRect->DestinationRect.left;
+
+            DestRect->left = TexHeight - MoveRect->DestinationRect.bottom;
+            DestRect->top = MoveRect->DestinationRect.left;
+            DestRect->right = TexHeight - MoveRect->DestinationRect.top;
+            DestRect->bottom = MoveRect->DestinationRect.right;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE180:
+        {
+            SrcRect->left = TexWidth - (MoveRect->SourcePoint.x + MoveRect->DestinationRect.right - MoveRect->DestinationRect.left);
+            SrcRect->top = TexHeight - (MoveRect->SourcePoint.y + MoveRect->DestinationRect.bottom - MoveRect->DestinationRect.top);
+            SrcRect->right = TexWidth - MoveRect->SourcePoint.x;
+            SrcRect->bottom = TexHeight - MoveRect->SourcePoint.y;
+
+            DestRect->left = TexWidth - MoveRect->DestinationRect.right;
+            DestRect->top = TexHeight - MoveRect->DestinationRect.bottom;
+            DestRect->right = TexWidth - MoveRect->DestinationRect.left;
+            DestRect->bottom = TexHeight - MoveRect->DestinationRect.top;
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE270:
+        {
+            SrcRect->left = MoveRect->SourcePoint.x;
+            SrcRect->top = TexWidth - (MoveRect->SourcePoint.x + MoveRect->DestinationRect.right - MoveRect->DestinationRect.left);
+            SrcRect->right = MoveRect->SourcePoint.y + MoveRect->DestinationRect.bottom - MoveRect->DestinationRect.top;
+            SrcRect->bottom = TexWidth - MoveRect->SourcePoint.x;
+
+            DestRect->left = MoveRect->DestinationRect.top;
+            DestRect->top = TexWidth - MoveRect->DestinationRect.right;
+            DestRect->right = MoveRect->DestinationRect.bottom;
+            DestRect->bottom = TexWidth - MoveRect->DestinationRect.left;
+            break;
+        }
+        default:
+        {
+            RtlZeroMemory(DestRect, sizeof(RECT));
+            RtlZeroMemory(SrcRect, sizeof(RECT));
+            break;
+        }
+    }
+}
+
+//
+// DISPLAYMANAGER::SetDirtyVert as it was before RECTTRANSFORM, DestDirty is handed out for TransformDirtyRects
+//
+static void ReferenceDirtyVert(VERTEX* Vertices, RECT* DestDirtyOut, RECT* Dirty, INT OffsetX, INT OffsetY, DXGI_OUTPUT_DESC* DeskDesc, D3D11_TEXTURE2D_DESC* FullDesc, D3D11_TEXTURE2D_DESC* ThisDesc)
+{
+    INT CenterX = FullDesc->Width / 2;
+    INT CenterY = FullDesc->Height / 2;
+
+    INT Width = DeskDesc->DesktopCoordinates.right - DeskDesc->DesktopCoordinates.left;
+    INT Height = DeskDesc->DesktopCoordinates.bottom - DeskDesc->DesktopCoordinates.top;
+
+    RECT DestDirty = *Dirty;
+
+    switch (DeskDesc->Rotation)
+    {
+        case DXGI_MODE_ROTATION_ROTATE90:
+        {
+            DestDirty.left = Width - Dirty->bottom;
+            DestDirty.top = Dirty->left;
+            DestDirty.right = Width - Dirty->top;
+            DestDirty.bottom = Dirty->right;
+
+            Vertices[0].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[1].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[2].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[5].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE180:
+        {
+            DestDirty.left = Width - Dirty->right;
+            DestDirty.top = Height - Dirty->bottom;
+            DestDirty.right = Width - Dirty->left;
+            DestDirty.bottom = Height - Dirty->top;
+
+            Vertices[0].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[1].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[2].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[5].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            break;
+        }
+        case DXGI_MODE_ROTATION_ROTATE270:
+        {
+            DestDirty.left = Dirty->top;
+            DestDirty.top = Height - Dirty->right;
+            DestDirty.right = Dirty->bottom;
+            DestDirty.bottom = Height - Dirty->left;
+
+            Vertices[0].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[1].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[2].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[5].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            break;
+        }
+        default:
+        {
+            Vertices[0].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[1].TexCoord = XMFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[2].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
+            Vertices[5].TexCoord = XMFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width), Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
+            break;
+        }
+    }
+
+    Vertices[0].Pos = XMFLOAT3((DestDirty.left + DeskDesc->DesktopCoordinates.left - OffsetX - CenterX) / static_cast<FLOAT>(CenterX),
+                               -1 * (DestDirty.bottom + DeskDesc->DesktopCoordinates.top - OffsetY - CenterY) / static_cast<FLOAT>(CenterY),
+                               0.0f);
+    Vertices[1].Pos = XMFLOAT3((DestDirty.left + DeskDesc->DesktopCoordinates.left - OffsetX - CenterX) / static_cast<FLOAT>(CenterX),
+                               -1 * (DestDirty.top + DeskDesc->DesktopCoordinates.top - OffsetY - CenterY) / static_cast<FLOAT>(CenterY),
+                               0.0f);
+    Vertices[2].Pos = XMFLOAT3((DestDirty.right + DeskDesc->DesktopCoordinates.left - OffsetX - CenterX) / static_cast<FLOAT>(CenterX),
+                               -1 * (DestDirty.bottom + DeskDesc->DesktopCoordinates.top - OffsetY - CenterY) / static_cast<FLOAT>(CenterY),
+                               0.0f);
+    Vertices[3].Pos = Vertices[2].Pos;
+    Vertices[4].Pos = Vertices[1].Pos;
+    Vertices[5].Pos = XMFLOAT3((DestDirty.right + DeskDesc->DesktopCoordinates.left - OffsetX - CenterX) / static_cast<FLOAT>(CenterX),
+                               -1 * (DestDirty.top + DeskDesc->DesktopCoordinates.top - OffsetY - CenterY) / static_cast<FLOAT>(CenterY),
+                               0.0f);
+
+    Vertices[3].TexCoord = Vertices[2].TexCoord;
+    Vertices[4].TexCoord = Vertices[1].TexCoord;
+
+    *DestDirtyOut = DestDirty;
+}
+
+static bool SameVertex(const VERTEX& First, const VERTEX& Second)
+{
+    return First.Pos.x == Second.Pos.x && First.Pos.y == Second.Pos.y && First.Pos.z == Second.Pos.z &&
+           First.TexCoord.x == Second.TexCoord.x && First.TexCoord.y == Second.TexCoord.y;
+}
+
+static RECT RandomRect(TESTRANDOM* Random, LONG MaxX, LONG MaxY, LONG MaxSize)
+{
+    RECT Rect;
+    Rect.left = Random->Below(MaxX);
+    Rect.top = Random->Below(MaxY);
+    Rect.right = Rect.left + Random->Below(MaxSize);
+    Rect.bottom = Rect.top + Random->Below(MaxSize);
+
+    return Rect;
+}
+
+#define MAX_BATCH 37
+
+//
+// Every rotation, random outputs and frame sizes, and batch sizes covering every tail length.
+// Outputs are bit for bit what the per rect code gives, also the second time round when the prepared tables are reused.
+//
+static void TestMatchesPerRectCode()
+{
+    const DXGI_MODE_ROTATION Rotations[] = {DXGI_MODE_ROTATION_UNSPECIFIED, DXGI_MODE_ROTATION_IDENTITY, DXGI_MODE_ROTATION_ROTATE90,
+                                            DXGI_MODE_ROTATION_ROTATE180, DXGI_MODE_ROTATION_ROTATE270};
+    TESTRANDOM Random(5);
+
+    for (unsigned Iteration = 0; Iteration < 4000; ++Iteration)
+    {
+        DXGI_MODE_ROTATION Rotation = Rotations[Iteration % ARRAYSIZE(Rotations)];
+        RECTTRANSFORM Transform;
+
+        DXGI_OUTPUT_DESC DeskDesc;
+        RtlZeroMemory(&DeskDesc, sizeof(DeskDesc));
+        DeskDesc.Rotation = Rotation;
+        DeskDesc.DesktopCoordinates.left = static_cast<LONG>(Random.Below(6000)) - 2000;
+        DeskDesc.DesktopCoordinates.top = static_cast<LONG>(Random.Below(4000)) - 1000;
+        DeskDesc.DesktopCoordinates.right = DeskDesc.DesktopCoordinates.left + 640 + Random.Below(3200);
+        DeskDesc.DesktopCoordinates.bottom = DeskDesc.DesktopCoordinates.top + 480 + Random.Below(2200);
+
+        D3D11_TEXTURE2D_DESC FullDesc;
+        D3D11_TEXTURE2D_DESC ThisDesc;
+        RtlZeroMemory(&FullDesc, sizeof(FullDesc));
+        RtlZeroMemory(&ThisDesc, sizeof(ThisDesc));
+        FullDesc.Width = 1000 + Random.Below(7000);
+        FullDesc.Height = 800 + Random.Below(4000);
+        ThisDesc.Width = 640 + Random.Below(3200);
+        ThisDesc.Height = 480 + Random.Below(2200);
+        INT OffsetX = static_cast<INT>(Random.Below(4000)) - 2000;
+        INT OffsetY = static_cast<INT>(Random.Below(4000)) - 2000;
+
+        UINT Count = Iteration % (MAX_BATCH + 1);
+        RECT Dirty[MAX_BATCH];
+        DXGI_OUTDUPL_MOVE_RECT Moves[MAX_BATCH];
+        for (UINT i = 0; i < Count; ++i)
+        {
+            Dirty[i] = RandomRect(&Random, 4000, 2400, 600);
+            Moves[i].SourcePoint.x = Random.Below(4000);
+            Moves[i].SourcePoint.y = Random.Below(2400);
+            Moves[i].DestinationRect = RandomRect(&Random, 4000, 2400, 600);
+        }
+
+        for (unsigned Pass = 0; Pass < 2; ++Pass)
+        {
+            VERTEX Vertices[MAX_BATCH * NUMVERTICES];
+            RECT DestRects[MAX_BATCH];
+            Transform.PrepareDirty(&DeskDesc, OffsetX, OffsetY, &FullDesc, &ThisDesc);
+            Transform.TransformDirty(Dirty, Count, Vertices);
+            Transform.TransformDirtyRects(Dirty, Count, DestRects);
+
+            RECT SrcRects[MAX_BATCH];
+            RECT MoveDestRects[MAX_BATCH];
+            Transform.PrepareMoves(Rotation, ThisDesc.Width, ThisDesc.Height);
+            Transform.TransformMoves(Moves, Count, SrcRects, MoveDestRects);
+
+            for (UINT i = 0; i < Count; ++i)
+            {
+                VERTEX Expected[NUMVERTICES];
+                RECT ExpectedDest;
+                ReferenceDirtyVert(Expected, &ExpectedDest, &Dirty[i], OffsetX, OffsetY, &DeskDesc, &FullDesc, &ThisDesc);
+                for (UINT v = 0; v < NUMVERTICES; ++v)
+                {
+                    TEST_CHECK(SameVertex(Vertices[(i * NUMVERTICES) + v], Expected[v]));
+                }
+                TEST_CHECK(EqualRect(&DestRects[i], &ExpectedDest));
+
+                RECT ExpectedSrc;
+                RECT ExpectedMoveDest;
+                ReferenceMoveRect(&ExpectedSrc, &ExpectedMoveDest, Rotation, &Moves[i], ThisDesc.Width, ThisDesc.Height);
+                TEST_CHECK(EqualRect(&SrcRects[i], &ExpectedSrc));
+                TEST_CHECK(EqualRect(&MoveDestRects[i], &ExpectedMoveDest));
+            }
+        }
+    }
+}
+
+//
+// Rotations DXGI doesn't define give empty move rects, as before
+//
+static void TestUnknownRotation()
+{
+    RECTTRANSFORM Transform;
+    DXGI_OUTDUPL_MOVE_RECT Move = {{10, 20}, {30, 40, 130, 140}};
+    RECT Src;
+    RECT Dest;
+    Transform.PrepareMoves(static_cast<DXGI_MODE_ROTATION>(9), 1920, 1080);
+    Transform.TransformMoves(&Move, 1, &Src, &Dest);
+
+    RECT Empty = {0, 0, 0, 0};
+    TEST_CHECK(EqualRect(&Src, &Empty));
+    TEST_CHECK(EqualRect(&Dest, &Empty));
+}
+
+int main()
+{
+    TestMatchesPerRectCode();
+    TestUnknownRotation();
+
+    return TestResult();
+}
@@ -0,0 +1,167 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "Region.h"
+#include "TestHarness.h"
+
+#define DESKTOP_WIDTH  1920
+#define DESKTOP_HEIGHT 1080
+
+//
+// Dirty rects the way DXGI hands them out while typing and scrolling: short runs of small rects along text lines
+//
+static std::vector<RECT> MakeDirtyRects(TESTRANDOM* Random, UINT Count)
+{
+    std::vector<RECT> Rects;
+    while (Rects.size() < Count)
+    {
+        LONG X = Random->Below(DESKTOP_WIDTH - 400);
+        LONG Y = Random->Below(DESKTOP_HEIGHT - 40);
+        UINT Run = 1 + Random->Below(8);
+        for (UINT i = 0; i < Run && Rects.size() < Count; ++i)
+        {
+            LONG Width = 8 + Random->Below(40);
+            Rects.push_back({X, Y, X + Width, Y + 16 + static_cast<LONG>(Random->Below(8))});
+            X += Width + Random->Below(6);
+        }
+    }
+
+    return Rects;
+}
+
+//
+// Covered pixel count of the rects, what the region area has to come out as
+//
+static UINT64 ReferenceArea(const std::vector<RECT>& First, const std::vector<RECT>* Second, REGION_OP Op)
+{
+    std::vector<unsigned char> Pixels(DESKTOP_WIDTH * DESKTOP_HEIGHT, 0);
+    for (const RECT& Rect : First)
+    {
+        for (LONG y = Rect.top; y < Rect.bottom; ++y)
+        {
+            memset(&Pixels[(y * DESKTOP_WIDTH) + Rect.left], 1, Rect.right - Rect.left);
+        }
+    }
+    if (Second)
+    {
+        std::vector<unsigned char> Other(DESKTOP_WIDTH * DESKTOP_HEIGHT, 0);
+        for (const RECT& Rect : *Second)
+        {
+            for (LONG y = Rect.top; y < Rect.bottom; ++y)
+            {
+                memset(&Other[(y * DESKTOP_WIDTH) + Rect.left], 1, Rect.right - Rect.left);
+            }
+        }
+        for (unsigned i = 0; i < Pixels.size(); ++i)
+        {
+            Pixels[i] = (Op == REGION_OP_UNION) ? (Pixels[i] | Other[i]) : (Op == REGION_OP_INTERSECT) ? (Pixels[i] & Other[i]) : (Pixels[i] & !Other[i]);
+        }
+    }
+
+    UINT64 Area = 0;
+    for (unsigned char Pixel : Pixels)
+    {
+        Area += Pixel;
+    }
+
+    return Area;
+}
+
+//
+// What callers did before REGION: test a window against every raw dirty rect
+//
+static bool RawIntersects(const std::vector<RECT>& Rects, const RECT& Probe)
+{
+    for (const RECT& Rect : Rects)
+    {
+        RECT Overlap;
+        if (IntersectRect(&Overlap, &Rect, &Probe))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void BenchCount(UINT Count, unsigned Iterations)
+{
+    TESTRANDOM Random(Count);
+    std::vector<RECT> First = MakeDirtyRects(&Random, Count);
+    std::vector<RECT> Second = MakeDirtyRects(&Random, Count);
+
+    REGION A;
+    REGION B;
+    REGION Result;
+    TEST_CHECK(A.SetFromRects(First.data(), Count) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(B.SetFromRects(Second.data(), Count) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(A.GetArea() == ReferenceArea(First, nullptr, REGION_OP_UNION));
+
+    UINT Boxes;
+    A.GetRects(&Boxes);
+    double Build = BenchNanoseconds(Iterations, 5, [&]() { Result.SetFromRects(First.data(), Count); });
+    printf("%5u rects -> %5u boxes  build %9.0f ns", Count, Boxes, Build);
+
+    const REGION_OP Ops[] = {REGION_OP_UNION, REGION_OP_INTERSECT, REGION_OP_SUBTRACT};
+    const char* Names[] = {"union", "intersect", "subtract"};
+    for (unsigned i = 0; i < ARRAYSIZE(Ops); ++i)
+    {
+        TEST_CHECK(Result.Copy(&A) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Result.Combine(&B, Ops[i]) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Result.GetArea() == ReferenceArea(First, &Second, Ops[i]));
+
+        double Time = BenchNanoseconds(Iterations, 5, [&]() {
+            Result.Copy(&A);
+            Result.Combine(&B, Ops[i]);
+        });
+        printf("  %s %9.0f ns", Names[i], Time);
+    }
+
+    double Translate = BenchNanoseconds(Iterations, 5, [&]() { A.Translate(1, -1); A.Translate(-1, 1); });
+    printf("  translate x2 %7.0f ns\n", Translate);
+
+    // Window sized probes, answered from the bands against a walk of every raw rect
+    std::vector<RECT> Probes;
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        LONG X = Random.Below(DESKTOP_WIDTH - 200);
+        LONG Y = Random.Below(DESKTOP_HEIGHT - 200);
+        Probes.push_back({X, Y, X + 20 + static_cast<LONG>(Random.Below(180)), Y + 20 + static_cast<LONG>(Random.Below(180))});
+        TEST_CHECK(A.Intersects(&Probes.back()) == RawIntersects(First, Probes.back()));
+    }
+
+    volatile unsigned Hits = 0;
+    double Region = BenchNanoseconds(Iterations, 5, [&]() {
+        for (const RECT& Probe : Probes)
+        {
+            Hits = Hits + A.Intersects(&Probe);
+        }
+    });
+    double Raw = BenchNanoseconds(Iterations, 5, [&]() {
+        for (const RECT& Probe : Probes)
+        {
+            Hits = Hits + RawIntersects(First, Probe);
+        }
+    });
+    TEST_CHECK(Hits);
+    printf("%32s  64 probes region %7.0f ns  raw rects %9.0f ns\n", "", Region, Raw);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned Iterations = BenchIsQuick(argc, argv) ? 2 : 200;
+
+    const UINT Counts[] = {16, 64, 256, 1024, 4096};
+    for (UINT Count : Counts)
+    {
+        BenchCount(Count, Iterations);
+    }
+
+    return TestResult();
+}
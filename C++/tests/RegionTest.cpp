@@ -0,0 +1,357 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "Region.h"
+#include "TestHarness.h"
+
+// The reference bitmap covers [-BITMAP_ORIGIN, BITMAP_SIZE - BITMAP_ORIGIN) on both axes
+#define BITMAP_SIZE   128
+#define BITMAP_ORIGIN 32
+
+//
+// One byte per pixel, the obviously correct region every REGION result is checked against
+//
+class BITMAP
+{
+    public:
+        BITMAP() : m_Pixels(BITMAP_SIZE * BITMAP_SIZE, 0) {}
+
+        unsigned char& At(LONG X, LONG Y)
+        {
+            return m_Pixels[((Y + BITMAP_ORIGIN) * BITMAP_SIZE) + X + BITMAP_ORIGIN];
+        }
+
+        void Fill(const RECT& Rect, unsigned char Value)
+        {
+            for (LONG y = Rect.top; y < Rect.bottom; ++y)
+            {
+                for (LONG x = Rect.left; x < Rect.right; ++x)
+                {
+                    At(x, y) = Value;
+                }
+            }
+        }
+
+        bool Any(const RECT& Rect)
+        {
+            for (LONG y = Rect.top; y < Rect.bottom; ++y)
+            {
+                for (LONG x = Rect.left; x < Rect.right; ++x)
+                {
+                    if (At(x, y))
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        UINT64 Area() const
+        {
+            UINT64 Area = 0;
+            for (unsigned char Pixel : m_Pixels)
+            {
+                Area += Pixel;
+            }
+
+            return Area;
+        }
+
+        void Combine(const BITMAP& Other, REGION_OP Op)
+        {
+            for (unsigned i = 0; i < m_Pixels.size(); ++i)
+            {
+                switch (Op)
+                {
+                    case REGION_OP_UNION:     m_Pixels[i] = m_Pixels[i] | Other.m_Pixels[i]; break;
+                    case REGION_OP_INTERSECT: m_Pixels[i] = m_Pixels[i] & Other.m_Pixels[i]; break;
+                    case REGION_OP_SUBTRACT:  m_Pixels[i] = m_Pixels[i] & !Other.m_Pixels[i]; break;
+                }
+            }
+        }
+
+        bool operator==(const BITMAP& Other) const
+        {
+            return m_Pixels == Other.m_Pixels;
+        }
+
+    private:
+        std::vector<unsigned char> m_Pixels;
+};
+
+//
+// Rasterizes the region and checks the banding invariants on the way: boxes are not empty, never overlap,
+// come sorted by band and then left, share top and bottom within a band, and never touch within a band.
+// Vertically adjacent bands with the same spans must have been merged.
+//
+static bool ToBitmap(const REGION& Region, BITMAP* Bitmap)
+{
+    UINT Count;
+    const RECT* Boxes = Region.GetRects(&Count);
+    bool Valid = true;
+
+    for (UINT i = 0; i < Count; ++i)
+    {
+        if (Boxes[i].left >= Boxes[i].right || Boxes[i].top >= Boxes[i].bottom)
+        {
+            return false;
+        }
+        for (LONG y = Boxes[i].top; y < Boxes[i].bottom; ++y)
+        {
+            for (LONG x = Boxes[i].left; x < Boxes[i].right; ++x)
+            {
+                Valid = Valid && !Bitmap->At(x, y);
+                Bitmap->At(x, y) = 1;
+            }
+        }
+
+        if (i)
+        {
+            const RECT& Previous = Boxes[i - 1];
+            if (Boxes[i].top == Previous.top)
+            {
+                Valid = Valid && Boxes[i].bottom == Previous.bottom && Boxes[i].left > Previous.right;
+            }
+            else
+            {
+                Valid = Valid && Boxes[i].top >= Previous.bottom;
+            }
+        }
+    }
+
+    // Walk band pairs, a band starting where the last ended must differ from it
+    UINT BandStart = 0;
+    UINT PreviousStart = 0;
+    UINT PreviousCount = 0;
+    while (BandStart < Count)
+    {
+        UINT BandEnd = BandStart + 1;
+        while (BandEnd < Count && Boxes[BandEnd].top == Boxes[BandStart].top)
+        {
+            ++BandEnd;
+        }
+
+        if (PreviousCount && Boxes[PreviousStart].bottom == Boxes[BandStart].top && PreviousCount == BandEnd - BandStart)
+        {
+            bool Same = true;
+            for (UINT i = 0; i < PreviousCount; ++i)
+            {
+                Same = Same && Boxes[PreviousStart + i].left == Boxes[BandStart + i].left && Boxes[PreviousStart + i].right == Boxes[BandStart + i].right;
+            }
+            Valid = Valid && !Same;
+        }
+
+        PreviousStart = BandStart;
+        PreviousCount = BandEnd - BandStart;
+        BandStart = BandEnd;
+    }
+
+    return Valid;
+}
+
+static bool Matches(const REGION& Region, const BITMAP& Expected)
+{
+    BITMAP Actual;
+    return ToBitmap(Region, &Actual) && Actual == Expected && Region.GetArea() == Expected.Area();
+}
+
+static RECT RandomRect(TESTRANDOM* Random)
+{
+    RECT Rect;
+    Rect.left = static_cast<LONG>(Random->Below(72)) - 8;
+    Rect.top = static_cast<LONG>(Random->Below(72)) - 8;
+    Rect.right = Rect.left + Random->Below(20);
+    Rect.bottom = Rect.top + Random->Below(20);
+
+    return Rect;
+}
+
+static void RandomRegion(TESTRANDOM* Random, REGION* Region, BITMAP* Bitmap)
+{
+    std::vector<RECT> Rects(Random->Below(12));
+    for (RECT& Rect : Rects)
+    {
+        Rect = RandomRect(Random);
+        Bitmap->Fill(Rect, 1);
+    }
+
+    TEST_CHECK(Region->SetFromRects(Rects.data(), static_cast<UINT>(Rects.size())) == DUPL_RETURN_SUCCESS);
+}
+
+//
+// Random regions built from rects and put through every operation, each result checked against the bitmap
+//
+static void TestAgainstBitmap()
+{
+    TESTRANDOM Random(9);
+
+    for (unsigned Iteration = 0; Iteration < 20000; ++Iteration)
+    {
+        REGION First;
+        REGION Second;
+        BITMAP FirstBitmap;
+        BITMAP SecondBitmap;
+        RandomRegion(&Random, &First, &FirstBitmap);
+        RandomRegion(&Random, &Second, &SecondBitmap);
+        TEST_CHECK(Matches(First, FirstBitmap));
+        TEST_CHECK(Matches(Second, SecondBitmap));
+
+        // Ops chain on the same region, so later ones start from results rather than freshly built regions
+        REGION Result;
+        TEST_CHECK(Result.Copy(&First) == DUPL_RETURN_SUCCESS);
+        BITMAP Expected = FirstBitmap;
+        for (unsigned Step = 0; Step < 3; ++Step)
+        {
+            REGION_OP Op = static_cast<REGION_OP>(Random.Below(3));
+            TEST_CHECK(Result.Combine(&Second, Op) == DUPL_RETURN_SUCCESS);
+            Expected.Combine(SecondBitmap, Op);
+            TEST_CHECK(Matches(Result, Expected));
+
+            RECT Rect = RandomRect(&Random);
+            BITMAP RectBitmap;
+            RectBitmap.Fill(Rect, 1);
+            switch (Random.Below(3))
+            {
+                case 0:  TEST_CHECK(Result.UnionRect(&Rect) == DUPL_RETURN_SUCCESS); Expected.Combine(RectBitmap, REGION_OP_UNION); break;
+                case 1:  TEST_CHECK(Result.IntersectRect(&Rect) == DUPL_RETURN_SUCCESS); Expected.Combine(RectBitmap, REGION_OP_INTERSECT); break;
+                default: TEST_CHECK(Result.SubtractRect(&Rect) == DUPL_RETURN_SUCCESS); Expected.Combine(RectBitmap, REGION_OP_SUBTRACT); break;
+            }
+            TEST_CHECK(Matches(Result, Expected));
+        }
+
+        RECT Probe = RandomRect(&Random);
+        TEST_CHECK(Result.Intersects(&Probe) == Expected.Any(Probe));
+        TEST_CHECK(Result.IsEmpty() == !Expected.Area());
+
+        if (!Result.IsEmpty())
+        {
+            RECT Extents;
+            Result.GetExtents(&Extents);
+            BITMAP Outside = Expected;
+            Outside.Fill(Extents, 0);
+            TEST_CHECK(!Outside.Area());
+            TEST_CHECK(Expected.Any({Extents.left, Extents.top, Extents.left + 1, Extents.bottom}));
+            TEST_CHECK(Expected.Any({Extents.right - 1, Extents.top, Extents.right, Extents.bottom}));
+            TEST_CHECK(Expected.Any({Extents.left, Extents.top, Extents.right, Extents.top + 1}));
+            TEST_CHECK(Expected.Any({Extents.left, Extents.bottom - 1, Extents.right, Extents.bottom}));
+        }
+
+        // Translating and then translating back is the identity, and in between every box moved
+        INT Dx = static_cast<INT>(Random.Below(17)) - 8;
+        INT Dy = static_cast<INT>(Random.Below(17)) - 8;
+        REGION Moved;
+        TEST_CHECK(Moved.Copy(&Result) == DUPL_RETURN_SUCCESS);
+        Moved.Translate(Dx, Dy);
+        UINT Count;
+        UINT MovedCount;
+        const RECT* Boxes = Result.GetRects(&Count);
+        const RECT* MovedBoxes = Moved.GetRects(&MovedCount);
+        TEST_CHECK(Count == MovedCount);
+        for (UINT i = 0; i < Count && i < MovedCount; ++i)
+        {
+            RECT Shifted = Boxes[i];
+            OffsetRect(&Shifted, Dx, Dy);
+            TEST_CHECK(EqualRect(&Shifted, &MovedBoxes[i]));
+        }
+        Moved.Translate(-Dx, -Dy);
+        TEST_CHECK(Matches(Moved, Expected));
+    }
+}
+
+//
+// Metadata from a frame, moves first and dirty rects after, both count as changed
+//
+static void TestFromMetadata()
+{
+    TESTRANDOM Random(10);
+
+    for (unsigned Iteration = 0; Iteration < 2000; ++Iteration)
+    {
+        UINT MoveCount = Random.Below(5);
+        UINT DirtyCount = Random.Below(8);
+        std::vector<BYTE> MetaData((MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)) + (DirtyCount * sizeof(RECT)));
+        DXGI_OUTDUPL_MOVE_RECT* Moves = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(MetaData.data());
+        RECT* Dirty = reinterpret_cast<RECT*>(MetaData.data() + (MoveCount * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
+
+        BITMAP Expected;
+        for (UINT i = 0; i < MoveCount; ++i)
+        {
+            Moves[i].DestinationRect = RandomRect(&Random);
+            Moves[i].SourcePoint.x = Random.Below(64);
+            Moves[i].SourcePoint.y = Random.Below(64);
+            Expected.Fill(Moves[i].DestinationRect, 1);
+        }
+        for (UINT i = 0; i < DirtyCount; ++i)
+        {
+            Dirty[i] = RandomRect(&Random);
+            Expected.Fill(Dirty[i], 1);
+        }
+
+        FRAME_DATA Data;
+        RtlZeroMemory(&Data, sizeof(Data));
+        Data.MetaData = MetaData.data();
+        Data.MoveCount = MoveCount;
+        Data.DirtyCount = DirtyCount;
+        Data.FrameInfo.TotalMetadataBufferSize = static_cast<UINT>(MetaData.size());
+
+        REGION Region;
+        RECT Stale = {0, 0, 10, 10};
+        TEST_CHECK(Region.SetRect(&Stale) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Region.SetFromMetadata(&Data) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Matches(Region, Expected));
+    }
+}
+
+//
+// Abutting rects from a tiled update collapse into one box, not one per tile
+//
+static void TestCanonicalForm()
+{
+    std::vector<RECT> Tiles;
+    for (LONG y = 0; y < 4; ++y)
+    {
+        for (LONG x = 0; x < 4; ++x)
+        {
+            Tiles.push_back({x * 16, y * 16, (x + 1) * 16, (y + 1) * 16});
+        }
+    }
+
+    REGION Region;
+    TEST_CHECK(Region.SetFromRects(Tiles.data(), static_cast<UINT>(Tiles.size())) == DUPL_RETURN_SUCCESS);
+    UINT Count;
+    const RECT* Boxes = Region.GetRects(&Count);
+    RECT Whole = {0, 0, 64, 64};
+    TEST_CHECK(Count == 1);
+    TEST_CHECK(Count == 1 && EqualRect(&Boxes[0], &Whole));
+
+    // Cutting the middle out and putting it back gives the same single box
+    RECT Middle = {16, 16, 48, 48};
+    TEST_CHECK(Region.SubtractRect(&Middle) == DUPL_RETURN_SUCCESS);
+    Region.GetRects(&Count);
+    TEST_CHECK(Count == 4);
+    TEST_CHECK(Region.GetArea() == (64 * 64) - (32 * 32));
+    TEST_CHECK(Region.UnionRect(&Middle) == DUPL_RETURN_SUCCESS);
+    Boxes = Region.GetRects(&Count);
+    TEST_CHECK(Count == 1 && EqualRect(&Boxes[0], &Whole));
+
+    Region.Clear();
+    TEST_CHECK(Region.IsEmpty());
+    TEST_CHECK(!Region.Intersects(&Whole));
+}
+
+int main()
+{
+    TestAgainstBitmap();
+    TestFromMetadata();
+    TestCanonicalForm();
+
+    return TestResult();
+}
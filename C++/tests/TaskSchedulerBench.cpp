@@ -0,0 +1,162 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <time.h>
+#include <vector>
+
+#include "FrameTiming.h"
+#include "TaskScheduler.h"
+#include "TestHarness.h"
+
+typedef std::chrono::steady_clock CLOCK;
+
+// What the scheduler used to do with every idle task, poll it again a millisecond later
+#define FIXED_POLL_MS 1
+
+// Time spent on a frame once it is there, about what a small dirty set costs to draw
+#define FRAME_WORK_US 300
+
+//
+// An output whose frames turn up at a fixed rate, polled by a capture task the way CAPTURETASK::Run does
+//
+typedef struct _SYNTHETIC_OUTPUT
+{
+    CLOCK::time_point NextFrame;
+    CLOCK::time_point End;
+    std::chrono::microseconds Period;
+    bool UseEstimate;
+    FRAMERATEESTIMATOR* Estimator;
+    std::atomic<unsigned> Running;
+    bool Overlapped;
+    unsigned Frames;
+    unsigned Polls;
+    std::vector<double> Latency;
+} SYNTHETIC_OUTPUT;
+
+static TASK_RESULT RunOutput(void* Context, unsigned* IdlePollMs)
+{
+    SYNTHETIC_OUTPUT* Output = reinterpret_cast<SYNTHETIC_OUTPUT*>(Context);
+    if (Output->Running++ != 0)
+    {
+        Output->Overlapped = true;
+    }
+
+    TASK_RESULT Result;
+    CLOCK::time_point Now = CLOCK::now();
+    ++Output->Polls;
+    if (Now >= Output->End)
+    {
+        Result = TASK_DONE;
+    }
+    else if (Now < Output->NextFrame)
+    {
+        *IdlePollMs = Output->UseEstimate ? Output->Estimator->GetPollInterval() : FIXED_POLL_MS;
+        Result = TASK_IDLE;
+    }
+    else
+    {
+        // Frames missed while late are folded into this one, as desktop duplication does
+        Output->Latency.push_back(std::chrono::duration<double, std::micro>(Now - Output->NextFrame).count());
+        Output->Estimator->OnFrame();
+        ++Output->Frames;
+        while (Output->NextFrame <= Now)
+        {
+            Output->NextFrame += Output->Period;
+        }
+
+        CLOCK::time_point WorkEnd = Now + std::chrono::microseconds(FRAME_WORK_US);
+        while (CLOCK::now() < WorkEnd)
+        {
+        }
+        Result = TASK_RUN_AGAIN;
+    }
+
+    --Output->Running;
+    return Result;
+}
+
+//
+// Runs outputs at the given rates on Workers workers for Milliseconds and reports polls, latency and CPU time
+//
+static void BenchPolicy(const char* Name, bool UseEstimate, unsigned Workers, const std::vector<unsigned>& Rates, unsigned Milliseconds, unsigned long long* IdleRuns)
+{
+    QPCCLOCK Clock;
+    std::vector<FRAMERATEESTIMATOR*> Estimators;
+    std::vector<SYNTHETIC_OUTPUT> Outputs(Rates.size());
+    TASKSCHEDULER Scheduler;
+
+    CLOCK::time_point Start = CLOCK::now();
+    for (size_t i = 0; i < Rates.size(); ++i)
+    {
+        Estimators.push_back(new FRAMERATEESTIMATOR(&Clock));
+        SYNTHETIC_OUTPUT& Output = Outputs[i];
+        Output.Period = std::chrono::microseconds(1000000 / Rates[i]);
+        Output.NextFrame = Start + std::chrono::microseconds(i * 1000);
+        Output.End = Start + std::chrono::milliseconds(Milliseconds);
+        Output.UseEstimate = UseEstimate;
+        Output.Estimator = Estimators[i];
+        Output.Running = 0;
+        Output.Overlapped = false;
+        Output.Frames = 0;
+        Output.Polls = 0;
+        TEST_CHECK(Scheduler.AddTask(RunOutput, &Output));
+    }
+
+    clock_t CpuStart = clock();
+    TEST_CHECK(Scheduler.Start(Workers, nullptr, nullptr));
+    Scheduler.WaitForTasks();
+    SCHEDULER_STATS Stats;
+    Scheduler.GetStats(&Stats);
+    Scheduler.Stop();
+    double CpuMs = (1000.0 * static_cast<double>(clock() - CpuStart)) / CLOCKS_PER_SEC;
+
+    std::vector<double> Latency;
+    unsigned Frames = 0;
+    unsigned Expected = 0;
+    for (size_t i = 0; i < Outputs.size(); ++i)
+    {
+        TEST_CHECK(!Outputs[i].Overlapped);
+        Latency.insert(Latency.end(), Outputs[i].Latency.begin(), Outputs[i].Latency.end());
+        Frames += Outputs[i].Frames;
+        Expected += (Rates[i] * Milliseconds) / 1000;
+        delete Estimators[i];
+    }
+    std::sort(Latency.begin(), Latency.end());
+
+    // Every frame is picked up, a late poll only merges frames when it is later than a whole period
+    TEST_CHECK(!Latency.empty());
+    TEST_CHECK(Frames + static_cast<unsigned>(Rates.size()) * 2 >= (Expected * 9) / 10);
+
+    if (!Latency.empty())
+    {
+        printf("%-9s %u workers %3zu outputs  %6u frames  %7llu idle polls (%5.1f per frame)  latency p50 %5.0f us p99 %6.0f us  cpu %6.0f ms\n",
+               Name, Workers, Rates.size(), Frames, Stats.IdleRuns, static_cast<double>(Stats.IdleRuns) / max(Frames, 1u),
+               Latency[Latency.size() / 2], Latency[(Latency.size() * 99) / 100], CpuMs - (Frames * FRAME_WORK_US) / 1000.0);
+    }
+    *IdleRuns = Stats.IdleRuns;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned Milliseconds = BenchIsQuick(argc, argv) ? 300 : 3000;
+
+    // Outputs refreshing at common rates, some of them not drawing much
+    std::vector<std::vector<unsigned>> Setups = {{60}, {60, 60, 144}, {30, 60, 60, 75, 120, 144}};
+    for (const std::vector<unsigned>& Rates : Setups)
+    {
+        unsigned long long FixedIdle;
+        unsigned long long EstimateIdle;
+        BenchPolicy("fixed 1ms", false, 2, Rates, Milliseconds, &FixedIdle);
+        BenchPolicy("estimate", true, 2, Rates, Milliseconds, &EstimateIdle);
+        TEST_CHECK(EstimateIdle < FixedIdle);
+    }
+
+    return TestResult();
+}
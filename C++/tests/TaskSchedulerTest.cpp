@@ -0,0 +1,262 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "FrameTiming.h"
+#include "TaskScheduler.h"
+#include "TestHarness.h"
+
+typedef std::chrono::steady_clock CLOCK;
+
+static double MillisecondsSince(CLOCK::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(CLOCK::now() - Start).count();
+}
+
+//
+// Runs a number of times and then finishes, flags it if two workers ever run it at once
+//
+typedef struct _COUNTING_TASK
+{
+    std::atomic<unsigned> Running;
+    unsigned Runs;
+    unsigned Target;
+    bool Overlapped;
+} COUNTING_TASK;
+
+static TASK_RESULT RunCounting(void* Context, unsigned* IdlePollMs)
+{
+    COUNTING_TASK* Task = reinterpret_cast<COUNTING_TASK*>(Context);
+    if (Task->Running++ != 0)
+    {
+        Task->Overlapped = true;
+    }
+
+    TASK_RESULT Result = (++Task->Runs >= Task->Target) ? TASK_DONE : ((Task->Runs % 3) ? TASK_RUN_AGAIN : TASK_IDLE);
+    if (Result == TASK_IDLE)
+    {
+        *IdlePollMs = 0;
+    }
+
+    --Task->Running;
+    return Result;
+}
+
+static std::atomic<unsigned> WorkerInits(0);
+
+static void CountInit(void* Context)
+{
+    (void)Context;
+    ++WorkerInits;
+}
+
+//
+// More tasks than workers, every one runs to the end exactly as often as it asked and never on two workers at once
+//
+static void TestRunsEveryTask()
+{
+    const unsigned TaskCount = 16;
+    std::vector<COUNTING_TASK> Tasks(TaskCount);
+    TASKSCHEDULER Scheduler;
+    for (unsigned i = 0; i < TaskCount; ++i)
+    {
+        Tasks[i].Running = 0;
+        Tasks[i].Runs = 0;
+        Tasks[i].Target = 500 + (i * 37);
+        Tasks[i].Overlapped = false;
+        TEST_CHECK(Scheduler.AddTask(RunCounting, &Tasks[i]));
+    }
+
+    WorkerInits = 0;
+    TEST_CHECK(Scheduler.Start(4, CountInit, nullptr));
+    TEST_CHECK(!Scheduler.AddTask(RunCounting, &Tasks[0]));
+    Scheduler.WaitForTasks();
+
+    SCHEDULER_STATS Stats;
+    Scheduler.GetStats(&Stats);
+    Scheduler.Stop();
+
+    unsigned long long Runs = 0;
+    for (unsigned i = 0; i < TaskCount; ++i)
+    {
+        TEST_CHECK(Tasks[i].Runs == Tasks[i].Target);
+        TEST_CHECK(!Tasks[i].Overlapped);
+        Runs += Tasks[i].Runs;
+    }
+    TEST_CHECK(Stats.Runs == Runs);
+    TEST_CHECK(Stats.IdleRuns > 0);
+    TEST_CHECK(WorkerInits == 4);
+}
+
+//
+// Idles a number of times with the poll interval it was given and notes when it was run
+//
+typedef struct _POLLING_TASK
+{
+    unsigned PollMs;
+    bool UseDefault;
+    unsigned Runs;
+    unsigned Target;
+    std::vector<CLOCK::time_point> RunTimes;
+} POLLING_TASK;
+
+static TASK_RESULT RunPolling(void* Context, unsigned* IdlePollMs)
+{
+    POLLING_TASK* Task = reinterpret_cast<POLLING_TASK*>(Context);
+    Task->RunTimes.push_back(CLOCK::now());
+    if (++Task->Runs >= Task->Target)
+    {
+        return TASK_DONE;
+    }
+
+    if (!Task->UseDefault)
+    {
+        *IdlePollMs = Task->PollMs;
+    }
+    return TASK_IDLE;
+}
+
+//
+// Idle tasks come back after the interval they asked for, not before, and workers block in between
+//
+static void TestIdlePollInterval()
+{
+    POLLING_TASK Slow = {25, false, 0, 6, {}};
+    POLLING_TASK Default = {0, true, 0, 6, {}};
+    TASKSCHEDULER Scheduler;
+    TEST_CHECK(Scheduler.AddTask(RunPolling, &Slow));
+    TEST_CHECK(Scheduler.AddTask(RunPolling, &Default));
+    TEST_CHECK(Scheduler.Start(2, nullptr, nullptr));
+    Scheduler.WaitForTasks();
+
+    SCHEDULER_STATS Stats;
+    Scheduler.GetStats(&Stats);
+    Scheduler.Stop();
+
+    for (size_t i = 1; i < Slow.RunTimes.size(); ++i)
+    {
+        TEST_CHECK(Slow.RunTimes[i] - Slow.RunTimes[i - 1] >= std::chrono::milliseconds(25));
+    }
+    for (size_t i = 1; i < Default.RunTimes.size(); ++i)
+    {
+        TEST_CHECK(Default.RunTimes[i] - Default.RunTimes[i - 1] >= std::chrono::milliseconds(TASK_IDLE_POLL_DEFAULT_MS));
+    }
+    TEST_CHECK(Stats.IdleRuns == 10);
+
+    // Every wait is one sleep, a worker polling would sleep far more often than the tasks ran
+    TEST_CHECK(Stats.Sleeps < 4 * Stats.Runs);
+}
+
+//
+// Wake runs an idle task right away however long it asked to wait
+//
+static void TestWake()
+{
+    POLLING_TASK Sleepy = {60000, false, 0, 2, {}};
+    TASKSCHEDULER Scheduler;
+    TEST_CHECK(Scheduler.AddTask(RunPolling, &Sleepy));
+    CLOCK::time_point Start = CLOCK::now();
+    TEST_CHECK(Scheduler.Start(2, nullptr, nullptr));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Scheduler.Wake();
+    Scheduler.WaitForTasks();
+    Scheduler.Stop();
+
+    TEST_CHECK(Sleepy.Runs == 2);
+    TEST_CHECK(MillisecondsSince(Start) < 5000.0);
+}
+
+//
+// Stop returns with tasks still parked far in the future
+//
+static void TestStopWhileIdle()
+{
+    POLLING_TASK Sleepy = {60000, false, 0, 1000, {}};
+    TASKSCHEDULER Scheduler;
+    TEST_CHECK(Scheduler.AddTask(RunPolling, &Sleepy));
+    CLOCK::time_point Start = CLOCK::now();
+    TEST_CHECK(Scheduler.Start(3, nullptr, nullptr));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Scheduler.Stop();
+
+    TEST_CHECK(Sleepy.Runs == 1);
+    TEST_CHECK(MillisecondsSince(Start) < 5000.0);
+}
+
+//
+// CAPTURECLOCK the test moves by hand, in microseconds
+//
+class FAKECLOCK : public CAPTURECLOCK
+{
+    public:
+        FAKECLOCK() : m_Now(1000000) {}
+        LONGLONG Now() { return m_Now; }
+        LONGLONG Frequency() { return 1000000; }
+        void Advance(LONGLONG Microseconds) { m_Now += Microseconds; }
+
+    private:
+        LONGLONG m_Now;
+};
+
+//
+// The poll interval tracks when the next frame is due and backs off once the output goes quiet
+//
+static void TestPollInterval()
+{
+    FAKECLOCK Clock;
+    FRAMERATEESTIMATOR Estimator(&Clock);
+    TEST_CHECK(Estimator.GetPollInterval() == ACQUIRE_TIMEOUT_MIN_MS);
+
+    for (unsigned i = 0; i < 20; ++i)
+    {
+        Estimator.OnFrame();
+        Clock.Advance(16667);
+    }
+    Estimator.OnFrame();
+
+    // Sleeps until a quarter interval before the next frame is due
+    TEST_CHECK(Estimator.GetPollInterval() == 12);
+    Clock.Advance(8000);
+    TEST_CHECK(Estimator.GetPollInterval() == 4);
+
+    // From then until the frame is an interval late it polls at the floor
+    Clock.Advance(8667);
+    TEST_CHECK(Estimator.GetPollInterval() == POLL_INTERVAL_MIN_MS);
+    Clock.Advance(10000);
+    TEST_CHECK(Estimator.GetPollInterval() == POLL_INTERVAL_MIN_MS);
+
+    // After that every quarter of how late it is, up to the longest acquire timeout
+    Clock.Advance(90000);
+    TEST_CHECK(Estimator.GetPollInterval() == 25);
+    Clock.Advance(1000000);
+    TEST_CHECK(Estimator.GetPollInterval() == ACQUIRE_TIMEOUT_MAX_MS);
+
+    // A fast output is never polled more often than the floor
+    FRAMERATEESTIMATOR Fast(&Clock);
+    for (unsigned i = 0; i < 20; ++i)
+    {
+        Fast.OnFrame();
+        Clock.Advance(500);
+    }
+    TEST_CHECK(Fast.GetPollInterval() == POLL_INTERVAL_MIN_MS);
+}
+
+int main()
+{
+    TestRunsEveryTask();
+    TestIdlePollInterval();
+    TestWake();
+    TestStopWhileIdle();
+    TestPollInterval();
+
+    return TestResult();
+}
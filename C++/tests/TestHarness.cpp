@@ -0,0 +1,39 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include "CommonTypes.h"
+#include "TestHarness.h"
+
+unsigned& TestFailureCount()
+{
+    static unsigned Failures = 0;
+    return Failures;
+}
+
+int TestResult()
+{
+    if (TestFailureCount())
+    {
+        fprintf(stderr, "%u checks failed\n", TestFailureCount());
+        return 1;
+    }
+
+    return 0;
+}
+
+//
+// The units under test report failures through ProcessFailure, here it only prints
+//
+_Post_satisfies_(return != DUPL_RETURN_SUCCESS)
+DUPL_RETURN ProcessFailure(_In_opt_ ID3D11Device* Device, _In_ LPCWSTR Str, _In_ LPCWSTR Title, HRESULT hr, _In_opt_z_ HRESULT* ExpectedErrors)
+{
+    (void)Device;
+    (void)ExpectedErrors;
+    fprintf(stderr, "%ls: %ls (0x%08X)\n", Title, Str, static_cast<unsigned>(hr));
+
+    return DUPL_RETURN_ERROR_UNEXPECTED;
+}
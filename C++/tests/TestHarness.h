@@ -0,0 +1,97 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _TESTHARNESS_H_
+#define _TESTHARNESS_H_
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+//
+// Checks keep going after a failure so one run reports everything that is wrong,
+// a test's main returns TestResult() which is non-zero once any check failed
+//
+unsigned& TestFailureCount();
+
+#define TEST_CHECK(Expr)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(Expr))                                                                \
+        {                                                                           \
+            ++TestFailureCount();                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #Expr); \
+        }                                                                           \
+    } while (0)
+
+int TestResult();
+
+//
+// Small deterministic generator so every run of a randomized test sees the same cases
+//
+class TESTRANDOM
+{
+    public:
+        explicit TESTRANDOM(unsigned long long Seed) : m_State(Seed ? Seed : 1) {}
+
+        unsigned long long Next()
+        {
+            m_State ^= m_State << 13;
+            m_State ^= m_State >> 7;
+            m_State ^= m_State << 17;
+            return m_State;
+        }
+
+        // Uniform in [0, Bound)
+        unsigned Below(unsigned Bound)
+        {
+            return Bound ? static_cast<unsigned>(Next() % Bound) : 0;
+        }
+
+        // Uniform in [0, 1)
+        double Unit()
+        {
+            return static_cast<double>(Next() >> 11) / 9007199254740992.0;
+        }
+
+    private:
+        unsigned long long m_State;
+};
+
+//
+// Wall time of Iterations calls of Body in nanoseconds per call, the best of Repeats runs
+//
+template <typename BODY>
+double BenchNanoseconds(unsigned Iterations, unsigned Repeats, BODY Body)
+{
+    double Best = 0.0;
+    for (unsigned r = 0; r < Repeats; ++r)
+    {
+        auto Start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < Iterations; ++i)
+        {
+            Body();
+        }
+        double Elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / Iterations;
+        if (!r || Elapsed < Best)
+        {
+            Best = Elapsed;
+        }
+    }
+
+    return Best;
+}
+
+//
+// ctest passes --quick to benchmarks, they then run few iterations and mostly check their results
+//
+inline bool BenchIsQuick(int Argc, char** Argv)
+{
+    return Argc > 1 && !strcmp(Argv[1], "--quick");
+}
+
+#endif
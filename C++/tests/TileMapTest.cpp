@@ -0,0 +1,360 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.h"
+#include "TileMap.h"
+
+// Writers in the concurrent tests, each owns a band of tile rows
+#define TILEMAP_TEST_WRITERS 4
+
+//
+// A fresh map is changed everywhere, sizes off a tile boundary round the counts up
+//
+static void TestInit()
+{
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(200, 65) == DUPL_RETURN_SUCCESS);
+
+    UINT TilesX;
+    UINT TilesY;
+    TileMap.GetTileCounts(&TilesX, &TilesY);
+    TEST_CHECK(TilesX == 4 && TilesY == 2);
+
+    LONG Generation = TileMap.GetGeneration();
+    for (UINT y = 0; y < TilesY; ++y)
+    {
+        for (UINT x = 0; x < TilesX; ++x)
+        {
+            TEST_CHECK(TileMap.IsTileChanged(x, y, Generation));
+            TEST_CHECK(!TileMap.IsTileChanged(x, y, Generation + 1));
+        }
+    }
+
+    // Outside the map nothing ever changed
+    TEST_CHECK(!TileMap.IsTileChanged(TilesX, 0, Generation));
+    TEST_CHECK(!TileMap.IsTileChanged(0, TilesY, Generation));
+
+    // Made again at the same size the counter carries on and everything is new once more
+    TEST_CHECK(TileMap.Init(200, 65) == DUPL_RETURN_SUCCESS);
+    TEST_CHECK(TileMap.GetGeneration() == Generation + 1);
+    TEST_CHECK(TileMap.IsTileChanged(3, 1, Generation + 1));
+
+    // And at a new size
+    TEST_CHECK(TileMap.Init(64, 64) == DUPL_RETURN_SUCCESS);
+    TileMap.GetTileCounts(&TilesX, &TilesY);
+    TEST_CHECK(TilesX == 1 && TilesY == 1);
+    TEST_CHECK(TileMap.IsTileChanged(0, 0, Generation + 2));
+}
+
+//
+// Rects stamp exactly the tiles they touch after the offset, clipped to the map
+//
+static void TestMarkRects()
+{
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(300, 200) == DUPL_RETURN_SUCCESS);
+    UINT TilesX;
+    UINT TilesY;
+    TileMap.GetTileCounts(&TilesX, &TilesY);
+
+    TESTRANDOM Random(5);
+    for (unsigned Iteration = 0; Iteration < 500; ++Iteration)
+    {
+        LONG Generation = TileMap.NextGeneration();
+        RECT Rect;
+        Rect.left = static_cast<LONG>(Random.Below(400)) - 50;
+        Rect.top = static_cast<LONG>(Random.Below(300)) - 50;
+        Rect.right = Rect.left + static_cast<LONG>(Random.Below(120));
+        Rect.bottom = Rect.top + static_cast<LONG>(Random.Below(120));
+        INT OffsetX = static_cast<INT>(Random.Below(40)) - 20;
+        INT OffsetY = static_cast<INT>(Random.Below(40)) - 20;
+        TileMap.MarkRects(&Rect, 1, OffsetX, OffsetY, Generation);
+
+        // The pixels the rect covers on the map after the offset
+        LONG Left = max(Rect.left + OffsetX, 0L);
+        LONG Top = max(Rect.top + OffsetY, 0L);
+        LONG Right = min(Rect.right + OffsetX, 300L);
+        LONG Bottom = min(Rect.bottom + OffsetY, 200L);
+        for (UINT y = 0; y < TilesY; ++y)
+        {
+            for (UINT x = 0; x < TilesX; ++x)
+            {
+                LONG TileLeft = x * TILE_SIZE;
+                LONG TileTop = y * TILE_SIZE;
+                bool Touched = Left < Right && Top < Bottom &&
+                               Left < TileLeft + TILE_SIZE && Right > TileLeft && Top < TileTop + TILE_SIZE && Bottom > TileTop;
+                TEST_CHECK(TileMap.IsTileChanged(x, y, Generation) == Touched);
+            }
+        }
+    }
+
+    // MarkAll reaches every tile
+    LONG Generation = TileMap.NextGeneration();
+    TileMap.MarkAll(Generation);
+    TEST_CHECK(TileMap.IsTileChanged(0, 0, Generation) && TileMap.IsTileChanged(TilesX - 1, TilesY - 1, Generation));
+}
+
+//
+// A writer whose generation is older than a tile's stamp never moves the tile back
+//
+static void TestStampsOnlyMoveForward()
+{
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(128, 128) == DUPL_RETURN_SUCCESS);
+
+    LONG Slow = TileMap.NextGeneration();
+    LONG Fast = TileMap.NextGeneration();
+    RECT Rect = { 0, 0, 10, 10 };
+    TileMap.MarkRects(&Rect, 1, 0, 0, Fast);
+    TileMap.MarkRects(&Rect, 1, 0, 0, Slow);
+    TEST_CHECK(TileMap.IsTileChanged(0, 0, Fast));
+
+    // The slow writer's other tile still gets its own stamp
+    RECT Other = { 70, 70, 80, 80 };
+    TileMap.MarkRects(&Other, 1, 0, 0, Slow);
+    TEST_CHECK(TileMap.IsTileChanged(1, 1, Slow));
+    TEST_CHECK(!TileMap.IsTileChanged(1, 1, Fast));
+}
+
+//
+// Bounds are the changed tiles under the rect, cut back to the rect
+//
+static void TestChangedBounds()
+{
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(640, 480) == DUPL_RETURN_SUCCESS);
+    LONG Since = TileMap.NextGeneration();
+
+    RECT Query = { 10, 20, 630, 470 };
+    RECT Bounds;
+    TEST_CHECK(!TileMap.GetChangedBounds(&Query, Since, &Bounds));
+    TEST_CHECK(Bounds.left == 0 && Bounds.right == 0);
+
+    RECT Dirty[] = { { 130, 70, 140, 75 }, { 400, 300, 401, 301 } };
+    TileMap.MarkRects(Dirty, 2, 0, 0, Since);
+    TEST_CHECK(TileMap.GetChangedBounds(&Query, Since, &Bounds));
+    TEST_CHECK(Bounds.left == 128 && Bounds.top == 64 && Bounds.right == 448 && Bounds.bottom == 320);
+
+    // Tiles only partly under the query are cut to it
+    RECT Inside = { 135, 72, 402, 302 };
+    TEST_CHECK(TileMap.GetChangedBounds(&Inside, Since, &Bounds));
+    TEST_CHECK(Bounds.left == 135 && Bounds.top == 72 && Bounds.right == 402 && Bounds.bottom == 302);
+
+    RECT Elsewhere = { 0, 400, 64, 480 };
+    TEST_CHECK(!TileMap.GetChangedBounds(&Elsewhere, Since, &Bounds));
+    RECT Outside = { 700, 0, 800, 100 };
+    TEST_CHECK(!TileMap.GetChangedBounds(&Outside, Since, &Bounds));
+}
+
+//
+// The runs cover exactly the changed tiles under the rect, cut to it, each as long as it can be along its row
+//
+static void TestChangedRuns()
+{
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(700, 300) == DUPL_RETURN_SUCCESS);
+    UINT TilesX;
+    UINT TilesY;
+    TileMap.GetTileCounts(&TilesX, &TilesY);
+
+    TESTRANDOM Random(9);
+    for (unsigned Iteration = 0; Iteration < 300; ++Iteration)
+    {
+        LONG Since = TileMap.NextGeneration();
+        unsigned Stamps = Random.Below(30);
+        for (unsigned i = 0; i < Stamps; ++i)
+        {
+            RECT Dirty;
+            Dirty.left = Random.Below(700);
+            Dirty.top = Random.Below(300);
+            Dirty.right = Dirty.left + 1 + Random.Below(150);
+            Dirty.bottom = Dirty.top + 1 + Random.Below(20);
+            TileMap.MarkRects(&Dirty, 1, 0, 0, Since);
+        }
+
+        // Outputs off tile boundaries and some reaching past the map
+        RECT Rect;
+        Rect.left = static_cast<LONG>(Random.Below(400)) - 30;
+        Rect.top = static_cast<LONG>(Random.Below(200)) - 30;
+        Rect.right = Rect.left + 1 + Random.Below(500);
+        Rect.bottom = Rect.top + 1 + Random.Below(200);
+        LONG Left = max(Rect.left, 0L);
+        LONG Top = max(Rect.top, 0L);
+        LONG Right = min(Rect.right, 700L);
+        LONG Bottom = min(Rect.bottom, 300L);
+
+        std::vector<unsigned char> Covered(700 * 300, 0);
+        UINT Cursor = 0;
+        RECT Run;
+        RECT Last = { -1, -1, -1, -1 };
+        while (TileMap.NextChangedRun(&Rect, Since, &Cursor, &Run))
+        {
+            TEST_CHECK(Run.left >= Left && Run.top >= Top && Run.right <= Right && Run.bottom <= Bottom);
+            TEST_CHECK(Run.left < Run.right && Run.top < Run.bottom);
+
+            // Row order, and two runs of one row never touch or they would have been one
+            TEST_CHECK(Run.top > Last.top || (Run.top == Last.top && Run.left > Last.right));
+            Last = Run;
+
+            for (LONG y = Run.top; y < Run.bottom; ++y)
+            {
+                for (LONG x = Run.left; x < Run.right; ++x)
+                {
+                    TEST_CHECK(!Covered[(y * 700) + x]);
+                    Covered[(y * 700) + x] = 1;
+                }
+            }
+        }
+
+        for (LONG y = 0; y < 300; ++y)
+        {
+            for (LONG x = 0; x < 700; ++x)
+            {
+                bool Expected = x >= Left && x < Right && y >= Top && y < Bottom && TileMap.IsTileChanged(x >> TILE_SHIFT, y >> TILE_SHIFT, Since);
+                if (Covered[(y * 700) + x] != Expected)
+                {
+                    TEST_CHECK(Covered[(y * 700) + x] == Expected);
+                    y = 300;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Nothing to walk outside the map
+    RECT Outside = { 800, 0, 900, 100 };
+    UINT Cursor = 0;
+    RECT Run;
+    TEST_CHECK(!TileMap.NextChangedRun(&Outside, TileMap.GetGeneration(), &Cursor, &Run));
+}
+
+//
+// Writers stamping their own bands at once: each one that reads back its own tiles with a generation it took
+// after its last frame sees every tile it stamps from then on, whatever the others do in between
+//
+static void TestWritersSeeTheirOwnTiles()
+{
+    const unsigned Frames = 20000;
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(512, TILEMAP_TEST_WRITERS * 2 * TILE_SIZE) == DUPL_RETURN_SUCCESS);
+    std::atomic<unsigned> Missed(0);
+    std::atomic<unsigned> Backwards(0);
+
+    std::vector<std::thread> Writers;
+    for (unsigned w = 0; w < TILEMAP_TEST_WRITERS; ++w)
+    {
+        Writers.push_back(std::thread([&, w]
+        {
+            TESTRANDOM Random(100 + w);
+            LONG BandTop = w * 2 * TILE_SIZE;
+            LONG Since = TileMap.GetGeneration() + 1;
+            for (unsigned Frame = 0; Frame < Frames; ++Frame)
+            {
+                LONG Generation = TileMap.NextGeneration();
+                RECT Dirty;
+                Dirty.left = Random.Below(512);
+                Dirty.top = BandTop + Random.Below(2 * TILE_SIZE);
+                Dirty.right = Dirty.left + 1;
+                Dirty.bottom = Dirty.top + 1;
+                TileMap.MarkRects(&Dirty, 1, 0, 0, Generation);
+
+                // The other writers take generations in between and may still be stamping older ones
+                if (!TileMap.IsTileChanged(Dirty.left >> TILE_SHIFT, Dirty.top >> TILE_SHIFT, Since))
+                {
+                    ++Missed;
+                }
+                if (!TileMap.IsTileChanged(Dirty.left >> TILE_SHIFT, Dirty.top >> TILE_SHIFT, Generation))
+                {
+                    ++Backwards;
+                }
+
+                // As CAPTURETASK does when it publishes
+                if (Random.Below(4) == 0)
+                {
+                    Since = TileMap.GetGeneration() + 1;
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < Writers.size(); ++i)
+    {
+        Writers[i].join();
+    }
+
+    TEST_CHECK(Missed == 0);
+    TEST_CHECK(Backwards == 0);
+}
+
+//
+// Many threads stamping the same tiles leave each with the newest generation any of them used on it
+//
+static void TestConcurrentStamps()
+{
+    const unsigned Frames = 20000;
+    TILEMAP TileMap;
+    TEST_CHECK(TileMap.Init(256, 256) == DUPL_RETURN_SUCCESS);
+    UINT TilesX;
+    UINT TilesY;
+    TileMap.GetTileCounts(&TilesX, &TilesY);
+    std::vector<std::atomic<LONG>> Newest(TilesX * TilesY);
+    for (size_t i = 0; i < Newest.size(); ++i)
+    {
+        Newest[i] = TileMap.GetGeneration();
+    }
+
+    std::vector<std::thread> Writers;
+    for (unsigned w = 0; w < TILEMAP_TEST_WRITERS; ++w)
+    {
+        Writers.push_back(std::thread([&, w]
+        {
+            TESTRANDOM Random(200 + w);
+            for (unsigned Frame = 0; Frame < Frames; ++Frame)
+            {
+                LONG Generation = TileMap.NextGeneration();
+                UINT Tile = Random.Below(TilesX * TilesY);
+                RECT Dirty;
+                Dirty.left = (Tile % TilesX) * TILE_SIZE;
+                Dirty.top = (Tile / TilesX) * TILE_SIZE;
+                Dirty.right = Dirty.left + 1;
+                Dirty.bottom = Dirty.top + 1;
+                TileMap.MarkRects(&Dirty, 1, 0, 0, Generation);
+
+                LONG Seen = Newest[Tile];
+                while (Seen < Generation && !Newest[Tile].compare_exchange_weak(Seen, Generation))
+                {
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < Writers.size(); ++i)
+    {
+        Writers[i].join();
+    }
+
+    for (UINT Tile = 0; Tile < TilesX * TilesY; ++Tile)
+    {
+        TEST_CHECK(TileMap.IsTileChanged(Tile % TilesX, Tile / TilesX, Newest[Tile]));
+        TEST_CHECK(!TileMap.IsTileChanged(Tile % TilesX, Tile / TilesX, Newest[Tile] + 1));
+    }
+}
+
+int main()
+{
+    TestInit();
+    TestMarkRects();
+    TestStampsOnlyMoveForward();
+    TestChangedBounds();
+    TestChangedRuns();
+    TestWritersSeeTheirOwnTiles();
+    TestConcurrentStamps();
+
+    return TestResult();
+}
@@ -0,0 +1,191 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "TestHarness.h"
+#include "TraceReader.h"
+#include "TraceWriter.h"
+
+// Trace recorded at 60Hz in 100ns ticks
+#define TRACE_BENCH_FREQUENCY   10000000
+#define TRACE_BENCH_INTERVAL    (TRACE_BENCH_FREQUENCY / 60)
+
+// Paced replays run this many times faster than recorded
+#define TRACE_BENCH_SPEED       4.0f
+
+//
+// Records FrameCount frames of a few windows updating and a scroll, the desktop is left as it is after the last frame
+//
+static void RecordTrace(unsigned Width, unsigned Height, unsigned FrameCount, std::vector<BYTE>* Trace, std::vector<BYTE>* Desktop, unsigned long long* PixelBytes)
+{
+    CAPTURE_TRACE_HEADER Header;
+    RECT DesktopCoordinates = {0, 0, static_cast<LONG>(Width), static_cast<LONG>(Height)};
+    LARGE_INTEGER Frequency;
+    Frequency.QuadPart = TRACE_BENCH_FREQUENCY;
+    TRACEWRITER::InitHeader(&Header, CAPTURE_TRACE_FLAG_PIXELS, 0, &DesktopCoordinates, DXGI_MODE_ROTATION_IDENTITY, Frequency);
+    Header.FrameWidth = Width;
+    Header.FrameHeight = Height;
+    Trace->assign(reinterpret_cast<BYTE*>(&Header), reinterpret_cast<BYTE*>(&Header + 1));
+
+    Desktop->assign(static_cast<size_t>(Width) * Height * BPP, 0);
+    *PixelBytes = 0;
+    TESTRANDOM Random(3);
+    TRACEWRITER Writer;
+    for (unsigned i = 0; i < FrameCount; ++i)
+    {
+        // A scrolled document, a line of typing that moves along and a small animation
+        DXGI_OUTDUPL_MOVE_RECT Scroll;
+        Scroll.SourcePoint.x = 0;
+        Scroll.SourcePoint.y = 40;
+        Scroll.DestinationRect = {0, 0, static_cast<LONG>(Width / 2), static_cast<LONG>(Height - 40)};
+        LONG Caret = static_cast<LONG>((i * 16) % (Width - 64));
+        RECT Dirty[3] = {
+            {0, static_cast<LONG>(Height - 40), static_cast<LONG>(Width / 2), static_cast<LONG>(Height)},
+            {Caret, static_cast<LONG>(Height / 2), Caret + 64, static_cast<LONG>(Height / 2) + 20},
+            {static_cast<LONG>(Width / 2), 0, static_cast<LONG>(Width), static_cast<LONG>(Height / 3)},
+        };
+
+        for (unsigned d = 0; d < ARRAYSIZE(Dirty); ++d)
+        {
+            for (LONG y = Dirty[d].top; y < Dirty[d].bottom; ++y)
+            {
+                BYTE* Row = &(*Desktop)[(static_cast<size_t>(y) * Width * BPP) + (Dirty[d].left * BPP)];
+                for (LONG x = 0; x < (Dirty[d].right - Dirty[d].left) * BPP; x += 8)
+                {
+                    unsigned long long Value = Random.Next();
+                    memcpy(Row + x, &Value, 8);
+                }
+            }
+        }
+
+        BYTE MetaData[sizeof(Scroll) + sizeof(Dirty)];
+        memcpy(MetaData, &Scroll, sizeof(Scroll));
+        memcpy(MetaData + sizeof(Scroll), Dirty, sizeof(Dirty));
+
+        DXGI_OUTDUPL_FRAME_INFO FrameInfo;
+        RtlZeroMemory(&FrameInfo, sizeof(FrameInfo));
+        LARGE_INTEGER AcquireTime;
+        AcquireTime.QuadPart = TRACE_BENCH_FREQUENCY + (static_cast<LONGLONG>(i) * TRACE_BENCH_INTERVAL);
+        FrameInfo.LastPresentTime.QuadPart = AcquireTime.QuadPart - 1;
+        FrameInfo.AccumulatedFrames = 1;
+        FrameInfo.TotalMetadataBufferSize = sizeof(MetaData);
+
+        TEST_CHECK(Writer.BeginRecord(&FrameInfo, AcquireTime, 1, ARRAYSIZE(Dirty), MetaData, 0, nullptr, nullptr) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Writer.AppendPixels(Dirty, ARRAYSIZE(Dirty), Width, Height, Desktop->data(), Width * BPP) == DUPL_RETURN_SUCCESS);
+        *PixelBytes += Writer.GetRecord()->PixelBytes;
+
+        const BYTE* Record;
+        UINT RecordSize;
+        TEST_CHECK(Writer.EndRecord(&Record, &RecordSize) == DUPL_RETURN_SUCCESS);
+        Trace->insert(Trace->end(), Record, Record + RecordSize);
+    }
+}
+
+//
+// Plays every record once and writes its pixels into Frame, as REPLAYMANAGER does into its texture
+//
+static void ReplayPass(TRACEREADER* Reader, unsigned Width, std::vector<BYTE>* Frame)
+{
+    for (UINT i = 0; i < Reader->GetRecordCount(); ++i)
+    {
+        TRACE_FRAME Replayed;
+        Reader->GetFrame(&Replayed);
+
+        TRACE_PIXEL_CURSOR Cursor = {0, 0};
+        RECT Rect;
+        const BYTE* Pixels;
+        while (Reader->NextDirtyPixels(&Replayed, &Cursor, &Rect, &Pixels))
+        {
+            UINT RowBytes = (Rect.right - Rect.left) * BPP;
+            for (LONG y = Rect.top; y < Rect.bottom; ++y)
+            {
+                memcpy(&(*Frame)[(static_cast<size_t>(y) * Width * BPP) + (Rect.left * BPP)], Pixels, RowBytes);
+                Pixels += RowBytes;
+            }
+        }
+
+        Reader->DoneWithFrame();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool Quick = BenchIsQuick(argc, argv);
+    unsigned Width = Quick ? 1920 : 3840;
+    unsigned Height = Quick ? 1080 : 2160;
+    unsigned FrameCount = Quick ? 16 : 48;
+    unsigned Iterations = Quick ? 2 : 10;
+
+    std::vector<BYTE> Trace;
+    std::vector<BYTE> Desktop;
+    unsigned long long PixelBytes;
+    RecordTrace(Width, Height, FrameCount, &Trace, &Desktop, &PixelBytes);
+    printf("%ux%u trace, %u frames, %.1f MB\n", Width, Height, FrameCount, Trace.size() / 1e6);
+
+    // As fast as the records can be walked and their pixels written out
+    TRACEREADER Reader;
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    TEST_CHECK(Reader.GetRecordCount() == FrameCount);
+    std::vector<BYTE> Frame(Desktop.size());
+    double Pass = BenchNanoseconds(Iterations, 3, [&]
+    {
+        ReplayPass(&Reader, Width, &Frame);
+    });
+    TEST_CHECK(Frame == Desktop);
+    printf("replay         %7.3f ms/frame  %8.0f frames/s  %6.2f GB/s\n", Pass / FrameCount / 1e6, FrameCount / (Pass / 1e9), PixelBytes / Pass);
+
+    // The walk alone, what replaying a trace without pixels costs
+    double Walk = BenchNanoseconds(Iterations * 100, 3, [&]
+    {
+        TRACE_FRAME Replayed;
+        for (UINT i = 0; i < FrameCount; ++i)
+        {
+            Reader.GetFrame(&Replayed);
+            Reader.DoneWithFrame();
+        }
+    });
+    printf("walk           %7.1f ns/frame\n", Walk / FrameCount);
+
+    // Paced across a couple of loops, sleeping in whole milliseconds like REPLAYMANAGER. How far from its due
+    // time each frame is handed out depends on the scheduler, so it is only reported.
+    TRACEPACER Pacer;
+    LARGE_INTEGER ClockFrequency;
+    QueryPerformanceFrequency(&ClockFrequency);
+    Pacer.Init(TRACE_BENCH_FREQUENCY, ClockFrequency.QuadPart, TRACE_BENCH_SPEED);
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    unsigned Paced = FrameCount * 2 + 1;
+    double OffsetSum = 0.0;
+    double Earliest = 0.0;
+    double Latest = 0.0;
+    for (unsigned i = 0; i < Paced; ++i)
+    {
+        TRACE_FRAME Replayed;
+        Reader.GetFrame(&Replayed);
+
+        LARGE_INTEGER Now;
+        QueryPerformanceCounter(&Now);
+        LONGLONG Due = Pacer.GetDue(Replayed.PlaybackTime, Now.QuadPart);
+        if (Due > Now.QuadPart)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(((Due - Now.QuadPart) * 1000) / ClockFrequency.QuadPart));
+        }
+        QueryPerformanceCounter(&Now);
+
+        double Offset = static_cast<double>(Now.QuadPart - Due) * 1000.0 / ClockFrequency.QuadPart;
+        OffsetSum += Offset;
+        Earliest = min(Earliest, Offset);
+        Latest = max(Latest, Offset);
+        Reader.DoneWithFrame();
+    }
+    TEST_CHECK(Reader.GetLoopCount() == 2);
+    printf("paced x%.0f     %7.3f ms mean from due  %7.3f ms earliest  %7.3f ms latest\n", TRACE_BENCH_SPEED, OffsetSum / Paced, Earliest, Latest);
+
+    return TestResult();
+}
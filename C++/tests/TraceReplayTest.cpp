@@ -0,0 +1,478 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#include <vector>
+
+#include "PointerPredictor.h"
+#include "TestHarness.h"
+#include "TraceReader.h"
+#include "TraceWriter.h"
+
+// Desktop the synthetic session is recorded from
+#define TRACE_TEST_WIDTH        96
+#define TRACE_TEST_HEIGHT       64
+#define TRACE_TEST_FRAMES       40
+
+// 100ns ticks, what QueryPerformanceFrequency gives on most Windows machines
+#define TRACE_TEST_FREQUENCY    10000000
+
+// Pointer shapes recorded every this many frames
+#define TRACE_TEST_SHAPE_EVERY  7
+#define TRACE_TEST_SHAPE_SIZE   16
+
+//
+// What went into one record, and the desktop as it was after the frame
+//
+typedef struct _RECORDED_FRAME
+{
+    LARGE_INTEGER AcquireTime;
+    DXGI_OUTDUPL_FRAME_INFO FrameInfo;
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> Moves;
+    std::vector<RECT> Dirty;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO ShapeInfo;
+    std::vector<BYTE> Shape;
+    std::vector<BYTE> Desktop;
+} RECORDED_FRAME;
+
+//
+// Random rect inside the desktop
+//
+static RECT RandomRect(TESTRANDOM* Random)
+{
+    RECT Rect;
+    Rect.left = Random->Below(TRACE_TEST_WIDTH - 1);
+    Rect.top = Random->Below(TRACE_TEST_HEIGHT - 1);
+    Rect.right = Rect.left + 1 + Random->Below(TRACE_TEST_WIDTH - Rect.left);
+    Rect.bottom = Rect.top + 1 + Random->Below(TRACE_TEST_HEIGHT - Rect.top);
+    return Rect;
+}
+
+//
+// Records a session of random updates the way TRACERECORDER does, the pixels are read from a CPU copy of the desktop.
+// Every few frames a dirty rect hangs off the desktop or is empty, those carry no pixels.
+//
+static void RecordTrace(UINT FrameCount, bool Pixels, std::vector<BYTE>* Trace, std::vector<RECORDED_FRAME>* Frames)
+{
+    CAPTURE_TRACE_HEADER Header;
+    RECT DesktopCoordinates = {0, 0, TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT};
+    LARGE_INTEGER Frequency;
+    Frequency.QuadPart = TRACE_TEST_FREQUENCY;
+    TRACEWRITER::InitHeader(&Header, Pixels ? CAPTURE_TRACE_FLAG_PIXELS : 0, 0, &DesktopCoordinates, DXGI_MODE_ROTATION_IDENTITY, Frequency);
+    Header.FrameWidth = TRACE_TEST_WIDTH;
+    Header.FrameHeight = TRACE_TEST_HEIGHT;
+    Trace->assign(reinterpret_cast<BYTE*>(&Header), reinterpret_cast<BYTE*>(&Header + 1));
+    Frames->clear();
+
+    TESTRANDOM Random(FrameCount);
+    TRACEWRITER Writer;
+    std::vector<BYTE> Desktop(TRACE_TEST_WIDTH * TRACE_TEST_HEIGHT * BPP);
+    LONGLONG Time = 50 * TRACE_TEST_FREQUENCY;
+    for (UINT i = 0; i < FrameCount; ++i)
+    {
+        RECORDED_FRAME Frame;
+        RtlZeroMemory(&Frame.FrameInfo, sizeof(Frame.FrameInfo));
+        RtlZeroMemory(&Frame.ShapeInfo, sizeof(Frame.ShapeInfo));
+
+        // About 60Hz with some jitter, presents just before the acquire
+        Time += (TRACE_TEST_FREQUENCY / 60) + Random.Below(TRACE_TEST_FREQUENCY / 500);
+        Frame.AcquireTime.QuadPart = Time;
+        Frame.FrameInfo.LastPresentTime.QuadPart = Time - 1 - Random.Below(TRACE_TEST_FREQUENCY / 1000);
+        Frame.FrameInfo.AccumulatedFrames = 1 + Random.Below(2);
+
+        // The pointer only moves on some frames, the first update is from long before the recording started
+        if (i == 0 || Random.Below(3))
+        {
+            Frame.FrameInfo.LastMouseUpdateTime.QuadPart = (i == 0) ? Time - TRACE_TEST_FREQUENCY : Time - 2 - Random.Below(TRACE_TEST_FREQUENCY / 1000);
+            Frame.FrameInfo.PointerPosition.Position.x = Random.Below(TRACE_TEST_WIDTH);
+            Frame.FrameInfo.PointerPosition.Position.y = Random.Below(TRACE_TEST_HEIGHT);
+            Frame.FrameInfo.PointerPosition.Visible = TRUE;
+        }
+
+        UINT MoveCount = Random.Below(3);
+        for (UINT m = 0; m < MoveCount; ++m)
+        {
+            DXGI_OUTDUPL_MOVE_RECT Move;
+            Move.DestinationRect = RandomRect(&Random);
+            Move.SourcePoint.x = Random.Below(TRACE_TEST_WIDTH - (Move.DestinationRect.right - Move.DestinationRect.left) + 1);
+            Move.SourcePoint.y = Random.Below(TRACE_TEST_HEIGHT - (Move.DestinationRect.bottom - Move.DestinationRect.top) + 1);
+            Frame.Moves.push_back(Move);
+        }
+
+        UINT DirtyCount = 1 + Random.Below(4);
+        for (UINT d = 0; d < DirtyCount; ++d)
+        {
+            Frame.Dirty.push_back(RandomRect(&Random));
+        }
+        if (i % 5 == 3)
+        {
+            RECT Outside = {TRACE_TEST_WIDTH - 8, 4, TRACE_TEST_WIDTH + 8, 12};
+            RECT Empty = {10, 10, 10, 20};
+            Frame.Dirty.insert(Frame.Dirty.begin() + Random.Below(DirtyCount), Outside);
+            Frame.Dirty.push_back(Empty);
+        }
+
+        // New content under the dirty rects
+        for (UINT d = 0; d < Frame.Dirty.size(); ++d)
+        {
+            if (IsTraceRectInFrame(&Frame.Dirty[d], TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT))
+            {
+                for (LONG y = Frame.Dirty[d].top; y < Frame.Dirty[d].bottom; ++y)
+                {
+                    for (LONG x = Frame.Dirty[d].left * BPP; x < Frame.Dirty[d].right * BPP; ++x)
+                    {
+                        Desktop[(y * TRACE_TEST_WIDTH * BPP) + x] = static_cast<BYTE>(Random.Next());
+                    }
+                }
+            }
+        }
+
+        if (i % TRACE_TEST_SHAPE_EVERY == 0)
+        {
+            Frame.ShapeInfo.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR;
+            Frame.ShapeInfo.Width = 2;
+            Frame.ShapeInfo.Height = 2;
+            Frame.ShapeInfo.Pitch = 2 * BPP;
+            for (UINT b = 0; b < TRACE_TEST_SHAPE_SIZE; ++b)
+            {
+                Frame.Shape.push_back(static_cast<BYTE>(i + b));
+            }
+        }
+
+        std::vector<BYTE> MetaData(reinterpret_cast<BYTE*>(Frame.Moves.data()), reinterpret_cast<BYTE*>(Frame.Moves.data() + Frame.Moves.size()));
+        MetaData.insert(MetaData.end(), reinterpret_cast<BYTE*>(Frame.Dirty.data()), reinterpret_cast<BYTE*>(Frame.Dirty.data() + Frame.Dirty.size()));
+        Frame.FrameInfo.TotalMetadataBufferSize = static_cast<UINT>(MetaData.size());
+        Frame.FrameInfo.PointerShapeBufferSize = static_cast<UINT>(Frame.Shape.size());
+
+        TEST_CHECK(Writer.BeginRecord(&Frame.FrameInfo, Frame.AcquireTime, static_cast<UINT>(Frame.Moves.size()), static_cast<UINT>(Frame.Dirty.size()), MetaData.data(),
+                                      static_cast<UINT>(Frame.Shape.size()), &Frame.ShapeInfo, Frame.Shape.data()) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(Writer.GetRecord() != nullptr);
+        if (Pixels)
+        {
+            TEST_CHECK(Writer.AppendPixels(Frame.Dirty.data(), static_cast<UINT>(Frame.Dirty.size()), TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT, Desktop.data(), TRACE_TEST_WIDTH * BPP) == DUPL_RETURN_SUCCESS);
+        }
+
+        const BYTE* Record;
+        UINT RecordSize;
+        TEST_CHECK(Writer.EndRecord(&Record, &RecordSize) == DUPL_RETURN_SUCCESS);
+        TEST_CHECK(RecordSize % CAPTURE_TRACE_ALIGN == 0);
+        TEST_CHECK(Writer.GetRecord() == nullptr);
+        Trace->insert(Trace->end(), Record, Record + RecordSize);
+
+        Frame.Desktop = Desktop;
+        Frames->push_back(Frame);
+    }
+}
+
+//
+// Writes the pixels of a replayed frame into Desktop, as REPLAYMANAGER does into its texture
+//
+static UINT UploadPixels(TRACEREADER* Reader, const TRACE_FRAME* Frame, std::vector<BYTE>* Desktop)
+{
+    TRACE_PIXEL_CURSOR Cursor = {0, 0};
+    RECT Rect;
+    const BYTE* Pixels;
+    UINT Uploaded = 0;
+    while (Reader->NextDirtyPixels(Frame, &Cursor, &Rect, &Pixels))
+    {
+        UINT RowBytes = (Rect.right - Rect.left) * BPP;
+        for (LONG y = Rect.top; y < Rect.bottom; ++y)
+        {
+            memcpy(&(*Desktop)[(y * TRACE_TEST_WIDTH * BPP) + (Rect.left * BPP)], Pixels, RowBytes);
+            Pixels += RowBytes;
+        }
+        ++Uploaded;
+    }
+
+    return Uploaded;
+}
+
+//
+// Every record comes back as it was recorded and the uploaded pixels rebuild the desktop frame by frame
+//
+static void TestRecordAndReplay()
+{
+    std::vector<BYTE> Trace;
+    std::vector<RECORDED_FRAME> Frames;
+    RecordTrace(TRACE_TEST_FRAMES, true, &Trace, &Frames);
+
+    TRACEREADER Reader;
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    TEST_CHECK(Reader.GetRecordCount() == TRACE_TEST_FRAMES);
+    TEST_CHECK(Reader.GetHeader()->FrameWidth == TRACE_TEST_WIDTH && Reader.GetHeader()->FrameHeight == TRACE_TEST_HEIGHT);
+    TEST_CHECK(Reader.GetHeader()->Flags == CAPTURE_TRACE_FLAG_PIXELS);
+
+    std::vector<BYTE> Desktop(TRACE_TEST_WIDTH * TRACE_TEST_HEIGHT * BPP);
+    for (UINT i = 0; i < TRACE_TEST_FRAMES; ++i)
+    {
+        const RECORDED_FRAME& Recorded = Frames[i];
+        TRACE_FRAME Frame;
+        Reader.GetFrame(&Frame);
+
+        // Asking again before moving on gives the same record, like a replay that timed out
+        TRACE_FRAME Again;
+        Reader.GetFrame(&Again);
+        TEST_CHECK(Again.Record == Frame.Record);
+
+        TEST_CHECK(Frame.AcquireTime.QuadPart == Recorded.AcquireTime.QuadPart);
+        TEST_CHECK(Frame.PlaybackTime == Recorded.AcquireTime.QuadPart);
+        TEST_CHECK(memcmp(&Frame.FrameInfo, &Recorded.FrameInfo, sizeof(DXGI_OUTDUPL_FRAME_INFO)) == 0);
+        TEST_CHECK(Frame.Record->MoveCount == Recorded.Moves.size() && Frame.Record->DirtyCount == Recorded.Dirty.size());
+        TEST_CHECK(Recorded.Moves.empty() || memcmp(Frame.MoveRects, Recorded.Moves.data(), Recorded.Moves.size() * sizeof(DXGI_OUTDUPL_MOVE_RECT)) == 0);
+        TEST_CHECK(memcmp(Frame.DirtyRects, Recorded.Dirty.data(), Recorded.Dirty.size() * sizeof(RECT)) == 0);
+        TEST_CHECK(Frame.Record->ShapeSize == Recorded.Shape.size());
+        if (!Recorded.Shape.empty())
+        {
+            TEST_CHECK(memcmp(Frame.Shape, Recorded.Shape.data(), Recorded.Shape.size()) == 0);
+            TEST_CHECK(memcmp(&Frame.Record->ShapeInfo, &Recorded.ShapeInfo, sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO)) == 0);
+        }
+
+        // Only the rects inside the desktop carry pixels
+        UINT InFrame = 0;
+        for (UINT d = 0; d < Recorded.Dirty.size(); ++d)
+        {
+            InFrame += IsTraceRectInFrame(&Recorded.Dirty[d], TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT) ? 1 : 0;
+        }
+        TEST_CHECK(UploadPixels(&Reader, &Frame, &Desktop) == InFrame);
+        TEST_CHECK(Desktop == Recorded.Desktop);
+
+        Reader.DoneWithFrame();
+    }
+    TEST_CHECK(Reader.GetLoopCount() == 0);
+
+    // Without pixels the rects are still there but nothing is uploaded
+    RecordTrace(TRACE_TEST_FRAMES, false, &Trace, &Frames);
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    TEST_CHECK(Reader.GetHeader()->Flags == 0);
+    for (UINT i = 0; i < TRACE_TEST_FRAMES; ++i)
+    {
+        TRACE_FRAME Frame;
+        Reader.GetFrame(&Frame);
+        TEST_CHECK(Frame.Record->PixelBytes == 0 && Frame.Record->DirtyCount == Frames[i].Dirty.size());
+        TEST_CHECK(UploadPixels(&Reader, &Frame, &Desktop) == 0);
+        Reader.DoneWithFrame();
+    }
+}
+
+//
+// Every loop moves the times on by the loop length, so each time of a loop is later than all of the previous one
+// and the pointer samples keep being taken by POINTERPREDICTOR
+//
+static void TestLoopsKeepTimeGoingForward()
+{
+    std::vector<BYTE> Trace;
+    std::vector<RECORDED_FRAME> Frames;
+    RecordTrace(TRACE_TEST_FRAMES, false, &Trace, &Frames);
+
+    TRACEREADER Reader;
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    LONGLONG LoopTicks = Reader.GetLoopTicks();
+    TEST_CHECK(LoopTicks > Frames.back().AcquireTime.QuadPart - Frames.front().FrameInfo.LastMouseUpdateTime.QuadPart);
+
+    POINTERPREDICTOR Predictor;
+    LONGLONG LastAcquire = 0;
+    LONGLONG LastPresent = 0;
+    LONGLONG LastMouse = 0;
+    UINT Samples = 0;
+    UINT Taken = 0;
+    for (UINT Loop = 0; Loop < 4; ++Loop)
+    {
+        for (UINT i = 0; i < TRACE_TEST_FRAMES; ++i)
+        {
+            TRACE_FRAME Frame;
+            Reader.GetFrame(&Frame);
+            TEST_CHECK(Reader.GetLoopCount() == Loop);
+
+            const RECORDED_FRAME& Recorded = Frames[i];
+            TEST_CHECK(Frame.AcquireTime.QuadPart == Recorded.AcquireTime.QuadPart + (Loop * LoopTicks));
+            TEST_CHECK(Frame.FrameInfo.LastPresentTime.QuadPart == Recorded.FrameInfo.LastPresentTime.QuadPart + (Loop * LoopTicks));
+            TEST_CHECK(Frame.AcquireTime.QuadPart > LastAcquire);
+            TEST_CHECK(Frame.FrameInfo.LastPresentTime.QuadPart > LastPresent);
+            LastAcquire = Frame.AcquireTime.QuadPart;
+            LastPresent = Frame.FrameInfo.LastPresentTime.QuadPart;
+
+            // A pointer that did not move keeps its 0
+            if (!Recorded.FrameInfo.LastMouseUpdateTime.QuadPart)
+            {
+                TEST_CHECK(Frame.FrameInfo.LastMouseUpdateTime.QuadPart == 0);
+            }
+            else
+            {
+                TEST_CHECK(Frame.FrameInfo.LastMouseUpdateTime.QuadPart == Recorded.FrameInfo.LastMouseUpdateTime.QuadPart + (Loop * LoopTicks));
+                TEST_CHECK(Frame.FrameInfo.LastMouseUpdateTime.QuadPart > LastMouse);
+                LastMouse = Frame.FrameInfo.LastMouseUpdateTime.QuadPart;
+
+                ++Samples;
+                Taken += Predictor.AddSample(static_cast<double>(LastMouse) / TRACE_TEST_FREQUENCY, Frame.FrameInfo.PointerPosition.Position.x,
+                                             Frame.FrameInfo.PointerPosition.Position.y) ? 1 : 0;
+            }
+
+            Reader.DoneWithFrame();
+        }
+    }
+    TEST_CHECK(Samples > 4 && Taken == Samples);
+
+    // A single frame repeats at 60Hz
+    RecordTrace(1, false, &Trace, &Frames);
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    TEST_CHECK(Reader.GetLoopTicks() == (Frames[0].AcquireTime.QuadPart - Frames[0].FrameInfo.LastMouseUpdateTime.QuadPart) + (TRACE_TEST_FREQUENCY / 60));
+}
+
+//
+// Broken traces are refused, a truncated or inconsistent record ends the trace and the records before it still play
+//
+static void TestDamagedTraces()
+{
+    std::vector<BYTE> Trace;
+    std::vector<RECORDED_FRAME> Frames;
+    RecordTrace(TRACE_TEST_FRAMES, true, &Trace, &Frames);
+
+    TRACEREADER Reader;
+    TEST_CHECK(!Reader.Open(Trace.data(), sizeof(CAPTURE_TRACE_HEADER) - 1));
+    TEST_CHECK(!Reader.Open(Trace.data(), sizeof(CAPTURE_TRACE_HEADER)));
+    TEST_CHECK(!Reader.Open(Trace.data(), sizeof(CAPTURE_TRACE_HEADER) + sizeof(CAPTURE_TRACE_RECORD)));
+
+    std::vector<BYTE> Damaged = Trace;
+    reinterpret_cast<CAPTURE_TRACE_HEADER*>(Damaged.data())->Magic ^= 1;
+    TEST_CHECK(!Reader.Open(Damaged.data(), Damaged.size()));
+    Damaged = Trace;
+    reinterpret_cast<CAPTURE_TRACE_HEADER*>(Damaged.data())->FrameWidth = 0;
+    TEST_CHECK(!Reader.Open(Damaged.data(), Damaged.size()));
+
+    // Cut into the last record, as a recording that was killed leaves it
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size() - 1));
+    TEST_CHECK(Reader.GetRecordCount() == TRACE_TEST_FRAMES - 1);
+    for (UINT i = 0; i < TRACE_TEST_FRAMES; ++i)
+    {
+        TRACE_FRAME Frame;
+        Reader.GetFrame(&Frame);
+        TEST_CHECK(Frame.AcquireTime.QuadPart == Frames[i % (TRACE_TEST_FRAMES - 1)].AcquireTime.QuadPart + (Reader.GetLoopCount() * Reader.GetLoopTicks()));
+        Reader.DoneWithFrame();
+    }
+    TEST_CHECK(Reader.GetLoopCount() == 1);
+
+    // A record claiming more payload than it holds ends the trace there
+    Damaged = Trace;
+    SIZE_T Offset = sizeof(CAPTURE_TRACE_HEADER);
+    for (UINT i = 0; i < 5; ++i)
+    {
+        Offset += reinterpret_cast<CAPTURE_TRACE_RECORD*>(&Damaged[Offset])->RecordSize;
+    }
+    CAPTURE_TRACE_RECORD* Record = reinterpret_cast<CAPTURE_TRACE_RECORD*>(&Damaged[Offset]);
+    Record->PixelBytes = Record->RecordSize;
+    TEST_CHECK(Reader.Open(Damaged.data(), Damaged.size()));
+    TEST_CHECK(Reader.GetRecordCount() == 5);
+}
+
+//
+// Rects stop once the pixel payload runs out, the rects before still get theirs
+//
+static void TestShortPixelPayload()
+{
+    std::vector<BYTE> Trace;
+    std::vector<RECORDED_FRAME> Frames;
+    RecordTrace(TRACE_TEST_FRAMES, true, &Trace, &Frames);
+
+    // The first frame with more than one rect in the desktop
+    SIZE_T Offset = sizeof(CAPTURE_TRACE_HEADER);
+    UINT Index = 0;
+    UINT InFrame = 0;
+    for (; Index < TRACE_TEST_FRAMES; ++Index)
+    {
+        InFrame = 0;
+        for (UINT d = 0; d < Frames[Index].Dirty.size(); ++d)
+        {
+            InFrame += IsTraceRectInFrame(&Frames[Index].Dirty[d], TRACE_TEST_WIDTH, TRACE_TEST_HEIGHT) ? 1 : 0;
+        }
+        if (InFrame > 1)
+        {
+            break;
+        }
+        Offset += reinterpret_cast<CAPTURE_TRACE_RECORD*>(&Trace[Offset])->RecordSize;
+    }
+    TEST_CHECK(Index < TRACE_TEST_FRAMES);
+    reinterpret_cast<CAPTURE_TRACE_RECORD*>(&Trace[Offset])->PixelBytes -= 1;
+
+    TRACEREADER Reader;
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    std::vector<BYTE> Desktop(TRACE_TEST_WIDTH * TRACE_TEST_HEIGHT * BPP);
+    for (UINT i = 0; i < Index; ++i)
+    {
+        TRACE_FRAME Frame;
+        Reader.GetFrame(&Frame);
+        Reader.DoneWithFrame();
+    }
+
+    TRACE_FRAME Frame;
+    Reader.GetFrame(&Frame);
+    TEST_CHECK(UploadPixels(&Reader, &Frame, &Desktop) == InFrame - 1);
+}
+
+//
+// Due times follow the trace times scaled by the speed from the first frame asked about
+//
+static void TestPacer()
+{
+    // Trace in milliseconds, clock in nanoseconds
+    TRACEPACER Pacer;
+    Pacer.Init(1000, 1000000000, 2.0f);
+    TEST_CHECK(Pacer.GetDue(5000, 100) == 100);
+    TEST_CHECK(Pacer.GetDue(5500, 200) == 100 + 250000000);
+    TEST_CHECK(Pacer.GetDue(5000, 300) == 100);
+    TEST_CHECK(Pacer.GetDue(7000, 400) == 100 + 1000000000);
+
+    // Init anchors again
+    Pacer.Init(1000, 1000000000, 0.5f);
+    TEST_CHECK(Pacer.GetDue(100, 7) == 7);
+    TEST_CHECK(Pacer.GetDue(101, 8) == 7 + 2000000);
+
+    // Unpaced every frame is due when asked
+    Pacer.Init(1000, 1000000000, 0.0f);
+    TEST_CHECK(Pacer.GetDue(5000, 100) == 100);
+    TEST_CHECK(Pacer.GetDue(9000, 150) == 150);
+
+    // Across loops the due times keep going up a frame interval at a time, the stale pointer update the trace starts with
+    // moves the times on by about a second every loop but playback does not wait for it
+    std::vector<BYTE> Trace;
+    std::vector<RECORDED_FRAME> Frames;
+    RecordTrace(TRACE_TEST_FRAMES, false, &Trace, &Frames);
+    TRACEREADER Reader;
+    TEST_CHECK(Reader.Open(Trace.data(), Trace.size()));
+    Pacer.Init(TRACE_TEST_FREQUENCY, TRACE_TEST_FREQUENCY, 1.0f);
+    LONGLONG LongestInterval = 0;
+    for (UINT i = 1; i < TRACE_TEST_FRAMES; ++i)
+    {
+        LongestInterval = max(LongestInterval, Frames[i].AcquireTime.QuadPart - Frames[i - 1].AcquireTime.QuadPart);
+    }
+    LONGLONG LastDue = -1;
+    LONGLONG LongestGap = 0;
+    for (UINT i = 0; i < 3 * TRACE_TEST_FRAMES; ++i)
+    {
+        TRACE_FRAME Frame;
+        Reader.GetFrame(&Frame);
+        LONGLONG Due = Pacer.GetDue(Frame.PlaybackTime, 0);
+        TEST_CHECK(Due > LastDue);
+        if (LastDue >= 0)
+        {
+            LongestGap = max(LongestGap, Due - LastDue);
+        }
+        LastDue = Due;
+        Reader.DoneWithFrame();
+    }
+    TEST_CHECK(Reader.GetLoopCount() == 2);
+    TEST_CHECK(LongestGap <= LongestInterval);
+}
+
+int main()
+{
+    TestRecordAndReplay();
+    TestLoopsKeepTimeGoingForward();
+    TestDamagedTraces();
+    TestShortPixelPayload();
+    TestPacer();
+
+    return TestResult();
+}
@@ -0,0 +1,49 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_DIRECTXMATH_H_
+#define _COMPAT_DIRECTXMATH_H_
+
+//
+// The DirectXMath storage types CommonTypes.h declares structs with
+//
+namespace DirectX
+{
+    struct XMFLOAT2
+    {
+        float x;
+        float y;
+        XMFLOAT2() {}
+        XMFLOAT2(float X, float Y) : x(X), y(Y) {}
+    };
+
+    struct XMFLOAT3
+    {
+        float x;
+        float y;
+        float z;
+        XMFLOAT3() {}
+        XMFLOAT3(float X, float Y, float Z) : x(X), y(Y), z(Z) {}
+    };
+
+    struct XMFLOAT4
+    {
+        float x;
+        float y;
+        float z;
+        float w;
+        XMFLOAT4() {}
+        XMFLOAT4(float X, float Y, float Z, float W) : x(X), y(Y), z(Z), w(W) {}
+    };
+
+    struct alignas(16) XMMATRIX
+    {
+        float m[4][4];
+    };
+}
+
+#endif
@@ -0,0 +1,13 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_PIXELSHADER_H_
+#define _COMPAT_PIXELSHADER_H_
+
+// Stands in for the header the shader compiler generates from PixelShader.hlsl, no test draws anything
+
+#endif
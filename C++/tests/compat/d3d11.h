@@ -0,0 +1,186 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_D3D11_H_
+#define _COMPAT_D3D11_H_
+
+#include <vector>
+
+#include "dxgi1_2.h"
+
+//
+// D3D11 structs the platform neutral units read, and CPU stand-ins for the few device calls they make.
+// Other interfaces are only ever held by pointer.
+//
+typedef enum D3D_DRIVER_TYPE
+{
+    D3D_DRIVER_TYPE_UNKNOWN     = 0,
+    D3D_DRIVER_TYPE_HARDWARE    = 1,
+    D3D_DRIVER_TYPE_REFERENCE   = 2,
+    D3D_DRIVER_TYPE_WARP        = 5
+} D3D_DRIVER_TYPE;
+
+typedef enum D3D11_USAGE
+{
+    D3D11_USAGE_DEFAULT = 0,
+    D3D11_USAGE_DYNAMIC = 2
+} D3D11_USAGE;
+
+#define D3D11_BIND_SHADER_RESOURCE  0x8L
+#define D3D11_BIND_RENDER_TARGET    0x20L
+
+typedef struct D3D11_BOX
+{
+    UINT left;
+    UINT top;
+    UINT front;
+    UINT right;
+    UINT bottom;
+    UINT back;
+} D3D11_BOX;
+
+typedef struct D3D11_SUBRESOURCE_DATA
+{
+    const void* pSysMem;
+    UINT SysMemPitch;
+    UINT SysMemSlicePitch;
+} D3D11_SUBRESOURCE_DATA;
+
+typedef struct D3D11_TEXTURE2D_DESC
+{
+    UINT Width;
+    UINT Height;
+    UINT MipLevels;
+    UINT ArraySize;
+    DXGI_FORMAT Format;
+    DXGI_SAMPLE_DESC SampleDesc;
+    D3D11_USAGE Usage;
+    UINT BindFlags;
+    UINT CPUAccessFlags;
+    UINT MiscFlags;
+} D3D11_TEXTURE2D_DESC;
+
+//
+// Texture in system memory, every format is taken to be 4 bytes a pixel with rows packed tight
+//
+struct ID3D11Texture2D
+{
+    D3D11_TEXTURE2D_DESC Desc;
+    std::vector<BYTE> Pixels;
+    ULONG RefCount;
+
+    ULONG AddRef()
+    {
+        return ++RefCount;
+    }
+
+    ULONG Release()
+    {
+        ULONG Count = --RefCount;
+        if (!Count)
+        {
+            delete this;
+        }
+        return Count;
+    }
+
+    void GetDesc(D3D11_TEXTURE2D_DESC* Out)
+    {
+        *Out = Desc;
+    }
+
+    BYTE* GetPixel(UINT X, UINT Y)
+    {
+        return &Pixels[((static_cast<size_t>(Y) * Desc.Width) + X) * 4];
+    }
+};
+
+//
+// Copies run straight away, CopiedPixels counts every pixel copied so tests can see how much was moved
+//
+struct ID3D11DeviceContext
+{
+    ULONG RefCount;
+    UINT64 CopiedPixels;
+
+    ULONG AddRef()
+    {
+        return ++RefCount;
+    }
+
+    ULONG Release()
+    {
+        return --RefCount;
+    }
+
+    void CopySubresourceRegion(ID3D11Texture2D* Dest, UINT, UINT DestX, UINT DestY, UINT, ID3D11Texture2D* Src, UINT, const D3D11_BOX* Box)
+    {
+        for (UINT y = Box->top; y < Box->bottom; ++y)
+        {
+            memcpy(Dest->GetPixel(DestX, DestY + (y - Box->top)), Src->GetPixel(Box->left, y), (Box->right - Box->left) * 4);
+        }
+        CopiedPixels += static_cast<UINT64>(Box->right - Box->left) * (Box->bottom - Box->top);
+    }
+};
+
+//
+// Lives on the test's stack, the context is part of it and textures go away with their last reference
+//
+struct ID3D11Device
+{
+    ID3D11DeviceContext Context;
+    ULONG RefCount;
+    UINT TexturesCreated;
+
+    ID3D11Device() : RefCount(1), TexturesCreated(0)
+    {
+        Context.RefCount = 1;
+        Context.CopiedPixels = 0;
+    }
+
+    ULONG AddRef()
+    {
+        return ++RefCount;
+    }
+
+    ULONG Release()
+    {
+        return --RefCount;
+    }
+
+    void GetImmediateContext(ID3D11DeviceContext** Out)
+    {
+        Context.AddRef();
+        *Out = &Context;
+    }
+
+    HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* Desc, const D3D11_SUBRESOURCE_DATA* Initial, ID3D11Texture2D** Texture)
+    {
+        ID3D11Texture2D* Created = new ID3D11Texture2D;
+        Created->Desc = *Desc;
+        Created->Pixels.assign(static_cast<size_t>(Desc->Width) * Desc->Height * 4, 0);
+        Created->RefCount = 1;
+        if (Initial)
+        {
+            for (UINT y = 0; y < Desc->Height; ++y)
+            {
+                memcpy(Created->GetPixel(0, y), static_cast<const BYTE*>(Initial->pSysMem) + (y * Initial->SysMemPitch), Desc->Width * 4);
+            }
+        }
+        ++TexturesCreated;
+        *Texture = Created;
+        return S_OK;
+    }
+};
+
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11InputLayout;
+struct ID3D11SamplerState;
+struct ID3D11ShaderResourceView;
+
+#endif
@@ -0,0 +1,40 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_SAL_H_
+#define _COMPAT_SAL_H_
+
+//
+// SAL annotations only mean something to the Visual Studio analyzer
+//
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_opt_z_
+#define _In_reads_(Size)
+#define _In_reads_bytes_(Size)
+#define _In_reads_bytes_opt_(Size)
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(Size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(Size)
+#define _Out_writes_bytes_(Size)
+#define _Out_writes_to_(Size, Count)
+#define _Outptr_
+#define _Outptr_result_maybenull_
+#define _Outptr_result_buffer_(Size)
+#define _Outptr_result_bytebuffer_(Size)
+#define _Ret_writes_(Size)
+#define _Field_size_(Size)
+#define _Field_size_bytes_(Size)
+#define _Post_satisfies_(Expr)
+#define _Return_type_success_(Expr)
+#define _Success_(Expr)
+
+#endif
@@ -0,0 +1,14 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_WARNING_H_
+#define _COMPAT_WARNING_H_
+
+// Analyzer warning numbers used with #pragma warning, which GCC and Clang ignore
+#define __WARNING_USING_UNINIT_VAR 6001
+
+#endif
@@ -0,0 +1,308 @@
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved
+
+#ifndef _COMPAT_WINDOWS_H_
+#define _COMPAT_WINDOWS_H_
+
+//
+// The part of the Windows headers the platform neutral units include through CommonTypes.h,
+// enough to build and test them with GCC or Clang. Types keep their Windows sizes so structs
+// such as RECT have the layout the real code expects.
+//
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "sal.h"
+
+#define WINAPI
+#define CALLBACK
+#define __cdecl
+
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef int INT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int BOOL;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+
+// long is 32 bits on Windows, so the limits code compares LONG against have to be too
+#undef LONG_MAX
+#undef LONG_MIN
+#define LONG_MAX INT32_MAX
+#define LONG_MIN INT32_MIN
+typedef uint8_t UINT8;
+typedef float FLOAT;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef const wchar_t* LPCWSTR;
+typedef const char* LPCSTR;
+typedef void* HANDLE;
+typedef int32_t HRESULT;
+typedef struct HWND__* HWND;
+typedef struct HMONITOR__* HMONITOR;
+typedef struct HINSTANCE__* HINSTANCE;
+typedef size_t SIZE_T;
+
+#define TRUE 1
+#define FALSE 0
+#define INFINITE 0xFFFFFFFF
+#define MAX_PATH 260
+#define WM_USER 0x0400
+
+#define S_OK            ((HRESULT)0)
+#define E_FAIL          ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY   ((HRESULT)0x8007000EL)
+#define E_INVALIDARG    ((HRESULT)0x80070057L)
+#define SUCCEEDED(hr)   (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)      (((HRESULT)(hr)) < 0)
+
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef union _LARGE_INTEGER
+{
+    struct
+    {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct tagRECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+} RECT;
+
+typedef struct tagPOINT
+{
+    LONG x;
+    LONG y;
+} POINT;
+
+typedef struct _GUID
+{
+    DWORD Data1;
+    WORD Data2;
+    WORD Data3;
+    BYTE Data4[8];
+} GUID, IID;
+
+// windows.h makes these macros, functions keep them from clashing with std::min and std::max
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(A First, B Second)
+{
+    return (First < Second) ? First : Second;
+}
+
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(A First, B Second)
+{
+    return (First > Second) ? First : Second;
+}
+
+#define RtlZeroMemory(Dest, Length) memset((Dest), 0, (Length))
+#define ZeroMemory RtlZeroMemory
+#define RtlCopyMemory(Dest, Src, Length) memcpy((Dest), (Src), (Length))
+#define CopyMemory RtlCopyMemory
+
+inline int memcpy_s(void* Dest, size_t DestSize, const void* Src, size_t Count)
+{
+    if (Count > DestSize)
+    {
+        memset(Dest, 0, DestSize);
+        return 34;
+    }
+    memcpy(Dest, Src, Count);
+    return 0;
+}
+
+//
+// Rect helpers, same results as user32
+//
+inline BOOL SetRectEmpty(RECT* Rect)
+{
+    memset(Rect, 0, sizeof(*Rect));
+    return TRUE;
+}
+
+inline BOOL IsRectEmpty(const RECT* Rect)
+{
+    return Rect->left >= Rect->right || Rect->top >= Rect->bottom;
+}
+
+inline BOOL EqualRect(const RECT* First, const RECT* Second)
+{
+    return First->left == Second->left && First->top == Second->top && First->right == Second->right && First->bottom == Second->bottom;
+}
+
+inline BOOL OffsetRect(RECT* Rect, int Dx, int Dy)
+{
+    Rect->left += Dx;
+    Rect->right += Dx;
+    Rect->top += Dy;
+    Rect->bottom += Dy;
+    return TRUE;
+}
+
+inline BOOL IntersectRect(RECT* Dest, const RECT* First, const RECT* Second)
+{
+    RECT Result;
+    Result.left = max(First->left, Second->left);
+    Result.top = max(First->top, Second->top);
+    Result.right = min(First->right, Second->right);
+    Result.bottom = min(First->bottom, Second->bottom);
+    if (IsRectEmpty(&Result))
+    {
+        SetRectEmpty(Dest);
+        return FALSE;
+    }
+    *Dest = Result;
+    return TRUE;
+}
+
+inline BOOL UnionRect(RECT* Dest, const RECT* First, const RECT* Second)
+{
+    if (IsRectEmpty(First))
+    {
+        *Dest = *Second;
+    }
+    else if (IsRectEmpty(Second))
+    {
+        *Dest = *First;
+    }
+    else
+    {
+        RECT Result;
+        Result.left = min(First->left, Second->left);
+        Result.top = min(First->top, Second->top);
+        Result.right = max(First->right, Second->right);
+        Result.bottom = max(First->bottom, Second->bottom);
+        *Dest = Result;
+    }
+    if (IsRectEmpty(Dest))
+    {
+        SetRectEmpty(Dest);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//
+// Timing, QPC ticks are nanoseconds here
+//
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* Frequency)
+{
+    Frequency->QuadPart = 1000000000LL;
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* Counter)
+{
+    timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    Counter->QuadPart = (static_cast<LONGLONG>(Now.tv_sec) * 1000000000LL) + Now.tv_nsec;
+    return TRUE;
+}
+
+//
+// Interlocked operations, all full barriers like their Windows counterparts
+//
+inline LONG InterlockedIncrement(LONG volatile* Target)
+{
+    return __sync_add_and_fetch(Target, 1);
+}
+
+inline LONG InterlockedDecrement(LONG volatile* Target)
+{
+    return __sync_sub_and_fetch(Target, 1);
+}
+
+inline LONG InterlockedExchange(LONG volatile* Target, LONG Value)
+{
+    __sync_synchronize();
+    return __sync_lock_test_and_set(Target, Value);
+}
+
+inline LONG InterlockedCompareExchange(LONG volatile* Target, LONG Exchange, LONG Comparand)
+{
+    return __sync_val_compare_and_swap(Target, Comparand, Exchange);
+}
+
+inline LONG InterlockedExchangeAdd(LONG volatile* Target, LONG Value)
+{
+    return __sync_fetch_and_add(Target, Value);
+}
+
+inline void MemoryBarrier()
+{
+    __sync_synchronize();
+}
+
+inline void YieldProcessor()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+//
+// Slim reader writer locks
+//
+typedef pthread_rwlock_t SRWLOCK;
+#define SRWLOCK_INIT PTHREAD_RWLOCK_INITIALIZER
+
+inline void InitializeSRWLock(SRWLOCK* Lock)
+{
+    pthread_rwlock_init(Lock, nullptr);
+}
+
+inline void AcquireSRWLockExclusive(SRWLOCK* Lock)
+{
+    pthread_rwlock_wrlock(Lock);
+}
+
+inline void ReleaseSRWLockExclusive(SRWLOCK* Lock)
+{
+    pthread_rwlock_unlock(Lock);
+}
+
+inline void AcquireSRWLockShared(SRWLOCK* Lock)
+{
+    pthread_rwlock_rdlock(Lock);
+}
+
+inline void ReleaseSRWLockShared(SRWLOCK* Lock)
+{
+    pthread_rwlock_unlock(Lock);
+}
+
+inline void OutputDebugStringW(LPCWSTR Str)
+{
+    fputws(Str, stderr);
+}
+
+#endif